@@ -0,0 +1,124 @@
+#include "turn_registry.h"
+#include <algorithm>
+#include <vector>
+
+namespace common {
+
+void TurnRegistry::Turn::SetCancelHook(std::function<void()> hook) {
+    std::lock_guard<std::mutex> lock(hook_mutex_);
+    on_cancel_ = std::move(hook);
+    // 훅 등록 전에 이미 취소된 경우 바로 실행
+    if (cancelled.load() && on_cancel_) {
+        on_cancel_();
+    }
+}
+
+void TurnRegistry::Turn::ClearCancelHook() {
+    std::lock_guard<std::mutex> lock(hook_mutex_);
+    on_cancel_ = nullptr;
+}
+
+void TurnRegistry::Turn::Cancel() {
+    std::lock_guard<std::mutex> lock(hook_mutex_);
+    if (on_cancel_) {
+        on_cancel_();
+    }
+}
+
+bool TurnRegistry::Session::Prune(std::chrono::steady_clock::time_point now) {
+    turns.erase(std::remove_if(turns.begin(), turns.end(), [](const std::weak_ptr<Turn>& turn) { return turn.expired(); }),
+                turns.end());
+    if (cancel_before_turn_id != 0 && now - watermark_updated_at > kWatermarkTtl) {
+        cancel_before_turn_id = 0;
+    }
+    return turns.empty() && cancel_before_turn_id == 0;
+}
+
+std::shared_ptr<TurnRegistry::Turn> TurnRegistry::Register(const std::string& frontend_session_id, uint64_t turn_id) {
+    auto turn = std::make_shared<Turn>();
+    turn->frontend_session_id = frontend_session_id;
+    turn->turn_id = turn_id;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto now = std::chrono::steady_clock::now();
+    sweep_locked(now);
+
+    Session& session = sessions_[frontend_session_id];
+    session.Prune(now);
+    if (turn_id != 0 && turn_id < session.cancel_before_turn_id) {
+        turn->cancelled.store(true);
+    }
+    session.turns.push_back(turn);
+    return turn;
+}
+
+size_t TurnRegistry::CancelBefore(const std::string& frontend_session_id, uint64_t before_turn_id) {
+    std::vector<std::shared_ptr<Turn>> to_cancel;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto now = std::chrono::steady_clock::now();
+        sweep_locked(now);
+
+        auto it = sessions_.find(frontend_session_id);
+        if (it == sessions_.end()) {
+            if (before_turn_id == 0) {
+                return 0; // 등록된 턴도 남길 워터마크도 없음
+            }
+            it = sessions_.emplace(frontend_session_id, Session{}).first;
+        }
+        Session& session = it->second;
+        session.Prune(now);
+
+        for (const auto& weak_turn : session.turns) {
+            auto turn = weak_turn.lock();
+            if (!turn) continue;
+            // turn_id 0(턴 정보 없음)은 세션 전체 취소(before_turn_id == 0)일 때만 취소
+            bool matches = (before_turn_id == 0) || (turn->turn_id != 0 && turn->turn_id < before_turn_id);
+            if (matches && !turn->cancelled.exchange(true)) {
+                to_cancel.push_back(std::move(turn));
+            }
+        }
+
+        if (before_turn_id != 0) {
+            if (before_turn_id > session.cancel_before_turn_id) {
+                session.cancel_before_turn_id = before_turn_id;
+            }
+            session.watermark_updated_at = now;
+        } else if (session.turns.empty() && session.cancel_before_turn_id == 0) {
+            sessions_.erase(it);
+        }
+    }
+
+    // 훅(예: StopSynthesis)은 엔진 뮤텍스를 잡을 수 있으므로 레지스트리 락 밖에서 호출
+    for (auto& turn : to_cancel) {
+        turn->Cancel();
+    }
+    return to_cancel.size();
+}
+
+size_t TurnRegistry::ActiveCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (const auto& [sid, session] : sessions_) {
+        for (const auto& weak_turn : session.turns) {
+            if (!weak_turn.expired()) count++;
+        }
+    }
+    return count;
+}
+
+void TurnRegistry::sweep_locked(std::chrono::steady_clock::time_point now) {
+    if (now - last_sweep_at_ < kSweepInterval) {
+        return;
+    }
+    last_sweep_at_ = now;
+    for (auto it = sessions_.begin(); it != sessions_.end();) {
+        if (it->second.Prune(now)) {
+            it = sessions_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace common
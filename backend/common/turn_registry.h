@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace common {
+
+// 진행 중인 턴(frontend_session_id + turn_id) 목록. llm_engine과 tts_service가 함께 쓴다.
+// 게이트웨이의 CancelTurn 요청(barge-in)이 오면 해당 세션의 이전 턴들에 취소 플래그를 세우고,
+// 등록된 취소 훅이 있으면 호출한다 (TTS: StopSynthesis, LLM: 플래그만 확인).
+class TurnRegistry {
+public:
+    class Turn {
+    public:
+        std::string frontend_session_id;
+        uint64_t turn_id = 0;
+        std::atomic<bool> cancelled{false};
+
+        // 취소 시 호출될 동작 등록/해제. 훅은 hook_mutex_ 아래에서 실행되므로
+        // ClearCancelHook()이 반환된 뒤에는 훅이 참조하던 객체(TTS 엔진)를 안전하게 해제할 수 있다.
+        void SetCancelHook(std::function<void()> hook);
+        void ClearCancelHook();
+
+    private:
+        friend class TurnRegistry;
+        void Cancel();
+
+        std::mutex hook_mutex_;
+        std::function<void()> on_cancel_;
+    };
+
+    // 반환된 shared_ptr이 해제되면 자동으로 비활성 처리됨 (별도 해제 호출 불필요).
+    // 취소 요청이 턴 등록보다 먼저 도착한 경우(STT 지연 등) 등록 즉시 취소 상태가 된다.
+    std::shared_ptr<Turn> Register(const std::string& frontend_session_id, uint64_t turn_id);
+
+    // turn_id < before_turn_id 인 턴 취소 (before_turn_id == 0 이면 세션 전체). 취소된 개수 반환
+    size_t CancelBefore(const std::string& frontend_session_id, uint64_t before_turn_id);
+
+    size_t ActiveCount() const;
+
+private:
+    // 세션별 상태. 등록/취소는 자기 세션 항목만 정리하므로 다른 세션 수와 무관하게 동작한다
+    struct Session {
+        std::vector<std::weak_ptr<Turn>> turns;
+        uint64_t cancel_before_turn_id = 0; // 취소 워터마크 (0 = 없음)
+        std::chrono::steady_clock::time_point watermark_updated_at;
+
+        // 해제된 턴 제거 후 만료된 워터마크를 지움. 남은 것이 없으면 true (항목 삭제 가능)
+        bool Prune(std::chrono::steady_clock::time_point now);
+    };
+
+    // 더 이상 호출이 오지 않는 세션 항목 정리. kSweepInterval마다 한 번만 전체를 훑는다
+    void sweep_locked(std::chrono::steady_clock::time_point now);
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Session> sessions_;
+    std::chrono::steady_clock::time_point last_sweep_at_ = std::chrono::steady_clock::now();
+
+    // 늦게 도착하는 턴을 잡기 위한 워터마크 보존 시간
+    static constexpr std::chrono::seconds kWatermarkTtl{120};
+    static constexpr std::chrono::seconds kSweepInterval{30};
+};
+
+} // namespace common
@@ -36,8 +36,9 @@ LLMServiceImpl::LLMServiceImpl(std::shared_ptr<TTSClient> tts_client,
     std::cout << "LLMServiceImpl initialized." << std::endl;
 }
 
-void LLMServiceImpl::handle_openai_chunk(const std::string& session_id, const std::string& chunk, std::atomic<bool>& tts_stream_ok) {
-    if (!tts_stream_ok.load()) {
+void LLMServiceImpl::handle_openai_chunk(const std::string& session_id, const std::string& chunk, std::atomic<bool>& tts_stream_ok,
+                                         const common::TurnRegistry::Turn& turn) {
+    if (!tts_stream_ok.load() || turn.cancelled.load()) {
          return; 
     }
     if (!tts_client_->SendTextChunk(chunk)) {
@@ -69,6 +70,20 @@ void LLMServiceImpl::handle_openai_completion(
      }
 }
 
+Status LLMServiceImpl::CancelTurn(
+    ServerContext* context,
+    const llm::CancelTurnRequest* request,
+    Empty* response)
+{
+    if (request->frontend_session_id().empty()) {
+        return Status(StatusCode::INVALID_ARGUMENT, "frontend_session_id is required.");
+    }
+    size_t cancelled = turn_registry_.CancelBefore(request->frontend_session_id(), request->before_turn_id());
+    std::cout << "✋ LLM_Service [FE_SID:" << request->frontend_session_id() << "] CancelTurn(before_turn_id="
+              << request->before_turn_id() << ") -> " << cancelled << " active turn(s) cancelled." << std::endl;
+    return Status::OK;
+}
+
 Status LLMServiceImpl::ProcessTextStream(
     ServerContext* context,
     ServerReader<LLMStreamRequest>* reader,
@@ -85,6 +100,7 @@ Status LLMServiceImpl::ProcessTextStream(
     std::atomic<bool> openai_processing_started{false};
     std::atomic<bool> overall_success{true}; 
     std::string last_error_message;
+    std::shared_ptr<common::TurnRegistry::Turn> turn; // CancelTurn으로 취소될 수 있는 현재 턴
 
     std::promise<void> openai_done_promise;
     auto openai_done_future = openai_done_promise.get_future();
@@ -143,7 +159,9 @@ Status LLMServiceImpl::ProcessTextStream(
         }
         std::cout << "   LLM_Service [LLM_SID:" << llm_internal_session_id 
                   << ", FE_SID:" << frontend_session_id 
-                  << "] Config received. STT internal Session ID = " << received_config.session_id() << std::endl;
+                  << "] Config received. STT internal Session ID = " << received_config.session_id()
+                  << ", Turn = " << received_config.turn_id() << std::endl;
+        turn = turn_registry_.Register(frontend_session_id, received_config.turn_id());
         
         std::string tts_language = "ko-KR"; 
         std::string tts_voice = "ko-KR-SunHiNeural";
@@ -157,6 +175,7 @@ Status LLMServiceImpl::ProcessTextStream(
         tts_config_to_send.set_session_id(llm_internal_session_id);      
         tts_config_to_send.set_language_code(tts_language);
         tts_config_to_send.set_voice_name(tts_voice);
+        tts_config_to_send.set_turn_id(received_config.turn_id());
 
         if (!tts_client_->StartStream(tts_config_to_send)) {
             last_error_message = "Failed to start stream to TTS Service.";
@@ -172,12 +191,16 @@ Status LLMServiceImpl::ProcessTextStream(
          LLMStreamRequest chunk_request;
          std::cout << "   LLM_Service [LLM_SID:" << llm_internal_session_id << "] Waiting for text chunks from client..." << std::endl;
 
-        while (overall_success.load() && !context->IsCancelled() && reader->Read(&chunk_request)) {
+        while (overall_success.load() && !context->IsCancelled() && !turn->cancelled.load() && reader->Read(&chunk_request)) {
             if (chunk_request.request_data_case() == LLMStreamRequest::kTextChunk) {
                 const std::string& chunk = chunk_request.text_chunk();
                  if (!chunk.empty()) {
                      accumulated_text += chunk;
                  }
+            } else if (chunk_request.request_data_case() == LLMStreamRequest::kTranscriptFinal) {
+                 // STT가 발화를 확정함. 스트림 종료(WritesDone)를 기다리지 않고 바로 응답 생성
+                 std::cout << "   LLM_Service [LLM_SID:" << llm_internal_session_id << "] Transcript final marker received." << std::endl;
+                 break;
             } else if (chunk_request.request_data_case() == LLMStreamRequest::kConfig) {
                  std::cerr << "⚠️ LLM_Service [LLM_SID:" << llm_internal_session_id << "] Received unexpected Config message after initialization. Ignoring." << std::endl;
             } else {
@@ -192,6 +215,11 @@ Status LLMServiceImpl::ProcessTextStream(
              cleanup_resources(true); 
              return Status(StatusCode::CANCELLED, last_error_message);
         }
+        if (turn->cancelled.load()) {
+             std::cout << "✋ LLM_Service [LLM_SID:" << llm_internal_session_id << "] Turn cancelled (barge-in) before OpenAI call." << std::endl;
+             cleanup_resources(true);
+             return Status::OK;
+        }
         if (!overall_success.load()) {
              std::cerr << "❌ LLM_Service [LLM_SID:" << llm_internal_session_id << "] Error occurred. Exiting read loop. Reason: " << last_error_message << std::endl;
              cleanup_resources(tts_stream_started.load()); 
@@ -212,8 +240,8 @@ Status LLMServiceImpl::ProcessTextStream(
          std::cout << "   LLM_Service [LLM_SID:" << llm_internal_session_id << "] Starting OpenAI streaming processing..." << std::endl;
          openai_processing_started.store(true);
 
-        auto openai_chunk_cb = [this, llm_sid = llm_internal_session_id, &tts_stream_ok](const std::string& chunk) {
-            this->handle_openai_chunk(llm_sid, chunk, tts_stream_ok);
+        auto openai_chunk_cb = [this, llm_sid = llm_internal_session_id, &tts_stream_ok, turn](const std::string& chunk) {
+            this->handle_openai_chunk(llm_sid, chunk, tts_stream_ok, *turn);
         };
         auto openai_completion_cb = 
             [this, llm_sid = llm_internal_session_id, &openai_done_promise, &overall_success, &last_error_message]
@@ -222,7 +250,9 @@ Status LLMServiceImpl::ProcessTextStream(
         };
 
         try {
-            openai_client_->StreamChatCompletion(chat_history, openai_chunk_cb, openai_completion_cb);
+            // 취소 플래그는 turn 객체의 수명을 공유 (aliasing shared_ptr)
+            std::shared_ptr<const std::atomic<bool>> cancel_flag(turn, &turn->cancelled);
+            openai_client_->StreamChatCompletion(chat_history, openai_chunk_cb, openai_completion_cb, cancel_flag);
         } catch (const std::exception& e) {
             last_error_message = "Failed to start OpenAI streaming: " + std::string(e.what());
             std::cerr << "❌ LLM_Service [LLM_SID:" << llm_internal_session_id << "] " << last_error_message << std::endl;
@@ -246,6 +276,16 @@ Status LLMServiceImpl::ProcessTextStream(
              std::cout << "   LLM_Service [LLM_SID:" << llm_internal_session_id << "] OpenAI processing finished signal received." << std::endl;
         }
 
+        if (turn->cancelled.load()) {
+             // 중단된 OpenAI 요청은 실패로 보고되지만 barge-in에 의한 정상 종료로 취급.
+             // TTS 스트림은 닫아서 tts_service 쪽 리소스도 바로 정리되게 한다.
+             std::cout << "✋ LLM_Service [LLM_SID:" << llm_internal_session_id << "] Turn cancelled (barge-in). OpenAI request aborted, finishing TTS stream." << std::endl;
+             overall_success.store(true);
+             last_error_message.clear();
+             cleanup_resources(true);
+             return Status::OK;
+        }
+
         if (tts_stream_started.load()) {
              std::cout << "   LLM_Service [LLM_SID:" << llm_internal_session_id << "] Finishing TTS engine stream for FE_SID [" << frontend_session_id << "]..." << std::endl;
              Status tts_status = tts_client_->FinishStream();
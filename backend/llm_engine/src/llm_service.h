@@ -13,6 +13,7 @@
 
 #include "tts_client.h"
 #include "openai_client.h"
+#include "turn_registry.h"
 
 namespace llm_engine {
 
@@ -37,13 +38,22 @@ public:
         Empty* response
     ) override;
 
+    // Barge-in: 게이트웨이가 보낸 이전 턴 취소 요청 처리
+    Status CancelTurn(
+        ServerContext* context,
+        const llm::CancelTurnRequest* request,
+        Empty* response
+    ) override;
+
 private:
     std::shared_ptr<TTSClient> tts_client_;
     std::shared_ptr<OpenAIClient> openai_client_;
+    common::TurnRegistry turn_registry_;
 
     static std::string generate_uuid();
 
-    void handle_openai_chunk(const std::string& session_id, const std::string& chunk, std::atomic<bool>& tts_stream_ok);
+    void handle_openai_chunk(const std::string& session_id, const std::string& chunk, std::atomic<bool>& tts_stream_ok,
+                             const common::TurnRegistry::Turn& turn);
 
     void handle_openai_completion(
         const std::string& session_id,
@@ -64,7 +64,8 @@ std::string OpenAIClient::extract_content_from_sse(const std::string& sse_line)
 void OpenAIClient::StreamChatCompletion(
     const std::vector<ChatMessage>& messages,
     const OpenAIChunkCallback& chunk_callback,
-    const OpenAICompletionCallback& completion_callback)
+    const OpenAICompletionCallback& completion_callback,
+    std::shared_ptr<const std::atomic<bool>> cancel_flag)
 {
     if (!chunk_callback || !completion_callback) {
          throw std::runtime_error("OpenAI callbacks cannot be null.");
@@ -73,13 +74,18 @@ void OpenAIClient::StreamChatCompletion(
     json payload = build_request_json(messages);
     std::string payload_str = payload.dump();
 
-    std::thread([this, payload_str, chunk_callback, completion_callback]() {
+    std::thread([this, payload_str, chunk_callback, completion_callback, cancel_flag]() {
         std::string accumulated_sse_data;
         bool stream_successful = true;
         std::string error_msg;
 
         try {
+             auto is_cancelled = [&cancel_flag]() { return cancel_flag && cancel_flag->load(); };
+
              auto write_callback = [&](std::string data, intptr_t) -> bool {
+                if (is_cancelled()) {
+                    return false; // false 반환 시 cpr/curl이 전송을 중단함
+                }
                 accumulated_sse_data += data;
                 size_t pos;
                 while ((pos = accumulated_sse_data.find("\n\n")) != std::string::npos) {
@@ -108,6 +114,10 @@ void OpenAIClient::StreamChatCompletion(
                 }
                 return true; 
             };
+            // 첫 토큰 도착 전(TTFT 구간)에도 취소가 바로 반영되도록 progress 콜백에서도 확인
+            auto progress_callback = [&](auto, auto, auto, auto, intptr_t) -> bool {
+                return !is_cancelled();
+            };
 
             std::cout << "   Sending request to OpenAI..." << std::endl;
             auto response = cpr::Post(
@@ -116,12 +126,17 @@ void OpenAIClient::StreamChatCompletion(
                             {"Content-Type", "application/json"},
                             {"Accept", "text/event-stream"}},
                 cpr::Body{payload_str},
-                cpr::WriteCallback{write_callback}
+                cpr::WriteCallback{write_callback},
+                cpr::ProgressCallback{progress_callback}
             );
 
              std::cout << "   OpenAI request finished. Status: " << response.status_code << std::endl;
 
-            if (response.status_code < 200 || response.status_code >= 300) {
+            if (is_cancelled()) {
+                stream_successful = false;
+                error_msg = "OpenAI request cancelled.";
+                std::cout << "ℹ️ " << error_msg << std::endl;
+            } else if (response.status_code < 200 || response.status_code >= 300) {
                 stream_successful = false;
                 error_msg = "OpenAI API Error: HTTP " + std::to_string(response.status_code) + " - " + response.error.message + " Body: " + response.text;
                 std::cerr << "❌ " << error_msg << std::endl;
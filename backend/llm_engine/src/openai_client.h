@@ -4,6 +4,7 @@
 #include <functional>
 #include <memory>
 #include <vector>
+#include <atomic>
 #include <nlohmann/json.hpp>
 
 namespace llm_engine {
@@ -30,10 +31,13 @@ public:
     // Starts a streaming chat completion request
     // Takes the conversation history and callbacks
     // This function would likely run asynchronously or manage an async task
+    // If cancel_flag is set to true while streaming, the HTTP transfer is aborted
+    // and completion_callback is invoked with success=false.
     void StreamChatCompletion(
         const std::vector<ChatMessage>& messages,
         const OpenAIChunkCallback& chunk_callback,
-        const OpenAICompletionCallback& completion_callback);
+        const OpenAICompletionCallback& completion_callback,
+        std::shared_ptr<const std::atomic<bool>> cancel_flag = nullptr);
 
     // Potentially add a method to signal the end of input if needed,
     // though typically chat completion takes the full history at once.
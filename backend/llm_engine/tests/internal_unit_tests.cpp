@@ -10,6 +10,7 @@
 
 #include "tts_client.h"
 #include "tts.grpc.pb.h"
+#include "turn_registry.h"
 
 // 네임스페이스 사용
 using namespace llm_engine;
@@ -21,6 +22,11 @@ class MockTTSStub : public tts::TTSService::StubInterface {
     // === 추가 필요한 Mock 메서드 정의 ===
     MOCK_METHOD(grpc::ClientAsyncWriterInterface<tts::TTSStreamRequest>*, AsyncSynthesizeStreamRaw, (grpc::ClientContext* context, google::protobuf::Empty* response, grpc::CompletionQueue* cq, void* tag), (override));
     MOCK_METHOD(grpc::ClientAsyncWriterInterface<tts::TTSStreamRequest>*, PrepareAsyncSynthesizeStreamRaw, (grpc::ClientContext* context, google::protobuf::Empty* response, grpc::CompletionQueue* cq), (override));
+
+    // CancelTurn (unary)
+    MOCK_METHOD(grpc::Status, CancelTurn, (grpc::ClientContext* context, const tts::CancelTurnRequest& request, google::protobuf::Empty* response), (override));
+    MOCK_METHOD(grpc::ClientAsyncResponseReaderInterface<google::protobuf::Empty>*, AsyncCancelTurnRaw, (grpc::ClientContext* context, const tts::CancelTurnRequest& request, grpc::CompletionQueue* cq), (override));
+    MOCK_METHOD(grpc::ClientAsyncResponseReaderInterface<google::protobuf::Empty>*, PrepareAsyncCancelTurnRaw, (grpc::ClientContext* context, const tts::CancelTurnRequest& request, grpc::CompletionQueue* cq), (override));
 };
 // ===== End Mock Stub Definition =====
 
@@ -83,9 +89,64 @@ TEST_F(TTSClientTest, InitialStreamState) {
 TEST_F(TTSClientTest, StartStreamParameterValidation) {
      // 성공 케이스는 Mocking 필요 - 여기서는 인자 유효성만 체크
      // 실패 케이스 (빈 인자)
-     EXPECT_FALSE(client_with_mock_->StartStream("", "ko-KR", "voice")); // 빈 세션 ID
-     EXPECT_FALSE(client_with_mock_->StartStream("session1", "", "voice")); // 빈 언어 코드
+     tts::SynthesisConfig config;
+     config.set_frontend_session_id("");
+     config.set_language_code("ko-KR");
+     config.set_voice_name("voice");
+     EXPECT_FALSE(client_with_mock_->StartStream(config)); // 빈 세션 ID
+
+     config.set_frontend_session_id("session1");
+     config.set_language_code("");
+     EXPECT_FALSE(client_with_mock_->StartStream(config)); // 빈 언어 코드
+
+     config.set_language_code("ko-KR");
+     config.set_voice_name("");
+     EXPECT_FALSE(client_with_mock_->StartStream(config)); // 빈 음성 이름
+     EXPECT_FALSE(client_with_mock_->IsStreamActive());
+}
+
+// ----- TurnRegistry (barge-in) -----
+
+// 이전 턴만 취소되고 새 턴은 유지되는지 확인
+TEST(TurnRegistryTest, CancelBeforeOnlyCancelsOlderTurns) {
+    common::TurnRegistry registry;
+    auto old_turn = registry.Register("fe1", 1);
+    auto new_turn = registry.Register("fe1", 2);
+    auto other_session = registry.Register("fe2", 1);
+
+    EXPECT_EQ(registry.CancelBefore("fe1", 2), 1u);
+    EXPECT_TRUE(old_turn->cancelled.load());
+    EXPECT_FALSE(new_turn->cancelled.load());
+    EXPECT_FALSE(other_session->cancelled.load());
+}
+
+// 취소 요청이 턴 등록보다 먼저 도착해도 해당 턴은 취소 상태로 시작
+TEST(TurnRegistryTest, LateRegisteredTurnIsCancelled) {
+    common::TurnRegistry registry;
+    EXPECT_EQ(registry.CancelBefore("fe1", 3), 0u);
+    EXPECT_TRUE(registry.Register("fe1", 2)->cancelled.load());
+    EXPECT_FALSE(registry.Register("fe1", 3)->cancelled.load());
+}
+
+// shared_ptr이 해제되면 활성 턴에서 빠짐
+TEST(TurnRegistryTest, ReleasedTurnIsNotActive) {
+    common::TurnRegistry registry;
+    {
+        auto turn = registry.Register("fe1", 1);
+        EXPECT_EQ(registry.ActiveCount(), 1u);
+    }
+    EXPECT_EQ(registry.ActiveCount(), 0u);
+}
 
-     // voice_name은 선택적일 수 있으므로 빈 값 테스트는 제외 가능
-     // EXPECT_FALSE(client_with_mock_->StartStream("session1", "ko-KR", ""));
+// 해제된 턴 정리는 세션 단위: 한 세션의 턴이 끝나도 워터마크와 다른 세션의 턴은 그대로
+TEST(TurnRegistryTest, ReleasedTurnsArePrunedPerSession) {
+    common::TurnRegistry registry;
+    auto other_session = registry.Register("fe2", 1);
+    registry.Register("fe1", 1).reset();
+    EXPECT_EQ(registry.CancelBefore("fe1", 5), 0u); // fe1의 해제된 턴은 취소 대상이 아님
+    EXPECT_EQ(registry.CancelBefore("fe1", 0), 0u);
+    EXPECT_TRUE(registry.Register("fe1", 4)->cancelled.load()); // 세션 전체 취소 후에도 워터마크 유지
+    EXPECT_EQ(registry.ActiveCount(), 1u);
+    EXPECT_EQ(registry.CancelBefore("fe2", 0), 1u);
+    EXPECT_TRUE(other_session->cancelled.load());
 }
@@ -0,0 +1,282 @@
+#include "audio_converter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STT_AUDIO_X86 1
+#endif
+
+namespace stt {
+
+namespace {
+
+constexpr float kInt16Scale = 1.0f / 32768.0f;
+constexpr double kPi = 3.14159265358979323846;
+
+float DotScalar(const float* a, const float* b, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+#ifdef STT_AUDIO_X86
+// n은 8의 배수 (taps_per_phase_)
+float DotSse(const float* a, const float* b, size_t n) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (size_t i = 0; i < n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    __m128 acc = _mm_add_ps(acc0, acc1);
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 0x55));
+    return _mm_cvtss_f32(acc);
+}
+
+__attribute__((target("avx2,fma")))
+float DotAvx2(const float* a, const float* b, size_t n) {
+    __m256 acc = _mm256_setzero_ps();
+    for (size_t i = 0; i < n; i += 8) {
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc);
+    }
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 0x55));
+    return _mm_cvtss_f32(sum);
+}
+
+// 다운믹스는 메모리 대역폭이 병목이라 SSE2(x86-64 기본)로 충분. 처리한 프레임 수 반환 (나머지는 스칼라)
+size_t DownmixInt16Sse(const uint8_t* src, size_t frames, uint32_t channels, float* dst) {
+    const __m128 scale = _mm_set1_ps(channels == 2 ? kInt16Scale * 0.5f : kInt16Scale);
+    size_t i = 0;
+    if (channels == 1) {
+        for (; i + 8 <= frames; i += 8) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+            const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16); // 부호 확장
+            const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+            _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+        }
+    } else if (channels == 2) {
+        for (; i + 4 <= frames; i += 4) {
+            // 32비트 레인 하나 = (L, R) 한 프레임
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+            const __m128i left = _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+            const __m128i right = _mm_srai_epi32(v, 16);
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(left, right)), scale));
+        }
+    }
+    return i;
+}
+
+size_t DownmixFloat32Sse(const uint8_t* src, size_t frames, uint32_t channels, float* dst) {
+    size_t i = 0;
+    if (channels == 1) {
+        for (; i + 4 <= frames; i += 4) {
+            _mm_storeu_ps(dst + i, _mm_loadu_ps(reinterpret_cast<const float*>(src) + i));
+        }
+    } else if (channels == 2) {
+        const __m128 half = _mm_set1_ps(0.5f);
+        const float* in = reinterpret_cast<const float*>(src);
+        for (; i + 4 <= frames; i += 4) {
+            const __m128 a = _mm_loadu_ps(in + i * 2);     // L0 R0 L1 R1
+            const __m128 b = _mm_loadu_ps(in + i * 2 + 4); // L2 R2 L3 R3
+            const __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+        }
+    }
+    return i;
+}
+#endif
+
+void DownmixScalar(const uint8_t* src, size_t frames, const AudioFormat& format, float* dst) {
+    const uint32_t channels = format.channels;
+    const float channel_scale = 1.0f / static_cast<float>(channels);
+    for (size_t i = 0; i < frames; ++i) {
+        float sum = 0.0f;
+        for (uint32_t c = 0; c < channels; ++c) {
+            if (format.sample_format == AudioFormat::SampleFormat::kFloat32) {
+                float sample;
+                std::memcpy(&sample, src + (i * channels + c) * 4, sizeof(sample));
+                sum += sample;
+            } else {
+                int16_t sample;
+                std::memcpy(&sample, src + (i * channels + c) * 2, sizeof(sample));
+                sum += static_cast<float>(sample) * kInt16Scale;
+            }
+        }
+        dst[i] = sum * channel_scale;
+    }
+}
+
+int16_t ToInt16(float sample) {
+    const float scaled = std::nearbyint(sample * 32768.0f);
+    return static_cast<int16_t>(std::clamp(scaled, -32768.0f, 32767.0f));
+}
+
+} // namespace
+
+std::string AudioFormat::ToString() const {
+    std::ostringstream ss;
+    ss << sample_rate_hz << "Hz/" << channels << "ch/" << (sample_format == SampleFormat::kFloat32 ? "f32" : "s16");
+    return ss.str();
+}
+
+std::string AudioConverter::Validate(const AudioFormat& format) {
+    if (format.sample_rate_hz < 8000 || format.sample_rate_hz > 192000) {
+        return "Unsupported sample rate " + std::to_string(format.sample_rate_hz) + " Hz (8000-192000).";
+    }
+    if (format.channels < 1 || format.channels > 8) {
+        return "Unsupported channel count " + std::to_string(format.channels) + " (1-8).";
+    }
+    return "";
+}
+
+AudioConverter::Simd AudioConverter::DetectSimd() {
+#ifdef STT_AUDIO_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return Simd::kAvx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return Simd::kSse;
+    }
+#endif
+    return Simd::kScalar;
+}
+
+const char* AudioConverter::SimdName(Simd simd) {
+    switch (simd) {
+        case Simd::kAvx2: return "avx2";
+        case Simd::kSse: return "sse";
+        case Simd::kScalar: break;
+    }
+    return "scalar";
+}
+
+AudioConverter::AudioConverter(const AudioFormat& format, Simd simd)
+    : format_(format), simd_(simd) {
+    const std::string error = Validate(format_);
+    if (!error.empty()) {
+        throw std::runtime_error(error);
+    }
+#ifndef STT_AUDIO_X86
+    simd_ = Simd::kScalar;
+#endif
+    passthrough_ = format_.sample_rate_hz == kOutputSampleRateHz && format_.channels == 1 &&
+                   format_.sample_format == AudioFormat::SampleFormat::kInt16;
+
+    const uint32_t g = std::gcd(format_.sample_rate_hz, kOutputSampleRateHz);
+    up_ = kOutputSampleRateHz / g;
+    down_ = format_.sample_rate_hz / g;
+    resample_ = up_ != down_;
+    if (!resample_) {
+        return;
+    }
+
+    dot_ = DotScalar;
+#ifdef STT_AUDIO_X86
+    if (simd_ == Simd::kAvx2) {
+        dot_ = DotAvx2;
+    } else if (simd_ == Simd::kSse) {
+        dot_ = DotSse;
+    }
+#endif
+
+    // 폴리페이즈 필터: 업샘플 도메인(L * fs_in)에서 설계한 Blackman 윈도우 sinc를 위상별로 나눔.
+    // 차단 주파수는 입출력 중 낮은 나이퀴스트의 90%. 데시메이션 비율이 클수록 탭을 늘려 전이 대역 유지
+    taps_per_phase_ = 16 * std::max<size_t>(1, (down_ + up_ - 1) / up_);
+    const size_t length = static_cast<size_t>(up_) * taps_per_phase_;
+    const double upsampled_rate = static_cast<double>(up_) * format_.sample_rate_hz;
+    const double cutoff = 0.45 * std::min(format_.sample_rate_hz, kOutputSampleRateHz) / upsampled_rate; // cycles/sample
+    const double center = (static_cast<double>(length) - 1.0) / 2.0;
+    std::vector<double> prototype(length);
+    for (size_t j = 0; j < length; ++j) {
+        const double t = static_cast<double>(j) - center;
+        const double sinc = t == 0.0 ? 1.0 : std::sin(2.0 * kPi * cutoff * t) / (2.0 * kPi * cutoff * t);
+        const double window = 0.42 - 0.5 * std::cos(2.0 * kPi * j / (length - 1)) + 0.08 * std::cos(4.0 * kPi * j / (length - 1));
+        prototype[j] = sinc * window;
+    }
+    coefficients_.assign(length, 0.0f);
+    for (uint32_t p = 0; p < up_; ++p) {
+        double gain = 0.0;
+        for (size_t k = 0; k < taps_per_phase_; ++k) {
+            gain += prototype[p + k * up_];
+        }
+        // 위상마다 DC 이득 1로 정규화 (위상 간 리플 제거)
+        for (size_t k = 0; k < taps_per_phase_; ++k) {
+            coefficients_[p * taps_per_phase_ + (taps_per_phase_ - 1 - k)] = static_cast<float>(prototype[p + k * up_] / gain);
+        }
+    }
+    history_.assign(taps_per_phase_ - 1, 0.0f);
+    next_input_ = taps_per_phase_ - 1;
+}
+
+void AudioConverter::Downmix(const uint8_t* frames, size_t frame_count) {
+    const size_t base = history_.size();
+    history_.resize(base + frame_count);
+    float* dst = history_.data() + base;
+    size_t done = 0;
+#ifdef STT_AUDIO_X86
+    if (simd_ != Simd::kScalar) {
+        done = format_.sample_format == AudioFormat::SampleFormat::kFloat32
+                   ? DownmixFloat32Sse(frames, frame_count, format_.channels, dst)
+                   : DownmixInt16Sse(frames, frame_count, format_.channels, dst);
+    }
+#endif
+    DownmixScalar(frames + done * format_.bytes_per_frame(), frame_count - done, format_, dst + done);
+}
+
+void AudioConverter::Resample(std::vector<int16_t>& out) {
+    if (!resample_) {
+        out.reserve(out.size() + history_.size());
+        for (float sample : history_) {
+            out.push_back(ToInt16(sample));
+        }
+        history_.clear();
+        return;
+    }
+    const size_t span = taps_per_phase_ - 1;
+    while (next_input_ < history_.size()) {
+        out.push_back(ToInt16(dot_(history_.data() + next_input_ - span, coefficients_.data() + phase_ * taps_per_phase_, taps_per_phase_)));
+        phase_ += down_;
+        next_input_ += phase_ / up_;
+        phase_ %= up_;
+    }
+    // 다음 출력에 필요한 이력만 남김
+    const size_t drop = std::min(next_input_ - span, history_.size());
+    history_.erase(history_.begin(), history_.begin() + static_cast<std::ptrdiff_t>(drop));
+    next_input_ -= drop;
+}
+
+void AudioConverter::Convert(const uint8_t* data, size_t size, std::vector<int16_t>& out) {
+    const size_t frame_bytes = format_.bytes_per_frame();
+    if (!partial_frame_.empty()) {
+        const size_t take = std::min(frame_bytes - partial_frame_.size(), size);
+        partial_frame_.insert(partial_frame_.end(), data, data + take);
+        data += take;
+        size -= take;
+        if (partial_frame_.size() < frame_bytes) {
+            return;
+        }
+        Downmix(partial_frame_.data(), 1);
+        partial_frame_.clear();
+    }
+    const size_t frames = size / frame_bytes;
+    if (frames > 0) {
+        Downmix(data, frames);
+    }
+    partial_frame_.assign(data + frames * frame_bytes, data + size);
+    Resample(out);
+}
+
+} // namespace stt
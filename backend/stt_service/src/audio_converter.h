@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace stt {
+
+// 클라이언트가 RecognitionConfig로 선언한 입력 오디오 형식
+struct AudioFormat {
+    enum class SampleFormat { kInt16, kFloat32 };
+
+    uint32_t sample_rate_hz = 16000;
+    uint32_t channels = 1;
+    SampleFormat sample_format = SampleFormat::kInt16;
+
+    size_t bytes_per_frame() const { return channels * (sample_format == SampleFormat::kFloat32 ? 4 : 2); }
+    std::string ToString() const;
+};
+
+// 입력 오디오를 인식 엔진 입력 형식(16kHz 16-bit mono PCM)으로 실시간 변환.
+// 다운믹스(채널 평균) -> 폴리페이즈 윈도우 sinc 리샘플러(유리수 비율 L/M) -> int16.
+// 내적/다운믹스는 AVX2 또는 SSE로 벡터화하고, x86이 아니면 스칼라로 처리한다 (CPU 기능은 런타임 감지).
+// 청크 경계에 걸친 프레임과 필터 이력은 내부에 보관하므로 스트림 하나당 인스턴스 하나. 스레드 안전하지 않음
+class AudioConverter {
+public:
+    enum class Simd { kScalar, kSse, kAvx2 };
+
+    static constexpr uint32_t kOutputSampleRateHz = 16000;
+
+    // 지원 범위를 벗어나면 오류 메시지, 아니면 빈 문자열
+    static std::string Validate(const AudioFormat& format);
+    // 이 CPU에서 쓸 수 있는 가장 넓은 명령어 집합
+    static Simd DetectSimd();
+    static const char* SimdName(Simd simd);
+
+    // 형식이 유효하지 않으면 std::runtime_error (먼저 Validate로 확인할 것)
+    explicit AudioConverter(const AudioFormat& format, Simd simd = DetectSimd());
+
+    // 16kHz mono int16 입력이면 변환 없이 그대로 전달하면 됨
+    bool passthrough() const { return passthrough_; }
+    Simd simd() const { return simd_; }
+
+    // data를 변환해 out 뒤에 덧붙인다. 프레임 단위가 아닌 나머지 바이트는 다음 호출로 이월
+    void Convert(const uint8_t* data, size_t size, std::vector<int16_t>& out);
+
+private:
+    using DotFn = float (*)(const float* a, const float* b, size_t n);
+
+    void Downmix(const uint8_t* frames, size_t frame_count);
+    void Resample(std::vector<int16_t>& out);
+
+    AudioFormat format_;
+    Simd simd_;
+    bool passthrough_ = false;
+
+    uint32_t up_ = 1;   // L
+    uint32_t down_ = 1; // M
+    bool resample_ = false;
+    size_t taps_per_phase_ = 0;       // 데시메이션 비율에 비례, SIMD 폭(8)의 배수
+    std::vector<float> coefficients_; // 위상별 taps_per_phase_개, 입력 순서대로 뒤집어 저장
+    DotFn dot_ = nullptr;
+
+    std::vector<uint8_t> partial_frame_; // 청크 경계에 걸친 프레임 조각
+    std::vector<float> history_;         // 다운믹스된 mono 입력 (앞쪽 taps_per_phase_-1개는 필터 이력)
+    size_t next_input_ = 0;              // 다음 출력이 참조할 history_ 위치
+    uint32_t phase_ = 0;                 // 다음 출력의 위상 (0 <= phase_ < up_)
+};
+
+} // namespace stt
@@ -0,0 +1,360 @@
+#include "audio_preprocessor.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define STT_AUDIO_X86 1
+#endif
+
+namespace stt {
+
+namespace {
+
+constexpr float kInt16Scale = 1.0f / 32768.0f;
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kSilenceDbfs = -120.0;         // 완전한 무음 블록의 레벨
+constexpr double kAgcMinLevelDbfs = -60.0;      // 게이트가 꺼져 있을 때 이보다 조용한 블록으로는 AGC를 조정하지 않음
+constexpr double kAgcAttack = 0.5;              // 이득을 줄일 때 블록마다 목표까지 남은 차이의 비율
+constexpr double kAgcReleaseDbPerSec = 6.0;     // 이득을 올리는 최대 속도 (숨소리/잡음 펌핑 방지)
+constexpr double kLimiterReleaseDbPerSec = 20.0;
+
+double DbToLinear(double db) { return std::pow(10.0, db / 20.0); }
+
+uint32_t BlockMs(size_t n) { return static_cast<uint32_t>(n * 1000 / AudioPreprocessor::kSampleRateHz); }
+
+void ToFloatScalar(const int16_t* src, float* dst, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] = static_cast<float>(src[i]) * kInt16Scale;
+    }
+}
+
+void ToInt16Scalar(const float* src, int16_t* dst, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        const float scaled = std::nearbyint(src[i] * 32768.0f);
+        dst[i] = static_cast<int16_t>(std::clamp(scaled, -32768.0f, 32767.0f));
+    }
+}
+
+float SumSquaresScalar(const float* x, size_t n) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        sum += x[i] * x[i];
+    }
+    return sum;
+}
+
+float PeakAbsScalar(const float* x, size_t n) {
+    float peak = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        peak = std::max(peak, std::fabs(x[i]));
+    }
+    return peak;
+}
+
+void GainRampScalar(float* x, size_t n, float start, float step) {
+    for (size_t i = 0; i < n; ++i) {
+        x[i] *= start + step * static_cast<float>(i);
+    }
+}
+
+#ifdef STT_AUDIO_X86
+// 변환은 메모리 대역폭이 병목이라 SSE2(x86-64 기본)로 충분. 나머지는 스칼라
+void ToFloatSse(const int16_t* src, float* dst, size_t n) {
+    const __m128 scale = _mm_set1_ps(kInt16Scale);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16); // 부호 확장
+        const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(dst + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    ToFloatScalar(src + i, dst + i, n - i);
+}
+
+void ToInt16Sse(const float* src, int16_t* dst, size_t n) {
+    const __m128 scale = _mm_set1_ps(32768.0f);
+    const __m128 lo_limit = _mm_set1_ps(-32768.0f);
+    const __m128 hi_limit = _mm_set1_ps(32767.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        // cvtps는 기본 반올림 모드(가장 가까운 짝수)라 nearbyint와 같음. 범위 밖 값은 먼저 잘라 둠
+        const __m128 a = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i), scale), lo_limit), hi_limit);
+        const __m128 b = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(src + i + 4), scale), lo_limit), hi_limit);
+        const __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), packed);
+    }
+    ToInt16Scalar(src + i, dst + i, n - i);
+}
+
+float HorizontalSum(__m128 v) {
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 0x55));
+    return _mm_cvtss_f32(v);
+}
+
+float HorizontalMax(__m128 v) {
+    v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 0x55));
+    return _mm_cvtss_f32(v);
+}
+
+float SumSquaresSse(const float* x, size_t n) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m128 a = _mm_loadu_ps(x + i);
+        const __m128 b = _mm_loadu_ps(x + i + 4);
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(a, a));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(b, b));
+    }
+    return HorizontalSum(_mm_add_ps(acc0, acc1)) + SumSquaresScalar(x + i, n - i);
+}
+
+float PeakAbsSse(const float* x, size_t n) {
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 peak = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        peak = _mm_max_ps(peak, _mm_and_ps(_mm_loadu_ps(x + i), abs_mask));
+    }
+    return std::max(HorizontalMax(peak), PeakAbsScalar(x + i, n - i));
+}
+
+void GainRampSse(float* x, size_t n, float start, float step) {
+    __m128 gain = _mm_add_ps(_mm_set1_ps(start), _mm_mul_ps(_mm_set1_ps(step), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f)));
+    const __m128 advance = _mm_set1_ps(step * 4.0f);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm_storeu_ps(x + i, _mm_mul_ps(_mm_loadu_ps(x + i), gain));
+        gain = _mm_add_ps(gain, advance);
+    }
+    GainRampScalar(x + i, n - i, start + step * static_cast<float>(i), step);
+}
+
+__attribute__((target("avx2,fma")))
+float SumSquaresAvx2(const float* x, size_t n) {
+    __m256 acc = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 v = _mm256_loadu_ps(x + i);
+        acc = _mm256_fmadd_ps(v, v, acc);
+    }
+    const __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    return HorizontalSum(sum) + SumSquaresScalar(x + i, n - i);
+}
+
+__attribute__((target("avx2,fma")))
+float PeakAbsAvx2(const float* x, size_t n) {
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 peak = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        peak = _mm256_max_ps(peak, _mm256_and_ps(_mm256_loadu_ps(x + i), abs_mask));
+    }
+    const __m128 half = _mm_max_ps(_mm256_castps256_ps128(peak), _mm256_extractf128_ps(peak, 1));
+    return std::max(HorizontalMax(half), PeakAbsScalar(x + i, n - i));
+}
+
+__attribute__((target("avx2,fma")))
+void GainRampAvx2(float* x, size_t n, float start, float step) {
+    __m256 gain = _mm256_fmadd_ps(_mm256_set1_ps(step), _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f),
+                                  _mm256_set1_ps(start));
+    const __m256 advance = _mm256_set1_ps(step * 8.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(_mm256_loadu_ps(x + i), gain));
+        gain = _mm256_add_ps(gain, advance);
+    }
+    GainRampScalar(x + i, n - i, start + step * static_cast<float>(i), step);
+}
+#endif
+
+// 구간 시간을 누적 (단계별 CPU 비용)
+class StageTimer {
+public:
+    explicit StageTimer(uint64_t& total_ns) : total_ns_(total_ns), start_(std::chrono::steady_clock::now()) {}
+    ~StageTimer() {
+        total_ns_ += static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count());
+    }
+
+private:
+    uint64_t& total_ns_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace
+
+void AudioPreprocessor::Stats::Add(const Stats& other) {
+    blocks += other.blocks;
+    samples += other.samples;
+    convert_ns += other.convert_ns;
+    high_pass_ns += other.high_pass_ns;
+    gate_ns += other.gate_ns;
+    agc_ns += other.agc_ns;
+    gated_blocks += other.gated_blocks;
+    limited_blocks += other.limited_blocks;
+}
+
+AudioPreprocessor::AudioPreprocessor(const AudioPreprocessorConfig& config, Simd simd)
+    : config_(config), simd_(simd) {
+    if (config_.high_pass && (config_.high_pass_hz <= 0.0 || config_.high_pass_hz >= kSampleRateHz / 4.0)) {
+        throw std::runtime_error("High-pass cutoff must be in (0, " + std::to_string(kSampleRateHz / 4) + ") Hz.");
+    }
+    if (config_.noise_gate && config_.gate_attenuation_db > 0.0) {
+        throw std::runtime_error("Noise gate attenuation must be <= 0 dB.");
+    }
+    if (config_.agc && (config_.agc_min_gain_db > config_.agc_max_gain_db || config_.limiter_ceiling_dbfs > 0.0)) {
+        throw std::runtime_error("AGC gain range must be ordered and limiter ceiling must be <= 0 dBFS.");
+    }
+#ifndef STT_AUDIO_X86
+    simd_ = Simd::kScalar;
+#endif
+
+    kernels_ = {ToFloatScalar, ToInt16Scalar, SumSquaresScalar, PeakAbsScalar, GainRampScalar};
+#ifdef STT_AUDIO_X86
+    if (simd_ == Simd::kAvx2) {
+        kernels_ = {ToFloatSse, ToInt16Sse, SumSquaresAvx2, PeakAbsAvx2, GainRampAvx2};
+    } else if (simd_ == Simd::kSse) {
+        kernels_ = {ToFloatSse, ToInt16Sse, SumSquaresSse, PeakAbsSse, GainRampSse};
+    }
+#endif
+
+    if (config_.high_pass) {
+        // RBJ 고역 통과 biquad (Q = 1/√2, Butterworth)
+        const double w0 = 2.0 * kPi * config_.high_pass_hz / kSampleRateHz;
+        const double alpha = std::sin(w0) / std::sqrt(2.0);
+        const double cos_w0 = std::cos(w0);
+        const double a0 = 1.0 + alpha;
+        b0_ = (1.0 + cos_w0) / 2.0 / a0;
+        b1_ = -(1.0 + cos_w0) / a0;
+        b2_ = b0_;
+        a1_ = -2.0 * cos_w0 / a0;
+        a2_ = (1.0 - alpha) / a0;
+    }
+    // 세션은 대개 무음으로 시작하므로 게이트는 닫힌 상태에서 출발 (첫 발화 블록에서 열리며 직선으로 올라감)
+    gate_gain_ = config_.noise_gate ? static_cast<float>(DbToLinear(config_.gate_attenuation_db)) : 1.0f;
+}
+
+void AudioPreprocessor::Process(int16_t* samples, size_t count) {
+    if (count == 0) {
+        return;
+    }
+    scratch_.resize(count);
+    float* x = scratch_.data();
+    {
+        StageTimer timer(stats_.convert_ns);
+        kernels_.to_float(samples, x, count);
+    }
+    if (config_.high_pass) {
+        StageTimer timer(stats_.high_pass_ns);
+        HighPass(x, count);
+    }
+    // 게이트/AGC 판단은 고역 통과 뒤, 이득 적용 전 입력 레벨 기준 (AGC가 키운 잡음으로 게이트가 열리지 않도록)
+    double level_dbfs = 0.0;
+    if (config_.noise_gate) {
+        StageTimer timer(stats_.gate_ns);
+        level_dbfs = MeasureLevelDbfs(x, count);
+        Gate(x, count, level_dbfs);
+    }
+    if (config_.agc) {
+        StageTimer timer(stats_.agc_ns);
+        if (!config_.noise_gate) {
+            level_dbfs = MeasureLevelDbfs(x, count);
+        }
+        Agc(x, count, level_dbfs);
+    }
+    {
+        StageTimer timer(stats_.convert_ns);
+        kernels_.to_int16(x, samples, count);
+    }
+    stats_.blocks++;
+    stats_.samples += count;
+}
+
+double AudioPreprocessor::MeasureLevelDbfs(const float* x, size_t n) const {
+    const double mean_square = static_cast<double>(kernels_.sum_squares(x, n)) / static_cast<double>(n);
+    return mean_square > 0.0 ? std::max(kSilenceDbfs, 10.0 * std::log10(mean_square)) : kSilenceDbfs;
+}
+
+void AudioPreprocessor::HighPass(float* x, size_t n) {
+    // 재귀 필터라 샘플 간 의존성이 있어 벡터화하지 않음 (블록당 640샘플, 5 곱셈/샘플)
+    double z1 = z1_, z2 = z2_;
+    for (size_t i = 0; i < n; ++i) {
+        const double in = x[i];
+        const double out = b0_ * in + z1;
+        z1 = b1_ * in - a1_ * out + z2;
+        z2 = b2_ * in - a2_ * out;
+        x[i] = static_cast<float>(out);
+    }
+    z1_ = z1;
+    z2_ = z2;
+}
+
+void AudioPreprocessor::Gate(float* x, size_t n, double level_dbfs) {
+    if (level_dbfs >= config_.gate_threshold_dbfs) {
+        gate_open_ = true;
+        gate_below_ms_ = 0;
+    } else if (gate_open_) {
+        // 단어 사이 짧은 쉼에서 닫히지 않도록 hold 동안은 열린 채로 유지
+        gate_below_ms_ += BlockMs(n);
+        if (gate_below_ms_ > config_.gate_hold_ms) {
+            gate_open_ = false;
+        }
+    }
+    const float target = gate_open_ ? 1.0f : static_cast<float>(DbToLinear(config_.gate_attenuation_db));
+    ApplyGain(x, n, gate_gain_, target);
+    gate_gain_ = target;
+    if (!gate_open_) {
+        stats_.gated_blocks++;
+    }
+}
+
+void AudioPreprocessor::Agc(float* x, size_t n, double level_dbfs) {
+    const double block_sec = static_cast<double>(n) / kSampleRateHz;
+    // 음성 구간에서만 이득을 조정하고 무음/게이트 구간에서는 유지 (잡음을 끌어올리지 않음)
+    const bool speech = config_.noise_gate ? gate_open_ && level_dbfs >= config_.gate_threshold_dbfs : level_dbfs >= kAgcMinLevelDbfs;
+    if (speech) {
+        const double desired = std::clamp(config_.agc_target_dbfs - level_dbfs, config_.agc_min_gain_db, config_.agc_max_gain_db);
+        if (desired < agc_gain_db_) {
+            agc_gain_db_ += (desired - agc_gain_db_) * kAgcAttack;
+        } else {
+            agc_gain_db_ = std::min(desired, agc_gain_db_ + kAgcReleaseDbPerSec * block_sec);
+        }
+    }
+    const float gain = static_cast<float>(DbToLinear(agc_gain_db_));
+    ApplyGain(x, n, agc_gain_, gain);
+    agc_gain_ = gain;
+
+    // 리미터: 블록 피크가 천장을 넘으면 그 블록 전체에 즉시 이득 감소, 풀 때는 천천히 (블록 내 직선 보간)
+    const float ceiling = static_cast<float>(DbToLinear(config_.limiter_ceiling_dbfs));
+    const float peak = kernels_.peak_abs(x, n);
+    const float released = std::min(1.0f, limiter_gain_ * static_cast<float>(DbToLinear(kLimiterReleaseDbPerSec * block_sec)));
+    const float allowed = peak > 0.0f ? ceiling / peak : 1.0f;
+    const float target = std::min(released, allowed);
+    if (allowed < released) {
+        stats_.limited_blocks++;
+    }
+    if (target < limiter_gain_) {
+        ApplyGain(x, n, target, target); // 공격: 블록 안의 어느 피크도 천장을 넘지 않게 상수 이득
+    } else {
+        ApplyGain(x, n, limiter_gain_, target); // 해제: limiter_gain_ <= target <= allowed 이므로 보간해도 천장 이하
+    }
+    limiter_gain_ = target;
+}
+
+void AudioPreprocessor::ApplyGain(float* x, size_t n, float from, float to) const {
+    if (from == 1.0f && to == 1.0f) {
+        return;
+    }
+    const float step = n > 1 ? (to - from) / static_cast<float>(n - 1) : 0.0f;
+    kernels_.gain_ramp(x, n, from, step);
+}
+
+} // namespace stt
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "audio_converter.h" // AudioConverter::Simd
+
+namespace stt {
+
+// 인식 엔진 입력 전처리 설정. 단계별로 끌 수 있고, 전체가 꺼져 있으면 세션에 전처리기를 만들지 않는다
+struct AudioPreprocessorConfig {
+    bool enabled = false;
+
+    bool high_pass = true;               // DC/저주파 험 제거 (2차 Butterworth 고역 통과)
+    double high_pass_hz = 80.0;
+
+    bool noise_gate = true;              // 블록 레벨이 임계값 아래로 hold_ms 넘게 머물면 감쇠
+    double gate_threshold_dbfs = -55.0;
+    double gate_attenuation_db = -20.0;
+    uint32_t gate_hold_ms = 200;
+
+    bool agc = true;                     // 음성 블록 RMS를 목표 레벨로 맞춤 + 피크 리미터
+    double agc_target_dbfs = -20.0;
+    double agc_max_gain_db = 24.0;
+    double agc_min_gain_db = -12.0;
+    double limiter_ceiling_dbfs = -1.0;
+};
+
+// 16kHz mono int16 블록을 제자리에서 처리: 고역 통과 -> 노이즈 게이트 -> AGC + 리미터.
+// 이득은 블록 경계에서 바뀌고 블록 안에서는 직선으로 이어 붙여 클릭이 생기지 않게 한다.
+// int16<->float 변환, 레벨/피크 측정, 이득 곱은 SSE/AVX2로 벡터화하고 (AudioConverter와 같은 런타임 감지),
+// 재귀 필터인 고역 통과만 스칼라다. 단계별 소요 시간을 누적해 세션 종료 시 CPU 비용으로 보고한다.
+// 필터/이득 상태를 블록 사이에 유지하므로 세션당 인스턴스 하나. 스레드 안전하지 않음 (오디오 펌프 소비자 전용)
+class AudioPreprocessor {
+public:
+    using Simd = AudioConverter::Simd;
+
+    static constexpr uint32_t kSampleRateHz = AudioConverter::kOutputSampleRateHz;
+
+    // 단계별 누적 지표 (시간은 ns)
+    struct Stats {
+        uint64_t blocks = 0;
+        uint64_t samples = 0;
+        uint64_t convert_ns = 0;   // int16 <-> float
+        uint64_t high_pass_ns = 0;
+        uint64_t gate_ns = 0;
+        uint64_t agc_ns = 0;       // 리미터 포함
+        uint64_t gated_blocks = 0; // 게이트가 닫혀(감쇠 중) 있던 블록
+        uint64_t limited_blocks = 0;
+
+        void Add(const Stats& other);
+        uint64_t total_ns() const { return convert_ns + high_pass_ns + gate_ns + agc_ns; }
+    };
+
+    // 설정 값이 범위를 벗어나면 std::runtime_error
+    explicit AudioPreprocessor(const AudioPreprocessorConfig& config, Simd simd = AudioConverter::DetectSimd());
+
+    // samples를 제자리에서 처리 (count는 블록 크기와 무관, 보통 펌프 블록 40ms)
+    void Process(int16_t* samples, size_t count);
+
+    const Stats& stats() const { return stats_; }
+    double agc_gain_db() const { return agc_gain_db_; }
+    bool gate_open() const { return gate_open_; }
+    Simd simd() const { return simd_; }
+
+private:
+    struct Kernels {
+        void (*to_float)(const int16_t* src, float* dst, size_t n);
+        void (*to_int16)(const float* src, int16_t* dst, size_t n);
+        float (*sum_squares)(const float* x, size_t n);
+        float (*peak_abs)(const float* x, size_t n);
+        void (*gain_ramp)(float* x, size_t n, float start, float step); // x[i] *= start + step * i
+    };
+
+    double MeasureLevelDbfs(const float* x, size_t n) const;
+    void HighPass(float* x, size_t n);
+    void Gate(float* x, size_t n, double level_dbfs);
+    void Agc(float* x, size_t n, double level_dbfs);
+    // 이득이 from -> to로 바뀌는 블록: 같으면 상수 곱, 다르면 직선 보간
+    void ApplyGain(float* x, size_t n, float from, float to) const;
+
+    const AudioPreprocessorConfig config_;
+    Simd simd_;
+    Kernels kernels_;
+    std::vector<float> scratch_;
+
+    // 고역 통과 (TDF-II biquad, 저주파 컷오프 정밀도를 위해 double)
+    double b0_ = 1.0, b1_ = 0.0, b2_ = 0.0, a1_ = 0.0, a2_ = 0.0;
+    double z1_ = 0.0, z2_ = 0.0;
+
+    bool gate_open_ = false;
+    uint32_t gate_below_ms_ = 0;
+    float gate_gain_;
+
+    double agc_gain_db_ = 0.0;
+    float agc_gain_ = 1.0f;
+    float limiter_gain_ = 1.0f;
+
+    Stats stats_;
+};
+
+} // namespace stt
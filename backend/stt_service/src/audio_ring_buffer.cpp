@@ -0,0 +1,57 @@
+#include "audio_ring_buffer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace stt {
+
+namespace {
+
+size_t RoundUpToPowerOfTwo(size_t n) {
+    size_t capacity = 1;
+    while (capacity < n) {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+} // namespace
+
+AudioRingBuffer::AudioRingBuffer(size_t min_capacity)
+    : capacity_(RoundUpToPowerOfTwo(std::max<size_t>(1, min_capacity))),
+      mask_(capacity_ - 1),
+      data_(new uint8_t[capacity_]) {}
+
+bool AudioRingBuffer::Write(const uint8_t* data, size_t size) {
+    const size_t write_pos = write_pos_.load(std::memory_order_relaxed);
+    const size_t read_pos = read_pos_.load(std::memory_order_acquire); // 소비자가 비운 공간 확인
+    if (capacity_ - (write_pos - read_pos) < size) {
+        return false;
+    }
+    // 끝에서 잘리면 두 번에 나눠 복사
+    const size_t offset = write_pos & mask_;
+    const size_t first = std::min(size, capacity_ - offset);
+    std::memcpy(data_.get() + offset, data, first);
+    std::memcpy(data_.get(), data + first, size - first);
+    write_pos_.store(write_pos + size, std::memory_order_release); // 데이터를 소비자에게 공개
+    return true;
+}
+
+size_t AudioRingBuffer::Read(uint8_t* out, size_t size) {
+    const size_t read_pos = read_pos_.load(std::memory_order_relaxed);
+    const size_t write_pos = write_pos_.load(std::memory_order_acquire); // 생산자가 쓴 데이터 확인
+    size = std::min(size, write_pos - read_pos);
+    const size_t offset = read_pos & mask_;
+    const size_t first = std::min(size, capacity_ - offset);
+    std::memcpy(out, data_.get() + offset, first);
+    std::memcpy(out + first, data_.get(), size - first);
+    read_pos_.store(read_pos + size, std::memory_order_release); // 공간을 생산자에게 반환
+    return size;
+}
+
+size_t AudioRingBuffer::size() const {
+    const size_t read_pos = read_pos_.load(std::memory_order_acquire);
+    const size_t write_pos = write_pos_.load(std::memory_order_acquire);
+    return write_pos - read_pos;
+}
+
+} // namespace stt
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace stt {
+
+// 단일 생산자/단일 소비자(SPSC) 잠금 없는 바이트 링 버퍼.
+// 생산자(gRPC 읽기 스레드)와 소비자(오디오 펌프)가 잠금 없이 주고받는다. 용량은 2의 거듭제곱으로 올림.
+// Write/Read는 각각 한 스레드에서만(또는 잠금 등으로 순서가 보장된 스레드들에서만) 호출해야 한다
+class AudioRingBuffer {
+public:
+    explicit AudioRingBuffer(size_t min_capacity);
+
+    AudioRingBuffer(const AudioRingBuffer&) = delete;
+    AudioRingBuffer& operator=(const AudioRingBuffer&) = delete;
+
+    // 생산자: 남은 공간이 size보다 작으면 아무것도 쓰지 않고 false
+    bool Write(const uint8_t* data, size_t size);
+    // 소비자: 최대 size 바이트를 꺼내고 꺼낸 바이트 수 반환
+    size_t Read(uint8_t* out, size_t size);
+
+    // 쌓인 바이트 수 (상대 스레드가 동시에 움직이므로 근사값. 소비자가 보면 최소값, 생산자가 보면 최대값)
+    size_t size() const;
+    size_t capacity() const { return capacity_; }
+
+private:
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<uint8_t[]> data_;
+    alignas(64) std::atomic<size_t> write_pos_{0}; // 생산자만 증가 (누적 바이트 수)
+    alignas(64) std::atomic<size_t> read_pos_{0};  // 소비자만 증가 (누적 바이트 수)
+};
+
+} // namespace stt
@@ -90,6 +90,7 @@ bool AzureSTTClient::StartContinuousRecognition(
 
         // 2. 상태 초기화
         recognition_has_error_.store(false);
+        completion_sent_.store(false);
         last_error_message_.clear();
         recognition_stopped_promise_ = std::promise<void>();
 
@@ -151,7 +152,30 @@ void AzureSTTClient::PushAudioChunk(const uint8_t* data, size_t size) {
     }
 }
 
-// 연속 인식 중지 (변경 없음 - 헤더 변수 선언 및 타입이 올바르다면)
+// 입력 종료: push stream을 닫기만 하고 바로 반환 (결과와 SessionStopped는 SDK 스레드에서 옴)
+void AzureSTTClient::CloseInput() {
+    std::lock_guard<std::mutex> lock(client_mutex_);
+    if (recognition_active_.load() && push_stream_) {
+        std::cout << "   Closing push audio stream (end of input)..." << std::endl;
+        push_stream_->Close();
+    }
+}
+
+// 재사용 준비: 오류 없이 끝난 세션만. recognizer/push stream은 다음 Start에서 새로 만듦
+bool AzureSTTClient::Recycle() {
+    std::lock_guard<std::mutex> lock(client_mutex_);
+    if (recognition_active_.load() || recognition_has_error_.load()) {
+        return false;
+    }
+    recognizer_.reset();
+    audio_config_.reset();
+    push_stream_.reset();
+    text_chunk_callback_ = nullptr;
+    completion_callback_ = nullptr;
+    return true;
+}
+
+// 연속 인식 중지 (블로킹: RecognizerReaper에서 호출)
 void AzureSTTClient::StopContinuousRecognition() {
     if (!recognition_active_.load()) {
         std::cout << "ℹ️ StopContinuousRecognition called but recognition is not active." << std::endl;
@@ -251,6 +275,11 @@ void AzureSTTClient::HandleRecognized(const SpeechRecognitionEventArgs& e) { //
 
 // HandleCanceled (using namespace 적용 외 변경 없음)
 void AzureSTTClient::HandleCanceled(const SpeechRecognitionCanceledEventArgs& e) { // 수정됨: 타입 이름만 사용
+    if (e.Reason == CancellationReason::EndOfStream) {
+        // CloseInput으로 입력을 닫은 정상 종료. 곧 SessionStopped가 완료를 알림
+        std::cout << "   CANCELED: EndOfStream (input closed)." << std::endl;
+        return;
+    }
     std::string error_details;
     std::string cancellation_reason_str;
     bool is_error = false;
@@ -268,7 +297,9 @@ void AzureSTTClient::HandleCanceled(const SpeechRecognitionCanceledEventArgs& e)
         }
         std::cerr << std::endl;
         last_error_message_ = "CancellationReason: " + cancellation_reason_str + (is_error ? " " + error_details : "");
-        cb = completion_callback_;
+        if (!completion_sent_.exchange(true)) {
+            cb = completion_callback_;
+        }
         try { recognition_stopped_promise_.set_value(); } catch (const std::future_error&) {}
     }
     if (cb) {
@@ -294,15 +325,15 @@ void AzureSTTClient::HandleSessionStopped(const SessionEventArgs& e) { // 수정
         recognition_active_.store(false);
         final_success = !recognition_has_error_.load();
         final_message = last_error_message_;
-        cb = completion_callback_;
+        if (!completion_sent_.exchange(true)) {
+            cb = completion_callback_;
+        }
         try { recognition_stopped_promise_.set_value(); } catch (const std::future_error&) {}
     }
     if (cb) {
         try { cb(final_success, final_message); } catch (const std::exception& cb_ex) {
             std::cerr << "❌ Exception in completion_callback_ (SessionStopped): " << cb_ex.what() << std::endl;
         }
-    } else {
-         std::cerr << "⚠️ Completion callback is null in SessionStopped handler." << std::endl;
     }
 }
 
@@ -10,18 +10,17 @@
 // Azure SDK 관련 헤더들...
 #include <speechapi_cxx.h> // 실제 사용하는 헤더 이름 확인 필요
 
-namespace stt {
+#include "recognition_engine.h"
 
-// 콜백 타입 정의
-using TextChunkCallback = std::function<void(const std::string&, bool)>;
-using RecognitionCompletionCallback = std::function<void(bool, const std::string&)>;
+namespace stt {
 
-class AzureSTTClient {
+// Azure Speech SDK 연속 인식 엔진 (RecognitionEngine 구현)
+class AzureSTTClient final : public RecognitionEngine {
 public:
     // ---=[ 생성자 선언 추가 ]=---
     // main.cpp 에서 std::make_shared 로 호출 시 필요
     explicit AzureSTTClient(const std::string& key, const std::string& region); // 수정됨: 생성자 선언 추가
-    ~AzureSTTClient(); // 소멸자 선언 (이미 존재)
+    ~AzureSTTClient() override; // 소멸자 선언 (이미 존재)
 
     // 복사 방지 (cpp 파일 구현 참고하여 필요시 추가/수정)
     AzureSTTClient(const AzureSTTClient&) = delete;
@@ -33,11 +32,13 @@ public:
     bool StartContinuousRecognition(
         const std::string& language,
         const TextChunkCallback& text_chunk_callback,
-        const RecognitionCompletionCallback& completion_callback);
+        const RecognitionCompletionCallback& completion_callback) override;
 
     // cpp 파일에 구현된 다른 public 함수들의 선언도 여기에 있어야 함
-    void PushAudioChunk(const uint8_t* data, size_t size);
-    void StopContinuousRecognition();
+    void PushAudioChunk(const uint8_t* data, size_t size) override;
+    void CloseInput() override; // push stream을 닫음: SDK가 남은 오디오를 인식한 뒤 Recognized -> SessionStopped
+    void StopContinuousRecognition() override;
+    bool Recycle() override;    // 정상 종료된 세션이면 recognizer/stream만 정리하고 SpeechConfig는 재사용
     // ... 기타 필요한 public 함수 선언 ...
 
 
@@ -56,6 +57,7 @@ private:
 
     std::atomic<bool> recognition_active_{false};
     std::atomic<bool> recognition_has_error_{false};
+    std::atomic<bool> completion_sent_{false}; // completion_callback_은 세션당 한 번 (Canceled/SessionStopped 중 먼저)
     std::mutex client_mutex_;
     std::string last_error_message_; // 오류 메시지 저장용
     std::promise<void> recognition_stopped_promise_; // 비동기 중지 완료 신호용
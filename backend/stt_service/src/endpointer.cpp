@@ -0,0 +1,81 @@
+#include "endpointer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace stt {
+
+namespace {
+
+constexpr double kSilenceFloorDbfs = -100.0; // 완전 무음 프레임
+constexpr double kNoiseFloorRise = 0.05;     // 잡음 바닥은 천천히 올라가고 즉시 내려감
+constexpr double kInitialNoiseFloorDbfs = -60.0; // 조용한 방 수준에서 출발 (첫 프레임이 발화여도 바닥이 되지 않도록)
+
+} // namespace
+
+Endpointer::Endpointer(const EndpointerConfig& config) : config_(config), noise_floor_dbfs_(kInitialNoiseFloorDbfs) {}
+
+bool Endpointer::OnAudio(const int16_t* samples, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const bool already_fired = fired_;
+    for (size_t i = 0; i < count; ++i) {
+        const double s = samples[i] / 32768.0;
+        frame_energy_ += s * s;
+        if (++frame_fill_ == kFrameSamples) {
+            const double mean_square = frame_energy_ / kFrameSamples;
+            OnFrameLocked(mean_square > 0.0 ? std::max(kSilenceFloorDbfs, 10.0 * std::log10(mean_square)) : kSilenceFloorDbfs);
+            frame_energy_ = 0.0;
+            frame_fill_ = 0;
+        }
+    }
+    return fired_ && !already_fired;
+}
+
+void Endpointer::OnFrameLocked(double energy_dbfs) {
+    audio_ms_ += kFrameMs;
+    const bool speech = energy_dbfs > config_.speech_threshold_dbfs &&
+                        energy_dbfs > noise_floor_dbfs_ + config_.noise_margin_db;
+    if (speech) {
+        speech_ms_ += kFrameMs;
+        silence_ms_ = 0;
+    } else {
+        silence_ms_ += kFrameMs;
+    }
+    // 바닥은 음성 임계값 아래 프레임으로만 추적 (임계값 근처 발화 꼬리가 바닥을 끌어올리지 않도록)
+    if (energy_dbfs <= config_.speech_threshold_dbfs) {
+        noise_floor_dbfs_ = energy_dbfs < noise_floor_dbfs_
+            ? energy_dbfs
+            : noise_floor_dbfs_ + (energy_dbfs - noise_floor_dbfs_) * kNoiseFloorRise;
+    }
+    if (fired_ || speech_ms_ < config_.min_speech_ms || last_text_.empty()) {
+        return;
+    }
+    // 발화가 있었고, 그 뒤로 충분히 조용하며, 인식 결과도 한동안 바뀌지 않았음
+    if (silence_ms_ >= config_.trailing_silence_ms && audio_ms_ - last_text_change_ms_ >= config_.transcript_stable_ms) {
+        fired_ = true;
+    }
+}
+
+void Endpointer::OnTranscript(const std::string& text) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (text != last_text_) {
+        last_text_ = text;
+        last_text_change_ms_ = audio_ms_;
+    }
+}
+
+uint64_t Endpointer::audio_ms() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return audio_ms_;
+}
+
+uint64_t Endpointer::trailing_silence_ms() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return silence_ms_;
+}
+
+bool Endpointer::fired() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return fired_;
+}
+
+} // namespace stt
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace stt {
+
+// 서버 측 끝점 검출 설정. 시간은 모두 오디오 시간(ms) 기준이라 재생 속도와 무관하게 결정적이다.
+struct EndpointerConfig {
+    bool enabled = false;
+    double speech_threshold_dbfs = -45.0; // 프레임 에너지가 이보다 크고
+    double noise_margin_db = 12.0;        // 추정 잡음 바닥 + margin보다도 커야 음성 프레임
+    uint32_t min_speech_ms = 150;         // 누적 음성이 이만큼 되어야 발화 시작으로 인정
+    uint32_t trailing_silence_ms = 600;   // 발화 시작 후 이만큼 연속으로 조용하고
+    uint32_t transcript_stable_ms = 400;  // 마지막 중간 결과 변화 후 이만큼 지나면 발화 끝
+};
+
+// 오디오 에너지 + 인식 중간 결과 안정도로 발화 끝을 판단 (세션마다 하나).
+// OnAudio는 오디오 펌프, OnTranscript는 엔진 콜백 스레드에서 호출되므로 내부 잠금 사용
+class Endpointer {
+public:
+    static constexpr uint32_t kFrameMs = 10;
+    static constexpr size_t kFrameSamples = 16000 / 1000 * kFrameMs; // 16kHz mono 입력
+
+    explicit Endpointer(const EndpointerConfig& config);
+
+    // 16kHz 16-bit mono PCM. 이번 호출에서 끝점이 처음 검출되면 true (이후로는 항상 false)
+    bool OnAudio(const int16_t* samples, size_t count);
+    // 중간/확정 결과 텍스트. 이전과 달라진 시점을 기록 (빈 텍스트는 발화로 보지 않음)
+    void OnTranscript(const std::string& text);
+
+    uint64_t audio_ms() const;
+    uint64_t trailing_silence_ms() const;
+    bool fired() const;
+
+private:
+    void OnFrameLocked(double energy_dbfs);
+
+    const EndpointerConfig config_;
+    mutable std::mutex mutex_;
+    // 프레임 경계에 걸친 샘플
+    double frame_energy_ = 0.0;
+    size_t frame_fill_ = 0;
+    uint64_t audio_ms_ = 0;
+    double noise_floor_dbfs_; // 음성 임계값 아래 프레임으로만 갱신
+    uint64_t speech_ms_ = 0;
+    uint64_t silence_ms_ = 0;
+    std::string last_text_;
+    uint64_t last_text_change_ms_ = 0;
+    bool fired_ = false;
+};
+
+} // namespace stt
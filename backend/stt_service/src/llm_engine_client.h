@@ -5,6 +5,8 @@
 #include <mutex>
 #include <utility> // For std::pair
 #include <atomic> // For std::atomic_bool
+#include <deque>
+#include <functional>
 
 #include <grpcpp/grpcpp.h>
 #include <google/protobuf/empty.pb.h> // 수정됨: Empty 메시지 사용을 위해 추가
@@ -21,10 +23,11 @@ using llm::LLMStreamRequest;
 using llm::SessionConfig;     // 수정됨: 추가 (LLMStreamRequest 내 사용)
 using grpc::Channel;
 using grpc::ClientContext;
-using grpc::ClientWriter;
 using grpc::Status;
 
-// LLM Engine으로 텍스트 청크를 스트리밍하는 클라이언트 클래스
+class LLMTurnWriter;
+
+// LLM Engine 채널/스텁을 보유하고 턴(RecognizeStream)마다 비동기 스트림을 연다. 여러 스레드에서 공유 가능
 class LLMEngineClient {
 public:
     explicit LLMEngineClient(const std::string& server_address);
@@ -33,30 +36,55 @@ public:
     // 복사 방지
     LLMEngineClient(const LLMEngineClient&) = delete;
     LLMEngineClient& operator=(const LLMEngineClient&) = delete;
-    LLMEngineClient(LLMEngineClient&&) = default;
-    LLMEngineClient& operator=(LLMEngineClient&&) = default;
-
-    bool StartStream(const llm::SessionConfig& config);
-
-    bool SendTextChunk(const std::string& text);
 
-    Status FinishStream();
+    using DoneCallback = std::function<void(const Status&)>;
 
-    bool IsStreamActive() const;
+    // ProcessTextStream 호출을 시작하고 SessionConfig를 첫 메시지로 큐에 넣는다 (블로킹 없음).
+    // 반환된 writer는 Close() 또는 Cancel() 전까지 유효하며, 그 뒤 서버 응답이 오면 on_done이 한 번 호출되고 writer는 스스로 삭제된다.
+    // config가 유효하지 않으면 nullptr
+    LLMTurnWriter* OpenTurn(const llm::SessionConfig& config, DoneCallback on_done);
 
 private:
     std::string server_address_;
-    std::string session_id_;
-
     std::shared_ptr<Channel> channel_;
     std::unique_ptr<LLMService::Stub> stub_;
+};
 
-    std::unique_ptr<ClientContext> context_;
-    std::unique_ptr<ClientWriter<LLMStreamRequest>> stream_;
-    google::protobuf::Empty server_response_;
+// 턴 하나의 LLM 텍스트 스트림 (콜백 API). 쓰기는 큐에 모아 하나씩 전송하므로 어느 스레드에서든 블로킹 없이 호출 가능.
+// 쓰기가 실패하면 이후 Send*는 false (최종 상태는 on_done으로 전달)
+class LLMTurnWriter final : public grpc::ClientWriteReactor<LLMStreamRequest> {
+public:
+    bool SendTextChunk(const std::string& text);
+    // 발화 확정 표시 전송 (이후 텍스트 없음). LLM은 이 표시를 받으면 바로 응답 생성을 시작한다
+    bool SendTranscriptFinal();
+    // 큐를 모두 보낸 뒤 WritesDone. 이후 이 객체를 사용하면 안 됨
+    void Close();
+    // 호출 취소 (LLM은 응답을 만들지 않음). 이후 이 객체를 사용하면 안 됨
+    void Cancel();
 
-    mutable std::mutex stream_mutex_;
-    std::atomic<bool> stream_active_{false};
+    void OnWriteDone(bool ok) override;
+    void OnWritesDoneDone(bool ok) override;
+    void OnDone(const Status& status) override;
+
+private:
+    friend class LLMEngineClient;
+    LLMTurnWriter(std::string session_id, LLMEngineClient::DoneCallback on_done)
+        : session_id_(std::move(session_id)), on_done_(std::move(on_done)) {}
+
+    bool Enqueue(LLMStreamRequest request);
+    void Release(); // Close/Cancel 후 큐가 비면 WritesDone + hold 해제 (released_로 한 번만)
+
+    std::string session_id_;
+    LLMEngineClient::DoneCallback on_done_;
+    ClientContext context_;
+    google::protobuf::Empty response_;
+
+    std::mutex mutex_;
+    std::deque<LLMStreamRequest> queue_; // front가 전송 중인 메시지
+    bool writing_ = false;
+    bool failed_ = false;
+    bool closing_ = false;
+    bool released_ = false;
 };
 
-} // namespace stt
\ No newline at end of file
+} // namespace stt
@@ -2,6 +2,7 @@
 
 #include <grpcpp/grpcpp.h>
 #include "azure_stt_client.h"
+#include "scripted_recognition_engine.h"
 #include "llm_engine_client.h"
 #include "stt_service.h"
 #include <cstdlib>
@@ -13,6 +14,7 @@
 #include <csignal> // For signal handling
 #include <atomic> // For shutdown flag
 #include <thread> // For shutdown delay
+#include <chrono>
 
 // 전역 종료 플래그 및 서버 포인터 (Graceful Shutdown 용)
 std::atomic<bool> shutdown_requested(false);
@@ -38,13 +40,21 @@ int main() {
     std::cout << "🚀 Starting STT Service..." << std::endl;
 
     // --- 환경 변수 로드 ---
+    const char* engine_env = std::getenv("STT_ENGINE"); // azure (기본) | scripted
     const char* azure_key_env = std::getenv("AZURE_SPEECH_KEY");
     const char* azure_region_env = std::getenv("AZURE_SPEECH_REGION");
     const char* llm_addr_env = std::getenv("LLM_ENGINE_ADDRESS");
     const char* server_addr_env = std::getenv("STT_SERVER_ADDRESS");
 
-    // 필수 환경 변수 확인
-    if (!azure_key_env || !azure_region_env || std::string(azure_key_env).empty() || std::string(azure_region_env).empty()) {
+    const std::string engine_name = (engine_env && std::string(engine_env).size() > 0) ? engine_env : "azure";
+    if (engine_name != "azure" && engine_name != "scripted") {
+        std::cerr << "❌ FATAL: Unknown STT_ENGINE '" << engine_name << "' (expected azure or scripted). Exiting." << std::endl;
+        return 1;
+    }
+
+    // 필수 환경 변수 확인 (Azure 자격 증명은 azure 엔진에서만 필요)
+    if (engine_name == "azure" &&
+        (!azure_key_env || !azure_region_env || std::string(azure_key_env).empty() || std::string(azure_region_env).empty())) {
         std::cerr << "❌ FATAL: Missing or empty AZURE_SPEECH_KEY or AZURE_SPEECH_REGION environment variables. Exiting." << std::endl;
         return 1;
     }
@@ -53,37 +63,131 @@ int main() {
         return 1;
     }
 
-    std::string azure_key = azure_key_env;
-    std::string azure_region = azure_region_env;
+    std::string azure_key = azure_key_env ? azure_key_env : "";
+    std::string azure_region = azure_region_env ? azure_region_env : "";
     std::string llm_engine_address = llm_addr_env;
     std::string stt_server_address = (server_addr_env && !std::string(server_addr_env).empty())
                                      ? server_addr_env
                                      : "0.0.0.0:50052"; // 기본값 설정
 
     std::cout << "🔧 Configuration:" << std::endl;
-    std::cout << "  Azure Region: " << azure_region << std::endl;
+    std::cout << "  STT Engine: " << engine_name << std::endl;
+    if (engine_name == "azure") {
+        std::cout << "  Azure Region: " << azure_region << std::endl;
+    }
     std::cout << "  LLM Engine Address: " << llm_engine_address << std::endl;
     std::cout << "  STT Service Listening Address: " << stt_server_address << std::endl;
 
     // 클라이언트 및 서비스 포인터 (Graceful Shutdown 위해 main 스코프에 선언)
-    std::shared_ptr<stt::AzureSTTClient> azure_client = nullptr;
+    stt::RecognitionEngineFactory engine_factory = nullptr;
     std::shared_ptr<stt::LLMEngineClient> llm_client = nullptr;
     std::unique_ptr<stt::STTServiceImpl> service_impl = nullptr;
 
 
     try {
         // --- 클라이언트 인스턴스 생성 ---
-        std::cout << "⏳ Initializing Azure STT client..." << std::endl;
-        azure_client = std::make_shared<stt::AzureSTTClient>(azure_key, azure_region);
-        std::cout << "✅ Azure STT client initialized." << std::endl;
+        if (engine_name == "scripted") {
+            // 오프라인 결정적 엔진: 자격 증명/네트워크 없이 RecognizeStream 부하·지연 측정용
+            const char* script_env = std::getenv("STT_SCRIPT_PATH");
+            if (!script_env || std::string(script_env).empty()) {
+                throw std::runtime_error("STT_ENGINE=scripted requires STT_SCRIPT_PATH (transcript sidecar file).");
+            }
+            stt::ScriptedRecognitionScript script = stt::LoadTranscriptSidecar(script_env);
+            if (const char* ms = std::getenv("STT_SCRIPT_MS_PER_WORD"); ms && *ms) {
+                script.audio_per_word = std::chrono::milliseconds(std::stoi(ms));
+            }
+            if (const char* ms = std::getenv("STT_SCRIPT_FINALIZE_DELAY_MS"); ms && *ms) {
+                script.finalize_delay = std::chrono::milliseconds(std::stoi(ms));
+            }
+            if (const char* ms = std::getenv("STT_SCRIPT_TEARDOWN_DELAY_MS"); ms && *ms) {
+                script.teardown_delay = std::chrono::milliseconds(std::stoi(ms));
+            }
+            std::cout << "✅ Scripted recognition engine loaded " << script.transcripts.size() << " transcript(s) from " << script_env << std::endl;
+            engine_factory = stt::ScriptedRecognitionEngine::Factory(std::move(script));
+        } else {
+            // 스트림마다 자체 recognizer/push stream을 갖도록 세션별로 클라이언트 생성 (정리된 인스턴스는 RecognizerReaper가 재사용)
+            std::cout << "⏳ Validating Azure STT credentials..." << std::endl;
+            stt::AzureSTTClient probe(azure_key, azure_region);
+            engine_factory = [azure_key, azure_region]() -> std::unique_ptr<stt::RecognitionEngine> {
+                return std::make_unique<stt::AzureSTTClient>(azure_key, azure_region);
+            };
+            std::cout << "✅ Azure STT engine factory initialized." << std::endl;
+        }
 
         std::cout << "⏳ Initializing LLM Engine client..." << std::endl;
         llm_client = std::make_shared<stt::LLMEngineClient>(llm_engine_address);
         std::cout << "✅ LLM Engine client initialized." << std::endl;
 
         // --- gRPC 서비스 구현체 생성 ---
-        service_impl = std::make_unique<stt::STTServiceImpl>(azure_client, llm_client);
-        std::cout << "✅ STT service implementation created." << std::endl;
+        // 인식 엔진 Start/Stop 같은 블로킹 호출을 맡는 작업 스레드 수 (세션 수와 무관)
+        size_t blocking_threads = stt::STTServiceImpl::kDefaultBlockingThreads;
+        if (const char* threads_env = std::getenv("STT_BLOCKING_THREADS"); threads_env && *threads_env) {
+            blocking_threads = static_cast<size_t>(std::stoul(threads_env));
+        }
+        // 인식 엔진 정리(Stop/소멸) 전용 스레드 수. Azure Stop은 세션당 수 초까지 블로킹될 수 있음
+        size_t reaper_threads = stt::RecognizerReaper::kDefaultThreads;
+        if (const char* reaper_env = std::getenv("STT_REAPER_THREADS"); reaper_env && *reaper_env) {
+            reaper_threads = static_cast<size_t>(std::stoul(reaper_env));
+        }
+        // 세션 캡처 (선택): 설정하면 세션마다 원본 오디오/청크 도착 시각/확정 텍스트를 기록 (tests/replay_captures.py로 재생)
+        std::shared_ptr<stt::SessionCaptureWriter> capture_writer = nullptr;
+        if (const char* capture_env = std::getenv("STT_CAPTURE_PATH"); capture_env && *capture_env) {
+            capture_writer = std::make_shared<stt::SessionCaptureWriter>(capture_env);
+            std::cout << "⚠️ Session capture enabled: recording audio and transcripts to " << capture_env << std::endl;
+        }
+        // 서버 측 끝점 검출 (선택): STT_ENDPOINT_SILENCE_MS > 0 이면 켜짐. 발화 끝을 감지하면 클라이언트 입력 종료 전에 LLM 턴을 닫음
+        stt::EndpointerConfig endpointing;
+        if (const char* silence_env = std::getenv("STT_ENDPOINT_SILENCE_MS"); silence_env && *silence_env) {
+            endpointing.trailing_silence_ms = static_cast<uint32_t>(std::stoul(silence_env));
+            endpointing.enabled = endpointing.trailing_silence_ms > 0;
+        }
+        if (const char* stable_env = std::getenv("STT_ENDPOINT_STABLE_MS"); stable_env && *stable_env) {
+            endpointing.transcript_stable_ms = static_cast<uint32_t>(std::stoul(stable_env));
+        }
+        if (const char* threshold_env = std::getenv("STT_ENDPOINT_THRESHOLD_DBFS"); threshold_env && *threshold_env) {
+            endpointing.speech_threshold_dbfs = std::stod(threshold_env);
+        }
+        if (endpointing.enabled) {
+            std::cout << "✅ Server-side endpointing enabled: trailing silence " << endpointing.trailing_silence_ms
+                      << " ms, transcript stable " << endpointing.transcript_stable_ms << " ms, threshold "
+                      << endpointing.speech_threshold_dbfs << " dBFS." << std::endl;
+        }
+        // 오디오 전처리 (선택): STT_PREPROCESS=1 이면 엔진 입력 전에 고역 통과/노이즈 게이트/AGC 적용.
+        // STT_PREPROCESS_STAGES로 단계 선택 (기본 highpass,gate,agc)
+        stt::AudioPreprocessorConfig preprocessing;
+        if (const char* preprocess_env = std::getenv("STT_PREPROCESS"); preprocess_env && *preprocess_env) {
+            preprocessing.enabled = std::string(preprocess_env) == "1" || std::string(preprocess_env) == "true";
+        }
+        if (const char* stages_env = std::getenv("STT_PREPROCESS_STAGES"); stages_env && *stages_env) {
+            const std::string stages = std::string(",") + stages_env + ",";
+            preprocessing.high_pass = stages.find(",highpass,") != std::string::npos;
+            preprocessing.noise_gate = stages.find(",gate,") != std::string::npos;
+            preprocessing.agc = stages.find(",agc,") != std::string::npos;
+        }
+        if (const char* hz_env = std::getenv("STT_PREPROCESS_HIGHPASS_HZ"); hz_env && *hz_env) {
+            preprocessing.high_pass_hz = std::stod(hz_env);
+        }
+        if (const char* gate_env = std::getenv("STT_PREPROCESS_GATE_DBFS"); gate_env && *gate_env) {
+            preprocessing.gate_threshold_dbfs = std::stod(gate_env);
+        }
+        if (const char* target_env = std::getenv("STT_PREPROCESS_AGC_TARGET_DBFS"); target_env && *target_env) {
+            preprocessing.agc_target_dbfs = std::stod(target_env);
+        }
+        if (const char* max_gain_env = std::getenv("STT_PREPROCESS_AGC_MAX_GAIN_DB"); max_gain_env && *max_gain_env) {
+            preprocessing.agc_max_gain_db = std::stod(max_gain_env);
+        }
+        if (preprocessing.enabled) {
+            std::cout << "✅ Audio preprocessing enabled (" << stt::AudioConverter::SimdName(stt::AudioConverter::DetectSimd()) << "):";
+            if (preprocessing.high_pass) std::cout << " high-pass " << preprocessing.high_pass_hz << " Hz;";
+            if (preprocessing.noise_gate) std::cout << " gate " << preprocessing.gate_threshold_dbfs << " dBFS;";
+            if (preprocessing.agc) std::cout << " AGC target " << preprocessing.agc_target_dbfs << " dBFS, max gain " << preprocessing.agc_max_gain_db << " dB;";
+            std::cout << std::endl;
+        }
+        service_impl = std::make_unique<stt::STTServiceImpl>(engine_factory, llm_client, blocking_threads,
+                                                             stt::STTServiceImpl::kDefaultPumpThreads, capture_writer,
+                                                             endpointing, reaper_threads, preprocessing);
+        std::cout << "✅ STT service implementation created (" << blocking_threads << " blocking worker threads, "
+                  << reaper_threads << " recognizer teardown threads)." << std::endl;
 
         // --- gRPC 서버 설정 및 시작 ---
         grpc::EnableDefaultHealthCheckService(true); // Health Check 서비스 활성화
@@ -111,14 +215,12 @@ int main() {
         server_ptr.reset(); // 서버 종료 (필요 시)
         service_impl.reset();
         llm_client.reset();
-        azure_client.reset();
         return 1;
     } catch (...) {
          std::cerr << "❌ FATAL Unknown exception caught during initialization. Exiting." << std::endl;
          server_ptr.reset();
          service_impl.reset();
          llm_client.reset();
-         azure_client.reset();
          return 1;
     }
 
@@ -132,8 +234,6 @@ int main() {
     // 클라이언트 객체 소멸 (소멸자에서 연결 정리 등 수행)
     llm_client.reset();
     std::cout << "  LLM Engine client released." << std::endl;
-    azure_client.reset(); // Azure 클라이언트 소멸자에서 Stop 시도
-    std::cout << "  Azure STT client released." << std::endl;
 
     std::cout << "✅ STT Service shut down gracefully." << std::endl;
     return 0;
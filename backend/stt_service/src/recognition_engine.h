@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace stt {
+
+// 콜백 타입 정의
+// text: 인식 중간 결과(is_final=false) 또는 확정 결과(is_final=true)
+using TextChunkCallback = std::function<void(const std::string&, bool)>;
+// 인식 종료 (정상 종료 또는 오류). 세션당 한 번
+using RecognitionCompletionCallback = std::function<void(bool, const std::string&)>;
+
+// 음성 인식 엔진 인터페이스. RecognizeStream 하나가 엔진 인스턴스 하나를 사용한다.
+// 입력 오디오는 16kHz 16-bit mono PCM. 콜백은 엔진 내부 스레드에서 호출될 수 있다.
+// 세션 흐름: Start -> PushAudioChunk... -> CloseInput -> (확정 결과, completion_callback) -> Stop (RecognizerReaper에서) -> Recycle 또는 소멸
+class RecognitionEngine {
+public:
+    virtual ~RecognitionEngine() = default;
+
+    virtual bool StartContinuousRecognition(
+        const std::string& language,
+        const TextChunkCallback& text_chunk_callback,
+        const RecognitionCompletionCallback& completion_callback) = 0;
+
+    virtual void PushAudioChunk(const uint8_t* data, size_t size) = 0;
+
+    // 입력을 닫음 (오래 블로킹하지 않음). 엔진은 남은 오디오의 결과를 전달한 뒤 completion_callback을 호출한다
+    virtual void CloseInput() = 0;
+
+    // 인식 세션 정리. 블로킹될 수 있으므로 (Azure는 세션 종료까지 최대 수십 초) RPC 경로가 아닌 곳에서 호출.
+    // 반환 후에는 콜백을 호출하지 않음
+    virtual void StopContinuousRecognition() = 0;
+
+    // Stop 후 세션 자원을 정리하고 같은 인스턴스를 다음 세션에서 다시 Start할 수 있으면 true (기본: 재사용 불가)
+    virtual bool Recycle() { return false; }
+};
+
+// 스트림마다 새 엔진을 만드는 팩토리 (main.cpp에서 STT_ENGINE 설정에 따라 선택)
+using RecognitionEngineFactory = std::function<std::unique_ptr<RecognitionEngine>()>;
+
+} // namespace stt
@@ -0,0 +1,112 @@
+#include "recognizer_reaper.h"
+#include <algorithm>
+#include <iostream>
+
+namespace stt {
+
+RecognizerReaper::RecognizerReaper(size_t threads, std::chrono::milliseconds leak_budget, size_t max_idle)
+    : leak_budget_(leak_budget), max_idle_(max_idle), scheduler_(threads) {}
+
+RecognizerReaper::~RecognizerReaper() {
+    const size_t in_flight = stats().in_flight;
+    if (in_flight > 0) {
+        std::cout << "ℹ️ RecognizerReaper: waiting for " << in_flight << " recognizer teardown(s) before shutdown." << std::endl;
+    }
+}
+
+std::unique_ptr<RecognitionEngine> RecognizerReaper::Acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (idle_.empty()) {
+        return nullptr;
+    }
+    std::unique_ptr<RecognitionEngine> engine = std::move(idle_.back()); // 가장 최근에 정리된 것부터 (캐시가 따뜻함)
+    idle_.pop_back();
+    stats_.reused++;
+    return engine;
+}
+
+void RecognizerReaper::Retire(std::unique_ptr<RecognitionEngine> engine) {
+    if (!engine) {
+        return;
+    }
+    uint64_t id;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto now = Clock::now();
+        UpdateLeaksLocked(now);
+        id = next_id_++;
+        pending_.emplace(id, Pending{now, false});
+        stats_.retired++;
+    }
+    // std::function은 복사 가능해야 하므로 shared_ptr로 감싸서 넘김
+    auto holder = std::make_shared<std::unique_ptr<RecognitionEngine>>(std::move(engine));
+    scheduler_.Post([this, id, holder]() { Teardown(id, std::move(*holder)); });
+}
+
+void RecognizerReaper::Teardown(uint64_t id, std::unique_ptr<RecognitionEngine> engine) {
+    const auto started = Clock::now();
+    bool recycled = false;
+    try {
+        engine->StopContinuousRecognition();
+        recycled = engine->Recycle();
+    } catch (const std::exception& e) {
+        std::cerr << "❌ RecognizerReaper: exception during recognizer teardown: " << e.what() << std::endl;
+    }
+    if (!recycled) {
+        engine.reset(); // 소멸도 블로킹될 수 있으므로 정리 시간에 포함
+    }
+    const auto finished = Clock::now();
+    const double teardown_ms = std::chrono::duration<double, std::milli>(finished - started).count();
+
+    std::unique_ptr<RecognitionEngine> dropped;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = pending_.find(id);
+        const double since_retire_ms = std::chrono::duration<double, std::milli>(finished - it->second.retired_at).count();
+        if (!it->second.leaked && since_retire_ms > leak_budget_.count()) {
+            stats_.leaked_total++; // 조회되기 전에 끝났어도 예산 초과는 집계
+        }
+        pending_.erase(it);
+        stats_.completed++;
+        stats_.last_teardown_ms = teardown_ms;
+        stats_.max_teardown_ms = std::max(stats_.max_teardown_ms, teardown_ms);
+        stats_.total_teardown_ms += teardown_ms;
+        if (recycled) {
+            if (idle_.size() < max_idle_) {
+                idle_.push_back(std::move(engine));
+                stats_.recycled++;
+            } else {
+                dropped = std::move(engine); // 유휴 목록이 가득 참: 잠금 밖에서 소멸
+            }
+        }
+    }
+    if (teardown_ms > 1000.0) {
+        std::cout << "⚠️ RecognizerReaper: slow recognizer teardown " << static_cast<int64_t>(teardown_ms) << " ms." << std::endl;
+    }
+}
+
+void RecognizerReaper::UpdateLeaksLocked(Clock::time_point now) const {
+    for (auto& entry : pending_) {
+        Pending& pending = entry.second;
+        if (!pending.leaked && now - pending.retired_at > leak_budget_) {
+            pending.leaked = true;
+            stats_.leaked_total++;
+            std::cerr << "⚠️ RecognizerReaper: recognizer teardown exceeded " << leak_budget_.count()
+                      << " ms; counting it as leaked." << std::endl;
+        }
+    }
+}
+
+RecognizerReaper::Stats RecognizerReaper::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto now = Clock::now();
+    UpdateLeaksLocked(now);
+    Stats stats = stats_;
+    stats.in_flight = pending_.size();
+    stats.leaked_now = static_cast<size_t>(std::count_if(pending_.begin(), pending_.end(),
+                                                         [](const auto& entry) { return entry.second.leaked; }));
+    stats.idle = idle_.size();
+    return stats;
+}
+
+} // namespace stt
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "recognition_engine.h"
+#include "task_scheduler.h"
+
+namespace stt {
+
+// 인식 엔진 정리 전담 (RPC 경로 밖에서).
+// 세션이 확정 결과를 받으면 엔진을 Retire로 넘기고 바로 LLM 턴/RPC를 끝낸다. 여기서 Stop(블로킹)과 소멸을 처리하고,
+// Recycle에 성공한 엔진은 유휴 목록에 보관했다가 다음 세션의 Acquire로 재사용한다.
+// 정리가 leak_budget을 넘기면 누수(leaked)로 집계한다 (SDK 세션이 끝나지 않아 스레드/연결을 붙잡고 있는 상태).
+class RecognizerReaper {
+public:
+    static constexpr size_t kDefaultThreads = 4;
+    static constexpr std::chrono::milliseconds kDefaultLeakBudget{35000}; // Azure Stop 최대 대기(10s + 20s) + 여유
+    static constexpr size_t kDefaultMaxIdle = 64;
+
+    struct Stats {
+        uint64_t retired = 0;         // Retire로 넘겨받은 엔진 수
+        uint64_t completed = 0;       // 정리 완료
+        uint64_t recycled = 0;        // 그중 유휴 목록으로 돌아간 수
+        uint64_t reused = 0;          // Acquire로 재사용된 수
+        uint64_t leaked_total = 0;    // 정리가 leak_budget을 넘긴 누적 수 (끝났든 아직이든)
+        size_t in_flight = 0;         // 정리 중 (대기 포함)
+        size_t leaked_now = 0;        // 그중 leak_budget을 넘겨 아직 끝나지 않은 수
+        size_t idle = 0;              // 재사용 대기 중인 엔진
+        double last_teardown_ms = 0;
+        double max_teardown_ms = 0;
+        double total_teardown_ms = 0; // 평균 = total / completed
+    };
+
+    explicit RecognizerReaper(size_t threads = kDefaultThreads,
+                              std::chrono::milliseconds leak_budget = kDefaultLeakBudget,
+                              size_t max_idle = kDefaultMaxIdle);
+    ~RecognizerReaper(); // 남은 정리를 모두 끝낸 뒤 반환 (Azure라면 최대 leak_budget만큼 블로킹 가능)
+
+    RecognizerReaper(const RecognizerReaper&) = delete;
+    RecognizerReaper& operator=(const RecognizerReaper&) = delete;
+
+    // 재사용 가능한 엔진 (없으면 nullptr: 호출자가 팩토리로 새로 생성)
+    std::unique_ptr<RecognitionEngine> Acquire();
+    // 엔진 정리를 넘김 (블로킹하지 않음). 엔진 콜백은 호출자가 이미 차단했어야 함
+    void Retire(std::unique_ptr<RecognitionEngine> engine);
+
+    Stats stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void Teardown(uint64_t id, std::unique_ptr<RecognitionEngine> engine);
+    void UpdateLeaksLocked(Clock::time_point now) const;
+
+    const std::chrono::milliseconds leak_budget_;
+    const size_t max_idle_;
+
+    mutable std::mutex mutex_;
+    std::deque<std::unique_ptr<RecognitionEngine>> idle_;
+    struct Pending {
+        Clock::time_point retired_at;
+        bool leaked = false;
+    };
+    mutable std::unordered_map<uint64_t, Pending> pending_; // 정리 중인 엔진 (누수 판정은 조회 시점에 갱신)
+    uint64_t next_id_ = 1;
+    mutable Stats stats_;
+    TaskScheduler scheduler_; // 마지막 멤버: 소멸 시 먼저 남은 정리를 끝냄
+};
+
+} // namespace stt
@@ -0,0 +1,136 @@
+#include "scripted_recognition_engine.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace stt {
+
+ScriptedRecognitionScript LoadTranscriptSidecar(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("Cannot open transcript sidecar: " + path);
+    }
+    ScriptedRecognitionScript script;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        const size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        script.transcripts.push_back(line.substr(first));
+    }
+    if (script.transcripts.empty()) {
+        throw std::runtime_error("Transcript sidecar has no utterances: " + path);
+    }
+    return script;
+}
+
+ScriptedRecognitionEngine::ScriptedRecognitionEngine(std::string transcript, std::chrono::milliseconds audio_per_word,
+                                                     std::chrono::milliseconds finalize_delay,
+                                                     std::chrono::milliseconds teardown_delay)
+    : bytes_per_word_(static_cast<size_t>(std::max<int64_t>(1, audio_per_word.count())) * kPcmBytesPerMs),
+      finalize_delay_(finalize_delay), teardown_delay_(teardown_delay) {
+    std::istringstream words(transcript);
+    for (std::string word; words >> word;) {
+        words_.push_back(std::move(word));
+    }
+}
+
+bool ScriptedRecognitionEngine::StartContinuousRecognition(
+    const std::string& language,
+    const TextChunkCallback& text_chunk_callback,
+    const RecognitionCompletionCallback& completion_callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (active_ || !text_chunk_callback || !completion_callback) {
+        return false;
+    }
+    text_chunk_callback_ = text_chunk_callback;
+    completion_callback_ = completion_callback;
+    words_emitted_ = 0;
+    audio_bytes_received_.store(0);
+    active_ = true;
+    std::cout << "   ScriptedRecognitionEngine: started (" << language << ", " << words_.size() << " word(s) scripted)." << std::endl;
+    return true;
+}
+
+void ScriptedRecognitionEngine::PushAudioChunk(const uint8_t* /*data*/, size_t size) {
+    std::string partial;
+    TextChunkCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!active_) {
+            return;
+        }
+        const uint64_t total = audio_bytes_received_.fetch_add(size) + size;
+        const size_t due = std::min(words_.size(), static_cast<size_t>(total / bytes_per_word_));
+        if (due <= words_emitted_) {
+            return;
+        }
+        words_emitted_ = due;
+        for (size_t i = 0; i < due; ++i) {
+            if (i > 0) {
+                partial += ' ';
+            }
+            partial += words_[i];
+        }
+        callback = text_chunk_callback_;
+    }
+    callback(partial, false); // Azure Recognizing처럼 매번 처음부터의 누적 가설
+}
+
+void ScriptedRecognitionEngine::CloseInput() {
+    TextChunkCallback text_callback;
+    RecognitionCompletionCallback completion_callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!active_) {
+            return;
+        }
+        active_ = false;
+        text_callback = std::move(text_chunk_callback_);
+        completion_callback = std::move(completion_callback_);
+    }
+    if (finalize_delay_.count() > 0) {
+        std::this_thread::sleep_for(finalize_delay_);
+    }
+    if (!words_.empty()) {
+        std::string final_text;
+        for (size_t i = 0; i < words_.size(); ++i) {
+            if (i > 0) {
+                final_text += ' ';
+            }
+            final_text += words_[i];
+        }
+        text_callback(final_text, true);
+    }
+    completion_callback(true, "");
+}
+
+void ScriptedRecognitionEngine::StopContinuousRecognition() {
+    CloseInput(); // 입력을 닫지 않고 Stop한 경우 결과부터 전달 (이미 닫혔으면 아무것도 안 함)
+    if (teardown_delay_.count() > 0) {
+        std::this_thread::sleep_for(teardown_delay_);
+    }
+}
+
+RecognitionEngineFactory ScriptedRecognitionEngine::Factory(ScriptedRecognitionScript script) {
+    if (script.transcripts.empty()) {
+        throw std::runtime_error("ScriptedRecognitionEngine requires at least one transcript.");
+    }
+    auto shared_script = std::make_shared<const ScriptedRecognitionScript>(std::move(script));
+    auto next = std::make_shared<std::atomic<uint64_t>>(0);
+    return [shared_script, next]() -> std::unique_ptr<RecognitionEngine> {
+        const auto& transcripts = shared_script->transcripts;
+        const std::string& transcript = transcripts[next->fetch_add(1) % transcripts.size()];
+        return std::make_unique<ScriptedRecognitionEngine>(transcript, shared_script->audio_per_word, shared_script->finalize_delay,
+                                                           shared_script->teardown_delay);
+    };
+}
+
+} // namespace stt
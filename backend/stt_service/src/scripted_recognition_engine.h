@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "recognition_engine.h"
+
+namespace stt {
+
+// 스크립트 인식 엔진 설정. 세션마다 transcripts를 순서대로 돌려 가며 하나씩 사용한다.
+struct ScriptedRecognitionScript {
+    std::vector<std::string> transcripts;
+    std::chrono::milliseconds audio_per_word{300}; // 이만큼의 오디오가 들어올 때마다 중간 결과에 단어 하나 추가
+    std::chrono::milliseconds finalize_delay{0};   // 입력 종료 후 확정 결과까지의 지연 (클라우드 인식 종료 지연 흉내)
+    std::chrono::milliseconds teardown_delay{0};   // Stop(세션 정리)에 걸리는 시간 (클라우드 세션 종료 대기 흉내)
+};
+
+// 트랜스크립트 사이드카 파일 로드: 한 줄에 발화 하나. 빈 줄과 '#' 주석 줄은 무시.
+// 파일을 열 수 없거나 발화가 하나도 없으면 std::runtime_error
+ScriptedRecognitionScript LoadTranscriptSidecar(const std::string& path);
+
+// 네트워크/자격 증명 없이 동작하는 결정적 인식 엔진 (테스트/벤치마크용).
+// 들어온 오디오 길이에 비례해 Azure의 Recognizing처럼 누적 중간 결과를 내고, 입력 종료 시 전체 발화를 확정 결과로 낸다.
+// 콜백은 PushAudioChunk/CloseInput(입력을 닫지 않고 Stop하면 Stop)을 호출한 스레드에서 동기적으로 호출된다.
+class ScriptedRecognitionEngine final : public RecognitionEngine {
+public:
+    ScriptedRecognitionEngine(std::string transcript, std::chrono::milliseconds audio_per_word,
+                              std::chrono::milliseconds finalize_delay = std::chrono::milliseconds(0),
+                              std::chrono::milliseconds teardown_delay = std::chrono::milliseconds(0));
+
+    bool StartContinuousRecognition(
+        const std::string& language,
+        const TextChunkCallback& text_chunk_callback,
+        const RecognitionCompletionCallback& completion_callback) override;
+    void PushAudioChunk(const uint8_t* data, size_t size) override;
+    void CloseInput() override;
+    void StopContinuousRecognition() override;
+
+    uint64_t audio_bytes_received() const { return audio_bytes_received_.load(); }
+
+    // 세션마다 script의 다음 발화로 엔진을 만드는 팩토리 (여러 스레드에서 호출 가능)
+    static RecognitionEngineFactory Factory(ScriptedRecognitionScript script);
+
+private:
+    static constexpr size_t kPcmBytesPerMs = 32; // 16kHz 16-bit mono
+
+    std::vector<std::string> words_;
+    size_t bytes_per_word_;
+    std::chrono::milliseconds finalize_delay_;
+    std::chrono::milliseconds teardown_delay_;
+
+    std::mutex mutex_;
+    bool active_ = false;
+    size_t words_emitted_ = 0;
+    TextChunkCallback text_chunk_callback_;
+    RecognitionCompletionCallback completion_callback_;
+    std::atomic<uint64_t> audio_bytes_received_{0};
+};
+
+} // namespace stt
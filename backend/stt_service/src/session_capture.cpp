@@ -0,0 +1,207 @@
+#include "session_capture.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace stt {
+
+namespace {
+
+constexpr char kDataMagic[8] = {'S', 'T', 'T', 'C', 'A', 'P', '0', '1'};
+constexpr char kIndexMagic[8] = {'S', 'T', 'T', 'I', 'D', 'X', '0', '1'};
+constexpr char kRecordMagic[4] = {'S', 'R', 'E', 'C'};
+constexpr size_t kRecordHeaderSize = sizeof(kRecordMagic) + sizeof(uint32_t);
+constexpr size_t kIndexEntrySize = 32;
+
+void PutVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void PutString(std::string& out, const std::string& value) {
+    PutVarint(out, value.size());
+    out.append(value);
+}
+
+void PutFixed(std::string& out, uint64_t value, size_t bytes) { // little-endian
+    for (size_t i = 0; i < bytes; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+uint64_t GetFixed(const char* data, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(data[i])) << (8 * i);
+    }
+    return value;
+}
+
+// 레코드 본문 디코더 (범위를 벗어나면 예외)
+class BodyReader {
+public:
+    explicit BodyReader(const std::string& body) : body_(body) {}
+
+    uint64_t Varint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (pos_ >= body_.size()) break;
+            const uint8_t byte = static_cast<uint8_t>(body_[pos_++]);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) return value;
+        }
+        throw std::runtime_error("Corrupt session capture record (varint).");
+    }
+    std::string Bytes(size_t size) {
+        if (size > body_.size() - pos_) {
+            throw std::runtime_error("Corrupt session capture record (length).");
+        }
+        std::string value = body_.substr(pos_, size);
+        pos_ += size;
+        return value;
+    }
+    std::string String() { return Bytes(Varint()); }
+
+private:
+    const std::string& body_;
+    size_t pos_ = 0;
+};
+
+// 기존 파일이면 헤더 확인, 새 파일이면 헤더 기록
+void OpenWithMagic(std::ofstream& file, const std::string& path, const char (&magic)[8]) {
+    std::ifstream existing(path, std::ios::binary);
+    char header[sizeof(magic)] = {};
+    const bool has_header = existing && existing.read(header, sizeof(header)).gcount() > 0;
+    if (has_header && std::memcmp(header, magic, sizeof(magic)) != 0) {
+        throw std::runtime_error("Not a session capture file: " + path);
+    }
+    file.open(path, std::ios::binary | std::ios::app);
+    if (!file) {
+        throw std::runtime_error("Failed to open session capture file: " + path);
+    }
+    if (!has_header) {
+        file.write(magic, sizeof(magic));
+        file.flush();
+    }
+}
+
+} // namespace
+
+SessionCaptureWriter::SessionCaptureWriter(const std::string& path) : path_(path) {
+    OpenWithMagic(data_, path_, kDataMagic);
+    OpenWithMagic(index_, path_ + ".idx", kIndexMagic);
+}
+
+void SessionCaptureWriter::Append(const SessionCapture& capture) {
+    // 잠금 밖에서 인코딩
+    std::string body;
+    body.reserve(capture.audio.size() + capture.chunks.size() * 4 + capture.transcript.size() + 128);
+    PutString(body, capture.stt_session_id);
+    PutString(body, capture.frontend_session_id);
+    PutString(body, capture.language);
+    PutVarint(body, capture.turn_id);
+    PutVarint(body, capture.sample_rate_hz);
+    PutVarint(body, capture.channels);
+    PutVarint(body, capture.sample_format);
+    PutVarint(body, capture.start_unix_ms);
+    PutVarint(body, capture.chunks.size());
+    uint64_t previous_us = 0;
+    for (const auto& chunk : capture.chunks) {
+        PutVarint(body, chunk.arrival_us - previous_us);
+        PutVarint(body, chunk.size);
+        previous_us = chunk.arrival_us;
+    }
+    body.append(capture.audio); // 크기는 청크 크기의 합
+    PutString(body, capture.transcript);
+    PutVarint(body, static_cast<uint32_t>(capture.status_code));
+
+    std::string header(kRecordMagic, sizeof(kRecordMagic));
+    PutFixed(header, body.size(), sizeof(uint32_t));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    data_.seekp(0, std::ios::end);
+    const uint64_t offset = static_cast<uint64_t>(data_.tellp());
+    data_.write(header.data(), header.size());
+    data_.write(body.data(), body.size());
+    data_.flush();
+
+    std::string entry;
+    PutFixed(entry, offset, 8);
+    PutFixed(entry, header.size() + body.size(), 4);
+    PutFixed(entry, capture.chunks.empty() ? 0 : capture.chunks.back().arrival_us / 1000, 4);
+    PutFixed(entry, capture.start_unix_ms, 8);
+    PutFixed(entry, capture.chunks.size(), 4);
+    PutFixed(entry, capture.audio.size(), 4);
+    index_.write(entry.data(), entry.size());
+    index_.flush();
+    if (!data_ || !index_) {
+        throw std::runtime_error("Failed to write session capture to " + path_);
+    }
+    sessions_written_++;
+}
+
+uint64_t SessionCaptureWriter::sessions_written() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sessions_written_;
+}
+
+std::vector<SessionCaptureIndexEntry> ReadSessionCaptureIndex(const std::string& path) {
+    std::ifstream index(path + ".idx", std::ios::binary);
+    char magic[sizeof(kIndexMagic)] = {};
+    if (!index.read(magic, sizeof(magic)) || std::memcmp(magic, kIndexMagic, sizeof(magic)) != 0) {
+        throw std::runtime_error("Missing or invalid session capture index: " + path + ".idx");
+    }
+    std::vector<SessionCaptureIndexEntry> entries;
+    char raw[kIndexEntrySize];
+    while (index.read(raw, sizeof(raw))) { // 잘린 마지막 항목은 무시
+        SessionCaptureIndexEntry entry;
+        entry.record_offset = GetFixed(raw, 8);
+        entry.record_size = static_cast<uint32_t>(GetFixed(raw + 8, 4));
+        entry.duration_ms = static_cast<uint32_t>(GetFixed(raw + 12, 4));
+        entry.start_unix_ms = GetFixed(raw + 16, 8);
+        entry.chunk_count = static_cast<uint32_t>(GetFixed(raw + 24, 4));
+        entry.audio_bytes = static_cast<uint32_t>(GetFixed(raw + 28, 4));
+        entries.push_back(entry);
+    }
+    return entries;
+}
+
+SessionCapture ReadSessionCapture(const std::string& path, const SessionCaptureIndexEntry& entry) {
+    std::ifstream data(path, std::ios::binary);
+    std::string record(entry.record_size, '\0');
+    if (entry.record_size < kRecordHeaderSize || !data.seekg(static_cast<std::streamoff>(entry.record_offset)) ||
+        !data.read(&record[0], record.size()) || std::memcmp(record.data(), kRecordMagic, sizeof(kRecordMagic)) != 0 ||
+        GetFixed(record.data() + sizeof(kRecordMagic), 4) != entry.record_size - kRecordHeaderSize) {
+        throw std::runtime_error("Invalid session capture record at offset " + std::to_string(entry.record_offset));
+    }
+    const std::string body = record.substr(kRecordHeaderSize);
+    BodyReader reader(body);
+    SessionCapture capture;
+    capture.stt_session_id = reader.String();
+    capture.frontend_session_id = reader.String();
+    capture.language = reader.String();
+    capture.turn_id = reader.Varint();
+    capture.sample_rate_hz = static_cast<uint32_t>(reader.Varint());
+    capture.channels = static_cast<uint32_t>(reader.Varint());
+    capture.sample_format = static_cast<uint32_t>(reader.Varint());
+    capture.start_unix_ms = reader.Varint();
+    const uint64_t chunk_count = reader.Varint();
+    uint64_t arrival_us = 0;
+    uint64_t audio_bytes = 0;
+    for (uint64_t i = 0; i < chunk_count; ++i) {
+        SessionCapture::Chunk chunk;
+        arrival_us += reader.Varint();
+        chunk.arrival_us = arrival_us;
+        chunk.size = static_cast<uint32_t>(reader.Varint());
+        audio_bytes += chunk.size;
+        capture.chunks.push_back(chunk);
+    }
+    capture.audio = reader.Bytes(audio_bytes);
+    capture.transcript = reader.String();
+    capture.status_code = static_cast<int32_t>(reader.Varint());
+    return capture;
+}
+
+} // namespace stt
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace stt {
+
+// RecognizeStream 한 번의 입력/결과 기록 (성능 회귀 재현용).
+// 오디오는 클라이언트가 보낸 원본 형식 그대로 (재생 시 변환 경로까지 재현).
+struct SessionCapture {
+    struct Chunk {
+        uint64_t arrival_us = 0; // 세션 시작(설정 수신) 기준 도착 시각
+        uint32_t size = 0;
+    };
+
+    std::string stt_session_id;
+    std::string frontend_session_id;
+    std::string language;
+    uint64_t turn_id = 0;
+    uint32_t sample_rate_hz = 0; // RecognitionConfig 값 그대로 (0 = 기본값)
+    uint32_t channels = 0;
+    uint32_t sample_format = 0;  // stt::SampleFormat 값
+    uint64_t start_unix_ms = 0;
+    std::vector<Chunk> chunks;
+    std::string audio;           // 청크를 이어 붙인 원본 바이트
+    std::string transcript;      // LLM으로 보낸 확정 텍스트
+    int32_t status_code = 0;     // RecognizeStream 최종 grpc::StatusCode
+};
+
+// 인덱스 항목 (<path>.idx에 고정 32바이트로 기록)
+struct SessionCaptureIndexEntry {
+    uint64_t record_offset = 0; // 컨테이너 파일 안의 레코드 시작 위치
+    uint32_t record_size = 0;   // 레코드 전체 크기 (헤더 포함)
+    uint32_t duration_ms = 0;   // 마지막 청크 도착 시각
+    uint64_t start_unix_ms = 0;
+    uint32_t chunk_count = 0;
+    uint32_t audio_bytes = 0;
+};
+
+// 세션 캡처를 추가 전용 컨테이너 파일에 기록.
+//   <path>     : "STTCAP01" 헤더 + 레코드("SREC" + u32 본문 크기 + 본문). 본문의 정수는 varint, 청크 도착 시각은 이전 청크와의 차이(us)
+//   <path>.idx : "STTIDX01" 헤더 + 레코드마다 고정 크기 항목. 레코드를 다 쓴 뒤에 기록하므로 중간에 죽어도 인덱스의 레코드는 온전함
+// 여러 세션에서 동시에 호출 가능 (Append는 파일 IO를 하므로 gRPC 콜백 스레드가 아닌 작업 풀에서 호출할 것).
+// 파일을 열 수 없거나 기존 파일 헤더가 다르면 생성자에서 std::runtime_error
+class SessionCaptureWriter {
+public:
+    explicit SessionCaptureWriter(const std::string& path);
+
+    void Append(const SessionCapture& capture);
+
+    const std::string& path() const { return path_; }
+    uint64_t sessions_written() const;
+
+private:
+    const std::string path_;
+    mutable std::mutex mutex_;
+    std::ofstream data_;
+    std::ofstream index_;
+    uint64_t sessions_written_ = 0; // mutex_
+};
+
+// 인덱스를 따라 캡처를 모두 읽음 (재생 도구/테스트용). 형식이 맞지 않으면 std::runtime_error
+std::vector<SessionCaptureIndexEntry> ReadSessionCaptureIndex(const std::string& path);
+SessionCapture ReadSessionCapture(const std::string& path, const SessionCaptureIndexEntry& entry);
+
+} // namespace stt
@@ -2,18 +2,24 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <future>
 #include <atomic>
 #include <random>
 #include <sstream>
 #include <iomanip>
 #include <chrono>
-#include <thread> 
+#include <mutex>
+#include <optional>
 
-#include "llm_engine_client.h" 
-#include "azure_stt_client.h" 
-#include <google/protobuf/empty.pb.h> 
-#include "stt.pb.h" 
+#include "llm_engine_client.h"
+#include "recognition_engine.h"
+#include "transcript_stabilizer.h"
+#include "audio_converter.h"
+#include "audio_ring_buffer.h"
+#include "endpointer.h"
+#include "audio_preprocessor.h"
+#include <algorithm>
+#include <google/protobuf/empty.pb.h>
+#include "stt.pb.h"
 #include "llm.pb.h" // llm::SessionConfig 사용을 위해 추가
 
 using grpc::Status;
@@ -33,278 +39,878 @@ std::string STTServiceImpl::generate_uuid() {
     return ss.str();
 }
 
-STTServiceImpl::STTServiceImpl(std::shared_ptr<AzureSTTClient> azure_client,
-                               std::shared_ptr<LLMEngineClient> llm_client)
-  : azure_stt_client_(azure_client), llm_engine_client_(llm_client)
+STTServiceImpl::STTServiceImpl(RecognitionEngineFactory recognition_engine_factory,
+                               std::shared_ptr<LLMEngineClient> llm_client,
+                               size_t blocking_threads,
+                               size_t pump_threads,
+                               std::shared_ptr<SessionCaptureWriter> capture_writer,
+                               EndpointerConfig endpointing,
+                               size_t reaper_threads,
+                               AudioPreprocessorConfig preprocessing)
+  : recognition_engine_factory_(std::move(recognition_engine_factory)), llm_engine_client_(llm_client),
+    capture_writer_(std::move(capture_writer)), endpointing_(endpointing), preprocessing_(preprocessing), reaper_(reaper_threads),
+    scheduler_(blocking_threads), pump_scheduler_(pump_threads)
 {
-    if (!azure_stt_client_) {
-        throw std::runtime_error("AzureSTTClient cannot be null in STTServiceImpl.");
+    if (!recognition_engine_factory_) {
+        throw std::runtime_error("RecognitionEngineFactory cannot be null in STTServiceImpl.");
     }
     if (!llm_engine_client_) {
         throw std::runtime_error("LLMEngineClient cannot be null in STTServiceImpl.");
     }
+    if (preprocessing_.enabled) {
+        AudioPreprocessor probe(preprocessing_); // 설정 오류를 첫 세션이 아닌 시작 시점에 드러냄
+    }
 }
 
-Status STTServiceImpl::RecognizeStream(
-    ServerContext* context,
-    ServerReader<STTStreamRequest>* reader,
-    google::protobuf::Empty* response 
-) {
-    const std::string client_peer = context->peer();
-    std::string stt_internal_session_id; // STT 서비스 내부 세션 ID
-    std::string frontend_session_id;     // 프론트엔드 웹소켓 세션 ID
-
-    std::cout << "✅ STT_Service: New client connection from: " << client_peer << std::endl;
-
-    std::string language;
-    std::atomic<bool> azure_started{false};
-    std::atomic<bool> llm_stream_started{false};
-    std::atomic<bool> stream_error_occurred{false};
-    std::string error_message_detail; // 상세 오류 메시지 저장용
-
-    std::promise<void> azure_processing_complete_promise;
-    auto azure_processing_complete_future = azure_processing_complete_promise.get_future();
-
-    auto cleanup_resources = [&](bool stop_azure, bool finish_llm) {
-         std::cout << "🧹 STT_Service [STT_SID:" << (stt_internal_session_id.empty() ? "NO_STT_SID" : stt_internal_session_id) 
-                   << ", FE_SID:" << (frontend_session_id.empty() ? "NO_FE_SID" : frontend_session_id)
-                   << "] Cleaning up resources... StopAzure=" << stop_azure << ", FinishLLM=" << finish_llm << std::endl;
-         if (finish_llm && llm_engine_client_ && llm_stream_started.load() && llm_engine_client_->IsStreamActive()) { // IsStreamActive 추가
-             std::cout << "   Finishing LLM stream for FE_SID [" << frontend_session_id << "]..." << std::endl;
-             grpc::Status llm_status = llm_engine_client_->FinishStream();
-             if (!llm_status.ok()) {
-                  std::cerr << "   ⚠️ LLM stream finish error during cleanup: (" << llm_status.error_code() << ") "
-                            << llm_status.error_message() << std::endl;
-             } else {
-                  std::cout << "   LLM stream finished successfully during cleanup for FE_SID [" << frontend_session_id << "]." << std::endl;
-             }
-             llm_stream_started.store(false);
-         }
-         if (stop_azure && azure_stt_client_ && azure_started.load()) {
-              std::cout << "   Stopping Azure recognition for STT_SID [" << stt_internal_session_id << "]..." << std::endl;
-              azure_stt_client_->StopContinuousRecognition();
-              azure_started.store(false);
-         }
-    };
+bool STTServiceImpl::RegisterTurn(const std::string& frontend_session_id, uint64_t turn_id, size_t* earlier_in_flight) {
+    std::lock_guard<std::mutex> lock(turns_mutex_);
+    std::vector<uint64_t>& turns = session_turns_[frontend_session_id];
+    if (std::find(turns.begin(), turns.end(), turn_id) != turns.end()) {
+        return false;
+    }
+    *earlier_in_flight = static_cast<size_t>(std::count_if(turns.begin(), turns.end(), [turn_id](uint64_t t) { return t < turn_id; }));
+    turns.push_back(turn_id);
+    if (*earlier_in_flight > 0) {
+        overlapping_turns_++;
+    }
+    return true;
+}
 
-    try {
-        STTStreamRequest initial_request;
-        std::cout << "   STT_Service: Waiting for initial RecognitionConfig from client " << client_peer << "..." << std::endl;
-        if (!reader->Read(&initial_request)) {
-            error_message_detail = "Failed to read initial request from client.";
-            std::cerr << "❌ STT_Service [Peer:" << client_peer << "] " << error_message_detail << std::endl;
-            return Status(StatusCode::INVALID_ARGUMENT, error_message_detail);
-        }
-        
-        if (initial_request.request_data_case() != STTStreamRequest::kConfig) {
-            error_message_detail = "Initial request must be RecognitionConfig.";
-            std::cerr << "❌ STT_Service [Peer:" << client_peer << "] " << error_message_detail << std::endl;
-            return Status(StatusCode::INVALID_ARGUMENT, error_message_detail);
-        }
-
-        const auto& received_config = initial_request.config();
-        language = received_config.language();
-        frontend_session_id = received_config.frontend_session_id(); // ★ frontend_session_id 추출
-        stt_internal_session_id = received_config.session_id();      // STT 내부용 세션 ID (websocket_gateway가 전달)
-        
-        if (stt_internal_session_id.empty()) { // 혹시 websocket_gateway가 안줬다면 생성
-            stt_internal_session_id = generate_uuid();
-        }
-
-        // ★ frontend_session_id 유효성 검사 (필수)
-        if (frontend_session_id.empty()) {
-            error_message_detail = "CRITICAL: frontend_session_id is missing in RecognitionConfig from websocket_gateway.";
-            std::cerr << "❌ STT_Service [STT_SID:" << stt_internal_session_id << "] " << error_message_detail << std::endl;
-            // 이 경우, 클라이언트(websocket_gateway)에게 오류를 알리고 스트림을 종료해야 함
-            return Status(StatusCode::INVALID_ARGUMENT, error_message_detail);
-        }
-        if (language.empty()) {
-           error_message_detail = "Language code is missing in RecognitionConfig.";
-           std::cerr << "❌ STT_Service [STT_SID:" << stt_internal_session_id << ", FE_SID:" << frontend_session_id << "] " << error_message_detail << std::endl;
-           return Status(StatusCode::INVALID_ARGUMENT, error_message_detail);
-        }
-        std::cout << "   STT_Service [STT_SID:" << stt_internal_session_id 
-                  << ", FE_SID:" << frontend_session_id 
-                  << "] Config received: Language=" << language 
-                  << ", Received STT SID from Gateway: " << received_config.session_id() 
-                  << ", Received FE SID from Gateway: " << received_config.frontend_session_id() << std::endl;
-        std::cout << "   STT_Service: Received RecognitionConfig (ShortDebugString): " << received_config.ShortDebugString() << std::endl; // 상세 로깅
-
-
-        std::cout << "   STT_Service [STT_SID:" << stt_internal_session_id << "] Starting stream to LLM Engine for FE_SID [" << frontend_session_id << "]..." << std::endl;
-        llm::SessionConfig llm_config_to_send; 
-        llm_config_to_send.set_frontend_session_id(frontend_session_id);       
-        llm_config_to_send.set_session_id(stt_internal_session_id); // STT의 내부 세션 ID를 LLM의 내부 세션 ID로 전달 (선택적)
-        
-        std::cout << "   STT_Service: Sending SessionConfig to LLM: " << llm_config_to_send.ShortDebugString() << std::endl; // 전송 전 로깅
-
-        if (!llm_engine_client_->StartStream(llm_config_to_send)) {
-            error_message_detail = "Failed to start stream to LLM Engine.";
-            std::cerr << "❌ STT_Service [STT_SID:" << stt_internal_session_id << ", FE_SID:" << frontend_session_id << "] " << error_message_detail << std::endl;
-            stream_error_occurred.store(true);
-            // cleanup_resources는 이 함수의 끝에서 호출되므로, 여기서는 상태만 설정
-            return Status(StatusCode::INTERNAL, error_message_detail);
-        }
-        llm_stream_started.store(true);
-        std::cout << "   STT_Service [STT_SID:" << stt_internal_session_id << "] LLM stream started successfully for FE_SID [" << frontend_session_id << "]." << std::endl;
-
-
-        auto text_callback =
-            [this, stt_sid = stt_internal_session_id, fe_sid = frontend_session_id, &stream_error_occurred, &error_message_detail, llm_client = llm_engine_client_]
-            (const std::string& text, bool is_final) { 
-            if (stream_error_occurred.load()) return;
-            // std::cout << "   STT_Service [STT_SID:" << stt_sid << ", FE_SID:" << fe_sid << "] Azure Text (is_final=" << is_final << "): '" << text << "'" << std::endl;
-            if (!llm_client->SendTextChunk(text)) { // SendTextChunk는 is_final 인자를 받지 않음
-                std::cerr << "❌ STT_Service [STT_SID:" << stt_sid << ", FE_SID:" << fe_sid << "] Error sending text chunk to LLM Engine. Marking stream as error." << std::endl;
-                if (!stream_error_occurred.load()) {
-                     error_message_detail = "Failed to forward text chunk to LLM engine.";
-                     stream_error_occurred.store(true);
-                }
+AudioPreprocessor::Stats STTServiceImpl::preprocess_stats() const {
+    std::lock_guard<std::mutex> lock(preprocess_mutex_);
+    return preprocess_totals_;
+}
+
+void STTServiceImpl::AddPreprocessStats(const AudioPreprocessor::Stats& stats) {
+    std::lock_guard<std::mutex> lock(preprocess_mutex_);
+    preprocess_totals_.Add(stats);
+}
+
+void STTServiceImpl::ReleaseTurn(const std::string& frontend_session_id, uint64_t turn_id) {
+    std::lock_guard<std::mutex> lock(turns_mutex_);
+    auto it = session_turns_.find(frontend_session_id);
+    if (it == session_turns_.end()) {
+        return;
+    }
+    auto& turns = it->second;
+    turns.erase(std::remove(turns.begin(), turns.end(), turn_id), turns.end());
+    if (turns.empty()) {
+        session_turns_.erase(it);
+    }
+}
+
+// RecognizeStream 하나의 상태 머신.
+//   kAwaitingConfig  -> 첫 메시지(RecognitionConfig) 대기. 검증 후 LLM 스트림을 열고 엔진 시작을 작업 풀에 맡김
+//   kStartingEngine  -> 작업 풀에서 엔진 생성/Start (블로킹 가능). 성공하면 오디오 읽기 시작
+//   kStreaming       -> 오디오 청크를 읽어 (필요 시 변환 후) 링 버퍼에 쌓고, 펌프가 kAudioPumpInterval마다 블록 단위로 엔진에 전달
+//   kStopping        -> 클라이언트 입력 종료 또는 오류. 작업 풀에서 펌프를 멈추고 남은 오디오를 넣은 뒤 입력을 닫고,
+//                       최종 결과/완료 콜백 대기 (최대 kRecognitionCompleteTimeout)
+//   kAwaitingLlm     -> 엔진을 RecognizerReaper로 넘기고 남은 텍스트 + 확정 표시를 보내고 LLM 스트림 종료를 기다림
+//   kFinished        -> LLM 스트림 종료. Finish 호출됨 (끝점 검출 후라면 클라이언트 입력 종료까지 미룸)
+// 서버 측 끝점 검출(endpointing)이 켜져 있으면 kStreaming 중 발화 끝을 감지한 즉시 LLM 스트림을 확정/종료하고
+// kStopping으로 넘어가 인식 엔진은 뒤에서 정리한다. 이후 클라이언트가 보내는 오디오는 입력이 끝날 때까지 읽고 버린다
+// (클라이언트 쓰기가 흐름 제어에 막히지 않도록).
+// 엔진 콜백은 CallbackGate를 거친다. FinishLlm이 게이트를 닫은 뒤 엔진을 넘기므로 리액터가 삭제된 뒤
+// 리퍼에서 Stop이 콜백을 불러도 리액터에 닿지 않는다.
+// 어느 콜백/작업도 다른 스레드를 기다리며 막히지 않는다: 링 버퍼 쓰기나 펌프 배출이 진행 중이면 정지 단계(배출/입력 닫기)와
+// LLM 종료 처리는 미뤄 두고, 플래그를 마지막으로 내리는 쪽이 작업 풀에 넘긴다.
+// 참조 수: 서버 리액터(OnDone) + LLM 스트림(on_done) + 대기 중인 작업/타이머(펌프 포함). 0이 되면 삭제.
+// Finish 후에는 다른 스레드의 OnDone이 객체를 지울 수 있으므로 Finish는 잠금 밖에서, 함수의 마지막 동작으로 호출한다.
+class STTServiceImpl::SessionReactor final : public grpc::ServerReadReactor<STTStreamRequest> {
+public:
+    SessionReactor(STTServiceImpl* service, CallbackServerContext* context)
+        : service_(service), context_(context), client_peer_(context->peer()) {
+        service_->active_sessions_++;
+        std::cout << "✅ STT_Service: New client connection from: " << client_peer_ << std::endl;
+        StartRead(&request_);
+    }
+
+    void OnReadDone(bool ok) override {
+        State state;
+        bool draining;
+        bool finish_now = false;
+        Status deferred_status;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            state = state_;
+            draining = draining_client_;
+            if (state == State::kStreaming && ok) {
+                pushing_ = true; // 마지막 배출/LLM 종료 처리는 이 쓰기가 끝난 뒤로 미뤄짐
+            }
+            if (draining && !ok) {
+                draining_client_ = false;
+                finish_now = llm_done_; // LLM 스트림이 먼저 끝났으면 미뤄 둔 상태로 종료
+                deferred_status = final_status_;
             }
-        };
-
-        auto completion_callback =
-            [this, stt_sid = stt_internal_session_id, fe_sid = frontend_session_id, &stream_error_occurred, &error_message_detail, &azure_processing_complete_promise]
-            (bool success, const std::string& azure_msg) {
-             std::cout << "ℹ️ STT_Service [STT_SID:" << stt_sid << ", FE_SID:" << fe_sid << "] Azure STT processing finished. Success: " << success << std::endl;
-             if (!success) {
-                 std::cerr << "   Azure STT Error: " << azure_msg << std::endl;
-                 if (!stream_error_occurred.load()) {
-                     error_message_detail = "Azure STT recognition failed: " + azure_msg;
-                     stream_error_occurred.store(true);
-                 }
-             }
-             try {
-                 azure_processing_complete_promise.set_value();
-             } catch (const std::future_error& e) {
-                  std::cerr << "ℹ️ STT_Service [STT_SID:" << stt_sid << "] Promise already set in completion_callback: " << e.what() << std::endl;
-             }
-        };
-
-        std::cout << "   STT_Service [STT_SID:" << stt_internal_session_id << "] Starting Azure continuous recognition..." << std::endl;
-        if (!azure_stt_client_->StartContinuousRecognition(language, text_callback, completion_callback)) {
-            error_message_detail = "Failed to start Azure continuous recognition.";
-            std::cerr << "❌ STT_Service [STT_SID:" << stt_internal_session_id << ", FE_SID:" << frontend_session_id << "] " << error_message_detail << std::endl;
-            stream_error_occurred.store(true);
-            // cleanup_resources(false, true); // LLM 스트림만 정리 시도 (함수 끝에서 일괄 처리)
-            return Status(StatusCode::INTERNAL, error_message_detail);
-        }
-        azure_started.store(true);
-        std::cout << "   STT_Service [STT_SID:" << stt_internal_session_id << "] Azure recognition started successfully." << std::endl;
-
-        STTStreamRequest audio_request;
-        size_t total_bytes_received = 0;
-        std::cout << "   STT_Service [STT_SID:" << stt_internal_session_id << "] Waiting for audio chunks from client..." << std::endl;
-        while (!stream_error_occurred.load() && reader->Read(&audio_request)) {
-            if (context->IsCancelled()) {
-                 std::cout << "   STT_Service [STT_SID:" << stt_internal_session_id << "] Client cancelled the request." << std::endl;
-                 error_message_detail = "Request cancelled by client.";
-                 stream_error_occurred.store(true);
-                 break;
-            }
-
-            if (audio_request.request_data_case() == STTStreamRequest::kAudioChunk) {
-                const auto& chunk_data_str = audio_request.audio_chunk(); // proto bytes is std::string
-                if (!chunk_data_str.empty()) {
-                    total_bytes_received += chunk_data_str.size();
-                    azure_stt_client_->PushAudioChunk(
-                        reinterpret_cast<const uint8_t*>(chunk_data_str.data()),
-                        chunk_data_str.size()
-                    );
+        }
+        if (state == State::kAwaitingConfig) {
+            HandleConfig(ok);
+            return;
+        }
+        if (draining) {
+            // 끝점 검출 후: 턴은 이미 닫혔으므로 남은 오디오는 버림
+            if (ok) {
+                if (request_.request_data_case() == STTStreamRequest::kAudioChunk) {
+                    discarded_bytes_ += request_.audio_chunk().size();
                 }
-            } else if (audio_request.request_data_case() == STTStreamRequest::REQUEST_DATA_NOT_SET) {
-                 std::cerr << "⚠️ STT_Service [STT_SID:" << stt_internal_session_id << "] Received request with data not set." << std::endl;
-            } else { // Config가 또 들어온 경우 등
-                  std::cerr << "⚠️ STT_Service [STT_SID:" << stt_internal_session_id << "] Received unexpected non-audio chunk data after config (type: "
-                            << audio_request.request_data_case() << "). Ignoring." << std::endl;
+                StartRead(&request_);
+                return;
+            }
+            std::cout << "ℹ️ STT_Service [STT_SID:" << stt_sid_ << ", FE_SID:" << fe_sid_ << "] Client finished sending audio after endpoint. "
+                      << discarded_bytes_ << " trailing byte(s) discarded." << std::endl;
+            if (finish_now) {
+                Finish(deferred_status);
             }
-        } 
+            return;
+        }
+        if (state != State::kStreaming) {
+            return; // 오류/종료 진행 중: 더 읽지 않음 (Finish가 남은 읽기를 정리)
+        }
+        if (!ok) {
+            std::cout << "ℹ️ STT_Service [STT_SID:" << stt_sid_ << ", FE_SID:" << fe_sid_
+                      << "] Client finished sending audio. Total bytes received: " << total_bytes_received_ << "." << std::endl;
+            BeginStop();
+            return;
+        }
 
-        if (stream_error_occurred.load()) {
-              std::cerr << "❌ STT_Service [STT_SID:" << stt_internal_session_id << ", FE_SID:" << frontend_session_id 
-                        << "] Error occurred, exiting audio reading loop. Reason: " << error_message_detail << std::endl;
-        } else {
-              std::cout << "ℹ️ STT_Service [STT_SID:" << stt_internal_session_id << ", FE_SID:" << frontend_session_id 
-                        << "] Client finished sending audio. Total bytes received: " << total_bytes_received << "." << std::endl;
+        BufferAudio();
+        bool keep_reading;
+        bool resume_stop;
+        bool resume_llm_done = false;
+        Status llm_status;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pushing_ = false;
+            resume_stop = TakePendingStopLocked();
+            if (llm_done_pending_) {
+                llm_done_pending_ = false;
+                resume_llm_done = true;
+                llm_status = pending_llm_status_;
+            }
+            keep_reading = state_ == State::kStreaming || draining_client_;
+            if (resume_llm_done && !draining_client_) {
+                keep_reading = false; // 넘긴 OnLlmDone이 Finish함
+            }
+        }
+        if (resume_stop) {
+            PostTask(&SessionReactor::DrainAndCloseInput);
+        }
+        if (resume_llm_done) {
+            // LLM 스트림 참조는 미뤄 둔 OnLlmDone이 마지막에 놓음
+            service_->scheduler_.Post([this, llm_status]() { OnLlmDone(llm_status); });
+        }
+        if (keep_reading) {
+            StartRead(&request_);
+        }
+    }
+
+    void OnCancel() override {
+        std::cout << "   STT_Service [STT_SID:" << stt_label() << "] Client cancelled the request." << std::endl;
+        Fail("Request cancelled by client.");
+    }
+
+    void OnDone() override {
+        if (turn_registered_) {
+            service_->ReleaseTurn(fe_sid_, turn_id_);
+        }
+        service_->active_sessions_--;
+        Unref();
+    }
+
+private:
+    enum class State { kAwaitingConfig, kStartingEngine, kStreaming, kStopping, kAwaitingLlm, kFinished };
+
+    static constexpr size_t kPcmBytesPerMs = AudioConverter::kOutputSampleRateHz / 1000 * sizeof(int16_t); // 엔진 입력: 16kHz 16-bit mono
+    static constexpr size_t kPumpBlockBytes = kPcmBytesPerMs * kAudioPumpInterval.count();
+
+    struct PumpStats {
+        uint64_t ticks = 0;
+        uint64_t blocks = 0;
+        uint64_t underruns = 0;
+        size_t max_depth_bytes = 0;
+    };
+
+    std::string stt_label() const { return stt_sid_.empty() ? "N/A" : stt_sid_; }
+
+    void Ref() { refs_.fetch_add(1); }
+    void Unref() {
+        if (refs_.fetch_sub(1) == 1) {
+            delete this;
+        }
+    }
+
+    // mutex_. RunStop이 진행 중인 쓰기/배출 때문에 미뤄 뒀고 방금 마지막 쪽이 끝났으면 true (호출자가 DrainAndCloseInput을 넘김)
+    bool TakePendingStopLocked() {
+        if (!stop_pending_ || pushing_ || pump_running_) {
+            return false;
+        }
+        stop_pending_ = false;
+        return true;
+    }
+
+    // 작업 풀에서 실행 (참조를 잡아 두었다가 끝나면 놓음)
+    void PostTask(void (SessionReactor::*task)()) {
+        Ref();
+        service_->scheduler_.Post([this, task]() {
+            (this->*task)();
+            Unref();
+        });
+    }
+
+    // 끝점 검출 후의 엔진 오류/타임아웃은 이미 닫힌 턴에 영향이 없으므로 경고만 남김
+    void RecordEngineErrorLocked(const std::string& detail) {
+        if (endpointed_) {
+            std::cerr << "⚠️ STT_Service [STT_SID:" << stt_sid_ << "] " << detail << " (after endpoint; turn already closed)" << std::endl;
+            return;
+        }
+        RecordErrorLocked(detail);
+    }
+
+    void RecordErrorLocked(const std::string& detail) {
+        if (!error_) {
+            error_ = true;
+            error_detail_ = detail;
+            std::cerr << "❌ STT_Service [STT_SID:" << stt_label() << ", FE_SID:" << (fe_sid_.empty() ? "N/A" : fe_sid_)
+                      << "] " << detail << std::endl;
+        }
+    }
+
+    // 어느 스레드에서든 호출 가능: 오류를 기록하고 스트리밍 중이면 인식을 멈춤
+    void Fail(const std::string& detail) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            RecordErrorLocked(detail);
+        }
+        BeginStop();
+    }
+
+    void HandleConfig(bool ok) {
+        Status rejected = ValidateConfigAndOpenLlm(ok);
+        if (!rejected.ok()) {
+            Finish(rejected);
+        }
+    }
+
+    // 설정 검증 + LLM 스트림 열기. 거절할 상태를 반환 (OK면 엔진 시작을 작업 풀에 맡김)
+    Status ValidateConfigAndOpenLlm(bool ok) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        state_ = State::kFinished; // 아래에서 성공할 때만 kStartingEngine으로
+        if (!ok) {
+            std::cerr << "❌ STT_Service [Peer:" << client_peer_ << "] Failed to read initial request from client." << std::endl;
+            return Status(StatusCode::INVALID_ARGUMENT, "Failed to read initial request from client.");
+        }
+        if (request_.request_data_case() != STTStreamRequest::kConfig) {
+            std::cerr << "❌ STT_Service [Peer:" << client_peer_ << "] Initial request must be RecognitionConfig." << std::endl;
+            return Status(StatusCode::INVALID_ARGUMENT, "Initial request must be RecognitionConfig.");
         }
 
-        if (azure_started.load()) {
-            std::cout << "   STT_Service [STT_SID:" << stt_internal_session_id << "] Signaling Azure to stop continuous recognition." << std::endl;
-            azure_stt_client_->StopContinuousRecognition();
+        const auto& received_config = request_.config();
+        language_ = received_config.language();
+        fe_sid_ = received_config.frontend_session_id(); // ★ frontend_session_id 추출
+        stt_sid_ = received_config.session_id();         // STT 내부용 세션 ID (websocket_gateway가 전달)
+        if (stt_sid_.empty()) { // 혹시 websocket_gateway가 안줬다면 생성
+            stt_sid_ = generate_uuid();
         }
 
-        std::cout << "   STT_Service [STT_SID:" << stt_internal_session_id << "] Waiting for Azure STT processing to complete..." << std::endl;
-        std::future_status wait_status = azure_processing_complete_future.wait_for(std::chrono::seconds(30));
-        if (wait_status == std::future_status::timeout) {
-             std::cerr << "❌ STT_Service [STT_SID:" << stt_internal_session_id << ", FE_SID:" << frontend_session_id 
-                       << "] Timed out waiting for Azure STT completion (30s)." << std::endl;
-             if (!stream_error_occurred.load()) {
-                 error_message_detail = "Timeout waiting for Azure STT completion.";
-                 stream_error_occurred.store(true);
-             }
+        std::string invalid;
+        AudioFormat audio_format;
+        if (fe_sid_.empty()) {
+            invalid = "CRITICAL: frontend_session_id is missing in RecognitionConfig from websocket_gateway.";
+        } else if (language_.empty()) {
+            invalid = "Language code is missing in RecognitionConfig.";
         } else {
-             std::cout << "   STT_Service [STT_SID:" << stt_internal_session_id << "] Azure STT processing completed or error signal received." << std::endl;
-        }
-
-        Status final_llm_status = Status::OK;
-        if (llm_stream_started.load()) {
-             std::cout << "   STT_Service [STT_SID:" << stt_internal_session_id << "] Finishing LLM engine stream for FE_SID [" << frontend_session_id << "]..." << std::endl;
-             grpc::Status llm_status = llm_engine_client_->FinishStream();
-             final_llm_status = llm_status;
-             llm_stream_started.store(false);
-
-             if (!llm_status.ok()) {
-                 std::cerr << "❌ STT_Service [STT_SID:" << stt_internal_session_id << ", FE_SID:" << frontend_session_id 
-                           << "] LLM stream finish error: (" << llm_status.error_code() << ") "
-                           << llm_status.error_message() << std::endl;
-                  if (!stream_error_occurred.load()) {
-                     error_message_detail = "Failed to finish LLM stream: " + llm_status.error_message();
-                     stream_error_occurred.store(true);
-                  }
-             } else {
-                  std::cout << "   STT_Service [STT_SID:" << stt_internal_session_id << "] LLM stream finished successfully for FE_SID [" << frontend_session_id << "]." << std::endl;
-             }
+            // 입력 오디오 형식 (생략 시 16kHz 16-bit mono). 인식 엔진 입력 형식과 다르면 스트림 동안 변환
+            if (received_config.sample_rate_hz() != 0) audio_format.sample_rate_hz = received_config.sample_rate_hz();
+            if (received_config.channels() != 0) audio_format.channels = received_config.channels();
+            switch (received_config.sample_format()) {
+                case ::stt::SAMPLE_FORMAT_UNSPECIFIED:
+                case ::stt::SAMPLE_FORMAT_INT16: audio_format.sample_format = AudioFormat::SampleFormat::kInt16; break;
+                case ::stt::SAMPLE_FORMAT_FLOAT32: audio_format.sample_format = AudioFormat::SampleFormat::kFloat32; break;
+                default: invalid = "Unsupported sample format in RecognitionConfig."; break;
+            }
+            if (invalid.empty()) {
+                invalid = AudioConverter::Validate(audio_format);
+            }
+        }
+        if (!invalid.empty()) {
+            std::cerr << "❌ STT_Service [STT_SID:" << stt_sid_ << ", FE_SID:" << fe_sid_ << "] " << invalid << std::endl;
+            return Status(StatusCode::INVALID_ARGUMENT, invalid);
+        }
+        turn_id_ = received_config.turn_id();
+        if (turn_id_ != 0) {
+            // 턴 번호 0은 턴 정보를 모르는 구버전 클라이언트 - 추적하지 않음
+            size_t earlier_in_flight = 0;
+            if (!service_->RegisterTurn(fe_sid_, turn_id_, &earlier_in_flight)) {
+                std::cerr << "❌ STT_Service [STT_SID:" << stt_sid_ << ", FE_SID:" << fe_sid_ << "] Turn " << turn_id_
+                          << " is already in progress for this session." << std::endl;
+                return Status(StatusCode::ALREADY_EXISTS, "Turn " + std::to_string(turn_id_) + " is already in progress.");
+            }
+            turn_registered_ = true;
+            if (earlier_in_flight > 0) {
+                std::cout << "🔀 STT_Service [STT_SID:" << stt_sid_ << ", FE_SID:" << fe_sid_ << "] Turn " << turn_id_ << " overlaps "
+                          << earlier_in_flight << " earlier turn(s) still finishing." << std::endl;
+            }
+        }
+        converter_.emplace(audio_format);
+        if (service_->endpointing_.enabled) {
+            endpointer_.emplace(service_->endpointing_);
+        }
+        if (service_->preprocessing_.enabled) {
+            preprocessor_.emplace(service_->preprocessing_);
+        }
+        if (service_->capture_writer_) {
+            capture_ = std::make_shared<SessionCapture>();
+            capture_->stt_session_id = stt_sid_;
+            capture_->frontend_session_id = fe_sid_;
+            capture_->language = language_;
+            capture_->turn_id = received_config.turn_id();
+            capture_->sample_rate_hz = received_config.sample_rate_hz();
+            capture_->channels = received_config.channels();
+            capture_->sample_format = static_cast<uint32_t>(received_config.sample_format());
+            capture_->start_unix_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count());
+            capture_start_ = std::chrono::steady_clock::now();
+        }
+        std::cout << "   STT_Service [STT_SID:" << stt_sid_ << ", FE_SID:" << fe_sid_
+                  << "] Config received: Language=" << language_ << ", Turn=" << received_config.turn_id()
+                  << ", Audio format: " << audio_format.ToString()
+                  << (converter_->passthrough() ? " (passthrough)" : std::string(" -> 16000Hz/1ch/s16 (") + AudioConverter::SimdName(converter_->simd()) + ")") << std::endl;
+
+        llm::SessionConfig llm_config_to_send;
+        llm_config_to_send.set_frontend_session_id(fe_sid_);
+        llm_config_to_send.set_session_id(stt_sid_); // STT의 내부 세션 ID를 LLM의 내부 세션 ID로 전달 (선택적)
+        llm_config_to_send.set_turn_id(received_config.turn_id()); // barge-in 취소 대상 식별용 턴 번호 전달
+
+        Ref(); // LLM 스트림 on_done이 놓음
+        llm_writer_ = service_->llm_engine_client_->OpenTurn(llm_config_to_send, [this](const Status& status) { OnLlmDone(status); });
+        if (!llm_writer_) {
+            refs_.fetch_sub(1); // 서버 리액터 참조가 남아 있으므로 삭제되지 않음
+            std::cerr << "❌ STT_Service [STT_SID:" << stt_sid_ << ", FE_SID:" << fe_sid_ << "] Failed to start stream to LLM Engine." << std::endl;
+            return Status(StatusCode::INTERNAL, "Failed to start stream to LLM Engine.");
+        }
+        state_ = State::kStartingEngine;
+        PostTask(&SessionReactor::StartEngine);
+        return Status::OK;
+    }
+
+    // 작업 풀: 엔진 확보 (리퍼가 재사용한 것 우선, 없으면 생성) + StartContinuousRecognition (Azure는 연결 수립까지 블로킹)
+    void StartEngine() {
+        std::unique_ptr<RecognitionEngine> engine;
+        bool started = false;
+        try {
+            engine = service_->reaper_.Acquire();
+            if (!engine) {
+                engine = service_->recognition_engine_factory_();
+            }
+            auto gate = callback_gate_;
+            started = engine && engine->StartContinuousRecognition(
+                language_,
+                [this, gate](const std::string& text, bool is_final) {
+                    std::lock_guard<std::mutex> lock(gate->mutex);
+                    if (gate->open) {
+                        OnText(text, is_final);
+                    }
+                },
+                [this, gate](bool success, const std::string& engine_msg) {
+                    std::lock_guard<std::mutex> lock(gate->mutex);
+                    if (gate->open) {
+                        OnRecognitionComplete(success, engine_msg);
+                    }
+                });
+        } catch (const std::exception& e) {
+            std::cerr << "❌ STT_Service [STT_SID:" << stt_sid_ << "] Exception while starting recognition: " << e.what() << std::endl;
+        }
+
+        bool cancelled_meanwhile = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            engine_ = std::move(engine);
+            if (!started) {
+                RecordErrorLocked("Failed to start continuous recognition.");
+                state_ = State::kStopping;
+                finishing_ = true;
+            } else {
+                std::cout << "   STT_Service [STT_SID:" << stt_sid_ << "] Recognition started successfully. Waiting for audio chunks from client..." << std::endl;
+                state_ = State::kStreaming;
+                cancelled_meanwhile = error_; // 시작하는 동안 클라이언트가 취소함
+                if (!cancelled_meanwhile) {
+                    next_pump_deadline_ = TaskScheduler::Clock::now() + kAudioPumpInterval;
+                    SchedulePumpLocked();
+                }
+            }
+        }
+        if (!started) {
+            FinishLlm(); // 엔진 반납 + LLM 스트림 취소 -> OnLlmDone에서 Finish
+        } else if (cancelled_meanwhile) {
+            BeginStop();
         } else {
-             std::cout << "   STT_Service [STT_SID:" << stt_internal_session_id << "] LLM stream was not started or already finished, skipping finish." << std::endl;
+            StartRead(&request_);
         }
+    }
 
-        std::cout << "🏁 STT_Service [STT_SID:" << stt_internal_session_id << ", FE_SID:" << frontend_session_id << "] Processing complete. Final status check." << std::endl;
-        if (stream_error_occurred.load()) {
-            if (context->IsCancelled()) { // 클라이언트가 명시적으로 취소한 경우
-                std::cerr << "❌ STT_Service [STT_SID:" << stt_internal_session_id << "] Returning CANCELLED status due to client cancellation." << std::endl;
-                 // cleanup_resources는 finally 블록처럼 여기서 호출될 것임
-                return Status(StatusCode::CANCELLED, "Request cancelled by client during processing: " + error_message_detail);
+    // 읽기 경로(생산자): 엔진 입력 형식으로 변환해 링 버퍼에 쌓음
+    void BufferAudio() {
+        if (request_.request_data_case() == STTStreamRequest::kAudioChunk) {
+            const std::string& chunk = request_.audio_chunk(); // proto bytes is std::string
+            if (chunk.empty()) {
+                return;
+            }
+            total_bytes_received_ += chunk.size();
+            if (capture_) {
+                const auto arrival = std::chrono::steady_clock::now() - capture_start_;
+                capture_->chunks.push_back({static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(arrival).count()),
+                                            static_cast<uint32_t>(chunk.size())});
+                capture_->audio.append(chunk);
             }
-            // LLM 스트림 종료 오류가 최종 오류인 경우 해당 상태 반환
-            if (!final_llm_status.ok() && final_llm_status.error_code() != StatusCode::CANCELLED) { // LLM 오류가 취소가 아니라면
-                 std::cerr << "❌ STT_Service [STT_SID:" << stt_internal_session_id << "] Returning LLM finish error status: (" 
-                           << final_llm_status.error_code() << ")" << std::endl;
-                 return final_llm_status;
+            const uint8_t* pcm = reinterpret_cast<const uint8_t*>(chunk.data());
+            size_t pcm_bytes = chunk.size();
+            if (!converter_->passthrough()) {
+                converted_pcm_.clear();
+                converter_->Convert(pcm, pcm_bytes, converted_pcm_);
+                pcm = reinterpret_cast<const uint8_t*>(converted_pcm_.data());
+                pcm_bytes = converted_pcm_.size() * sizeof(int16_t);
             }
-            // 그 외 내부 오류
-            std::cerr << "❌ STT_Service [STT_SID:" << stt_internal_session_id << "] Returning INTERNAL error status: " << error_message_detail << std::endl;
-            return Status(StatusCode::INTERNAL, "An internal error occurred in STT service: " + error_message_detail);
+            if (pcm_bytes > 0 && !audio_ring_.Write(pcm, pcm_bytes)) {
+                // 펌프가 밀린 경우 (kAudioRingDuration 이상 적체). 읽기를 막지 않고 버린 양만 집계
+                if (overrun_bytes_.fetch_add(pcm_bytes) == 0) {
+                    std::cerr << "⚠️ STT_Service [STT_SID:" << stt_sid_ << "] Audio ring buffer full; dropping audio." << std::endl;
+                }
+            }
+        } else if (request_.request_data_case() == STTStreamRequest::REQUEST_DATA_NOT_SET) {
+            std::cerr << "⚠️ STT_Service [STT_SID:" << stt_sid_ << "] Received request with data not set." << std::endl;
+        } else { // Config가 또 들어온 경우 등
+            std::cerr << "⚠️ STT_Service [STT_SID:" << stt_sid_ << "] Received unexpected non-audio chunk data after config (type: "
+                      << request_.request_data_case() << "). Ignoring." << std::endl;
+        }
+    }
+
+    // next_pump_deadline_에 펌프 주기 예약 (타이머가 참조를 잡고, 스케줄러 소멸로 버려지면 on_drop이 놓음)
+    void SchedulePumpLocked() {
+        Ref();
+        pump_timer_ = service_->pump_scheduler_.PostAt(next_pump_deadline_, [this]() { PumpTick(); Unref(); }, [this]() { Unref(); });
+    }
+
+    // 다음 기한 = 이전 기한 + 주기 (실행 지연이 주기에 누적되지 않음). 한 주기 넘게 밀렸으면
+    // 밀린 주기는 건너뜀 (이번 주기에서 쌓인 블록을 모두 배출했으므로 연달아 돌 필요 없음)
+    void AdvancePumpDeadlineLocked() {
+        next_pump_deadline_ += kAudioPumpInterval;
+        const auto now = TaskScheduler::Clock::now();
+        if (next_pump_deadline_ <= now) {
+            const auto behind = (now - next_pump_deadline_) / kAudioPumpInterval + 1;
+            next_pump_deadline_ += behind * kAudioPumpInterval;
+        }
+    }
+
+    // 오디오 펌프 (소비자): 쌓인 완전한 블록을 모두 엔진에 넣고 다음 주기 예약.
+    // 스트리밍이 끝났으면 아무것도 하지 않음 (남은 오디오는 DrainAndCloseInput이 배출)
+    void PumpTick() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pump_timer_ = 0;
+            if (state_ != State::kStreaming) {
+                return;
+            }
+            pump_running_ = true;
+        }
+        const bool end_of_speech = DrainAudio(false);
+        bool resume_stop;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pump_running_ = false;
+            resume_stop = TakePendingStopLocked();
+            if (state_ == State::kStreaming && !end_of_speech) {
+                AdvancePumpDeadlineLocked();
+                SchedulePumpLocked();
+            }
+        }
+        if (resume_stop) {
+            PostTask(&SessionReactor::DrainAndCloseInput);
+        }
+        if (end_of_speech) {
+            OnEndOfSpeech();
+        }
+    }
+
+    // 소비자 전용 (펌프 주기 또는 펌프를 멈춘 뒤의 DrainAndCloseInput). flush면 블록에 못 미치는 꼬리까지 넣음.
+    // 펌프 주기에서 끝점이 검출되면 그 블록까지만 넣고 true
+    bool DrainAudio(bool flush) {
+        const size_t depth = audio_ring_.size();
+        pump_stats_.ticks++;
+        pump_stats_.max_depth_bytes = std::max(pump_stats_.max_depth_bytes, depth);
+        if (depth > 0) {
+            audio_started_ = true;
+        }
+        if (!flush && audio_started_ && depth < kPumpBlockBytes) {
+            pump_stats_.underruns++; // 오디오가 시작된 뒤 이번 주기에 엔진에 넣을 블록이 없음 (네트워크 지연)
+        }
+        while (audio_ring_.size() >= kPumpBlockBytes) {
+            audio_ring_.Read(pump_block_.data(), kPumpBlockBytes);
+            Preprocess(kPumpBlockBytes);
+            engine_->PushAudioChunk(pump_block_.data(), kPumpBlockBytes);
+            pump_stats_.blocks++;
+            if (!flush && endpointer_ &&
+                endpointer_->OnAudio(reinterpret_cast<const int16_t*>(pump_block_.data()), kPumpBlockBytes / sizeof(int16_t))) {
+                return true;
+            }
+        }
+        if (flush) {
+            const size_t tail = audio_ring_.Read(pump_block_.data(), kPumpBlockBytes);
+            if (tail > 0) {
+                Preprocess(tail);
+                engine_->PushAudioChunk(pump_block_.data(), tail);
+                pump_stats_.blocks++;
+            }
+        }
+        return false;
+    }
+
+    // 소비자 전용. 펌프 블록을 엔진에 넣기 전에 제자리에서 전처리 (끝점 검출도 전처리된 오디오를 봄)
+    void Preprocess(size_t bytes) {
+        if (preprocessor_) {
+            preprocessor_->Process(reinterpret_cast<int16_t*>(pump_block_.data()), bytes / sizeof(int16_t));
+        }
+    }
+
+    // 펌프 스레드: 발화 끝. LLM 턴을 바로 확정/종료하고 인식 엔진 정지는 작업 풀에서 진행
+    void OnEndOfSpeech() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (state_ != State::kStreaming) {
+                return; // 이미 클라이언트 입력 종료/오류로 정지 중
+            }
+            state_ = State::kStopping;
+            endpointed_ = true;
+            draining_client_ = true;
+        }
+        std::cout << "🎯 STT_Service [STT_SID:" << stt_sid_ << ", FE_SID:" << fe_sid_ << "] End of speech at " << endpointer_->audio_ms()
+                  << " ms of audio (trailing silence " << endpointer_->trailing_silence_ms()
+                  << " ms). Closing LLM turn; recognition stops in background." << std::endl;
+        CloseLlmTurn();
+        PostTask(&SessionReactor::RunStop);
+    }
+
+    // 엔진 콜백 스레드: 중간 결과 수정 이력을 추적해 확정된 증분만 LLM으로 보냄
+    void OnText(const std::string& text, bool is_final) {
+        // 전송까지 잠금 유지: 증분 순서가 엔진 콜백 순서와 같아야 함 (Send는 큐에 넣기만 하므로 블로킹 없음)
+        std::lock_guard<std::mutex> lock(text_mutex_);
+        if (text_closed_) {
+            return;
+        }
+        if (endpointer_) {
+            endpointer_->OnTranscript(text);
+        }
+        const std::string delta = is_final ? stabilizer_.OnFinal(text) : stabilizer_.OnHypothesis(text);
+        if (delta.empty()) {
+            return;
+        }
+        if (!llm_writer_->SendTextChunk(delta)) {
+            text_closed_ = true;
+            Fail("Failed to forward text chunk to LLM engine.");
+        } else if (capture_) {
+            capture_->transcript += delta;
+        }
+    }
+
+    // 스트리밍 중이면 kStopping으로 전환하고 RunStop을 작업 풀에 맡김 (한 번만)
+    void BeginStop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (state_ != State::kStreaming) {
+                return;
+            }
+            state_ = State::kStopping;
+        }
+        PostTask(&SessionReactor::RunStop);
+    }
+
+    // 작업 풀: 펌프를 멈춤. 링 버퍼 쓰기나 펌프 배출이 진행 중이면 기다리지 않고, 그 쪽이 끝나면서
+    // DrainAndCloseInput을 작업 풀에 넘김 (kStopping 이후 pushing_/pump_running_은 다시 켜지지 않음)
+    void RunStop() {
+        bool pump_cancelled = false;
+        bool busy;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pump_cancelled = pump_timer_ != 0 && service_->pump_scheduler_.Cancel(pump_timer_);
+            pump_timer_ = 0;
+            busy = pushing_ || pump_running_;
+            stop_pending_ = busy;
+        }
+        if (pump_cancelled) {
+            Unref(); // 이 작업이 참조를 잡고 있으므로 삭제되지 않음
+        }
+        if (!busy) {
+            DrainAndCloseInput();
+        }
+    }
+
+    // 작업 풀 (소비자가 없을 때만): 남은 오디오를 넣고 입력을 닫음 (블로킹하지 않음).
+    // 블로킹되는 Stop은 최종 결과/완료 콜백 뒤 리퍼가 호출
+    void DrainAndCloseInput() {
+        DrainAudio(true);
+        if (preprocessor_) {
+            service_->AddPreprocessStats(preprocessor_->stats()); // 마지막 소비자 작업
+        }
+        std::cout << "   STT_Service [STT_SID:" << stt_sid_ << "] Closing recognizer input; waiting for the final result." << std::endl;
+        engine_->CloseInput();
+
+        bool proceed = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            input_closed_ = true;
+            if (recognition_complete_) {
+                proceed = !finishing_;
+                finishing_ = true;
+            } else {
+                Ref(); // 타이머가 놓음 (먼저 취소되면 OnRecognitionComplete가 놓음)
+                timeout_timer_ = service_->scheduler_.PostAfter(
+                    std::chrono::duration_cast<std::chrono::milliseconds>(kRecognitionCompleteTimeout),
+                    [this]() { OnRecognitionTimeout(); Unref(); }, [this]() { Unref(); });
+            }
+        }
+        if (proceed) {
+            FinishLlm();
+        }
+    }
+
+    // 엔진 콜백 스레드 (CloseInput 안에서 동기적으로 올 수도 있음). 게이트 잠금 아래에서 실행
+    void OnRecognitionComplete(bool success, const std::string& engine_msg) {
+        std::cout << "ℹ️ STT_Service [STT_SID:" << stt_sid_ << ", FE_SID:" << fe_sid_ << "] STT processing finished. Success: " << success << std::endl;
+        bool stop_now = false;
+        bool proceed = false;
+        bool release_timer = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!success) {
+                RecordEngineErrorLocked("STT recognition failed: " + engine_msg);
+            }
+            recognition_complete_ = true;
+            if (state_ == State::kStreaming) {
+                stop_now = true; // 클라이언트 입력이 끝나기 전에 엔진이 먼저 끝남 (오류 등)
+            } else if (state_ == State::kStopping && input_closed_ && !finishing_) {
+                finishing_ = true;
+                proceed = true;
+                release_timer = timeout_timer_ != 0 && service_->scheduler_.Cancel(timeout_timer_);
+            }
+        }
+        if (stop_now) {
+            BeginStop();
+        } else if (proceed) {
+            // 콜백 게이트를 닫는 FinishLlm은 콜백 안에서 부를 수 없으므로 작업 풀로 넘김
+            PostTask(&SessionReactor::FinishLlm);
+        }
+        if (release_timer) {
+            Unref(); // 위 작업이 참조를 잡고 있으므로 삭제되지 않음
+        }
+    }
+
+    void OnRecognitionTimeout() {
+        bool proceed = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!finishing_) {
+                RecordEngineErrorLocked("Timeout waiting for STT completion.");
+                finishing_ = true;
+                proceed = true;
+            }
+        }
+        if (proceed) {
+            FinishLlm();
+        }
+    }
+
+    // 작업 풀 (엔진 콜백 밖): 콜백 게이트를 닫고 엔진을 리퍼로 넘긴 뒤 LLM 스트림 마무리
+    // (끝점 검출로 이미 닫았으면 엔진 반납만). 블로킹되는 Stop/소멸은 리퍼가 처리
+    void FinishLlm() {
+        {
+            // 진행 중인 콜백이 끝날 때까지 기다림. 이후 엔진 콜백은 리액터에 닿지 않음
+            std::lock_guard<std::mutex> gate_lock(callback_gate_->mutex);
+            callback_gate_->open = false;
+        }
+        std::unique_ptr<RecognitionEngine> engine;
+        bool endpointed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            engine = std::move(engine_);
+            endpointed = endpointed_;
+        }
+        service_->reaper_.Retire(std::move(engine));
+        if (endpointed) {
+            std::cout << "   STT_Service [STT_SID:" << stt_sid_ << "] Recognition stopped after endpoint." << std::endl;
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            state_ = State::kAwaitingLlm;
+        }
+        CloseLlmTurn();
+    }
+
+    // LLM 턴 마무리 (한 번만). 정상이면 남은 꼬리 + 확정 표시 후 닫고, 오류면 취소
+    void CloseLlmTurn() {
+        std::lock_guard<std::mutex> text_lock(text_mutex_);
+        text_closed_ = true;
+        bool error;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            error = error_;
+        }
+        if (!error) {
+            const std::string tail = stabilizer_.Flush();
+            if (capture_) {
+                capture_->transcript += tail;
+            }
+            if ((!tail.empty() && !llm_writer_->SendTextChunk(tail)) || !llm_writer_->SendTranscriptFinal()) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                RecordErrorLocked("Failed to send final transcript to LLM engine.");
+                error = true;
+            }
+            const auto& stats = stabilizer_.stats();
+            std::cout << "   STT_Service [STT_SID:" << stt_sid_ << "] Transcript stabilizer: " << stats.hypotheses
+                      << " partial(s), " << stats.finals << " final(s) -> " << stats.deltas << " chunk(s), "
+                      << stats.committed_words << " word(s), " << stats.revisions_after_commit << " late revision(s)." << std::endl;
+            std::cout << "   STT_Service [STT_SID:" << stt_sid_ << "] Audio pump: " << pump_stats_.blocks << " block(s) in "
+                      << pump_stats_.ticks << " tick(s), max queue depth " << pump_stats_.max_depth_bytes / kPcmBytesPerMs << " ms, "
+                      << pump_stats_.underruns << " underrun(s), " << overrun_bytes_.load() << " byte(s) dropped." << std::endl;
+            if (preprocessor_) {
+                const auto& pre = preprocessor_->stats();
+                const auto per_block_us = [&pre](uint64_t ns) { return pre.blocks ? ns / 1000.0 / pre.blocks : 0.0; };
+                std::cout << "   STT_Service [STT_SID:" << stt_sid_ << "] Preprocess (" << AudioConverter::SimdName(preprocessor_->simd())
+                          << "): " << pre.blocks << " block(s), us/block convert " << per_block_us(pre.convert_ns) << ", high-pass "
+                          << per_block_us(pre.high_pass_ns) << ", gate " << per_block_us(pre.gate_ns) << ", agc "
+                          << per_block_us(pre.agc_ns) << "; gain " << preprocessor_->agc_gain_db() << " dB, "
+                          << pre.gated_blocks << " gated, " << pre.limited_blocks << " limited block(s)." << std::endl;
+            }
+        }
+        // 이후 writer는 OnDone에서 스스로 삭제되므로 다시 사용하지 않음 (OnText는 text_closed_로 차단됨)
+        if (error) {
+            llm_writer_->Cancel(); // 중단된 발화에는 LLM이 응답하지 않음
         } else {
-            std::cout << "✅ STT_Service [STT_SID:" << stt_internal_session_id << "] Returning OK status." << std::endl;
-            return Status::OK;
-        }
-
-    } catch (const std::exception& e) {
-        std::cerr << "❌ STT_Service [STT_SID:" << (stt_internal_session_id.empty() ? "N/A" : stt_internal_session_id) 
-                  << ", FE_SID:" << (frontend_session_id.empty() ? "N/A" : frontend_session_id)
-                  << "] Unhandled exception in RecognizeStream: " << e.what() << std::endl;
-        stream_error_occurred.store(true); // 오류 플래그 설정
-        error_message_detail = "Unhandled exception: " + std::string(e.what());
-        // cleanup_resources는 함수 종료 시 호출됨
-        return Status(StatusCode::UNKNOWN, "An unknown exception occurred in the STT service handler.");
-    } catch (...) {
-         std::cerr << "❌ STT_Service [STT_SID:" << (stt_internal_session_id.empty() ? "N/A" : stt_internal_session_id) 
-                   << ", FE_SID:" << (frontend_session_id.empty() ? "N/A" : frontend_session_id)
-                   << "] Unknown non-standard exception in RecognizeStream." << std::endl;
-         stream_error_occurred.store(true);
-         error_message_detail = "Unknown non-standard exception.";
-         return Status(StatusCode::UNKNOWN, "An unknown non-standard exception occurred.");
+            std::cout << "   STT_Service [STT_SID:" << stt_sid_ << "] Finishing LLM engine stream for FE_SID [" << fe_sid_ << "]..." << std::endl;
+            llm_writer_->Close();
+        }
+    }
+
+    // LLM 스트림 종료 (gRPC 스레드, 또는 미뤄진 경우 작업 풀). 세션의 최종 상태 결정
+    void OnLlmDone(const Status& llm_status) {
+        Status status = Status::OK;
+        bool defer_finish;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pushing_) {
+                // 읽기 경로가 아직 캡처 오디오를 기록 중 (끝점 검출 직후에만): 기다리지 않고 쓰기를 끝낸 OnReadDone이 다시 넘김
+                llm_done_pending_ = true;
+                pending_llm_status_ = llm_status;
+                return;
+            }
+            llm_writer_ = nullptr;
+            if (!endpointed_) {
+                state_ = State::kFinished; // 끝점 검출 후라면 상태는 뒤에서 진행 중인 엔진 정지(kStopping)가 계속 사용
+            }
+            if (!error_ && !llm_status.ok()) {
+                RecordErrorLocked("Failed to finish LLM stream: " + llm_status.error_message());
+            }
+            if (error_) {
+                if (context_->IsCancelled()) { // 클라이언트가 명시적으로 취소한 경우
+                    status = Status(StatusCode::CANCELLED, "Request cancelled by client during processing: " + error_detail_);
+                } else if (!llm_status.ok() && llm_status.error_code() != StatusCode::CANCELLED) {
+                    status = llm_status; // LLM 스트림 종료 오류가 최종 오류
+                } else {
+                    status = Status(StatusCode::INTERNAL, "An internal error occurred in STT service: " + error_detail_);
+                }
+                std::cerr << "❌ STT_Service [STT_SID:" << stt_sid_ << "] Returning error status: (" << status.error_code() << ") " << status.error_message() << std::endl;
+            } else {
+                std::cout << "✅ STT_Service [STT_SID:" << stt_sid_ << "] Returning OK status." << std::endl;
+            }
+            defer_finish = draining_client_; // 끝점 검출 후 클라이언트가 아직 오디오를 보내는 중: 입력 종료 시 Finish
+            if (defer_finish) {
+                llm_done_ = true;
+                final_status_ = status;
+            }
+        }
+        if (capture_) {
+            // 파일 IO는 작업 풀에서 (리액터 수명과 무관하게 캡처와 기록기만 붙잡음)
+            capture_->status_code = static_cast<int32_t>(status.error_code());
+            service_->scheduler_.Post([writer = service_->capture_writer_, capture = std::move(capture_)]() {
+                writer->Append(*capture);
+            });
+        }
+        if (!defer_finish) {
+            Finish(status);
+        }
+        Unref(); // LLM 스트림 참조 (Finish를 미뤘으면 서버 리액터 참조가 남아 있음)
     }
+
+    STTServiceImpl* service_;
+    CallbackServerContext* context_;
+    const std::string client_peer_;
+    std::atomic<int> refs_{1};
+
+    // 설정 이후 불변 (ValidateConfigAndOpenLlm에서 한 번 기록)
+    std::string stt_sid_;
+    std::string fe_sid_;
+    std::string language_;
+    uint64_t turn_id_ = 0;
+    bool turn_registered_ = false; // 서비스의 세션별 턴 목록에 등록됨 (OnDone에서 해제)
+
+    // 읽기 경로 전용 (동시에 걸린 읽기는 항상 하나)
+    STTStreamRequest request_;
+    std::optional<AudioConverter> converter_;
+    std::vector<int16_t> converted_pcm_; // 변환 버퍼 (청크마다 재사용)
+    size_t total_bytes_received_ = 0;
+    size_t discarded_bytes_ = 0;         // 끝점 검출 후 버린 오디오
+
+    // 링 버퍼: 생산자 = 읽기 경로, 소비자 = 펌프 주기/DrainAndCloseInput (pump_running_으로 한 번에 하나만)
+    AudioRingBuffer audio_ring_{kPcmBytesPerMs * kAudioRingDuration.count()};
+    std::vector<uint8_t> pump_block_ = std::vector<uint8_t>(kPumpBlockBytes); // 소비자 전용
+    PumpStats pump_stats_;                     // 소비자 전용
+    bool audio_started_ = false;               // 소비자 전용
+    std::atomic<uint64_t> overrun_bytes_{0};
+    std::optional<AudioPreprocessor> preprocessor_; // 전처리가 켜진 경우만. 소비자 전용
+    std::optional<Endpointer> endpointer_; // 끝점 검출이 켜진 경우만 (오디오는 펌프, 텍스트는 OnText에서 입력)
+
+    // 세션 캡처 (켜진 경우만): 오디오는 읽기 경로, 텍스트는 text_mutex_ 아래에서 기록. OnLlmDone에서 기록기로 넘김
+    std::shared_ptr<SessionCapture> capture_;
+    std::chrono::steady_clock::time_point capture_start_;
+
+    std::mutex mutex_;
+    State state_ = State::kAwaitingConfig;     // mutex_
+    bool pushing_ = false;                     // mutex_: OnReadDone이 링 버퍼에 오디오를 쓰는 중
+    bool pump_running_ = false;                // mutex_: 펌프 주기가 엔진에 오디오를 넣는 중
+    bool stop_pending_ = false;                // mutex_: RunStop이 위 둘 중 하나 때문에 배출/입력 닫기를 미룸
+    bool llm_done_pending_ = false;            // mutex_: OnLlmDone이 pushing_ 때문에 미뤄짐 (pending_llm_status_)
+    Status pending_llm_status_;                // mutex_
+    TaskScheduler::TimerId pump_timer_ = 0;    // mutex_
+    TaskScheduler::Clock::time_point next_pump_deadline_; // mutex_: 다음 펌프 주기의 절대 기한
+    bool error_ = false;                       // mutex_
+    std::string error_detail_;                 // mutex_
+    bool recognition_complete_ = false;        // mutex_
+    bool input_closed_ = false;                // mutex_
+    bool finishing_ = false;                   // mutex_: FinishLlm 진입 (한 번만)
+    TaskScheduler::TimerId timeout_timer_ = 0; // mutex_
+    bool endpointed_ = false;                  // mutex_: 끝점 검출로 LLM 턴을 먼저 닫음
+    bool draining_client_ = false;             // mutex_: 끝점 검출 후 클라이언트 입력 종료를 기다리며 읽고 버리는 중
+    bool llm_done_ = false;                    // mutex_: draining 중 LLM 스트림이 끝남 (final_status_로 Finish 대기)
+    Status final_status_;                      // mutex_
+    std::unique_ptr<RecognitionEngine> engine_; // kStreaming~kStopping 동안 유효 (펌프/DrainAndCloseInput만 사용), FinishLlm에서 리퍼로 넘김
+
+    // 엔진 콜백 차단용. 콜백 람다가 공유하므로 리액터가 삭제된 뒤에도 유효
+    struct CallbackGate {
+        std::mutex mutex;  // 잠금 순서: callback_gate_ -> text_mutex_ -> mutex_
+        bool open = true;
+    };
+    std::shared_ptr<CallbackGate> callback_gate_ = std::make_shared<CallbackGate>();
+
+    std::mutex text_mutex_;                    // 잠금 순서: text_mutex_ -> mutex_
+    bool text_closed_ = false;                 // text_mutex_
+    TranscriptStabilizer stabilizer_;          // text_mutex_
+    LLMTurnWriter* llm_writer_ = nullptr;      // Close/Cancel 전까지 유효 (OnLlmDone에서 nullptr)
+};
+
+grpc::ServerReadReactor<STTStreamRequest>* STTServiceImpl::RecognizeStream(
+    CallbackServerContext* context,
+    Empty* /*response*/)
+{
+    return new SessionReactor(this, context);
 }
 
 } // namespace stt
@@ -2,6 +2,11 @@
 
 #include <string>
 #include <memory> // std::shared_ptr
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include <grpcpp/grpcpp.h>
 // !! Proto 파일/메시지 이름 변경 시 아래 include 및 using 구문 확인 !!
@@ -9,44 +14,96 @@
 
 #include <google/protobuf/empty.pb.h> // Empty 메시지 사용
 // 내부 클라이언트 헤더
-#include "azure_stt_client.h"
+#include "recognition_engine.h"
 #include "llm_engine_client.h"
+#include "task_scheduler.h"
+#include "session_capture.h"
+#include "endpointer.h"
+#include "recognizer_reaper.h"
+#include "audio_preprocessor.h"
 
 namespace stt {
 
 // 네임스페이스 명시
-using grpc::ServerContext;
-using grpc::ServerReader; // Client Streaming 사용
+using grpc::CallbackServerContext;
 using grpc::Status;
 using google::protobuf::Empty;
 // !! Proto 서비스/메시지 이름 변경 시 아래 using 구문 확인 !!
 using ::stt::STTService;
 using ::stt::STTStreamRequest;
-// using ::stt::RecognitionConfig; // 필요한 경우
-// using ::stt::AudioChunk;       // 필요한 경우
 
-// stt.proto에 정의된 STTService 구현 클래스
-class STTServiceImpl final : public STTService::Service {
+// stt.proto에 정의된 STTService 구현 클래스 (콜백 API).
+// RecognizeStream마다 세션 리액터(상태 머신)를 만들고, gRPC 스레드를 붙잡지 않는다.
+// 인식 엔진 Start/Stop처럼 블로킹될 수 있는 호출만 고정 크기 작업 스레드 풀에서 실행한다.
+// 읽은 오디오는 세션별 SPSC 링 버퍼에 쌓고, 오디오 펌프가 일정 주기로 고정 크기 블록으로 엔진에 넣는다
+// (네트워크 지터가 인식 엔진 입력 간격에 그대로 전달되지 않도록).
+// 끝점 검출이 켜져 있으면 오디오 에너지 + 중간 결과 안정도로 발화 끝을 감지해 클라이언트 입력 종료를 기다리지 않고 LLM 턴을 닫는다.
+// 인식 엔진 정리(Stop/소멸)는 RPC 경로에서 하지 않는다: 입력을 닫고 최종 결과/완료 콜백이 오면 바로 턴을 끝내고,
+// 엔진은 RecognizerReaper가 뒤에서 정리/재사용한다.
+// 한 프론트엔드 세션의 턴(turn_id)은 겹칠 수 있다: 이전 턴의 LLM/TTS가 마무리되는 동안 다음 발화의 스트림이 들어오면
+// 그대로 병렬로 처리한다 (응답 순서는 게이트웨이가 턴 번호로 보장). 같은 턴 번호가 동시에 두 번 들어오면 거부한다.
+// 전처리가 켜져 있으면 엔진에 넣기 전 펌프 블록마다 고역 통과/노이즈 게이트/AGC를 적용하고 단계별 CPU 비용을 집계한다.
+// 캡처 기록기가 주어지면 세션마다 원본 오디오, 청크 도착 시각, 확정 텍스트를 컨테이너 파일에 남긴다 (재생 벤치마크용).
+class STTServiceImpl final : public STTService::CallbackService {
 public:
-    // 생성자: 의존성 주입 (Azure 클라이언트, LLM 클라이언트)
-    STTServiceImpl(std::shared_ptr<AzureSTTClient> azure_client,
-                   std::shared_ptr<LLMEngineClient> llm_client);
-
-    // Client Streaming RPC 구현 메소드
-    // 클라이언트가 오디오 스트림을 보내면, 서버는 이를 처리하고 최종적으로 Empty 응답 반환
-    // !! Proto 서비스/메소드 시그니처 변경 시 이 함수 시그니처 수정 필요 !!
-    Status RecognizeStream(
-        ServerContext* context,
-        ServerReader<STTStreamRequest>* reader, // 클라이언트 요청 스트림
+    static constexpr size_t kDefaultBlockingThreads = 8;
+    static constexpr size_t kDefaultPumpThreads = 2;
+    static constexpr std::chrono::seconds kRecognitionCompleteTimeout{30}; // 입력 종료 후 최종 결과/완료 콜백 대기 한도
+    static constexpr std::chrono::milliseconds kAudioPumpInterval{40};    // 펌프 주기 = 엔진에 넣는 블록 길이
+    static constexpr std::chrono::milliseconds kAudioRingDuration{4000};  // 세션별 링 버퍼 용량 (넘치면 버리고 overrun으로 집계)
+
+    // 생성자: 의존성 주입 (스트림마다 인식 엔진을 만드는 팩토리, LLM 클라이언트, 블로킹 작업/오디오 펌프 스레드 수,
+    // 세션 캡처 기록기 - nullptr이면 기록 안 함, 서버 측 끝점 검출 설정, 엔진 정리 스레드 수, 오디오 전처리 설정)
+    STTServiceImpl(RecognitionEngineFactory recognition_engine_factory,
+                   std::shared_ptr<LLMEngineClient> llm_client,
+                   size_t blocking_threads = kDefaultBlockingThreads,
+                   size_t pump_threads = kDefaultPumpThreads,
+                   std::shared_ptr<SessionCaptureWriter> capture_writer = nullptr,
+                   EndpointerConfig endpointing = EndpointerConfig{},
+                   size_t reaper_threads = RecognizerReaper::kDefaultThreads,
+                   AudioPreprocessorConfig preprocessing = AudioPreprocessorConfig{});
+
+    // Client Streaming RPC: 세션 리액터를 만들어 반환 (리액터는 모든 작업이 끝나면 스스로 삭제)
+    // 클라이언트가 오디오 스트림을 다 보내면 LLM 스트림이 끝난 뒤 Empty 응답 반환
+    grpc::ServerReadReactor<STTStreamRequest>* RecognizeStream(
+        CallbackServerContext* context,
         Empty* response // 최종 응답 (내용 없음)
     ) override;
 
+    size_t active_sessions() const { return active_sessions_.load(); }
+    // 엔진 정리 지표 (정리 시간, 누수 수, 재사용 수)
+    RecognizerReaper::Stats reaper_stats() const { return reaper_.stats(); }
+    // 같은 세션의 이전 턴이 아직 진행 중일 때 시작된 턴 수
+    uint64_t overlapping_turns() const { return overlapping_turns_.load(); }
+    // 끝난 세션들의 전처리 단계별 누적 지표 (전처리가 꺼져 있으면 모두 0)
+    AudioPreprocessor::Stats preprocess_stats() const;
+
 private:
-    std::shared_ptr<AzureSTTClient> azure_stt_client_;
+    class SessionReactor;
+
+    RecognitionEngineFactory recognition_engine_factory_;
     std::shared_ptr<LLMEngineClient> llm_engine_client_;
+    std::shared_ptr<SessionCaptureWriter> capture_writer_;
+    const EndpointerConfig endpointing_;
+    const AudioPreprocessorConfig preprocessing_;
+    std::atomic<size_t> active_sessions_{0};
+
+    // 세션별 진행 중인 턴. 이미 진행 중인 턴 번호면 false, 아니면 등록하고 더 이전 턴 수를 earlier_in_flight에
+    bool RegisterTurn(const std::string& frontend_session_id, uint64_t turn_id, size_t* earlier_in_flight);
+    void ReleaseTurn(const std::string& frontend_session_id, uint64_t turn_id);
+    std::mutex turns_mutex_;
+    std::unordered_map<std::string, std::vector<uint64_t>> session_turns_; // turns_mutex_
+    std::atomic<uint64_t> overlapping_turns_{0};
+    void AddPreprocessStats(const AudioPreprocessor::Stats& stats);
+    mutable std::mutex preprocess_mutex_;
+    AudioPreprocessor::Stats preprocess_totals_; // preprocess_mutex_
+    RecognizerReaper reaper_;      // 작업 스레드보다 먼저 선언: 남은 작업이 Retire한 엔진까지 소멸 시 정리
+    // 마지막 멤버: 소멸 시 먼저 작업 스레드를 정리
+    TaskScheduler scheduler_;      // 블로킹 호출 (엔진 생성/Start), 인식 완료 타임아웃
+    TaskScheduler pump_scheduler_; // 오디오 펌프 주기 작업 (블로킹 호출에 밀리지 않도록 분리)
 
     // 간단한 UUID 생성 함수 (내부 헬퍼)
     static std::string generate_uuid();
 };
 
-} // namespace stt
\ No newline at end of file
+} // namespace stt
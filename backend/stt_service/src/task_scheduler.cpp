@@ -0,0 +1,114 @@
+#include "task_scheduler.h"
+#include <algorithm>
+#include <iostream>
+
+namespace stt {
+
+TaskScheduler::TaskScheduler(size_t threads) {
+    threads = std::max<size_t>(1, threads);
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this]() { WorkerLoop(); });
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+
+    // 작업 스레드가 모두 끝났으므로 잠금 없이 남은 지연 작업을 정리
+    TimerQueue dropped;
+    dropped.swap(timers_);
+    timer_index_.clear();
+    for (auto& entry : dropped) {
+        if (!entry.second.on_drop) {
+            continue;
+        }
+        try {
+            entry.second.on_drop();
+        } catch (const std::exception& e) {
+            std::cerr << "❌ TaskScheduler: on_drop threw: " << e.what() << std::endl;
+        }
+    }
+}
+
+void TaskScheduler::Post(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ready_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+TaskScheduler::TimerId TaskScheduler::PostAfter(std::chrono::milliseconds delay, Task task, Task on_drop) {
+    return PostAt(Clock::now() + delay, std::move(task), std::move(on_drop));
+}
+
+TaskScheduler::TimerId TaskScheduler::PostAt(Clock::time_point when, Task task, Task on_drop) {
+    TimerId id;
+    bool earliest;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = next_timer_id_++;
+        auto it = timers_.emplace(when, Timer{id, std::move(task), std::move(on_drop)});
+        timer_index_.emplace(id, it);
+        earliest = it == timers_.begin();
+    }
+    if (earliest) {
+        cv_.notify_one(); // 대기 중인 워커의 깨어날 시각이 앞당겨짐
+    }
+    return id;
+}
+
+bool TaskScheduler::Cancel(TimerId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = timer_index_.find(id);
+    if (it == timer_index_.end()) {
+        return false;
+    }
+    timers_.erase(it->second);
+    timer_index_.erase(it);
+    return true;
+}
+
+void TaskScheduler::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        // 시각이 된 지연 작업을 즉시 작업 큐로 옮김
+        const auto now = Clock::now();
+        while (!timers_.empty() && timers_.begin()->first <= now) {
+            auto it = timers_.begin();
+            timer_index_.erase(it->second.id);
+            ready_.push_back(std::move(it->second.task));
+            timers_.erase(it);
+        }
+        if (!ready_.empty()) {
+            Task task = std::move(ready_.front());
+            ready_.pop_front();
+            lock.unlock();
+            try {
+                task();
+            } catch (const std::exception& e) {
+                std::cerr << "❌ TaskScheduler: task threw: " << e.what() << std::endl;
+            }
+            lock.lock();
+            continue;
+        }
+        if (stopping_) {
+            return;
+        }
+        if (timers_.empty()) {
+            cv_.wait(lock);
+        } else {
+            cv_.wait_until(lock, timers_.begin()->first);
+        }
+    }
+}
+
+} // namespace stt
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace stt {
+
+// 고정 크기 작업 스레드 풀 + 지연 작업.
+// gRPC 콜백 스레드에서 하면 안 되는 블로킹 호출(인식 엔진 Start/Stop/소멸)과 세션 타임아웃을 처리한다.
+// 세션 수와 무관하게 스레드 수가 고정이므로 세션 비용은 상태 메모리뿐.
+class TaskScheduler {
+public:
+    using Task = std::function<void()>;
+    using TimerId = uint64_t;
+    using Clock = std::chrono::steady_clock;
+
+    explicit TaskScheduler(size_t threads);
+    // 남은 즉시 작업은 실행하고, 아직 시각이 안 된 지연 작업은 버리면서 그 작업의 on_drop을 호출
+    // (작업이 잡고 있던 참조 등을 놓을 수 있도록)
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    void Post(Task task);
+    // on_drop: 작업이 실행되지 못하고 스케줄러 소멸과 함께 버려질 때만 호출됨 (Cancel 시에는 호출 안 함)
+    TimerId PostAfter(std::chrono::milliseconds delay, Task task, Task on_drop = nullptr);
+    // 절대 시각 기준 예약. 주기 작업은 이전 기한에 주기를 더해 예약하면 실행 지연이 누적되지 않음
+    TimerId PostAt(Clock::time_point when, Task task, Task on_drop = nullptr);
+    // 아직 실행되지 않은 지연 작업 취소. 취소했으면 true (false면 이미 실행 중이거나 끝남)
+    bool Cancel(TimerId id);
+
+    size_t thread_count() const { return workers_.size(); }
+
+private:
+    struct Timer {
+        TimerId id;
+        Task task;
+        Task on_drop;
+    };
+    using TimerQueue = std::multimap<Clock::time_point, Timer>;
+
+    void WorkerLoop();
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Task> ready_;
+    TimerQueue timers_;
+    std::unordered_map<TimerId, TimerQueue::iterator> timer_index_;
+    TimerId next_timer_id_ = 1;
+    bool stopping_ = false;
+    std::vector<std::thread> workers_;
+};
+
+} // namespace stt
@@ -0,0 +1,124 @@
+#include "transcript_stabilizer.h"
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+namespace stt {
+
+TranscriptStabilizer::TranscriptStabilizer(size_t stability_hypotheses)
+    : stability_hypotheses_(std::max<size_t>(1, stability_hypotheses)) {}
+
+TranscriptStabilizer::Words TranscriptStabilizer::Split(const std::string& text) {
+    Words words;
+    std::istringstream in(text);
+    for (std::string word; in >> word;) {
+        words.push_back(std::move(word));
+    }
+    return words;
+}
+
+bool TranscriptStabilizer::SameWord(const std::string& a, const std::string& b) {
+    auto normalize = [](const std::string& word) {
+        std::string out;
+        out.reserve(word.size());
+        for (unsigned char c : word) {
+            if (c < 0x80 && std::ispunct(c)) {
+                continue; // ASCII 문장부호만 제거 (UTF-8 멀티바이트는 그대로)
+            }
+            out += static_cast<char>(c < 0x80 ? std::tolower(c) : c);
+        }
+        return out;
+    };
+    return normalize(a) == normalize(b);
+}
+
+bool TranscriptStabilizer::MatchesCommitted(const Words& words) const {
+    if (words.size() < segment_committed_) {
+        return false;
+    }
+    for (size_t i = 0; i < segment_committed_; ++i) {
+        if (!SameWord(words[i], segment_words_[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string TranscriptStabilizer::Commit(const Words& words, size_t from, size_t to) {
+    std::string delta;
+    for (size_t i = from; i < to; ++i) {
+        if (any_committed_ || !delta.empty()) {
+            delta += ' ';
+        }
+        delta += words[i];
+        segment_words_.push_back(words[i]);
+    }
+    if (to > from) {
+        segment_committed_ = to;
+        any_committed_ = true;
+        stats_.committed_words += to - from;
+        ++stats_.deltas;
+    }
+    return delta;
+}
+
+void TranscriptStabilizer::ResetSegment() {
+    recent_.clear();
+    segment_committed_ = 0;
+    segment_words_.clear();
+}
+
+std::string TranscriptStabilizer::OnHypothesis(const std::string& text) {
+    ++stats_.hypotheses;
+    Words words = Split(text);
+    if (!MatchesCommitted(words)) {
+        // 이미 보낸 부분이 수정됨. 되돌릴 수 없으므로 기록만 하고 확정 결과에서 이어 붙임
+        ++stats_.revisions_after_commit;
+    }
+    recent_.push_back(std::move(words));
+    if (recent_.size() > stability_hypotheses_) {
+        recent_.pop_front();
+    }
+    if (recent_.size() < stability_hypotheses_) {
+        return "";
+    }
+
+    // 최근 가설 전체의 공통 접두사 (마지막 단어는 아직 자라는 중일 수 있으므로 제외)
+    const Words& latest = recent_.back();
+    size_t stable = latest.empty() ? 0 : latest.size() - 1;
+    for (const auto& hypothesis : recent_) {
+        size_t common = 0;
+        while (common < stable && common < hypothesis.size() && hypothesis[common] == latest[common]) {
+            ++common;
+        }
+        stable = common;
+    }
+    if (stable <= segment_committed_ || !MatchesCommitted(latest)) {
+        return "";
+    }
+    return Commit(latest, segment_committed_, stable);
+}
+
+std::string TranscriptStabilizer::CloseSegment(const Words& words) {
+    if (!MatchesCommitted(words)) {
+        ++stats_.revisions_after_commit;
+    }
+    std::string delta = Commit(words, std::min(segment_committed_, words.size()), words.size());
+    ResetSegment();
+    return delta;
+}
+
+std::string TranscriptStabilizer::OnFinal(const std::string& text) {
+    ++stats_.finals;
+    return CloseSegment(Split(text));
+}
+
+std::string TranscriptStabilizer::Flush() {
+    if (recent_.empty()) {
+        return "";
+    }
+    Words words = std::move(recent_.back());
+    return CloseSegment(words);
+}
+
+} // namespace stt
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace stt {
+
+// 인식 중간 결과(누적 가설)의 수정 이력을 추적해서 더 이상 바뀌지 않을 앞부분만 증분으로 내보낸다.
+// 단어 단위로, 최근 stability_hypotheses개의 가설에 공통으로 나타나고 가설의 마지막 단어가 아닌 경우에만 확정한다.
+// 확정 결과(is_final)가 오면 그 구간의 남은 부분을 모두 확정하고 다음 구간을 위해 상태를 초기화한다.
+// 반환값은 LLM에 그대로 이어 붙이면 되는 텍스트 (구간 사이 공백 포함). 확정된 것이 없으면 빈 문자열.
+// 스레드 안전하지 않음 (호출자가 직렬화)
+class TranscriptStabilizer {
+public:
+    struct Stats {
+        uint64_t hypotheses = 0;            // 받은 중간 결과 수
+        uint64_t finals = 0;                // 받은 확정 결과 수
+        uint64_t deltas = 0;                // 내보낸 증분 수 (= LLM으로 가는 text_chunk 수)
+        uint64_t committed_words = 0;
+        uint64_t revisions_after_commit = 0; // 이미 보낸 단어와 다른 가설/확정 결과를 받은 횟수
+    };
+
+    explicit TranscriptStabilizer(size_t stability_hypotheses = 2);
+
+    std::string OnHypothesis(const std::string& text);
+    std::string OnFinal(const std::string& text);
+    // 스트림 종료 시 확정 결과 없이 남은 마지막 가설을 확정 (Stop 전에 인식기가 확정하지 못한 꼬리)
+    std::string Flush();
+
+    const Stats& stats() const { return stats_; }
+
+private:
+    using Words = std::vector<std::string>;
+
+    static Words Split(const std::string& text);
+    // 문장부호/대소문자 차이는 수정으로 보지 않음 (확정 결과는 문장부호가 붙어서 옴)
+    static bool SameWord(const std::string& a, const std::string& b);
+    bool MatchesCommitted(const Words& words) const;
+    std::string Commit(const Words& words, size_t from, size_t to);
+    // 구간의 남은 단어를 모두 확정하고 다음 구간 준비
+    std::string CloseSegment(const Words& words);
+    void ResetSegment();
+
+    size_t stability_hypotheses_;
+    std::deque<Words> recent_;   // 현재 구간의 최근 가설들
+    size_t segment_committed_ = 0; // 현재 구간에서 이미 보낸 단어 수
+    Words segment_words_;          // 현재 구간에서 이미 보낸 단어들 (수정 감지용)
+    bool any_committed_ = false;   // 스트림 전체에서 보낸 텍스트가 있는지 (구간 사이 공백용)
+    Stats stats_;
+};
+
+} // namespace stt
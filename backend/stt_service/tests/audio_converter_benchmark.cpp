@@ -0,0 +1,88 @@
+// tests/audio_converter_benchmark.cpp
+//
+// AudioConverter 단일 코어 처리 속도 측정. 입력 형식 x SIMD 경로별로 실시간 대비 배속(= 한 코어가 동시에 감당할 수 있는 스트림 수)을 출력.
+//
+//   cmake -DBUILD_TESTING=ON .. && make audio_converter_benchmark
+//   ./audio_converter_benchmark [seconds_of_audio=60] [chunk_ms=20]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "audio_converter.h"
+
+namespace {
+
+// 440Hz + 3kHz 톤 (채널마다 위상만 다르게)
+std::vector<uint8_t> MakeInput(const stt::AudioFormat& format, double seconds) {
+    const size_t frames = static_cast<size_t>(seconds * format.sample_rate_hz);
+    std::vector<uint8_t> bytes(frames * format.bytes_per_frame());
+    for (size_t i = 0; i < frames; ++i) {
+        for (uint32_t c = 0; c < format.channels; ++c) {
+            const double t = static_cast<double>(i) / format.sample_rate_hz;
+            const float v = static_cast<float>(0.4 * std::sin(2 * M_PI * 440 * t + c) + 0.2 * std::sin(2 * M_PI * 3000 * t));
+            uint8_t* dst = bytes.data() + (i * format.channels + c) * (format.bytes_per_frame() / format.channels);
+            if (format.sample_format == stt::AudioFormat::SampleFormat::kFloat32) {
+                std::memcpy(dst, &v, sizeof(v));
+            } else {
+                const int16_t s = static_cast<int16_t>(v * 32767.0f);
+                std::memcpy(dst, &s, sizeof(s));
+            }
+        }
+    }
+    return bytes;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 60.0;
+    const int chunk_ms = argc > 2 ? std::atoi(argv[2]) : 20;
+
+    using SF = stt::AudioFormat::SampleFormat;
+    const stt::AudioFormat formats[] = {
+        {16000, 1, SF::kInt16}, {16000, 2, SF::kInt16}, {44100, 1, SF::kInt16},
+        {48000, 1, SF::kInt16}, {48000, 2, SF::kInt16}, {48000, 2, SF::kFloat32},
+    };
+    const stt::AudioConverter::Simd best = stt::AudioConverter::DetectSimd();
+
+    std::cout << "AudioConverter benchmark: " << seconds << "s of audio per format, " << chunk_ms << " ms chunks, best SIMD = "
+              << stt::AudioConverter::SimdName(best) << std::endl;
+    std::cout << std::left << std::setw(20) << "format" << std::setw(8) << "simd" << std::right << std::setw(12) << "RTF"
+              << std::setw(16) << "x real-time" << std::endl;
+
+    for (const auto& format : formats) {
+        const std::vector<uint8_t> input = MakeInput(format, seconds);
+        const size_t chunk_bytes = format.bytes_per_frame() * format.sample_rate_hz * chunk_ms / 1000;
+        for (auto simd : {stt::AudioConverter::Simd::kScalar, stt::AudioConverter::Simd::kSse, stt::AudioConverter::Simd::kAvx2}) {
+            if (static_cast<int>(simd) > static_cast<int>(best)) {
+                continue;
+            }
+            stt::AudioConverter converter(format, simd);
+            if (converter.passthrough()) {
+                // 변환 없음 (서비스는 원본 바이트를 그대로 엔진에 전달)
+                std::cout << std::left << std::setw(20) << format.ToString() << "passthrough" << std::endl;
+                break;
+            }
+            std::vector<int16_t> out;
+            out.reserve(static_cast<size_t>(seconds * stt::AudioConverter::kOutputSampleRateHz) + 1024);
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t offset = 0; offset < input.size(); offset += chunk_bytes) {
+                converter.Convert(input.data() + offset, std::min(chunk_bytes, input.size() - offset), out);
+            }
+            const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            const double rtf = elapsed / seconds;
+            std::cout << std::left << std::setw(20) << format.ToString() << std::setw(8)
+                      << stt::AudioConverter::SimdName(simd) << std::right
+                      << std::setw(12) << std::scientific << std::setprecision(2) << rtf << std::fixed
+                      << std::setw(15) << std::setprecision(0) << (rtf > 0 ? 1.0 / rtf : 0.0) << "x" << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,204 @@
+// tests/callback_load_tests.cpp
+// 콜백 API RecognizeStream 부하 테스트: in-process gRPC 서버 두 개(STT + 가짜 LLM)에 스트림 1,000개를 열어 둠.
+// 수십 초 걸리므로 unit_tests와 분리된 실행 파일 (ctest에 등록, 라벨 load)
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <grpcpp/grpcpp.h>
+#include "llm.grpc.pb.h"
+#include "stt.grpc.pb.h"
+
+#include "llm_engine_client.h"
+#include "scripted_recognition_engine.h"
+#include "stt_service.h"
+
+namespace {
+
+// 프로세스의 현재 스레드 수 (/proc/self/status)
+int CurrentThreadCount() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("Threads:", 0) == 0) {
+            return std::stoi(line.substr(8));
+        }
+    }
+    return -1;
+}
+
+// 가짜 LLM 엔진: 텍스트 증분과 확정 표시 수만 세고 OK로 종료
+class FakeLlmService final : public llm::LLMService::CallbackService {
+public:
+    std::atomic<int> turns{0};
+    std::atomic<int> text_chunks{0};
+    std::atomic<int> transcript_finals{0};
+
+    grpc::ServerReadReactor<llm::LLMStreamRequest>* ProcessTextStream(
+        grpc::CallbackServerContext*, google::protobuf::Empty*) override {
+        turns++;
+        return new Turn(this);
+    }
+
+private:
+    class Turn final : public grpc::ServerReadReactor<llm::LLMStreamRequest> {
+    public:
+        explicit Turn(FakeLlmService* service) : service_(service) { StartRead(&request_); }
+        void OnReadDone(bool ok) override {
+            if (!ok) {
+                Finish(grpc::Status::OK);
+                return;
+            }
+            if (request_.request_data_case() == llm::LLMStreamRequest::kTextChunk) service_->text_chunks++;
+            if (request_.request_data_case() == llm::LLMStreamRequest::kTranscriptFinal) service_->transcript_finals++;
+            StartRead(&request_);
+        }
+        void OnDone() override { delete this; }
+
+    private:
+        FakeLlmService* service_;
+        llm::LLMStreamRequest request_;
+    };
+};
+
+// 설정 + 오디오 두 청크를 보낸 뒤 입력을 닫을 때까지 대기하는 클라이언트 스트림
+class IdleRecognizeStream final : public grpc::ClientWriteReactor<stt::STTStreamRequest> {
+public:
+    IdleRecognizeStream(stt::STTService::Stub* stub, int index, std::mutex& mutex, std::condition_variable& cv)
+        : mutex_(mutex), cv_(cv) {
+        auto* config = config_.mutable_config();
+        config->set_language("ko-KR");
+        config->set_frontend_session_id("fe-" + std::to_string(index));
+        config->set_session_id("stt-" + std::to_string(index));
+        audio_.set_audio_chunk(std::string(3200, '\0')); // 16kHz 16-bit mono 100ms
+        stub->async()->RecognizeStream(&context_, &response_, this);
+        AddHold();
+        StartWrite(&config_);
+        StartCall();
+    }
+
+    void CloseWrites() {
+        StartWritesDone();
+        RemoveHold();
+    }
+
+    void OnWriteDone(bool ok) override {
+        if (ok && ++writes_ <= 2) {
+            StartWrite(&audio_);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_ = true;
+        cv_.notify_all();
+    }
+
+    void OnDone(const grpc::Status& status) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        status_ = status;
+        done_ = true;
+        cv_.notify_all();
+    }
+
+    bool idle() const { return idle_; }   // mutex_
+    bool done() const { return done_; }   // mutex_
+    const grpc::Status& status() const { return status_; }
+
+private:
+    std::mutex& mutex_;
+    std::condition_variable& cv_;
+    grpc::ClientContext context_;
+    google::protobuf::Empty response_;
+    stt::STTStreamRequest config_;
+    stt::STTStreamRequest audio_;
+    int writes_ = 0;
+    bool idle_ = false;
+    bool done_ = false;
+    grpc::Status status_;
+};
+
+} // namespace
+
+// 콜백 API RecognizeStream: 동시 스트림 1,000개가 열려 있어도 스레드 수는 고정 (스트림당 스레드 없음)
+TEST(STTServiceCallbackTest, ThousandIdleStreamsWithoutThreadPerSession) {
+    constexpr int kStreams = 1000;
+
+    FakeLlmService llm_service;
+    int llm_port = 0;
+    grpc::ServerBuilder llm_builder;
+    llm_builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &llm_port);
+    llm_builder.RegisterService(&llm_service);
+    auto llm_server = llm_builder.BuildAndStart();
+    ASSERT_TRUE(llm_server);
+
+    stt::ScriptedRecognitionScript script;
+    script.transcripts = {"안녕하세요 오늘 날씨 어때요"};
+    script.audio_per_word = std::chrono::milliseconds(100);
+    auto llm_client = std::make_shared<stt::LLMEngineClient>("127.0.0.1:" + std::to_string(llm_port));
+    stt::STTServiceImpl service(stt::ScriptedRecognitionEngine::Factory(script), llm_client, 4);
+    int stt_port = 0;
+    grpc::ServerBuilder stt_builder;
+    stt_builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &stt_port);
+    stt_builder.RegisterService(&service);
+    auto stt_server = stt_builder.BuildAndStart();
+    ASSERT_TRUE(stt_server);
+
+    auto stub = stt::STTService::NewStub(
+        grpc::CreateChannel("127.0.0.1:" + std::to_string(stt_port), grpc::InsecureChannelCredentials()));
+    const int threads_before = CurrentThreadCount();
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::unique_ptr<IdleRecognizeStream>> streams;
+    streams.reserve(kStreams);
+    for (int i = 0; i < kStreams; ++i) {
+        streams.push_back(std::make_unique<IdleRecognizeStream>(stub.get(), i, mutex, cv));
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(60), [&]() {
+            for (const auto& stream : streams) if (!stream->idle()) return false;
+            return true;
+        }));
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (service.active_sessions() < kStreams && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    ASSERT_EQ(service.active_sessions(), static_cast<size_t>(kStreams));
+
+    // 모든 스트림이 열린 상태에서 스레드 증가는 gRPC 폴러 + 작업 풀 정도여야 함
+    const int threads_during = CurrentThreadCount();
+    EXPECT_LT(threads_during - threads_before, 200) << "threads before=" << threads_before << " during=" << threads_during;
+
+    for (auto& stream : streams) {
+        stream->CloseWrites();
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(120), [&]() {
+            for (const auto& stream : streams) if (!stream->done()) return false;
+            return true;
+        }));
+    }
+    int ok = 0;
+    for (const auto& stream : streams) {
+        if (stream->status().ok()) ok++;
+    }
+    EXPECT_EQ(ok, kStreams);
+    EXPECT_EQ(llm_service.turns.load(), kStreams);
+    EXPECT_EQ(llm_service.transcript_finals.load(), kStreams);
+    EXPECT_GE(llm_service.text_chunks.load(), kStreams);
+
+    stt_server->Shutdown();
+    llm_server->Shutdown();
+    EXPECT_EQ(service.active_sessions(), 0u);
+}
@@ -6,9 +6,30 @@
 #include <exception> // for std::exception (needed for EXPECT_ANY_THROW potentially)
 
 // 테스트 대상 헤더 (필요에 따라 추가)
-// #include "stt_service.h"
+#include "stt_service.h"
+#include "task_scheduler.h"
 #include "azure_stt_client.h"
 #include "llm_engine_client.h"
+#include "scripted_recognition_engine.h"
+#include "transcript_stabilizer.h"
+#include "audio_converter.h"
+#include "audio_ring_buffer.h"
+#include "session_capture.h"
+#include "endpointer.h"
+#include "recognizer_reaper.h"
+#include "audio_preprocessor.h"
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
 
 // 가정: generate_uuid가 테스트 가능하도록 별도 파일이나 public static으로 분리됨
 // namespace stt { std::string generate_uuid(); } // 예시 선언
@@ -55,6 +76,637 @@ TEST(InternalClientTest, AzureSTTClientConstructor_MissingCredentials) {
     // EXPECT_NO_THROW(stt::AzureSTTClient("valid_key", "valid_region"));
 }
 
+// ScriptedRecognitionEngine: 오디오 길이에 비례한 누적 중간 결과, Stop 시 확정 결과 + 완료 콜백 1회
+TEST(ScriptedRecognitionEngineTest, EmitsCumulativePartialsThenFinalOnStop) {
+    stt::ScriptedRecognitionEngine engine("안녕하세요 오늘 날씨", std::chrono::milliseconds(100));
+    std::vector<std::pair<std::string, bool>> chunks;
+    int completions = 0;
+    ASSERT_TRUE(engine.StartContinuousRecognition(
+        "ko-KR",
+        [&](const std::string& text, bool is_final) { chunks.emplace_back(text, is_final); },
+        [&](bool success, const std::string&) { EXPECT_TRUE(success); ++completions; }));
+
+    std::vector<uint8_t> pcm(3200 * 2); // 100ms = 3200 bytes, 200ms 분량
+    engine.PushAudioChunk(pcm.data(), 3200);
+    engine.PushAudioChunk(pcm.data(), 1000); // 단어 경계 미달 -> 결과 없음
+    engine.PushAudioChunk(pcm.data(), 2200);
+    ASSERT_EQ(chunks.size(), 2u);
+    EXPECT_EQ(chunks[0].first, "안녕하세요");
+    EXPECT_EQ(chunks[1].first, "안녕하세요 오늘");
+    EXPECT_FALSE(chunks[1].second);
+    EXPECT_EQ(engine.audio_bytes_received(), 6400u);
+
+    engine.StopContinuousRecognition();
+    engine.StopContinuousRecognition(); // 중복 Stop은 무시
+    ASSERT_EQ(chunks.size(), 3u);
+    EXPECT_EQ(chunks[2].first, "안녕하세요 오늘 날씨");
+    EXPECT_TRUE(chunks[2].second);
+    EXPECT_EQ(completions, 1);
+}
+
+TEST(ScriptedRecognitionEngineTest, FactoryRotatesTranscripts) {
+    stt::ScriptedRecognitionScript script;
+    script.transcripts = {"하나", "둘"};
+    script.audio_per_word = std::chrono::milliseconds(10);
+    auto factory = stt::ScriptedRecognitionEngine::Factory(script);
+
+    std::vector<std::string> finals;
+    for (int i = 0; i < 3; ++i) {
+        auto engine = factory();
+        ASSERT_TRUE(engine->StartContinuousRecognition(
+            "ko-KR",
+            [&](const std::string& text, bool is_final) { if (is_final) finals.push_back(text); },
+            [](bool, const std::string&) {}));
+        engine->StopContinuousRecognition();
+    }
+    EXPECT_EQ(finals, (std::vector<std::string>{"하나", "둘", "하나"}));
+    EXPECT_THROW(stt::ScriptedRecognitionEngine::Factory(stt::ScriptedRecognitionScript{}), std::runtime_error);
+}
+
+TEST(ScriptedRecognitionEngineTest, LoadTranscriptSidecarSkipsCommentsAndBlankLines) {
+    const std::string path = ::testing::TempDir() + "scripted_transcripts_test.txt";
+    {
+        std::ofstream out(path);
+        out << "# header\n\n  첫 번째 발화\r\n두 번째 발화\n   \n";
+    }
+    auto script = stt::LoadTranscriptSidecar(path);
+    EXPECT_EQ(script.transcripts, (std::vector<std::string>{"첫 번째 발화", "두 번째 발화"}));
+
+    { std::ofstream out(path); out << "# only comments\n"; }
+    EXPECT_THROW(stt::LoadTranscriptSidecar(path), std::runtime_error);
+    std::remove(path.c_str());
+    EXPECT_THROW(stt::LoadTranscriptSidecar(path + ".missing"), std::runtime_error);
+}
+
+// TranscriptStabilizer: 연속 가설에서 변하지 않은 앞부분만 증분으로, 확정 결과에서 나머지를 보냄
+TEST(TranscriptStabilizerTest, CommitsStablePrefixOnceAndFinishesOnFinal) {
+    stt::TranscriptStabilizer stabilizer(2);
+    std::string sent;
+    auto feed = [&](const std::string& delta) { sent += delta; return delta; };
+
+    EXPECT_EQ(feed(stabilizer.OnHypothesis("오늘")), "");
+    EXPECT_EQ(feed(stabilizer.OnHypothesis("오늘 날")), "오늘");      // 두 가설에 공통 + 마지막 단어 아님
+    EXPECT_EQ(feed(stabilizer.OnHypothesis("오늘 날씨 어")), "");      // "날" -> "날씨": 아직 자라는 중
+    EXPECT_EQ(feed(stabilizer.OnHypothesis("오늘 날씨 어때")), " 날씨");
+    EXPECT_EQ(feed(stabilizer.OnHypothesis("오늘 날씨 어때")), "");   // 반복 가설은 메시지 없음
+    EXPECT_EQ(feed(stabilizer.OnFinal("오늘, 날씨 어때요?")), " 어때요?"); // 문장부호 차이는 수정 아님
+    EXPECT_EQ(feed(stabilizer.OnHypothesis("서울")), "");            // 다음 구간
+    EXPECT_EQ(feed(stabilizer.OnFinal("서울은")), " 서울은");
+    EXPECT_EQ(sent, "오늘 날씨 어때요? 서울은");
+
+    const auto& stats = stabilizer.stats();
+    EXPECT_EQ(stats.hypotheses, 6u);
+    EXPECT_EQ(stats.finals, 2u);
+    EXPECT_EQ(stats.deltas, 4u);
+    EXPECT_EQ(stats.committed_words, 4u);
+    EXPECT_EQ(stats.revisions_after_commit, 0u);
+}
+
+TEST(TranscriptStabilizerTest, HoldsBackRevisedWordsAndFlushesUnfinishedTail) {
+    stt::TranscriptStabilizer stabilizer(2);
+    EXPECT_EQ(stabilizer.OnHypothesis("내일 비"), "");
+    EXPECT_EQ(stabilizer.OnHypothesis("내일 비가"), "내일");
+    EXPECT_EQ(stabilizer.OnHypothesis("내 일이 비가"), "");   // 보낸 단어가 수정됨 -> 보류
+    EXPECT_EQ(stabilizer.stats().revisions_after_commit, 1u);
+    EXPECT_EQ(stabilizer.OnHypothesis("내일 비가 와"), "");   // 직전 가설과 공통 접두사 없음
+    EXPECT_EQ(stabilizer.OnHypothesis("내일 비가 와요"), " 비가");
+    EXPECT_EQ(stabilizer.Flush(), " 와요");                  // 확정 결과 없이 스트림 종료
+    EXPECT_EQ(stabilizer.Flush(), "");
+}
+
+// AudioConverter: 48kHz 스테레오 -> 16kHz mono. 통과 대역 톤은 유지, 16kHz 나이퀴스트 위 톤은 제거
+namespace {
+std::vector<uint8_t> MakeStereoTone(uint32_t rate, double hz, size_t frames, stt::AudioFormat::SampleFormat sample_format) {
+    const size_t bytes_per_sample = sample_format == stt::AudioFormat::SampleFormat::kFloat32 ? 4 : 2;
+    std::vector<uint8_t> bytes(frames * 2 * bytes_per_sample);
+    for (size_t i = 0; i < frames * 2; ++i) {
+        const float v = static_cast<float>(0.5 * std::sin(2.0 * M_PI * hz * static_cast<double>(i / 2) / rate));
+        if (bytes_per_sample == 4) {
+            std::memcpy(bytes.data() + i * 4, &v, 4);
+        } else {
+            const int16_t s = static_cast<int16_t>(v * 32767.0f);
+            std::memcpy(bytes.data() + i * 2, &s, 2);
+        }
+    }
+    return bytes;
+}
+
+double Rms(const std::vector<int16_t>& pcm, size_t skip) {
+    double sum = 0.0;
+    for (size_t i = skip; i < pcm.size(); ++i) sum += static_cast<double>(pcm[i]) * pcm[i];
+    return std::sqrt(sum / static_cast<double>(pcm.size() - skip)) / 32768.0;
+}
+} // namespace
+
+TEST(AudioConverterTest, Downsamples48kStereoAndRejectsAliasing) {
+    using SF = stt::AudioFormat::SampleFormat;
+    for (SF sample_format : {SF::kInt16, SF::kFloat32}) {
+        const stt::AudioFormat format{48000, 2, sample_format};
+        std::vector<int16_t> pass, alias;
+        stt::AudioConverter(format).Convert(MakeStereoTone(48000, 440.0, 48000, sample_format).data(), 48000 * format.bytes_per_frame(), pass);
+        stt::AudioConverter(format).Convert(MakeStereoTone(48000, 12000.0, 48000, sample_format).data(), 48000 * format.bytes_per_frame(), alias);
+        EXPECT_NEAR(static_cast<double>(pass.size()), 16000.0, 16.0);
+        EXPECT_NEAR(Rms(pass, 64), 0.5 / std::sqrt(2.0), 0.01); // 사인파 RMS = A/√2
+        EXPECT_LT(Rms(alias, 64), 0.005);
+    }
+}
+
+TEST(AudioConverterTest, ChunkingAndSimdPathsMatchScalar) {
+    const stt::AudioFormat format{44100, 2, stt::AudioFormat::SampleFormat::kInt16};
+    const std::vector<uint8_t> input = MakeStereoTone(44100, 1000.0, 44100, format.sample_format);
+
+    std::vector<int16_t> reference;
+    stt::AudioConverter(format, stt::AudioConverter::Simd::kScalar).Convert(input.data(), input.size(), reference);
+
+    stt::AudioConverter converter(format); // 이 CPU의 최선 경로
+    std::vector<int16_t> chunked;
+    for (size_t offset = 0; offset < input.size(); offset += 1001) { // 프레임 경계와 어긋나는 청크
+        converter.Convert(input.data() + offset, std::min<size_t>(1001, input.size() - offset), chunked);
+    }
+    ASSERT_EQ(chunked.size(), reference.size());
+    for (size_t i = 0; i < reference.size(); ++i) {
+        ASSERT_NEAR(chunked[i], reference[i], 2) << "sample " << i;
+    }
+}
+
+TEST(AudioConverterTest, ValidatesFormatAndDetectsPassthrough) {
+    EXPECT_TRUE(stt::AudioConverter(stt::AudioFormat{}).passthrough());
+    EXPECT_FALSE(stt::AudioConverter(stt::AudioFormat{16000, 2, stt::AudioFormat::SampleFormat::kInt16}).passthrough());
+    EXPECT_FALSE(stt::AudioConverter::Validate(stt::AudioFormat{4000, 1, stt::AudioFormat::SampleFormat::kInt16}).empty());
+    EXPECT_FALSE(stt::AudioConverter::Validate(stt::AudioFormat{48000, 0, stt::AudioFormat::SampleFormat::kInt16}).empty());
+    EXPECT_THROW(stt::AudioConverter(stt::AudioFormat{48000, 9, stt::AudioFormat::SampleFormat::kInt16}), std::runtime_error);
+}
+
+// AudioRingBuffer: 용량은 2의 거듭제곱, 가득 차면 쓰기 거부, 끝을 넘는 읽기/쓰기도 순서 유지
+TEST(AudioRingBufferTest, WrapsAroundAndRejectsWritesWhenFull) {
+    stt::AudioRingBuffer ring(6);
+    EXPECT_EQ(ring.capacity(), 8u);
+    const uint8_t a[] = {1, 2, 3, 4, 5, 6};
+    ASSERT_TRUE(ring.Write(a, 6));
+    EXPECT_FALSE(ring.Write(a, 3)); // 남은 공간 2
+    uint8_t out[8] = {};
+    EXPECT_EQ(ring.Read(out, 4), 4u);
+    EXPECT_EQ(std::vector<uint8_t>(out, out + 4), (std::vector<uint8_t>{1, 2, 3, 4}));
+    const uint8_t b[] = {7, 8, 9, 10, 11, 12};
+    ASSERT_TRUE(ring.Write(b, 6)); // 끝에서 잘려 앞으로 이어짐
+    EXPECT_EQ(ring.size(), 8u);
+    EXPECT_EQ(ring.Read(out, 8), 8u);
+    EXPECT_EQ(std::vector<uint8_t>(out, out + 8), (std::vector<uint8_t>{5, 6, 7, 8, 9, 10, 11, 12}));
+    EXPECT_EQ(ring.Read(out, 8), 0u);
+}
+
+TEST(AudioRingBufferTest, TransfersByteSequenceBetweenTwoThreads) {
+    constexpr size_t kTotal = 1 << 20;
+    stt::AudioRingBuffer ring(1000);
+    std::thread producer([&]() {
+        uint8_t chunk[333];
+        size_t written = 0;
+        while (written < kTotal) {
+            const size_t n = std::min(sizeof(chunk), kTotal - written);
+            for (size_t i = 0; i < n; ++i) chunk[i] = static_cast<uint8_t>((written + i) * 7);
+            if (ring.Write(chunk, n)) {
+                written += n;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint8_t block[640];
+    size_t read = 0;
+    size_t mismatches = 0;
+    while (read < kTotal) {
+        const size_t n = ring.Read(block, sizeof(block));
+        for (size_t i = 0; i < n; ++i) {
+            if (block[i] != static_cast<uint8_t>((read + i) * 7)) mismatches++;
+        }
+        read += n;
+        if (n == 0) std::this_thread::yield();
+    }
+    producer.join();
+    EXPECT_EQ(mismatches, 0u);
+    EXPECT_EQ(ring.size(), 0u);
+}
+
+// SessionCaptureWriter: 추가 기록 + 인덱스로 다시 읽기, 기존 파일에 이어 쓰기, 잘린 인덱스 항목 무시
+TEST(SessionCaptureTest, AppendsIndexedRecordsAndReadsThemBack) {
+    const std::string path = ::testing::TempDir() + "session_capture_test.cap";
+    std::remove(path.c_str());
+    std::remove((path + ".idx").c_str());
+
+    stt::SessionCapture first;
+    first.stt_session_id = "stt-1";
+    first.frontend_session_id = "fe-1";
+    first.language = "ko-KR";
+    first.turn_id = 7;
+    first.sample_rate_hz = 48000;
+    first.channels = 2;
+    first.sample_format = 2;
+    first.start_unix_ms = 1700000000123ull;
+    first.chunks = {{1500, 3}, {41500, 2}, {2041500, 4}};
+    first.audio = std::string("abcde\0fg", 9); // 청크 크기 합 = 9
+    first.transcript = "안녕하세요 오늘";
+    first.status_code = 0;
+    stt::SessionCapture second = first;
+    second.stt_session_id = "stt-2";
+    second.chunks.clear();
+    second.audio.clear();
+    second.transcript.clear();
+    second.status_code = 1;
+
+    {
+        stt::SessionCaptureWriter writer(path);
+        writer.Append(first);
+        EXPECT_EQ(writer.sessions_written(), 1u);
+    }
+    {
+        stt::SessionCaptureWriter writer(path); // 다시 열면 이어서 기록
+        writer.Append(second);
+    }
+    { std::ofstream idx(path + ".idx", std::ios::binary | std::ios::app); idx << "partial"; }
+
+    const auto entries = stt::ReadSessionCaptureIndex(path);
+    ASSERT_EQ(entries.size(), 2u);
+    EXPECT_EQ(entries[0].record_offset, 8u);
+    EXPECT_EQ(entries[0].duration_ms, 2041u);
+    EXPECT_EQ(entries[0].chunk_count, 3u);
+    EXPECT_EQ(entries[0].audio_bytes, 9u);
+    EXPECT_EQ(entries[1].record_offset, entries[0].record_offset + entries[0].record_size);
+
+    const auto read_first = stt::ReadSessionCapture(path, entries[0]);
+    EXPECT_EQ(read_first.stt_session_id, "stt-1");
+    EXPECT_EQ(read_first.frontend_session_id, "fe-1");
+    EXPECT_EQ(read_first.turn_id, 7u);
+    EXPECT_EQ(read_first.sample_rate_hz, 48000u);
+    EXPECT_EQ(read_first.channels, 2u);
+    EXPECT_EQ(read_first.sample_format, 2u);
+    EXPECT_EQ(read_first.start_unix_ms, 1700000000123ull);
+    ASSERT_EQ(read_first.chunks.size(), 3u);
+    EXPECT_EQ(read_first.chunks[2].arrival_us, 2041500u);
+    EXPECT_EQ(read_first.chunks[2].size, 4u);
+    EXPECT_EQ(read_first.audio, first.audio);
+    EXPECT_EQ(read_first.transcript, "안녕하세요 오늘");
+    const auto read_second = stt::ReadSessionCapture(path, entries[1]);
+    EXPECT_EQ(read_second.stt_session_id, "stt-2");
+    EXPECT_TRUE(read_second.chunks.empty());
+    EXPECT_EQ(read_second.status_code, 1);
+
+    { std::ofstream other(path + ".other", std::ios::binary); other << "not a capture"; }
+    EXPECT_THROW(stt::SessionCaptureWriter(path + ".other"), std::runtime_error);
+    std::remove(path.c_str());
+    std::remove((path + ".idx").c_str());
+    std::remove((path + ".other").c_str());
+}
+
+// Endpointer: 발화 후 무음이 이어지고 중간 결과가 안정되면 끝점 (오디오 시간 기준)
+namespace {
+
+std::vector<int16_t> Tone(int ms, double amplitude) {
+    std::vector<int16_t> pcm(static_cast<size_t>(ms) * 16);
+    for (size_t i = 0; i < pcm.size(); ++i) {
+        pcm[i] = static_cast<int16_t>(amplitude * 32767.0 * std::sin(2 * M_PI * 300.0 * i / 16000.0));
+    }
+    return pcm;
+}
+
+// 40ms 블록 단위로 넣고, 끝점이 검출된 시점(오디오 ms)을 반환 (없으면 -1)
+int FeedUntilEndpoint(stt::Endpointer& endpointer, const std::vector<int16_t>& pcm) {
+    for (size_t offset = 0; offset < pcm.size(); offset += 640) {
+        if (endpointer.OnAudio(pcm.data() + offset, std::min<size_t>(640, pcm.size() - offset))) {
+            return static_cast<int>(endpointer.audio_ms());
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+TEST(EndpointerTest, FiresAfterTrailingSilenceOnceTranscriptIsStable) {
+    stt::EndpointerConfig config;
+    config.enabled = true;
+    config.trailing_silence_ms = 500;
+    config.transcript_stable_ms = 300;
+    stt::Endpointer endpointer(config);
+
+    const auto quiet = Tone(200, 0.0005); // 잡음 바닥 (~-69 dBFS)
+    EXPECT_EQ(FeedUntilEndpoint(endpointer, quiet), -1);
+    EXPECT_EQ(FeedUntilEndpoint(endpointer, Tone(800, 0.3)), -1); // 발화
+    endpointer.OnTranscript("안녕하세요");
+    // 발화 끝(1000ms) + 무음 500ms. 텍스트 변화(1000ms) 후 300ms도 지남
+    EXPECT_EQ(FeedUntilEndpoint(endpointer, Tone(1000, 0.0005)), 1520); // 40ms 블록 경계
+    EXPECT_FALSE(endpointer.OnAudio(quiet.data(), quiet.size())); // 한 번만
+    EXPECT_TRUE(endpointer.fired());
+}
+
+TEST(EndpointerTest, WaitsForTranscriptToSettleAndIgnoresSilenceWithoutSpeech) {
+    stt::EndpointerConfig config;
+    config.enabled = true;
+    config.trailing_silence_ms = 300;
+    config.transcript_stable_ms = 600;
+    stt::Endpointer endpointer(config);
+
+    // 발화 없이 무음/잡음만: 텍스트가 있어도 끝점 아님
+    endpointer.OnTranscript("잡음");
+    EXPECT_EQ(FeedUntilEndpoint(endpointer, Tone(1000, 0.0005)), -1);
+
+    EXPECT_EQ(FeedUntilEndpoint(endpointer, Tone(400, 0.3)), -1);
+    EXPECT_EQ(FeedUntilEndpoint(endpointer, Tone(200, 0.0005)), -1);
+    endpointer.OnTranscript("안녕하세요 오늘"); // 무음 중에도 인식 결과가 바뀜 (1600ms)
+    // 무음 조건(300ms)은 1700ms에 만족하지만 텍스트 안정(600ms)은 2200ms에야 만족
+    EXPECT_EQ(FeedUntilEndpoint(endpointer, Tone(2000, 0.0005)), 2200);
+}
+
+TEST(EndpointerTest, FiresWhenSpeechStartsAtFirstFrame) {
+    stt::EndpointerConfig config;
+    config.enabled = true;
+    config.trailing_silence_ms = 500;
+    config.transcript_stable_ms = 300;
+    stt::Endpointer endpointer(config);
+
+    // 앞쪽 무음 없이 바로 발화: 첫 프레임이 잡음 바닥이 되면 발화가 바닥 + margin을 넘지 못해 끝점이 안 나옴
+    EXPECT_EQ(FeedUntilEndpoint(endpointer, Tone(800, 0.3)), -1);
+    endpointer.OnTranscript("안녕하세요");
+    EXPECT_EQ(FeedUntilEndpoint(endpointer, Tone(1000, 0.0005)), 1320); // 발화 끝(800ms) + 무음 500ms, 40ms 블록 경계
+}
+
+// RecognizerReaper: 느린 Stop을 뒤에서 처리하고 재사용 가능한 엔진은 Acquire로 돌려줌, 예산을 넘긴 정리는 누수로 집계
+namespace {
+class SlowStopEngine : public stt::RecognitionEngine {
+public:
+    SlowStopEngine(std::chrono::milliseconds stop_delay, bool recyclable, std::atomic<int>* destroyed)
+        : stop_delay_(stop_delay), recyclable_(recyclable), destroyed_(destroyed) {}
+    ~SlowStopEngine() override { destroyed_->fetch_add(1); }
+
+    bool StartContinuousRecognition(const std::string&, const stt::TextChunkCallback&,
+                                    const stt::RecognitionCompletionCallback&) override {
+        return true;
+    }
+    void PushAudioChunk(const uint8_t*, size_t) override {}
+    void CloseInput() override {}
+    void StopContinuousRecognition() override { std::this_thread::sleep_for(stop_delay_); }
+    bool Recycle() override { return recyclable_; }
+
+private:
+    std::chrono::milliseconds stop_delay_;
+    bool recyclable_;
+    std::atomic<int>* destroyed_;
+};
+
+template <typename Pred>
+bool WaitFor(Pred pred, std::chrono::milliseconds limit = std::chrono::milliseconds(3000)) {
+    const auto deadline = std::chrono::steady_clock::now() + limit;
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+} // namespace
+
+TEST(RecognizerReaperTest, RetireReturnsImmediatelyAndRecyclesEngines) {
+    std::atomic<int> destroyed{0};
+    stt::RecognizerReaper reaper(2, std::chrono::milliseconds(5000), 1);
+    EXPECT_EQ(reaper.Acquire(), nullptr);
+
+    const auto begin = std::chrono::steady_clock::now();
+    reaper.Retire(std::make_unique<SlowStopEngine>(std::chrono::milliseconds(200), true, &destroyed));
+    reaper.Retire(std::make_unique<SlowStopEngine>(std::chrono::milliseconds(200), true, &destroyed));
+    reaper.Retire(std::make_unique<SlowStopEngine>(std::chrono::milliseconds(10), false, &destroyed));
+    EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::milliseconds(100)); // Stop을 기다리지 않음
+    EXPECT_EQ(reaper.stats().in_flight, 3u);
+
+    ASSERT_TRUE(WaitFor([&]() { return reaper.stats().completed == 3; }));
+    auto stats = reaper.stats();
+    EXPECT_EQ(stats.retired, 3u);
+    EXPECT_EQ(stats.in_flight, 0u);
+    EXPECT_EQ(stats.recycled, 1u); // 유휴 목록 한도 1: 두 번째 재사용 가능 엔진은 소멸
+    EXPECT_EQ(stats.idle, 1u);
+    EXPECT_EQ(destroyed.load(), 2);
+    EXPECT_GE(stats.max_teardown_ms, 200.0);
+    EXPECT_EQ(stats.leaked_total, 0u);
+
+    auto engine = reaper.Acquire();
+    ASSERT_NE(engine, nullptr);
+    EXPECT_EQ(reaper.Acquire(), nullptr);
+    EXPECT_EQ(reaper.stats().reused, 1u);
+}
+
+TEST(RecognizerReaperTest, CountsTeardownsOverBudgetAsLeaked) {
+    std::atomic<int> destroyed{0};
+    {
+        stt::RecognizerReaper reaper(1, std::chrono::milliseconds(50), 4);
+        reaper.Retire(std::make_unique<SlowStopEngine>(std::chrono::milliseconds(300), false, &destroyed));
+        reaper.Retire(std::make_unique<SlowStopEngine>(std::chrono::milliseconds(0), false, &destroyed)); // 앞의 정리 뒤에서 대기
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        auto stats = reaper.stats();
+        EXPECT_EQ(stats.in_flight, 2u);
+        EXPECT_EQ(stats.leaked_now, 2u); // 대기 중인 것도 예산은 Retire부터 계산
+        EXPECT_EQ(stats.leaked_total, 2u);
+
+        ASSERT_TRUE(WaitFor([&]() { return reaper.stats().completed == 2; }));
+        stats = reaper.stats();
+        EXPECT_EQ(stats.leaked_now, 0u);
+        EXPECT_EQ(stats.leaked_total, 2u); // 끝난 뒤에도 중복 집계 안 함
+    }
+    EXPECT_EQ(destroyed.load(), 2);
+}
+
+// AudioPreprocessor: DC/저주파 험 제거, 조용한 음성은 목표 레벨로 키우되 피크는 천장 아래, 잡음 구간은 게이트로 감쇠
+namespace {
+// amplitude(0~1) 톤 + dc 오프셋, 16kHz int16
+std::vector<int16_t> MakeTone(double hz, double amplitude, double dc, size_t samples, size_t offset = 0) {
+    std::vector<int16_t> pcm(samples);
+    for (size_t i = 0; i < samples; ++i) {
+        const double v = dc + amplitude * std::sin(2.0 * M_PI * hz * static_cast<double>(i + offset) / 16000.0);
+        pcm[i] = static_cast<int16_t>(std::lround(std::clamp(v, -1.0, 32767.0 / 32768.0) * 32768.0));
+    }
+    return pcm;
+}
+
+// 40ms 블록 단위로 처리 (펌프와 같은 크기)
+void ProcessInBlocks(stt::AudioPreprocessor& pre, std::vector<int16_t>& pcm) {
+    for (size_t offset = 0; offset < pcm.size(); offset += 640) {
+        pre.Process(pcm.data() + offset, std::min<size_t>(640, pcm.size() - offset));
+    }
+}
+
+double MeanOf(const std::vector<int16_t>& pcm, size_t skip) {
+    double sum = 0.0;
+    for (size_t i = skip; i < pcm.size(); ++i) sum += pcm[i];
+    return sum / static_cast<double>(pcm.size() - skip) / 32768.0;
+}
+} // namespace
+
+TEST(AudioPreprocessorTest, HighPassRemovesDcAndRumbleButKeepsSpeechBand) {
+    stt::AudioPreprocessorConfig config;
+    config.enabled = true;
+    config.noise_gate = false;
+    config.agc = false;
+    stt::AudioPreprocessor pre(config);
+
+    std::vector<int16_t> speech = MakeTone(1000.0, 0.3, 0.2, 16000);
+    ProcessInBlocks(pre, speech);
+    EXPECT_NEAR(MeanOf(speech, 8000), 0.0, 0.001);
+    EXPECT_NEAR(Rms(speech, 8000), 0.3 / std::sqrt(2.0), 0.01);
+
+    std::vector<int16_t> rumble = MakeTone(20.0, 0.3, 0.0, 16000);
+    ProcessInBlocks(pre, rumble);
+    EXPECT_LT(Rms(rumble, 8000), 0.3 / std::sqrt(2.0) * 0.1); // 80Hz 2차 필터: 20Hz는 -24dB
+    EXPECT_EQ(pre.stats().blocks, 50u);
+    EXPECT_GT(pre.stats().high_pass_ns, 0u);
+}
+
+TEST(AudioPreprocessorTest, AgcRaisesQuietSpeechAndLimiterHoldsCeiling) {
+    stt::AudioPreprocessorConfig config;
+    config.enabled = true;
+    config.high_pass = false;
+    config.noise_gate = false;
+    stt::AudioPreprocessor pre(config);
+
+    std::vector<int16_t> quiet = MakeTone(500.0, 0.02, 0.0, 16000 * 6); // -37 dBFS RMS
+    ProcessInBlocks(pre, quiet);
+    EXPECT_GT(pre.agc_gain_db(), 15.0);
+    EXPECT_GT(Rms(quiet, 16000 * 5), 0.02 / std::sqrt(2.0) * 5.0);
+
+    // 이득이 올라간 상태에서 갑자기 큰 소리: 첫 블록부터 천장(-1 dBFS)을 넘지 않음
+    std::vector<int16_t> loud = MakeTone(500.0, 0.9, 0.0, 16000);
+    ProcessInBlocks(pre, loud);
+    const int16_t ceiling = static_cast<int16_t>(32768.0 * std::pow(10.0, -1.0 / 20.0)) + 1;
+    for (size_t i = 0; i < loud.size(); ++i) {
+        ASSERT_LE(std::abs(loud[i]), ceiling) << "sample " << i;
+    }
+    EXPECT_GT(pre.stats().limited_blocks, 0u);
+    EXPECT_LT(pre.agc_gain_db(), 0.0);
+}
+
+TEST(AudioPreprocessorTest, GateAttenuatesNoiseAfterHoldAndReopensOnSpeech) {
+    stt::AudioPreprocessorConfig config;
+    config.enabled = true;
+    config.agc = false;
+    stt::AudioPreprocessor pre(config);
+
+    std::vector<int16_t> speech = MakeTone(1000.0, 0.1, 0.0, 8000);
+    ProcessInBlocks(pre, speech);
+    EXPECT_TRUE(pre.gate_open());
+    EXPECT_NEAR(Rms(speech, 640), 0.1 / std::sqrt(2.0), 0.005);
+
+    std::vector<int16_t> noise = MakeTone(1000.0, 0.0005, 0.0, 16000); // -69 dBFS
+    ProcessInBlocks(pre, noise);
+    EXPECT_FALSE(pre.gate_open());
+    EXPECT_LT(Rms(noise, 8000), 0.0005 / std::sqrt(2.0) * 0.2); // -20 dB 감쇠 (양자화 여유)
+    EXPECT_GT(pre.stats().gated_blocks, 0u);
+
+    std::vector<int16_t> again = MakeTone(1000.0, 0.1, 0.0, 1280);
+    ProcessInBlocks(pre, again);
+    EXPECT_TRUE(pre.gate_open());
+}
+
+TEST(AudioPreprocessorTest, SimdPathsMatchScalar) {
+    stt::AudioPreprocessorConfig config;
+    config.enabled = true;
+    std::vector<int16_t> input = MakeTone(300.0, 0.05, 0.01, 16000 * 2);
+    const std::vector<int16_t> burst = MakeTone(2000.0, 0.95, 0.0, 4000, 7);
+    std::copy(burst.begin(), burst.end(), input.begin() + 16000);
+
+    // SIMD 폭과 어긋나는 블록 크기로 나머지 처리 경로까지 확인
+    auto run = [&input](stt::AudioPreprocessor pre) {
+        std::vector<int16_t> pcm = input;
+        for (size_t offset = 0; offset < pcm.size(); offset += 637) {
+            pre.Process(pcm.data() + offset, std::min<size_t>(637, pcm.size() - offset));
+        }
+        return pcm;
+    };
+    const std::vector<int16_t> reference = run(stt::AudioPreprocessor(config, stt::AudioConverter::Simd::kScalar));
+    const std::vector<int16_t> vectorized = run(stt::AudioPreprocessor(config)); // 이 CPU의 최선 경로
+    ASSERT_EQ(vectorized.size(), reference.size());
+    for (size_t i = 0; i < reference.size(); ++i) {
+        ASSERT_NEAR(vectorized[i], reference[i], 2) << "sample " << i;
+    }
+    EXPECT_NE(reference, input); // 실제로 처리됨
+    EXPECT_THROW(stt::AudioPreprocessor(stt::AudioPreprocessorConfig{true, true, 0.0}), std::runtime_error);
+}
+
+// TaskScheduler: 즉시 작업은 작업 스레드에서 실행, 지연 작업은 시각 순서대로, 취소된 작업은 실행 안 됨
+TEST(TaskSchedulerTest, RunsPostedAndDelayedTasksAndHonorsCancel) {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::string> order;
+    auto record = [&](const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(name);
+        cv.notify_all();
+    };
+    {
+        stt::TaskScheduler scheduler(2);
+        EXPECT_EQ(scheduler.thread_count(), 2u);
+        const auto caller = std::this_thread::get_id();
+        std::atomic<bool> ran_on_worker{false};
+        scheduler.PostAfter(std::chrono::milliseconds(80), [&]() { record("late"); });
+        scheduler.PostAfter(std::chrono::milliseconds(30), [&]() { record("early"); });
+        const auto cancelled = scheduler.PostAfter(std::chrono::milliseconds(50), [&]() { record("cancelled"); });
+        scheduler.Post([&]() { ran_on_worker = std::this_thread::get_id() != caller; record("now"); });
+        EXPECT_TRUE(scheduler.Cancel(cancelled));
+        EXPECT_FALSE(scheduler.Cancel(cancelled));
+
+        std::unique_lock<std::mutex> lock(mutex);
+        ASSERT_TRUE(cv.wait_for(lock, std::chrono::seconds(5), [&]() { return order.size() == 3; }));
+        EXPECT_EQ(order, (std::vector<std::string>{"now", "early", "late"}));
+        EXPECT_TRUE(ran_on_worker.load());
+
+        // 소멸 시 시각이 안 된 지연 작업은 버림
+        scheduler.PostAfter(std::chrono::hours(1), [&]() { ADD_FAILURE() << "pending timer ran at shutdown"; });
+    }
+}
+
+// TaskScheduler: 소멸로 버려지는 지연 작업만 on_drop 호출 (실행/취소된 작업은 호출 안 함) - 세션 참조 누수 방지
+TEST(TaskSchedulerTest, CallsOnDropForTimersDroppedAtShutdown) {
+    std::atomic<int> refs{3};
+    std::atomic<bool> ran{false};
+    {
+        stt::TaskScheduler scheduler(1);
+        std::promise<void> done;
+        scheduler.PostAfter(std::chrono::milliseconds(1), [&]() { ran = true; refs--; done.set_value(); }, [&]() { ADD_FAILURE() << "on_drop after run"; });
+        const auto cancelled = scheduler.PostAfter(std::chrono::hours(1), [&]() {}, [&]() { ADD_FAILURE() << "on_drop after cancel"; });
+        scheduler.PostAfter(std::chrono::hours(1), [&]() { ADD_FAILURE() << "pending timer ran at shutdown"; }, [&]() { refs--; });
+        scheduler.PostAt(stt::TaskScheduler::Clock::now() + std::chrono::hours(2), [&]() {}, [&]() { refs--; });
+        ASSERT_EQ(done.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+        EXPECT_TRUE(scheduler.Cancel(cancelled));
+        EXPECT_EQ(refs.load(), 2);
+    }
+    EXPECT_TRUE(ran.load());
+    EXPECT_EQ(refs.load(), 0);
+}
+
+// TaskScheduler: 이전 기한 + 주기로 PostAt 재예약하면 작업 실행 시간이 주기에 누적되지 않음 (오디오 펌프 방식)
+TEST(TaskSchedulerTest, PostAtKeepsPeriodicTicksOnAbsoluteDeadlines) {
+    constexpr auto kInterval = std::chrono::milliseconds(20);
+    constexpr int kTicks = 25;
+    stt::TaskScheduler scheduler(1);
+    std::promise<stt::TaskScheduler::Clock::time_point> finished;
+    const auto start = stt::TaskScheduler::Clock::now();
+    auto deadline = start;
+    int ticks = 0;
+    std::function<void()> tick = [&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5)); // 주기마다의 작업 시간
+        if (++ticks == kTicks) {
+            finished.set_value(stt::TaskScheduler::Clock::now());
+            return;
+        }
+        deadline += kInterval;
+        scheduler.PostAt(deadline, tick);
+    };
+    deadline += kInterval;
+    scheduler.PostAt(deadline, tick);
+    auto future = finished.get_future();
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(10)), std::future_status::ready);
+    // PostAfter로 재예약했다면 25 * (20 + 5)ms = 625ms. 절대 기한이면 25 * 20ms + 마지막 작업 5ms 근처
+    const auto elapsed = future.get() - start;
+    EXPECT_GE(elapsed, kInterval * kTicks);
+    EXPECT_LT(elapsed, kInterval * kTicks + std::chrono::milliseconds(100));
+}
+
 // TODO: 추가적인 내부 단위 테스트 케이스 작성
 // ...
 
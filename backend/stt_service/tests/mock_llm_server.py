@@ -74,6 +74,9 @@ class MockLLMEngineService(llm_pb2_grpc.LLMServiceServicer): # 사용자 파일
                             # 필요시 청크 내용 로깅 (주석 처리)
                             # text = request.text_chunk
                             # print(f"MockLLM: [{current_session}] Req#{self.request_count} Received chunk len: {len(text)}")
+                        elif request_type == 'transcript_final':
+                            # 발화 확정 표시 (이후 텍스트 없음)
+                            print(f"MockLLM: [{current_session}] Received transcript final marker after {self.received_chunks_count} chunk(s).")
                         elif request_type == 'config':
                             # 초기화 후 config가 또 들어오면 오류
                             print(f"MockLLM: [{current_session}] Error: Received unexpected SessionConfig after initialization.", file=sys.stderr)
@@ -0,0 +1,136 @@
+# tests/recognize_stream_benchmark.py
+#
+# RecognizeStream 처리량/지연 벤치마크. Azure 없이 돌리려면 스크립트 엔진으로 STT 서비스를 띄운다.
+# LLM 쪽은 mock_llm_server.py로 충분하다 (STT는 텍스트 전달과 FinishStream만 기다림).
+#
+#   python tests/mock_llm_server.py &
+#   STT_ENGINE=scripted STT_SCRIPT_PATH=tests/scripted_transcripts.txt \
+#   LLM_ENGINE_ADDRESS=localhost:50051 STT_SERVER_ADDRESS=0.0.0.0:50056 ./build/stt_server &
+#   python tests/recognize_stream_benchmark.py --streams 50 --concurrency 10 --pace 0
+#
+# 측정값
+#   finish latency : 마지막 오디오 청크 전송 → RecognizeStream 응답 (턴 종료 후 LLM 스트림 마감까지의 지연)
+#   throughput     : 완료 스트림/s 와 실시간 대비 오디오 처리 배속
+# --pace 1 은 실시간 속도로 업로드 (게이트웨이와 같은 조건), 0 은 가능한 한 빠르게.
+
+import argparse
+import os
+import statistics
+import threading
+import time
+from concurrent import futures
+
+import grpc
+
+try:
+    import stt_pb2
+    import stt_pb2_grpc
+except ImportError:
+    print("Error: Protobuf/gRPC Python files not found.")
+    print("Run 'python -m grpc_tools.protoc -Iprotos --python_out=. --grpc_python_out=. protos/stt.proto' first.")
+    exit(1)
+
+
+# --- Configuration ---
+STT_SERVICE_ADDRESS = os.getenv("STT_SERVICE_ADDRESS", "localhost:50056")
+AUDIO_SAMPLE_PATH = os.getenv("AUDIO_SAMPLE_PATH", "tests/sample.wav")
+PCM_BYTES_PER_SEC = 32000  # 16kHz 16-bit mono
+WAV_HEADER_BYTES = 44
+
+
+def load_pcm(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] == b"RIFF":
+        data = data[WAV_HEADER_BYTES:]
+    return data
+
+
+def run_stream(stub, index, pcm, chunk_bytes, pace, language):
+    marks = {}
+
+    def requests():
+        config = stt_pb2.RecognitionConfig(
+            language=language,
+            frontend_session_id=f"bench-{index}",
+            session_id=f"bench-stt-{index}",
+            turn_id=1,
+        )
+        yield stt_pb2.STTStreamRequest(config=config)
+        start = time.monotonic()
+        for offset in range(0, len(pcm), chunk_bytes):
+            chunk = pcm[offset:offset + chunk_bytes]
+            if pace > 0:
+                # 업로드 시각을 오디오 타임라인에 맞춤 (누적 오차 없이)
+                due = start + (offset / PCM_BYTES_PER_SEC) / pace
+                delay = due - time.monotonic()
+                if delay > 0:
+                    time.sleep(delay)
+            yield stt_pb2.STTStreamRequest(audio_chunk=chunk)
+        marks["audio_done"] = time.monotonic()
+
+    started = time.monotonic()
+    try:
+        stub.RecognizeStream(requests(), timeout=120)
+        ok = True
+    except grpc.RpcError as e:
+        print(f"  stream {index} failed: {e.code()} {e.details()}")
+        ok = False
+    finished = time.monotonic()
+    return ok, finished - started, finished - marks.get("audio_done", finished)
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    k = min(len(ordered) - 1, max(0, int(round(p / 100.0 * (len(ordered) - 1)))))
+    return ordered[k]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="RecognizeStream throughput/latency benchmark")
+    parser.add_argument("--streams", type=int, default=20, help="total streams to run")
+    parser.add_argument("--concurrency", type=int, default=4, help="streams in flight at once")
+    parser.add_argument("--chunk-ms", type=int, default=100, help="audio per request message")
+    parser.add_argument("--pace", type=float, default=1.0, help="upload speed as a multiple of real time (0 = unpaced)")
+    parser.add_argument("--language", default="ko-KR")
+    parser.add_argument("--audio", default=AUDIO_SAMPLE_PATH)
+    args = parser.parse_args()
+
+    pcm = load_pcm(args.audio)
+    chunk_bytes = max(2, args.chunk_ms * PCM_BYTES_PER_SEC // 1000) & ~1
+    audio_sec = len(pcm) / PCM_BYTES_PER_SEC
+    print(f"Audio: {args.audio} ({audio_sec:.2f}s), {args.streams} streams, concurrency {args.concurrency}, "
+          f"pace {'unpaced' if args.pace <= 0 else f'{args.pace}x'}")
+
+    channel = grpc.insecure_channel(STT_SERVICE_ADDRESS)
+    grpc.channel_ready_future(channel).result(timeout=10)
+    stub = stt_pb2_grpc.STTServiceStub(channel)
+
+    results = []
+    lock = threading.Lock()
+    bench_start = time.monotonic()
+    with futures.ThreadPoolExecutor(max_workers=args.concurrency) as pool:
+        jobs = [pool.submit(run_stream, stub, i, pcm, chunk_bytes, args.pace, args.language) for i in range(args.streams)]
+        for job in futures.as_completed(jobs):
+            with lock:
+                results.append(job.result())
+    elapsed = time.monotonic() - bench_start
+    channel.close()
+
+    succeeded = [r for r in results if r[0]]
+    finish_ms = [r[2] * 1000.0 for r in succeeded]
+    total_ms = [r[1] * 1000.0 for r in succeeded]
+    print(f"\nCompleted {len(succeeded)}/{len(results)} streams in {elapsed:.2f}s")
+    print(f"  throughput     : {len(succeeded) / elapsed:.2f} streams/s, "
+          f"{len(succeeded) * audio_sec / elapsed:.1f}x real-time audio")
+    if succeeded:
+        print(f"  finish latency : p50 {percentile(finish_ms, 50):.1f} ms, p95 {percentile(finish_ms, 95):.1f} ms, "
+              f"max {max(finish_ms):.1f} ms")
+        print(f"  stream duration: mean {statistics.mean(total_ms):.1f} ms")
+    return 0 if len(succeeded) == len(results) else 1
+
+
+if __name__ == "__main__":
+    exit(main())
@@ -0,0 +1,225 @@
+# tests/replay_captures.py
+#
+# STT_CAPTURE_PATH로 기록한 세션 캡처를 RecognizeStream으로 다시 재생 (재현 가능한 지연/처리량 측정).
+# 캡처에 기록된 원본 오디오 형식과 청크 도착 간격을 그대로 사용하고, --speed로 간격을 줄인다.
+#
+#   STT_ENGINE=scripted STT_SCRIPT_PATH=tests/scripted_transcripts.txt ... ./build/stt_server &
+#   python tests/replay_captures.py captures/stt.cap --speed 4 --concurrency 20
+#   python tests/replay_captures.py captures/stt.cap --list
+#
+# 측정값
+#   finish latency : 마지막 청크 전송 → RecognizeStream 응답
+#   throughput     : 완료 스트림/s 와 실시간 대비 오디오 처리 배속
+# --speed 1 은 기록된 도착 간격 그대로, N 은 N배 빠르게, 0 은 간격 없이.
+# 컨테이너 형식은 src/session_capture.h 참고.
+
+import argparse
+import os
+import statistics
+import struct
+import threading
+import time
+from concurrent import futures
+
+import grpc
+
+try:
+    import stt_pb2
+    import stt_pb2_grpc
+except ImportError:
+    print("Error: Protobuf/gRPC Python files not found.")
+    print("Run 'python -m grpc_tools.protoc -Iprotos --python_out=. --grpc_python_out=. protos/stt.proto' first.")
+    exit(1)
+
+
+# --- Configuration ---
+STT_SERVICE_ADDRESS = os.getenv("STT_SERVICE_ADDRESS", "localhost:50056")
+DATA_MAGIC = b"STTCAP01"
+INDEX_MAGIC = b"STTIDX01"
+RECORD_MAGIC = b"SREC"
+INDEX_ENTRY = struct.Struct("<QIIQII")  # offset, record_size, duration_ms, start_unix_ms, chunk_count, audio_bytes
+
+
+class BodyReader:
+    def __init__(self, body):
+        self.body = body
+        self.pos = 0
+
+    def varint(self):
+        value, shift = 0, 0
+        while True:
+            if self.pos >= len(self.body) or shift >= 64:
+                raise ValueError("corrupt capture record (varint)")
+            byte = self.body[self.pos]
+            self.pos += 1
+            value |= (byte & 0x7F) << shift
+            if not byte & 0x80:
+                return value
+            shift += 7
+
+    def bytes(self, size):
+        if self.pos + size > len(self.body):
+            raise ValueError("corrupt capture record (length)")
+        value = self.body[self.pos:self.pos + size]
+        self.pos += size
+        return value
+
+    def string(self):
+        return self.bytes(self.varint()).decode("utf-8", errors="replace")
+
+
+def read_index(path):
+    with open(path + ".idx", "rb") as f:
+        if f.read(len(INDEX_MAGIC)) != INDEX_MAGIC:
+            raise ValueError(f"{path}.idx is not a session capture index")
+        entries = []
+        while True:
+            raw = f.read(INDEX_ENTRY.size)
+            if len(raw) < INDEX_ENTRY.size:  # 잘린 마지막 항목은 무시
+                return entries
+            entries.append(INDEX_ENTRY.unpack(raw))
+
+
+def read_capture(f, entry):
+    offset, record_size = entry[0], entry[1]
+    f.seek(offset)
+    record = f.read(record_size)
+    if len(record) != record_size or record[:4] != RECORD_MAGIC or struct.unpack("<I", record[4:8])[0] != record_size - 8:
+        raise ValueError(f"invalid capture record at offset {offset}")
+    r = BodyReader(record[8:])
+    capture = {
+        "stt_session_id": r.string(),
+        "frontend_session_id": r.string(),
+        "language": r.string(),
+        "turn_id": r.varint(),
+        "sample_rate_hz": r.varint(),
+        "channels": r.varint(),
+        "sample_format": r.varint(),
+        "start_unix_ms": r.varint(),
+    }
+    chunks, arrival_us = [], 0
+    for _ in range(r.varint()):
+        arrival_us += r.varint()
+        chunks.append((arrival_us, r.varint()))
+    audio = r.bytes(sum(size for _, size in chunks))
+    capture["chunks"] = []
+    pos = 0
+    for arrival, size in chunks:
+        capture["chunks"].append((arrival / 1e6, audio[pos:pos + size]))
+        pos += size
+    capture["transcript"] = r.string()
+    capture["status_code"] = r.varint()
+    capture["duration_sec"] = entry[2] / 1000.0  # 마지막 청크 도착 시각
+    bytes_per_sec = (capture["sample_rate_hz"] or 16000) * (capture["channels"] or 1) * (4 if capture["sample_format"] == 2 else 2)
+    capture["audio_sec"] = len(audio) / bytes_per_sec
+    return capture
+
+
+def load_captures(path):
+    with open(path, "rb") as f:
+        if f.read(len(DATA_MAGIC)) != DATA_MAGIC:
+            raise ValueError(f"{path} is not a session capture file")
+        return [read_capture(f, entry) for entry in read_index(path)]
+
+
+def replay_stream(stub, index, capture, speed):
+    marks = {}
+
+    def requests():
+        config = stt_pb2.RecognitionConfig(
+            language=capture["language"],
+            frontend_session_id=f"replay-{index}-{capture['frontend_session_id']}",
+            session_id=f"replay-{index}",
+            turn_id=capture["turn_id"],
+            sample_rate_hz=capture["sample_rate_hz"],
+            channels=capture["channels"],
+            sample_format=capture["sample_format"],
+        )
+        yield stt_pb2.STTStreamRequest(config=config)
+        start = time.monotonic()
+        for arrival, chunk in capture["chunks"]:
+            if speed > 0:
+                # 기록된 도착 시각에 맞춤 (누적 오차 없이)
+                delay = start + arrival / speed - time.monotonic()
+                if delay > 0:
+                    time.sleep(delay)
+            yield stt_pb2.STTStreamRequest(audio_chunk=chunk)
+        marks["audio_done"] = time.monotonic()
+
+    started = time.monotonic()
+    try:
+        stub.RecognizeStream(requests(), timeout=300)
+        ok = True
+    except grpc.RpcError as e:
+        print(f"  replay {index} ({capture['stt_session_id']}) failed: {e.code()} {e.details()}")
+        ok = False
+    finished = time.monotonic()
+    return ok, finished - started, finished - marks.get("audio_done", finished), capture["audio_sec"]
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    k = min(len(ordered) - 1, max(0, int(round(p / 100.0 * (len(ordered) - 1)))))
+    return ordered[k]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Replay recorded STT session captures over gRPC")
+    parser.add_argument("capture", help="capture container written via STT_CAPTURE_PATH")
+    parser.add_argument("--speed", type=float, default=1.0, help="replay speed as a multiple of recorded arrival timing (0 = unpaced)")
+    parser.add_argument("--concurrency", type=int, default=4, help="streams in flight at once")
+    parser.add_argument("--repeat", type=int, default=1, help="replay the whole capture set this many times")
+    parser.add_argument("--only-ok", action="store_true", help="skip sessions that did not finish with OK when recorded")
+    parser.add_argument("--list", action="store_true", help="print the captured sessions and exit")
+    args = parser.parse_args()
+
+    captures = load_captures(args.capture)
+    if args.only_ok:
+        captures = [c for c in captures if c["status_code"] == 0]
+    if args.list:
+        for i, c in enumerate(captures):
+            fmt = f"{c['sample_rate_hz'] or 16000}Hz/{c['channels'] or 1}ch/{'f32' if c['sample_format'] == 2 else 's16'}"
+            print(f"{i:5d} {c['stt_session_id']} fe={c['frontend_session_id']} turn={c['turn_id']} {fmt} "
+                  f"{len(c['chunks'])} chunks {c['audio_sec']:.2f}s audio over {c['duration_sec']:.2f}s status={c['status_code']} \"{c['transcript']}\"")
+        return 0
+    if not captures:
+        print("No sessions to replay.")
+        return 1
+
+    jobs_list = captures * max(1, args.repeat)
+    audio_sec = sum(c["audio_sec"] for c in jobs_list)
+    print(f"Replaying {len(jobs_list)} session(s) ({audio_sec:.1f}s of audio) from {args.capture}, "
+          f"concurrency {args.concurrency}, speed {'unpaced' if args.speed <= 0 else f'{args.speed}x'}")
+
+    channel = grpc.insecure_channel(STT_SERVICE_ADDRESS)
+    grpc.channel_ready_future(channel).result(timeout=10)
+    stub = stt_pb2_grpc.STTServiceStub(channel)
+
+    results = []
+    lock = threading.Lock()
+    replay_start = time.monotonic()
+    with futures.ThreadPoolExecutor(max_workers=args.concurrency) as pool:
+        jobs = [pool.submit(replay_stream, stub, i, c, args.speed) for i, c in enumerate(jobs_list)]
+        for job in futures.as_completed(jobs):
+            with lock:
+                results.append(job.result())
+    elapsed = time.monotonic() - replay_start
+    channel.close()
+
+    succeeded = [r for r in results if r[0]]
+    finish_ms = [r[2] * 1000.0 for r in succeeded]
+    total_ms = [r[1] * 1000.0 for r in succeeded]
+    print(f"\nCompleted {len(succeeded)}/{len(results)} streams in {elapsed:.2f}s")
+    print(f"  throughput     : {len(succeeded) / elapsed:.2f} streams/s, "
+          f"{sum(r[3] for r in succeeded) / elapsed:.1f}x real-time audio")
+    if succeeded:
+        print(f"  finish latency : p50 {percentile(finish_ms, 50):.1f} ms, p95 {percentile(finish_ms, 95):.1f} ms, "
+              f"max {max(finish_ms):.1f} ms")
+        print(f"  stream duration: mean {statistics.mean(total_ms):.1f} ms")
+    return 0 if len(succeeded) == len(results) else 1
+
+
+if __name__ == "__main__":
+    exit(main())
@@ -1,9 +1,9 @@
 #pragma once // 헤더 가드 추가
 
 #include <string>
+#include <map>
 #include <memory>
 #include <mutex>
-#include <atomic>
 #include <vector>
 #include <grpcpp/grpcpp.h>
 #include "avatar_sync.grpc.pb.h" // 생성된 avatar_sync proto 헤더
@@ -21,46 +21,64 @@ using grpc::ClientContext;
 using grpc::ClientWriter; // ClientWriterInterface 대신 ClientWriter 사용 (일반적)
 using grpc::Status;
 
+// 턴 하나의 AvatarSync 송신 핸들 (턴마다 SyncAvatarStream RPC 하나 또는 다중화 채널 하나).
+// 턴마다 독립이라 같은 세션의 이전 턴이 아직 전송 중이어도 다음 턴을 열 수 있다 (응답 순서는 게이트웨이가 턴 번호로 정렬)
+class AvatarSyncTurnStream {
+public:
+    virtual ~AvatarSyncTurnStream() = default;
+
+    virtual bool SendAudioChunk(const std::vector<uint8_t>& audio_chunk) = 0;
+    virtual bool SendVisemeDataBatch(const std::vector<VisemeData>& visemes) = 0;
+    // 스트림 종료 및 최종 상태 수신 (한 번만 유효, 이후 호출은 FAILED_PRECONDITION)
+    virtual Status Finish() = 0;
+};
+
+// 세션 ID 접두어로 세션을 소유한 게이트웨이의 AvatarSync 주소를 고르는 라우팅 표.
+// AvatarSyncClient와 AvatarSyncMux가 같은 규칙을 쓰도록 둘 다 이 표로 주소를 결정한다 (생성 후 읽기 전용).
+class AvatarSyncRoutes {
+public:
+    // replica_routes: 게이트웨이 레플리카 ID → AvatarSync 주소 (게이트웨이 GATEWAY_PEERS와 같은 목록)
+    explicit AvatarSyncRoutes(std::string default_address, std::map<std::string, std::string> replica_routes = {});
+
+    // 세션 ID가 "<replica_id>-..." 형태이고 목록에 있으면 그 레플리카 주소, 아니면 기본 주소
+    const std::string& Resolve(const std::string& frontend_session_id) const;
+
+    const std::string& default_address() const { return default_address_; }
+    size_t replica_count() const { return replica_routes_.size(); }
+
+private:
+    std::string default_address_;
+    std::map<std::string, std::string> replica_routes_;
+};
+
 class AvatarSyncClient {
 public:
-    explicit AvatarSyncClient(const std::string& server_address);
+    // replica_routes: AvatarSyncRoutes 참고. 소유 레플리카로 직접 스트리밍하고, 모르는 세션은 server_address 사용
+    explicit AvatarSyncClient(const std::string& server_address,
+                              std::map<std::string, std::string> replica_routes = {});
     ~AvatarSyncClient();
 
     AvatarSyncClient(const AvatarSyncClient&) = delete;
     AvatarSyncClient& operator=(const AvatarSyncClient&) = delete;
-    AvatarSyncClient(AvatarSyncClient&&) = default;
-    AvatarSyncClient& operator=(AvatarSyncClient&&) = default;
-
-    // Avatar Sync 서비스로 스트림 시작 및 초기 설정(SyncConfig) 전송
-    // ★ 인자를 const avatar_sync::SyncConfig& config 로 변경
-    bool StartStream(const avatar_sync::SyncConfig& config);
 
-    // 생성된 오디오 청크를 Avatar Sync 서비스로 전송
-    bool SendAudioChunk(const std::vector<uint8_t>& audio_chunk);
+    // 턴 하나의 스트림을 열고 초기 설정(SyncConfig) 전송. 실패 시 nullptr.
+    // 클라이언트(채널/스텁)는 모든 턴이 공유하고, 스트림 상태는 반환된 핸들이 가짐 (동시에 여러 턴 가능)
+    std::unique_ptr<AvatarSyncTurnStream> OpenStream(const avatar_sync::SyncConfig& config);
 
-    // 생성된 비정형 데이터(VisemeData)를 Avatar Sync 서비스로 전송
-    bool SendVisemeData(const VisemeData& viseme_data);
-    bool SendVisemeDataBatch(const std::vector<VisemeData>& visemes);
-
-    // 스트림 종료 및 최종 상태 수신
-    Status FinishStream();
-
-    // 현재 스트림이 활성 상태인지 확인
-    bool IsStreamActive() const;
+    // 세션을 소유한 게이트웨이의 AvatarSync 주소
+    const std::string& ResolveAddress(const std::string& frontend_session_id) const { return routes_.Resolve(frontend_session_id); }
 
 private:
-    std::string server_address_;
-    std::string current_frontend_session_id_; // 현재 활성화된 스트림의 프론트엔드 세션 ID 저장용
+    class RpcStream;
 
-    std::shared_ptr<Channel> channel_;
-    std::unique_ptr<AvatarSyncService::Stub> stub_;
+    AvatarSyncService::Stub* StubFor(const std::string& address);
 
-    std::unique_ptr<ClientContext> context_;
-    std::unique_ptr<ClientWriter<AvatarSyncStreamRequest>> stream_;
-    google::protobuf::Empty server_response_;
+    AvatarSyncRoutes routes_;
 
-    mutable std::mutex stream_mutex_;
-    std::atomic<bool> stream_active_{false};
+    std::shared_ptr<Channel> channel_;
+    std::unique_ptr<AvatarSyncService::Stub> stub_; // 기본 주소(routes_.default_address())용
+    std::mutex stubs_mutex_;
+    std::map<std::string, std::unique_ptr<AvatarSyncService::Stub>> route_stubs_; // 주소별 채널 재사용 (stubs_mutex_로 보호)
 };
 
 } // namespace tts
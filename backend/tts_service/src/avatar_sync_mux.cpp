@@ -0,0 +1,207 @@
+#include "avatar_sync_mux.h"
+#include <iostream>
+
+namespace tts {
+
+AvatarSyncMux::Connection::Connection(avatar_sync::AvatarSyncService::Stub* stub, std::string address,
+                                      std::chrono::milliseconds credit_wait_timeout)
+    : address_(std::move(address)), credit_wait_timeout_(credit_wait_timeout) {
+    stream_ = stub->SyncAvatarMux(&context_);
+    if (!stream_) {
+        broken_.store(true);
+        return;
+    }
+    reader_ = std::thread(&Connection::ReadLoop, this);
+}
+
+AvatarSyncMux::Connection::~Connection() {
+    if (stream_) {
+        {
+            std::lock_guard<std::mutex> lock(write_mutex_);
+            stream_->WritesDone();
+        }
+        context_.TryCancel(); // 게이트웨이가 스트림을 닫을 때까지 기다리지 않음
+    }
+    if (reader_.joinable()) {
+        reader_.join();
+    }
+    if (stream_) {
+        stream_->Finish();
+    }
+}
+
+void AvatarSyncMux::Connection::ReadLoop() {
+    avatar_sync::AvatarSyncMuxControl control;
+    while (stream_->Read(&control)) {
+        std::lock_guard<std::mutex> lock(state_mutex_);
+        if (control.control_data_case() == avatar_sync::AvatarSyncMuxControl::kCreditBytes) {
+            credit_bytes_ += control.credit_bytes();
+            credit_cv_.notify_all();
+        } else if (control.control_data_case() == avatar_sync::AvatarSyncMuxControl::kChannelError) {
+            std::cerr << "⚠️ AvatarSyncMux: gateway " << address_ << " rejected channel " << control.channel_id()
+                      << ": " << control.channel_error() << std::endl;
+            rejected_.insert(control.channel_id());
+        }
+    }
+    std::cerr << "⚠️ AvatarSyncMux: multiplexed stream to " << address_ << " closed." << std::endl;
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    broken_.store(true);
+    credit_cv_.notify_all();
+}
+
+uint32_t AvatarSyncMux::Connection::AllocateChannelId() {
+    uint32_t id = next_channel_id_.fetch_add(1);
+    while (id == 0) { // 0은 연결 전체를 뜻하므로 건너뜀 (한 바퀴 돈 경우)
+        id = next_channel_id_.fetch_add(1);
+    }
+    return id;
+}
+
+bool AvatarSyncMux::Connection::Write(const avatar_sync::AvatarSyncMuxFrame& frame) {
+    // 게이트웨이와 같은 기준: open/데이터/close 모든 프레임의 직렬화 크기를 차감
+    const int64_t size = static_cast<int64_t>(frame.ByteSizeLong());
+    {
+        std::unique_lock<std::mutex> lock(state_mutex_);
+        // close는 크레딧을 기다리지 않고 보냄 (채널 정리가 막히지 않도록). 차감은 똑같이 해서 게이트웨이 반환분과 맞춤
+        if (frame.frame_data_case() != avatar_sync::AvatarSyncMuxFrame::kClose) {
+            // 창이 비어 있어도 프레임 하나는 창보다 클 수 있으므로 양수이기만 하면 전송 (음수만큼은 다음 크레딧에서 상계)
+            if (!credit_cv_.wait_for(lock, credit_wait_timeout_, [this]() { return credit_bytes_ > 0 || broken_.load(); })) {
+                std::cerr << "❌ AvatarSyncMux: no credit from gateway " << address_ << " within "
+                          << credit_wait_timeout_.count() << " ms." << std::endl;
+                return false;
+            }
+        }
+        if (broken_.load()) {
+            return false;
+        }
+        credit_bytes_ -= size;
+    }
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    if (!stream_->Write(frame)) {
+        broken_.store(true);
+        return false;
+    }
+    return true;
+}
+
+bool AvatarSyncMux::Connection::IsRejected(uint32_t channel_id) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    return rejected_.count(channel_id) > 0;
+}
+
+void AvatarSyncMux::Connection::ReleaseChannel(uint32_t channel_id) {
+    std::lock_guard<std::mutex> lock(state_mutex_);
+    rejected_.erase(channel_id);
+}
+
+AvatarSyncMux::Channel::Channel(std::shared_ptr<Connection> connection, uint32_t channel_id, std::string frontend_session_id)
+    : connection_(std::move(connection)), channel_id_(channel_id), frontend_session_id_(std::move(frontend_session_id)) {}
+
+AvatarSyncMux::Channel::~Channel() {
+    if (!finished_) {
+        Finish();
+    }
+}
+
+bool AvatarSyncMux::Channel::Send(avatar_sync::AvatarSyncMuxFrame& frame) {
+    if (finished_ || connection_->IsRejected(channel_id_)) {
+        return false;
+    }
+    frame.set_channel_id(channel_id_);
+    return connection_->Write(frame);
+}
+
+bool AvatarSyncMux::Channel::SendAudioChunk(const std::vector<uint8_t>& audio_chunk) {
+    if (audio_chunk.empty()) {
+        return true;
+    }
+    avatar_sync::AvatarSyncMuxFrame frame;
+    frame.set_audio_chunk(audio_chunk.data(), audio_chunk.size());
+    return Send(frame);
+}
+
+bool AvatarSyncMux::Channel::SendVisemeDataBatch(const std::vector<avatar_sync::VisemeData>& visemes) {
+    avatar_sync::AvatarSyncMuxFrame frame;
+    for (const auto& viseme : visemes) {
+        *frame.mutable_viseme_data() = viseme;
+        if (!Send(frame)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+grpc::Status AvatarSyncMux::Channel::Finish() {
+    if (finished_) {
+        return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, "Channel already finished");
+    }
+    finished_ = true;
+    const bool rejected = connection_->IsRejected(channel_id_);
+    avatar_sync::AvatarSyncMuxFrame frame;
+    frame.set_channel_id(channel_id_);
+    frame.set_close(true);
+    const bool closed = connection_->Write(frame);
+    connection_->ReleaseChannel(channel_id_);
+    if (rejected) {
+        return grpc::Status(grpc::StatusCode::NOT_FOUND, "Gateway rejected channel for FE_SID " + frontend_session_id_);
+    }
+    if (!closed) {
+        return grpc::Status(grpc::StatusCode::UNAVAILABLE, "Multiplexed stream to " + connection_->address() + " is broken");
+    }
+    return grpc::Status::OK;
+}
+
+AvatarSyncMux::AvatarSyncMux(const std::string& server_address, std::map<std::string, std::string> replica_routes,
+                             size_t connections_per_gateway, std::chrono::milliseconds credit_wait_timeout)
+    : routes_(server_address, std::move(replica_routes)),
+      connections_per_gateway_(connections_per_gateway), credit_wait_timeout_(credit_wait_timeout) {
+    if (connections_per_gateway_ == 0) {
+        throw std::runtime_error("AvatarSyncMux requires at least one connection per gateway.");
+    }
+    std::cout << "  AvatarSyncMux initialized: " << connections_per_gateway_ << " multiplexed stream(s) per gateway, default "
+              << routes_.default_address() << std::endl;
+}
+
+AvatarSyncMux::~AvatarSyncMux() {
+    std::lock_guard<std::mutex> lock(pools_mutex_);
+    pools_.clear(); // Connection 소멸자가 스트림을 닫고 reader 스레드를 join (남은 Channel이 있으면 그쪽이 마지막 참조)
+}
+
+std::shared_ptr<AvatarSyncMux::Connection> AvatarSyncMux::AcquireConnection(const std::string& address) {
+    std::lock_guard<std::mutex> lock(pools_mutex_);
+    Pool& pool = pools_[address];
+    if (!pool.stub) {
+        pool.channel = grpc::CreateChannel(address, grpc::InsecureChannelCredentials());
+        pool.stub = avatar_sync::AvatarSyncService::NewStub(pool.channel);
+        pool.connections.resize(connections_per_gateway_);
+    }
+    std::shared_ptr<Connection>& slot = pool.connections[pool.next++ % pool.connections.size()];
+    if (!slot || slot->broken()) {
+        // 끊긴 스트림은 교체. 기존 연결은 아직 쓰는 Channel이 놓을 때 정리된다
+        slot = std::make_shared<Connection>(pool.stub.get(), address, credit_wait_timeout_);
+        std::cout << "🔀 AvatarSyncMux: opened multiplexed stream to " << address << std::endl;
+    }
+    return slot;
+}
+
+std::unique_ptr<AvatarSyncMux::Channel> AvatarSyncMux::OpenChannel(const avatar_sync::SyncConfig& config) {
+    if (config.frontend_session_id().empty()) {
+        std::cerr << "❌ AvatarSyncMux: OpenChannel called with empty frontend_session_id." << std::endl;
+        return nullptr;
+    }
+    std::shared_ptr<Connection> connection = AcquireConnection(ResolveAddress(config.frontend_session_id()));
+    if (connection->broken()) {
+        return nullptr;
+    }
+    const uint32_t channel_id = connection->AllocateChannelId();
+    avatar_sync::AvatarSyncMuxFrame frame;
+    frame.set_channel_id(channel_id);
+    *frame.mutable_open() = config;
+    if (!connection->Write(frame)) {
+        std::cerr << "❌ AvatarSyncMux: failed to open channel for FE_SID [" << config.frontend_session_id() << "]." << std::endl;
+        return nullptr;
+    }
+    return std::unique_ptr<Channel>(new Channel(std::move(connection), channel_id, config.frontend_session_id()));
+}
+
+} // namespace tts
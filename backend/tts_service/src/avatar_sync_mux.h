@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include <grpcpp/grpcpp.h>
+#include "avatar_sync.grpc.pb.h"
+#include "avatar_sync_client.h" // AvatarSyncTurnStream
+
+namespace tts {
+
+// 게이트웨이와의 다중화 AvatarSync 전송 (SyncAvatarMux).
+// 턴마다 새 RPC를 여는 대신 게이트웨이 주소마다 소수의 장기 양방향 스트림을 유지하고, 턴 하나를 채널 하나로 싣는다.
+// 게이트웨이가 보내는 크레딧만큼만 송신하므로 게이트웨이 송신이 밀리면 Send*가 대기하며 합성 속도가 자연히 늦춰진다.
+class AvatarSyncMux {
+public:
+    class Connection;
+
+    // 턴 하나의 송신 핸들. 한 스레드(해당 SynthesizeStream)에서만 사용
+    class Channel final : public AvatarSyncTurnStream {
+    public:
+        ~Channel() override; // Finish 없이 파괴되면 close 프레임 전송
+
+        Channel(const Channel&) = delete;
+        Channel& operator=(const Channel&) = delete;
+
+        bool SendAudioChunk(const std::vector<uint8_t>& audio_chunk) override;
+        bool SendVisemeDataBatch(const std::vector<avatar_sync::VisemeData>& visemes) override;
+        // close 프레임 전송. 게이트웨이가 채널을 거부했거나 연결이 끊겼으면 오류 상태
+        grpc::Status Finish() override;
+
+    private:
+        friend class AvatarSyncMux;
+        Channel(std::shared_ptr<Connection> connection, uint32_t channel_id, std::string frontend_session_id);
+        bool Send(avatar_sync::AvatarSyncMuxFrame& frame);
+
+        std::shared_ptr<Connection> connection_;
+        uint32_t channel_id_;
+        std::string frontend_session_id_;
+        bool finished_ = false;
+    };
+
+    // replica_routes: AvatarSyncClient와 같은 목록. 세션 ID 접두어로 소유 게이트웨이 선택 (AvatarSyncRoutes)
+    // connections_per_gateway: 주소마다 유지하는 스트림 수 (채널은 라운드로빈 배정)
+    AvatarSyncMux(const std::string& server_address, std::map<std::string, std::string> replica_routes = {},
+                  size_t connections_per_gateway = 2,
+                  std::chrono::milliseconds credit_wait_timeout = std::chrono::milliseconds(5000));
+    ~AvatarSyncMux();
+
+    AvatarSyncMux(const AvatarSyncMux&) = delete;
+    AvatarSyncMux& operator=(const AvatarSyncMux&) = delete;
+
+    // 채널을 열고 config(open 프레임)를 보냄. 연결 실패 시 nullptr
+    std::unique_ptr<Channel> OpenChannel(const avatar_sync::SyncConfig& config);
+
+    const std::string& ResolveAddress(const std::string& frontend_session_id) const { return routes_.Resolve(frontend_session_id); }
+
+private:
+    std::shared_ptr<Connection> AcquireConnection(const std::string& address);
+
+    AvatarSyncRoutes routes_;
+    size_t connections_per_gateway_;
+    std::chrono::milliseconds credit_wait_timeout_;
+
+    struct Pool {
+        std::shared_ptr<grpc::Channel> channel;
+        std::unique_ptr<avatar_sync::AvatarSyncService::Stub> stub;
+        std::vector<std::shared_ptr<Connection>> connections;
+        size_t next = 0;
+    };
+    std::map<std::string, Pool> pools_;
+    std::mutex pools_mutex_;
+};
+
+// 장기 양방향 스트림 하나. 쓰기는 여러 채널(SynthesizeStream 스레드)이 write_mutex_로 직렬화하고,
+// 전용 reader 스레드가 게이트웨이의 크레딧/채널 오류를 받는다.
+class AvatarSyncMux::Connection {
+public:
+    Connection(avatar_sync::AvatarSyncService::Stub* stub, std::string address, std::chrono::milliseconds credit_wait_timeout);
+    ~Connection(); // 스트림 종료 후 reader 스레드 join
+
+    bool broken() const { return broken_.load(); }
+    uint32_t AllocateChannelId();
+    // 크레딧을 기다린 뒤 전송 (close 프레임은 크레딧 없이 전송)
+    bool Write(const avatar_sync::AvatarSyncMuxFrame& frame);
+    bool IsRejected(uint32_t channel_id);
+    void ReleaseChannel(uint32_t channel_id);
+    const std::string& address() const { return address_; }
+
+private:
+    void ReadLoop();
+
+    std::string address_;
+    std::chrono::milliseconds credit_wait_timeout_;
+    grpc::ClientContext context_;
+    std::unique_ptr<grpc::ClientReaderWriter<avatar_sync::AvatarSyncMuxFrame, avatar_sync::AvatarSyncMuxControl>> stream_;
+    std::mutex write_mutex_;
+
+    std::mutex state_mutex_;
+    std::condition_variable credit_cv_;
+    int64_t credit_bytes_ = 0;                 // 게이트웨이가 허용한 남은 바이트 (state_mutex_)
+    std::unordered_set<uint32_t> rejected_;    // 게이트웨이가 거부한 채널 (state_mutex_)
+    std::atomic<uint32_t> next_channel_id_{1};
+    std::atomic<bool> broken_{false};
+    std::thread reader_;
+};
+
+} // namespace tts
@@ -73,6 +73,7 @@ bool AzureTTSEngine::InitializeSynthesis(const SynthesisConfig& config) {
         synthesizer_->SynthesisStarted.Connect([this](const SpeechSynthesisEventArgs& e) { this->HandleSynthesisStarted(e); });
         synthesizer_->Synthesizing.Connect([this](const SpeechSynthesisEventArgs& e) { this->HandleSynthesizing(e); });
         synthesizer_->SynthesisCompleted.Connect([this](const SpeechSynthesisEventArgs& e) { this->HandleSynthesisCompleted(e); });
+        synthesizer_->SynthesisCanceled.Connect([this](const SpeechSynthesisEventArgs& e) { this->HandleSynthesisCanceled(e); });
         synthesizer_->VisemeReceived.Connect([this](const SpeechSynthesisVisemeEventArgs& e) { this->HandleVisemeReceived(e); });
 
         synthesis_has_error_.store(false);
@@ -240,6 +241,33 @@ void AzureTTSEngine::HandleSynthesisCompleted(const SpeechSynthesisEventArgs& e)
     }
 }
 
+void AzureTTSEngine::HandleSynthesisCanceled(const SpeechSynthesisEventArgs& e) {
+    // StopSpeakingAsync() 또는 서비스 오류로 합성이 중단된 경우. 완료 콜백을 호출해야 대기 중인 청크가 풀린다.
+    SynthesisCompletionCallback completion_cb_local;
+    std::string error_msg_local = "Synthesis canceled.";
+
+    {
+        std::lock_guard<std::mutex> lock(engine_mutex_);
+        auto details = SpeechSynthesisCancellationDetails::FromResult(e.Result);
+        if (details && details->Reason == CancellationReason::Error) {
+            error_msg_local = "Synthesis canceled with error: " + details->ErrorDetails;
+        }
+        std::cout << "   AzureTTSEngine: " << error_msg_local << " Stream ID: " << e.Result->ResultId << std::endl;
+        completion_cb_local = completion_callback_;
+        synthesis_has_error_.store(true);
+        last_error_message_ = error_msg_local;
+        synthesis_active_.store(false);
+    }
+
+    if (completion_cb_local) {
+        try {
+            completion_cb_local(false, error_msg_local);
+        } catch (const std::exception& ex) {
+            std::cerr << "❌ Exception in completion_callback_ (Canceled): " << ex.what() << std::endl;
+        }
+    }
+}
+
 void AzureTTSEngine::HandleVisemeReceived(const SpeechSynthesisVisemeEventArgs& e) {
     // e.VisemeId, e.AudioOffset (100ns 단위), e.Animation (JSON 문자열)
     // VisemeId는 숫자형 문자열, Animation은 더 상세한 블렌드 쉐이프 정보 포함 가능
@@ -68,6 +68,7 @@ private:
     void HandleSynthesisStarted(const Microsoft::CognitiveServices::Speech::SpeechSynthesisEventArgs& e);
     void HandleSynthesizing(const Microsoft::CognitiveServices::Speech::SpeechSynthesisEventArgs& e);
     void HandleSynthesisCompleted(const Microsoft::CognitiveServices::Speech::SpeechSynthesisEventArgs& e);
+    void HandleSynthesisCanceled(const Microsoft::CognitiveServices::Speech::SpeechSynthesisEventArgs& e);
     void HandleVisemeReceived(const Microsoft::CognitiveServices::Speech::SpeechSynthesisVisemeEventArgs& e);
 
     // 타임스탬프 변환 헬퍼
@@ -5,6 +5,7 @@
 #include <cstdlib>
 #include <iostream>
 #include <string>
+#include <map>
 #include <memory>
 #include <stdexcept>
 #include <csignal>
@@ -34,6 +35,8 @@ int main() {
     const char* azure_region_env = std::getenv("AZURE_SPEECH_REGION");
     const char* avatar_sync_addr_env = std::getenv("AVATAR_SYNC_SERVICE_ADDRESS");
     const char* server_addr_env = std::getenv("TTS_SERVER_ADDRESS");
+    const char* avatar_sync_routes_env = std::getenv("AVATAR_SYNC_ROUTES"); // 다중 게이트웨이: "g0=gateway-0:50055,g1=gateway-1:50055"
+    const char* avatar_sync_mux_env = std::getenv("AVATAR_SYNC_MUX_CONNECTIONS"); // 0/미설정 = 턴마다 SyncAvatarStream
 
     if (!azure_key_env || std::string(azure_key_env).empty() ||
         !azure_region_env || std::string(azure_region_env).empty()) {
@@ -57,22 +60,51 @@ int main() {
     std::cout << "  AvatarSync Service Address: " << avatar_sync_service_address << std::endl;
     std::cout << "  TTS Service Listening Address: " << tts_server_address << std::endl;
 
+    std::map<std::string, std::string> avatar_sync_routes;
+    if (avatar_sync_routes_env && *avatar_sync_routes_env) {
+        std::string spec = avatar_sync_routes_env;
+        size_t start = 0;
+        while (start < spec.size()) {
+            size_t end = spec.find(',', start);
+            if (end == std::string::npos) end = spec.size();
+            const std::string entry = spec.substr(start, end - start);
+            const size_t eq = entry.find('=');
+            if (eq == std::string::npos || eq == 0 || eq + 1 == entry.size()) {
+                std::cerr << "❌ FATAL: Invalid AVATAR_SYNC_ROUTES entry '" << entry << "' (expected id=host:port). Exiting." << std::endl;
+                return 1;
+            }
+            avatar_sync_routes[entry.substr(0, eq)] = entry.substr(eq + 1);
+            start = end + 1;
+        }
+        std::cout << "  AvatarSync Gateway Routes: " << avatar_sync_routes.size() << " replica(s)" << std::endl;
+    }
+
+    const size_t avatar_sync_mux_connections = (avatar_sync_mux_env && *avatar_sync_mux_env) ? std::stoul(avatar_sync_mux_env) : 0;
+    std::cout << "  AvatarSync Transport: " << (avatar_sync_mux_connections > 0
+                  ? "multiplexed (" + std::to_string(avatar_sync_mux_connections) + " stream(s) per gateway)"
+                  : std::string("stream per turn")) << std::endl;
+
     std::shared_ptr<tts::AvatarSyncClient> avatar_s_client = nullptr;
+    std::shared_ptr<tts::AvatarSyncMux> avatar_sync_mux = nullptr;
     std::unique_ptr<tts::TTSServiceImpl> service_impl = nullptr;
     const std::string key_for_factory = azure_speech_key;
     const std::string region_for_factory = azure_speech_region;
 
     try {
         std::cout << "⏳ Initializing AvatarSync client..." << std::endl;
-        avatar_s_client = std::make_shared<tts::AvatarSyncClient>(avatar_sync_service_address);
+        avatar_s_client = std::make_shared<tts::AvatarSyncClient>(avatar_sync_service_address, avatar_sync_routes);
         std::cout << "✅ AvatarSync client initialized." << std::endl;
+        if (avatar_sync_mux_connections > 0) {
+            avatar_sync_mux = std::make_shared<tts::AvatarSyncMux>(avatar_sync_service_address, avatar_sync_routes,
+                                                                   avatar_sync_mux_connections);
+        }
 
         auto tts_engine_factory = [&key_for_factory, &region_for_factory]() -> std::unique_ptr<tts::AzureTTSEngine> {
             return std::make_unique<tts::AzureTTSEngine>(key_for_factory, region_for_factory);
         };
         std::cout << "✅ TTS Engine factory (AzureTTSEngine) configured." << std::endl;
 
-        service_impl = std::make_unique<tts::TTSServiceImpl>(avatar_s_client, tts_engine_factory);
+        service_impl = std::make_unique<tts::TTSServiceImpl>(avatar_s_client, tts_engine_factory, avatar_sync_mux);
         std::cout << "✅ TTS service implementation created." << std::endl;
         
         // gRPC Health Check 서비스 활성화
@@ -113,6 +145,7 @@ int main() {
 
     service_impl.reset();
     std::cout << "  TTS service implementation released." << std::endl;
+    avatar_sync_mux.reset();
     avatar_s_client.reset();
     std::cout << "  AvatarSync client released." << std::endl;
 
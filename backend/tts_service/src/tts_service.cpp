@@ -20,6 +20,20 @@ using grpc::StatusCode;
 
 namespace tts {
 
+namespace {
+
+// Raw16Khz16BitMonoPcm: 1ms = 16 샘플 * 2바이트
+constexpr uint64_t kPcmBytesPerMs = 32;
+
+// Azure viseme 오프셋은 Synthesize 호출마다 0부터 시작하므로, 턴 전체 오디오 기준 오프셋으로 옮김
+void ShiftTimestamp(google::protobuf::Timestamp* ts, uint64_t offset_ms) {
+    int64_t nanos = static_cast<int64_t>(ts->nanos()) + static_cast<int64_t>(offset_ms % 1000) * 1000000;
+    ts->set_seconds(ts->seconds() + static_cast<int64_t>(offset_ms / 1000) + nanos / 1000000000);
+    ts->set_nanos(static_cast<int32_t>(nanos % 1000000000));
+}
+
+} // namespace
+
 std::string TTSServiceImpl::generate_uuid() {
     std::random_device rd;
     std::mt19937_64 gen(rd());
@@ -33,8 +47,9 @@ std::string TTSServiceImpl::generate_uuid() {
 
 
 TTSServiceImpl::TTSServiceImpl(std::shared_ptr<AvatarSyncClient> avatar_sync_client,
-                                 std::function<std::unique_ptr<AzureTTSEngine>()> tts_engine_factory)
-  : avatar_sync_client_(avatar_sync_client), tts_engine_factory_(tts_engine_factory) {
+                                 std::function<std::unique_ptr<AzureTTSEngine>()> tts_engine_factory,
+                                 std::shared_ptr<AvatarSyncMux> avatar_sync_mux)
+  : avatar_sync_client_(avatar_sync_client), avatar_sync_mux_(std::move(avatar_sync_mux)), tts_engine_factory_(tts_engine_factory) {
     if (!avatar_sync_client_) {
         throw std::runtime_error("AvatarSyncClient cannot be null in TTSServiceImpl.");
     }
@@ -64,8 +79,14 @@ Status TTSServiceImpl::SynthesizeStream(
     SynthesisConfig active_synthesis_config; // 현재 활성화된 TTS 설정 (frontend_session_id 포함)
     bool tts_engine_initialized = false;
     bool avatar_sync_stream_started = false;
+    // 이 턴의 AvatarSync 송신 핸들 (다중화 채널 또는 턴 전용 RPC). 같은 세션의 다른 턴과 공유하지 않음
+    std::unique_ptr<AvatarSyncTurnStream> avatar_stream;
     std::atomic<bool> synthesis_error_occurred{false};
     std::string error_message_detail;
+    std::shared_ptr<common::TurnRegistry::Turn> turn; // 첫 config 수신 시 등록
+    // 게이트웨이가 오디오/viseme에 같은 재생 시각(PTS)을 매길 수 있도록 viseme 오프셋을 턴 기준으로 보정
+    std::atomic<uint64_t> turn_audio_bytes{0};    // 이 턴에서 지금까지 보낸 오디오
+    std::atomic<uint64_t> call_audio_offset_ms{0}; // 현재 Synthesize 호출의 첫 오디오가 턴 안에서 놓이는 위치
 
     std::promise<void> overall_synthesis_complete_promise;
     auto overall_synthesis_complete_future = overall_synthesis_complete_promise.get_future();
@@ -76,9 +97,17 @@ Status TTSServiceImpl::SynthesizeStream(
                    << ", FE_SID:" << (fe_session_id_ref.empty() ? "NO_FE_SID" : fe_session_id_ref)
                    << "] Cleaning up TTS resources..." << std::endl;
 
-         if (avatar_sync_stream_started && avatar_sync_client_ && avatar_sync_client_->IsStreamActive()) {
+         // 엔진을 먼저 멈춰 합성 콜백이 종료된 스트림에 쓰지 않도록 함
+         if (turn) turn->ClearCancelHook(); // 엔진 해제 전에 취소 훅 제거
+         if (tts_engine_initialized && tts_engine) {
+             std::cout << "   Stopping/Finalizing TTS engine for TTS_SID [" << tts_session_id_ref << "]..." << std::endl;
+             tts_engine->StopSynthesis();
+         }
+         tts_engine_initialized = false;
+         tts_engine.reset();
+         if (avatar_stream) {
              std::cout << "   Finishing AvatarSync stream for FE_SID [" << fe_session_id_ref << "]..." << std::endl;
-             Status avatar_finish_status = avatar_sync_client_->FinishStream(); // FinishStream은 내부적으로 세션 ID를 알고 있음
+             Status avatar_finish_status = avatar_stream->Finish();
              if (!avatar_finish_status.ok()) {
                  std::cerr << "   ⚠️ AvatarSync stream finish error during cleanup: ("
                            << avatar_finish_status.error_code() << ") "
@@ -86,15 +115,9 @@ Status TTSServiceImpl::SynthesizeStream(
              } else {
                  std::cout << "   AvatarSync stream finished successfully during cleanup for FE_SID [" << fe_session_id_ref << "]." << std::endl;
              }
+             avatar_stream.reset();
          }
          avatar_sync_stream_started = false;
-
-         if (tts_engine_initialized && tts_engine) {
-             std::cout << "   Stopping/Finalizing TTS engine for TTS_SID [" << tts_session_id_ref << "]..." << std::endl;
-             tts_engine->StopSynthesis();
-         }
-         tts_engine_initialized = false;
-         tts_engine.reset();
     };
 
     try {
@@ -103,13 +126,16 @@ Status TTSServiceImpl::SynthesizeStream(
 
         // Audio/Viseme 콜백: 로그에 tts_internal_session_id와 frontend_session_id를 모두 사용
         auto audio_viseme_cb =
-            [this, &synthesis_error_occurred, &error_message_detail, &tts_internal_session_id, &frontend_session_id]
+            [this, &synthesis_error_occurred, &error_message_detail, &tts_internal_session_id, &frontend_session_id, &turn,
+             &turn_audio_bytes, &call_audio_offset_ms, &avatar_stream]
             (const std::vector<uint8_t>& audio_chunk, const std::vector<avatar_sync::VisemeData>& visemes) {
-            if (synthesis_error_occurred.load()) return;
+            if (synthesis_error_occurred.load() || !avatar_stream) return;
+            if (turn && turn->cancelled.load()) return; // barge-in으로 취소된 턴의 잔여 프레임은 버림
 
             if (!audio_chunk.empty()) {
+                turn_audio_bytes += audio_chunk.size();
                 // std::cout << "  TTS_Service [TTS_SID:" << tts_internal_session_id << ", FE_SID:" << frontend_session_id << "] Sending audio chunk (" << audio_chunk.size() << " bytes) to AvatarSync." << std::endl;
-                if (!avatar_sync_client_->SendAudioChunk(audio_chunk)) { // AvatarSyncClient는 내부적으로 frontend_session_id를 알고 있음
+                if (!avatar_stream->SendAudioChunk(audio_chunk)) { // 다중화 채널이면 크레딧이 없을 때 여기서 대기
                     std::cerr << "  ❌ TTS_Service [TTS_SID:" << tts_internal_session_id << ", FE_SID:" << frontend_session_id << "] Failed to send audio chunk to AvatarSync." << std::endl;
                     if(!synthesis_error_occurred.load()) error_message_detail = "AvatarSync SendAudioChunk failed.";
                     synthesis_error_occurred.store(true);
@@ -117,7 +143,16 @@ Status TTSServiceImpl::SynthesizeStream(
             }
             if (!visemes.empty()) {
                 // std::cout << "  TTS_Service [TTS_SID:" << tts_internal_session_id << ", FE_SID:" << frontend_session_id << "] Sending " << visemes.size() << " visemes to AvatarSync." << std::endl;
-                if (!avatar_sync_client_->SendVisemeDataBatch(visemes)) {
+                const uint64_t offset_ms = call_audio_offset_ms.load();
+                std::vector<avatar_sync::VisemeData> turn_visemes;
+                if (offset_ms > 0) {
+                    turn_visemes = visemes;
+                    for (auto& viseme : turn_visemes) {
+                        ShiftTimestamp(viseme.mutable_start_time(), offset_ms);
+                    }
+                }
+                const auto& batch = offset_ms > 0 ? turn_visemes : visemes;
+                if (!avatar_stream->SendVisemeDataBatch(batch)) {
                      std::cerr << "  ❌ TTS_Service [TTS_SID:" << tts_internal_session_id << ", FE_SID:" << frontend_session_id << "] Failed to send viseme data to AvatarSync." << std::endl;
                      if(!synthesis_error_occurred.load()) error_message_detail = "AvatarSync SendVisemeDataBatch failed.";
                      synthesis_error_occurred.store(true);
@@ -126,6 +161,9 @@ Status TTSServiceImpl::SynthesizeStream(
         };
 
         while (reader->Read(&request)) {
+            if (turn && turn->cancelled.load()) {
+                break;
+            }
             if (context->IsCancelled()) {
                 error_message_detail = "Request cancelled by LLM client.";
                 std::cerr << "🚫 TTS_Service [TTS_SID:" << (tts_internal_session_id.empty() ? client_peer : tts_internal_session_id)
@@ -149,6 +187,7 @@ Status TTSServiceImpl::SynthesizeStream(
                          cleanup_resources(tts_internal_session_id, frontend_session_id);
                          return Status(StatusCode::INVALID_ARGUMENT, error_message_detail);
                      }
+                     turn = turn_registry_.Register(frontend_session_id, received_config.turn_id());
                  } else if (frontend_session_id != received_config.frontend_session_id()) {
                      // 스트림 중간에 frontend_session_id가 변경되는 것은 허용하지 않음
                      error_message_detail = "CRITICAL: frontend_session_id changed mid-stream. This is not supported.";
@@ -187,6 +226,7 @@ Status TTSServiceImpl::SynthesizeStream(
                            << "] Received SynthesisConfig: Lang=" << active_synthesis_config.language_code()
                            << ", Voice=" << active_synthesis_config.voice_name() << std::endl;
 
+                 if (turn) turn->ClearCancelHook(); // 엔진 교체 전 이전 엔진을 가리키는 훅 제거
                  tts_engine = tts_engine_factory_();
                  if (!tts_engine || !tts_engine->InitializeSynthesis(active_synthesis_config)) {
                      error_message_detail = "Failed to initialize TTS engine with provided config.";
@@ -195,14 +235,22 @@ Status TTSServiceImpl::SynthesizeStream(
                      break;
                  }
                  tts_engine_initialized = true;
+                 AzureTTSEngine* engine_raw = tts_engine.get();
+                 turn->SetCancelHook([engine_raw]() { engine_raw->StopSynthesis(); });
                  std::cout << "   TTS_Service [TTS_SID:" << tts_internal_session_id << "] TTS engine initialized." << std::endl;
 
                  if (first_message) { // AvatarSync 스트림은 첫 config 메시지 수신 시에만 시작
                      avatar_sync::SyncConfig avatar_config_to_send;
                      avatar_config_to_send.set_frontend_session_id(frontend_session_id); // ★ AvatarSync에는 frontend_session_id만 전달
+                     avatar_config_to_send.set_turn_id(received_config.turn_id());
 
                      std::cout << "   TTS_Service [TTS_SID:" << tts_internal_session_id << "] Starting stream to AvatarSync for FE_SID [" << frontend_session_id << "]..." << std::endl;
-                     if (!avatar_sync_client_->StartStream(avatar_config_to_send)) { // AvatarSyncClient::StartStream은 SyncConfig 객체를 받음
+                     if (avatar_sync_mux_) {
+                         avatar_stream = avatar_sync_mux_->OpenChannel(avatar_config_to_send);
+                     } else {
+                         avatar_stream = avatar_sync_client_->OpenStream(avatar_config_to_send); // 턴마다 별도 RPC (이전 턴과 겹쳐도 됨)
+                     }
+                     if (!avatar_stream) {
                          error_message_detail = "Failed to start stream to AvatarSync service.";
                          std::cerr << "❌ TTS_Service [TTS_SID:" << tts_internal_session_id << ", FE_SID:" << frontend_session_id << "] " << error_message_detail << std::endl;
                          synthesis_error_occurred.store(true);
@@ -257,6 +305,8 @@ Status TTSServiceImpl::SynthesizeStream(
                     }
                 };
 
+                // 이전 청크는 완료까지 기다렸으므로 지금까지의 오디오 길이가 이번 호출의 시작 위치
+                call_audio_offset_ms = turn_audio_bytes.load() / kPcmBytesPerMs;
                 std::cout << "  TTS_Service [TTS_SID:" << tts_internal_session_id << "] Calling TTS Engine Synthesize for current chunk..." << std::endl;
                 synthesize_call_ok = tts_engine->Synthesize(text, audio_viseme_cb, chunk_completion_cb);
 
@@ -334,6 +384,14 @@ Status TTSServiceImpl::SynthesizeStream(
 
     cleanup_resources(tts_internal_session_id, frontend_session_id);
 
+    if (turn && turn->cancelled.load()) {
+        // 취소는 정상 흐름 (StopSynthesis로 인한 청크 실패도 여기서 흡수)
+        std::cout << "✋ TTS_Service [TTS_SID:" << (tts_internal_session_id.empty() ? client_peer : tts_internal_session_id)
+                  << ", FE_SID:" << frontend_session_id << ", Turn:" << turn->turn_id
+                  << "] Synthesis stopped by barge-in (CancelTurn)." << std::endl;
+        return Status::OK;
+    }
+
     if (synthesis_error_occurred.load()) {
         std::cerr << "❌ TTS_Service [TTS_SID:" << (tts_internal_session_id.empty() ? client_peer : tts_internal_session_id)
                   << ", FE_SID:" << (frontend_session_id.empty() ? "N/A" : frontend_session_id)
@@ -350,4 +408,18 @@ Status TTSServiceImpl::SynthesizeStream(
     return Status::OK;
 }
 
+Status TTSServiceImpl::CancelTurn(
+    ServerContext* context,
+    const CancelTurnRequest* request,
+    Empty* response) {
+
+    if (request->frontend_session_id().empty()) {
+        return Status(StatusCode::INVALID_ARGUMENT, "frontend_session_id is required for CancelTurn.");
+    }
+    size_t cancelled = turn_registry_.CancelBefore(request->frontend_session_id(), request->before_turn_id());
+    std::cout << "✋ TTS_Service [FE_SID:" << request->frontend_session_id() << "] CancelTurn(before_turn_id="
+              << request->before_turn_id() << "): " << cancelled << " active turn(s) cancelled." << std::endl;
+    return Status::OK;
+}
+
 } // namespace tts
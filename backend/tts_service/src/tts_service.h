@@ -10,7 +10,9 @@
 #include <google/protobuf/empty.pb.h>
 
 #include "avatar_sync_client.h"
+#include "avatar_sync_mux.h"
 #include "azure_tts_engine.h"   // AzureTTSEngine 헤더 포함
+#include "turn_registry.h"
 
 namespace tts {
 
@@ -23,13 +25,16 @@ using google::protobuf::Empty;
 using ::tts::TTSService;
 using ::tts::TTSStreamRequest;
 using ::tts::SynthesisConfig;
+using ::tts::CancelTurnRequest;
 
 
 class TTSServiceImpl final : public TTSService::Service {
 public:
     // 생성자: AvatarSync 클라이언트와 TTS 엔진 팩토리(또는 인스턴스) 주입
+    // avatar_sync_mux가 있으면 턴마다 RPC를 여는 대신 다중화 스트림의 채널로 전송 (AvatarSyncClient는 사용하지 않음)
     explicit TTSServiceImpl(std::shared_ptr<AvatarSyncClient> avatar_sync_client,
-                              std::function<std::unique_ptr<AzureTTSEngine>()> tts_engine_factory);
+                              std::function<std::unique_ptr<AzureTTSEngine>()> tts_engine_factory,
+                              std::shared_ptr<AvatarSyncMux> avatar_sync_mux = nullptr);
     ~TTSServiceImpl();
 
     // Client Streaming RPC: LLM으로부터 텍스트 스트림을 받아 음성 합성 후 AvatarSync로 스트리밍
@@ -39,9 +44,18 @@ public:
         Empty* response
     ) override;
 
+    // Unary RPC: 게이트웨이의 barge-in 요청. 해당 세션의 이전 턴 합성을 중단한다.
+    Status CancelTurn(
+        ServerContext* context,
+        const CancelTurnRequest* request,
+        Empty* response
+    ) override;
+
 private:
     std::shared_ptr<AvatarSyncClient> avatar_sync_client_;
+    std::shared_ptr<AvatarSyncMux> avatar_sync_mux_;
     std::function<std::unique_ptr<AzureTTSEngine>()> tts_engine_factory_;
+    common::TurnRegistry turn_registry_;
 
     // 간단한 UUID 생성 함수 (내부 헬퍼)
     static std::string generate_uuid();
@@ -8,11 +8,17 @@
 #include <condition_variable> // For waiting on callbacks
 #include <thread>   // std::this_thread::sleep_for 사용을 위해
 #include <chrono>   // std::chrono::milliseconds 사용을 위해
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <grpcpp/grpcpp.h>
 
 // 헤더 파일 경로 주의 (CMake 설정에 따라 달라질 수 있음)
 #include "azure_tts_engine.h"     // 테스트 대상
 #include "avatar_sync_client.h" // AvatarSyncClient 생성자 등 테스트용
+#include "avatar_sync_mux.h"
 #include "tts.pb.h"             // SynthesisConfig 사용
+#include "turn_registry.h"      // barge-in 턴 취소
 
 // AzureTTSEngine 테스트를 위한 환경 변수 (실제 키/지역 필요, CI에서는 Mock 사용 권장)
 const char* azure_key_env_test = std::getenv("AZURE_SPEECH_KEY");
@@ -25,6 +31,108 @@ TEST(TTSInternalClientTest, AvatarSyncClientConstructor_InvalidAddress) {
     EXPECT_NO_THROW(tts::AvatarSyncClient("localhost:12345"));
 }
 
+// --- AvatarSyncClient Routing Test ---
+TEST(TTSInternalClientTest, AvatarSyncClientRoutesToOwningGateway) {
+    tts::AvatarSyncClient client("gateway-lb:50055", {{"g0", "gateway-0:50055"}, {"g1", "gateway-1:50055"}});
+    EXPECT_EQ(client.ResolveAddress("g1-0123abcd"), "gateway-1:50055");
+    EXPECT_EQ(client.ResolveAddress("g0-0123abcd"), "gateway-0:50055");
+    EXPECT_EQ(client.ResolveAddress("0123abcd"), "gateway-lb:50055");    // 접두어 없는 세션
+    EXPECT_EQ(client.ResolveAddress("g7-0123abcd"), "gateway-lb:50055"); // 모르는 레플리카 → 게이트웨이가 전달
+}
+
+// --- AvatarSyncRoutes Test ---
+TEST(TTSInternalClientTest, AvatarSyncRoutesResolveOwningGateway) {
+    const tts::AvatarSyncRoutes routes("gateway-lb:50055", {{"g0", "gateway-0:50055"}, {"g1", "gateway-1:50055"}});
+    EXPECT_EQ(routes.Resolve("g1-0123abcd"), "gateway-1:50055");
+    EXPECT_EQ(routes.Resolve("g1"), "gateway-lb:50055");             // 구분자 없음
+    EXPECT_EQ(routes.Resolve("-0123abcd"), "gateway-lb:50055");      // 빈 접두어
+    EXPECT_EQ(routes.Resolve("g0-1-0123abcd"), "gateway-0:50055");   // 첫 '-'까지만 레플리카 ID
+    EXPECT_EQ(routes.replica_count(), 2u);
+    EXPECT_EQ(tts::AvatarSyncRoutes("gateway-lb:50055").Resolve("g1-0123abcd"), "gateway-lb:50055");
+}
+
+// --- AvatarSyncClient Overlapping Turns Test ---
+namespace {
+// 턴 번호별로 받은 오디오 청크 수를 기록하는 AvatarSync 서버 (게이트웨이 대역)
+class RecordingAvatarSyncService final : public avatar_sync::AvatarSyncService::Service {
+public:
+    grpc::Status SyncAvatarStream(grpc::ServerContext*, grpc::ServerReader<avatar_sync::AvatarSyncStreamRequest>* reader,
+                                  google::protobuf::Empty*) override {
+        avatar_sync::AvatarSyncStreamRequest request;
+        uint64_t turn_id = 0;
+        while (reader->Read(&request)) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (request.has_config()) {
+                turn_id = request.config().turn_id();
+                open_turns++;
+                max_open_turns = std::max(max_open_turns, open_turns);
+            } else if (request.request_data_case() == avatar_sync::AvatarSyncStreamRequest::kAudioChunk) {
+                audio_chunks[turn_id]++;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        open_turns--;
+        return grpc::Status::OK;
+    }
+
+    std::mutex mutex;
+    std::map<uint64_t, int> audio_chunks;
+    int open_turns = 0;
+    int max_open_turns = 0;
+};
+} // namespace
+
+// 같은 세션의 이전 턴이 아직 전송 중일 때 다음 턴 스트림을 열어도 두 턴 모두 끝까지 전달되어야 함 (턴마다 별도 RPC)
+TEST(TTSInternalClientTest, AvatarSyncClientStreamsOverlappingTurnsOfOneSession) {
+    RecordingAvatarSyncService gateway;
+    int port = 0;
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+    builder.RegisterService(&gateway);
+    std::unique_ptr<grpc::Server> server = builder.BuildAndStart();
+    ASSERT_TRUE(server);
+
+    tts::AvatarSyncClient client("127.0.0.1:" + std::to_string(port));
+    avatar_sync::SyncConfig config;
+    config.set_frontend_session_id("0123abcd");
+    config.set_turn_id(1);
+    auto turn1 = client.OpenStream(config);
+    ASSERT_NE(turn1, nullptr);
+    config.set_turn_id(2);
+    auto turn2 = client.OpenStream(config); // 턴 1이 끝나기 전
+    ASSERT_NE(turn2, nullptr);
+
+    const std::vector<uint8_t> chunk(640, 0);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(turn1->SendAudioChunk(chunk));
+        EXPECT_TRUE(turn2->SendAudioChunk(chunk));
+    }
+    EXPECT_TRUE(turn2->SendAudioChunk(chunk));
+    EXPECT_TRUE(turn2->Finish().ok()); // 나중 턴이 먼저 끝나도 이전 턴 스트림은 유지
+    EXPECT_TRUE(turn1->SendAudioChunk(chunk));
+    EXPECT_TRUE(turn1->Finish().ok());
+    EXPECT_FALSE(turn1->Finish().ok()); // 두 번째 Finish는 오류
+
+    server->Shutdown();
+    std::lock_guard<std::mutex> lock(gateway.mutex);
+    EXPECT_EQ(gateway.max_open_turns, 2);
+    EXPECT_EQ(gateway.audio_chunks[1], 4);
+    EXPECT_EQ(gateway.audio_chunks[2], 4);
+}
+
+// --- AvatarSyncMux Test ---
+TEST(TTSInternalClientTest, AvatarSyncMuxWithoutGatewayCreditFailsOpen) {
+    // 게이트웨이가 크레딧을 주지 않으면 (연결 불가) 채널 열기가 대기 시간 후 실패해야 함
+    tts::AvatarSyncMux mux("127.0.0.1:1", {{"g1", "127.0.0.1:2"}}, 1, std::chrono::milliseconds(200));
+    EXPECT_EQ(mux.ResolveAddress("g1-0123abcd"), "127.0.0.1:2");
+    avatar_sync::SyncConfig config;
+    config.set_frontend_session_id("0123abcd");
+    EXPECT_EQ(mux.OpenChannel(config), nullptr);
+    config.set_frontend_session_id("");
+    EXPECT_EQ(mux.OpenChannel(config), nullptr);
+    EXPECT_THROW(tts::AvatarSyncMux("127.0.0.1:1", {}, 0), std::runtime_error);
+}
+
 
 // --- AzureTTSEngine Tests ---
 class AzureTTSEngineTest : public ::testing::Test {
@@ -163,6 +271,38 @@ TEST_F(AzureTTSEngineTest, Synthesize_EmptyText) {
     EXPECT_TRUE(success_status.load());
 }
 
+// --- TurnRegistry Tests ---
+// 이전 턴만 취소되고, 취소 훅(StopSynthesis 역할)이 한 번 호출되어야 함
+TEST(TurnRegistryTest, CancelBeforeInvokesHookForOlderTurnsOnly) {
+    common::TurnRegistry registry;
+    auto old_turn = registry.Register("fe1", 1);
+    auto new_turn = registry.Register("fe1", 2);
+    int old_hook_calls = 0;
+    int new_hook_calls = 0;
+    old_turn->SetCancelHook([&]() { old_hook_calls++; });
+    new_turn->SetCancelHook([&]() { new_hook_calls++; });
+
+    EXPECT_EQ(registry.CancelBefore("fe1", 2), 1u);
+    EXPECT_EQ(registry.CancelBefore("fe1", 2), 0u); // 중복 취소 요청은 무시
+    EXPECT_TRUE(old_turn->cancelled.load());
+    EXPECT_FALSE(new_turn->cancelled.load());
+    EXPECT_EQ(old_hook_calls, 1);
+    EXPECT_EQ(new_hook_calls, 0);
+}
+
+// 훅 해제 후에는 취소되어도 훅이 호출되지 않음 (엔진 해제 후 안전성)
+TEST(TurnRegistryTest, ClearedHookIsNotInvoked) {
+    common::TurnRegistry registry;
+    auto turn = registry.Register("fe1", 1);
+    bool hook_called = false;
+    turn->SetCancelHook([&]() { hook_called = true; });
+    turn->ClearCancelHook();
+
+    EXPECT_EQ(registry.CancelBefore("fe1", 0), 1u);
+    EXPECT_TRUE(turn->cancelled.load());
+    EXPECT_FALSE(hook_called);
+}
+
 
 // --- Main Function ---
 int main(int argc, char **argv) {
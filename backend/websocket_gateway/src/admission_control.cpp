@@ -0,0 +1,91 @@
+#include "admission_control.h"
+#include <algorithm>
+
+namespace websocket_gateway {
+
+AdmissionController::AdmissionController(const AdmissionConfig& config, CapacityHint capacity_hint)
+    : config_(config), capacity_hint_(std::move(capacity_hint)) {}
+
+bool AdmissionController::AdmitSession() {
+    if (config_.max_sessions != 0 && active_sessions_ >= config_.max_sessions) {
+        stats_.sessions_rejected++;
+        return false;
+    }
+    active_sessions_++;
+    return true;
+}
+
+void AdmissionController::ReleaseSession() {
+    if (active_sessions_ > 0) {
+        active_sessions_--;
+    }
+}
+
+bool AdmissionController::HasTurnCapacity() {
+    if (config_.max_active_turns != 0 && active_turns_ >= config_.max_active_turns) {
+        return false;
+    }
+    if (capacity_hint_ && capacity_hint_() == 0) {
+        stats_.downstream_blocked++;
+        return false;
+    }
+    return true;
+}
+
+AdmissionController::Decision AdmissionController::RequestTurn(uint32_t now_ms, Ticket* ticket) {
+    // 대기 중인 요청이 있으면 새 요청이 앞지르지 않음
+    if (queue_.empty() && HasTurnCapacity()) {
+        active_turns_++;
+        stats_.turns_admitted++;
+        return Decision::kAdmitted;
+    }
+    if (queue_.size() >= config_.queue_capacity) {
+        stats_.turns_rejected++;
+        return Decision::kRejected;
+    }
+    *ticket = next_ticket_++;
+    if (*ticket == 0) {
+        *ticket = next_ticket_++; // 32비트가 한 바퀴 돈 경우 0("대기 중 아님")은 건너뜀
+    }
+    queue_.push_back(Waiter{*ticket, now_ms});
+    stats_.turns_queued++;
+    return Decision::kQueued;
+}
+
+void AdmissionController::ReleaseTurn() {
+    if (active_turns_ > 0) {
+        active_turns_--;
+    }
+}
+
+bool AdmissionController::Cancel(Ticket ticket) {
+    auto it = std::find_if(queue_.begin(), queue_.end(), [ticket](const Waiter& w) { return w.ticket == ticket; });
+    if (it == queue_.end()) {
+        return false;
+    }
+    queue_.erase(it);
+    return true;
+}
+
+void AdmissionController::Poll(uint32_t now_ms, std::vector<Admission>& admitted, std::vector<Ticket>& expired) {
+    const auto timeout_ms = static_cast<uint32_t>(config_.queue_timeout.count());
+    while (!queue_.empty()) {
+        const Waiter& front = queue_.front();
+        const uint32_t waited_ms = now_ms - std::min(now_ms, front.enqueued_ms);
+        if (waited_ms >= timeout_ms) {
+            stats_.turns_expired++;
+            expired.push_back(front.ticket);
+            queue_.pop_front();
+            continue;
+        }
+        if (!HasTurnCapacity()) {
+            break; // 뒤쪽 대기는 front보다 늦게 들어왔으므로 아직 만료 전
+        }
+        active_turns_++;
+        stats_.turns_admitted++;
+        admitted.push_back(Admission{front.ticket, waited_ms});
+        queue_.pop_front();
+    }
+}
+
+} // namespace websocket_gateway
@@ -0,0 +1,100 @@
+#ifndef ADMISSION_CONTROL_H
+#define ADMISSION_CONTROL_H
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace websocket_gateway {
+
+// 게이트웨이 입장 제어 설정. 상한 0은 해당 제한 비활성화 (기본값은 모두 무제한 = 기존 동작).
+struct AdmissionConfig {
+    uint32_t max_sessions = 0;                     // 동시 WebSocket 세션 상한. 초과 연결은 busy 후 1013으로 종료
+    uint32_t max_active_turns = 0;                 // 동시 진행 턴 상한 (start_stream ~ 첫 응답 프레임)
+    uint32_t queue_capacity = 32;                  // 턴 슬롯 대기열 길이. 가득 차면 즉시 busy
+    std::chrono::milliseconds queue_timeout{2000}; // 대기열에서 이 시간 안에 슬롯을 못 받으면 busy
+    std::chrono::milliseconds retry_after{3000};   // busy 응답의 retryAfterMs 기본값
+    // 디버그 타임라인 슬롯 = max_sessions + 이 값 (최근 종료 세션 보존분). max_sessions=0이면 kDefaultTimelineSessions
+    uint32_t timeline_retained_sessions = 256;
+    static constexpr uint32_t kDefaultTimelineSessions = 1024;
+
+    // 살아 있는 세션이 모두 타임라인을 갖도록 잡은 슬롯 수 (슬롯당 약 1.1KB를 생성 시 할당)
+    size_t timeline_sessions() const {
+        return max_sessions == 0 ? kDefaultTimelineSessions : size_t{max_sessions} + timeline_retained_sessions;
+    }
+};
+
+// 세션/턴 입장 제어기. 로컬 카운터와 (선택) 하위 서비스 여유 힌트로 결정하며,
+// 턴 슬롯이 없으면 짧은 FIFO 대기열에 넣고 기한이 지나면 거절한다.
+// uWS 루프 스레드 전용 (스레드 안전하지 않음). 시각은 서버 타임라인 ms.
+class AdmissionController {
+public:
+    using Ticket = uint32_t; // 0은 "대기 중 아님". PerSocketData에 들어가므로 32비트 (대기 시간 안에 한 바퀴 돌 수 없음)
+    // 하위 서비스(STT/LLM/TTS 경로)가 추가로 받을 수 있는 턴 수. 음수 = 알 수 없음 (로컬 카운터만 사용)
+    using CapacityHint = std::function<int64_t()>;
+
+    enum class Decision { kAdmitted, kQueued, kRejected };
+
+    struct Admission {
+        Ticket ticket;
+        uint32_t waited_ms;
+    };
+
+    struct Stats {
+        uint64_t sessions_rejected = 0;
+        uint64_t turns_admitted = 0;        // 즉시 + 대기 후 입장
+        uint64_t turns_queued = 0;
+        uint64_t turns_rejected = 0;        // 대기열 가득 참
+        uint64_t turns_expired = 0;         // 대기 기한 초과
+        uint64_t downstream_blocked = 0;    // 로컬 여유는 있었지만 힌트가 0이라 입장 못 함
+    };
+
+    explicit AdmissionController(const AdmissionConfig& config = AdmissionConfig{}, CapacityHint capacity_hint = nullptr);
+
+    AdmissionController(const AdmissionController&) = delete;
+    AdmissionController& operator=(const AdmissionController&) = delete;
+
+    // 세션 입장. true면 종료 시 ReleaseSession 필수
+    bool AdmitSession();
+    void ReleaseSession();
+
+    // 턴 슬롯 요청. kAdmitted면 슬롯 보유 (ReleaseTurn 필수), kQueued면 *ticket으로 Poll 결과를 기다림
+    Decision RequestTurn(uint32_t now_ms, Ticket* ticket);
+    void ReleaseTurn();
+    // 대기 중인 티켓 취소 (세션 종료, stop_stream). 이미 입장/만료된 티켓이면 false
+    bool Cancel(Ticket ticket);
+
+    // 비어 있는 슬롯을 대기열 앞에서부터 배정하고, 기한이 지난 대기를 거절.
+    // admitted의 티켓은 슬롯을 보유한 상태이며 호출 측이 턴을 시작해야 함
+    void Poll(uint32_t now_ms, std::vector<Admission>& admitted, std::vector<Ticket>& expired);
+
+    uint32_t RetryAfterMs() const { return static_cast<uint32_t>(config_.retry_after.count()); }
+
+    const AdmissionConfig& config() const { return config_; }
+    const Stats& stats() const { return stats_; }
+    uint32_t active_sessions() const { return active_sessions_; }
+    uint32_t active_turns() const { return active_turns_; }
+    size_t queue_depth() const { return queue_.size(); }
+
+private:
+    bool HasTurnCapacity();
+
+    struct Waiter {
+        Ticket ticket;
+        uint32_t enqueued_ms;
+    };
+
+    AdmissionConfig config_;
+    CapacityHint capacity_hint_;
+    uint32_t active_sessions_ = 0;
+    uint32_t active_turns_ = 0;
+    std::deque<Waiter> queue_; // 모든 대기의 기한이 같으므로 앞쪽이 항상 먼저 만료됨
+    Ticket next_ticket_ = 1;
+    Stats stats_;
+};
+
+} // namespace websocket_gateway
+
+#endif // ADMISSION_CONTROL_H
@@ -1,7 +1,11 @@
 // src/avatar_sync_service_impl.cpp
 #include "avatar_sync_service_impl.h" // 해당 클래스의 헤더 파일을 가장 먼저 포함하는 것이 일반적입니다.
 
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <iostream>
+#include <unordered_map>
 #include "google/protobuf/empty.pb.h" // google::protobuf::Empty 사용
 #include <nlohmann/json.hpp>          // JSON 처리 (필요시)
 
@@ -12,96 +16,661 @@
 
 namespace websocket_gateway { 
 
-AvatarSyncServiceImpl::AvatarSyncServiceImpl(WebSocketFinder finder)
-    : find_websocket_by_session_id_(std::move(finder)) {
+AvatarSyncServiceImpl::AvatarSyncServiceImpl(WebSocketFinder finder, FrameDeliverer deliverer,
+                                             std::shared_ptr<TrafficTap> traffic_tap,
+                                             std::shared_ptr<SessionDirectory> session_directory,
+                                             BacklogProbe backlog_probe)
+    : find_websocket_by_session_id_(std::move(finder)), deliver_frame_(std::move(deliverer)),
+      traffic_tap_(std::move(traffic_tap)), session_directory_(std::move(session_directory)),
+      backlog_probe_(std::move(backlog_probe)) {
     if (!find_websocket_by_session_id_) { // 콜백 유효성 검사
         throw std::runtime_error("WebSocketFinder callback cannot be null in AvatarSyncServiceImpl constructor.");
     }
+    if (!deliver_frame_) {
+        throw std::runtime_error("FrameDeliverer callback cannot be null in AvatarSyncServiceImpl constructor.");
+    }
     std::cout << "AvatarSyncServiceImpl initialized." << std::endl;
 }
 
-grpc::Status AvatarSyncServiceImpl::SyncAvatarStream(
-    grpc::ServerContext* context,
-    grpc::ServerReader<avatar_sync::AvatarSyncStreamRequest>* reader,
+AvatarSyncServiceImpl::~AvatarSyncServiceImpl() {
+    {
+        std::lock_guard<std::mutex> lock(stalled_mutex_);
+        stopping_ = true;
+        stalled_.clear();
+    }
+    stalled_cv_.notify_all();
+    if (credit_pump_.joinable()) {
+        credit_pump_.join();
+    }
+}
+
+// 소유 레플리카로의 중계: 서버 쪽 읽기 하나 → 피어 쓰기 하나를 번갈아 수행하므로 한 번에 하나의 요청만 들고 있다.
+// hold로 피어 호출이 끝나는 시점을 서버 쪽 스트림 종료 이후로 고정해, 쓰기를 시작하는 동안 OnDone이 끼어들지 않는다.
+class AvatarSyncServiceImpl::PeerWriter final : public grpc::ClientWriteReactor<avatar_sync::AvatarSyncStreamRequest> {
+public:
+    PeerWriter(StreamReactor* stream, std::string owner_address) : stream_(stream), owner_address_(std::move(owner_address)) {
+        context_.AddMetadata(kForwardedMetadataKey, "1");
+    }
+
+    void Start(avatar_sync::AvatarSyncService::Stub* stub, avatar_sync::AvatarSyncStreamRequest& config_request);
+    // 서버 쪽에서 받은 다음 요청 전송 (이전 쓰기 완료 후에만 호출됨)
+    void Relay(avatar_sync::AvatarSyncStreamRequest& request) {
+        outgoing_.Swap(&request);
+        StartWrite(&outgoing_);
+    }
+    // 서버 쪽 스트림 종료: 정상 종료면 WritesDone, 취소면 피어 호출도 취소
+    void Close(bool cancelled) {
+        if (cancelled) {
+            context_.TryCancel();
+        } else {
+            StartWritesDone();
+        }
+        RemoveHold();
+    }
+    void Cancel() { context_.TryCancel(); }
+    const std::string& owner_address() const { return owner_address_; }
+
+    void OnWriteDone(bool ok) override;
+    void OnDone(const grpc::Status& status) override;
+
+private:
+    StreamReactor* stream_;
+    std::string owner_address_;
+    grpc::ClientContext context_;
+    google::protobuf::Empty response_;
+    avatar_sync::AvatarSyncStreamRequest outgoing_;
+};
+
+// TTS 턴 하나의 스트림. 읽기 완료마다 ProcessRequest로 프레임을 전달 큐에 넣고 다음 읽기를 건다.
+// 서버 리액터와 (중계 시) 피어 리액터가 모두 끝나야 삭제된다.
+class AvatarSyncServiceImpl::StreamReactor final : public grpc::ServerReadReactor<avatar_sync::AvatarSyncStreamRequest> {
+public:
+    StreamReactor(AvatarSyncServiceImpl* service, grpc::CallbackServerContext* context)
+        : service_(service), context_(context),
+          already_forwarded_(context->client_metadata().count(kForwardedMetadataKey) > 0) {
+        service_->streams_active_++;
+        std::cout << "AvatarSyncServiceImpl: incoming gRPC stream from TTS service (peer: " << context_->peer() << ")" << std::endl;
+        StartRead(&request_);
+    }
+
+    void OnReadDone(bool ok) override {
+        if (peer_) {
+            if (ok) {
+                peer_->Relay(request_);
+            } else {
+                peer_->Close(context_->IsCancelled());
+            }
+            return;
+        }
+        if (!ok) {
+            if (context_->IsCancelled()) {
+                std::cout << "AvatarSyncService: [" << session_label() << "] Client (TTS service) cancelled the gRPC stream." << std::endl;
+                Finish(grpc::Status(grpc::StatusCode::CANCELLED, "Client (TTS service) cancelled gRPC stream"));
+            } else {
+                std::cout << "AvatarSyncService: [" << session_label() << "] gRPC stream closed by client (TTS service)." << std::endl;
+                Finish(grpc::Status::OK);
+            }
+            return;
+        }
+
+        if (!already_forwarded_ && request_.request_data_case() == avatar_sync::AvatarSyncStreamRequest::kConfig) {
+            // 이 레플리카에 소켓이 없는 세션: 디렉터리가 아는 소유 레플리카로 스트림 전체를 중계
+            const std::string owner = service_->RemoteOwner(request_.config().frontend_session_id());
+            if (!owner.empty()) {
+                std::cout << "AvatarSyncService: [" << request_.config().frontend_session_id() << "] ↪️ Session owned by "
+                          << owner << ", forwarding stream." << std::endl;
+                state_.frontend_session_id = request_.config().frontend_session_id();
+                refs_.fetch_add(1);
+                peer_ = std::make_unique<PeerWriter>(this, owner);
+                peer_->Start(service_->peer_stub(owner).get(), request_);
+                return; // 다음 읽기는 피어 쓰기 완료 후
+            }
+        }
+
+        grpc::Status status = service_->ProcessRequest(state_, request_);
+        if (!status.ok()) {
+            Finish(status);
+            return;
+        }
+        StartRead(&request_);
+    }
+
+    void OnCancel() override {
+        if (peer_) {
+            peer_->Cancel(); // 대기 중인 피어 쓰기를 실패시켜 종료 경로로 진입
+        }
+    }
+
+    void OnDone() override {
+        service_->streams_active_--;
+        Unref();
+    }
+
+    // 피어 쓰기 결과: 성공하면 서버 쪽 다음 요청을 읽음
+    void OnPeerWriteDone(bool ok) {
+        if (ok) {
+            StartRead(&request_);
+        }
+        // 실패 시 피어 호출은 hold 해제 후 오류 상태로 끝나고 OnPeerDone에서 서버 스트림을 닫음
+    }
+
+    void OnPeerDone(const grpc::Status& status) {
+        const std::string& owner = peer_->owner_address();
+        if (context_->IsCancelled()) {
+            Finish(grpc::Status(grpc::StatusCode::CANCELLED, "Client (TTS service) cancelled gRPC stream"));
+        } else if (!status.ok()) {
+            std::cerr << "AvatarSyncService: [" << session_label() << "] ❌ Forwarding to " << owner << " failed: ("
+                      << status.error_code() << ") " << status.error_message() << std::endl;
+            Finish(grpc::Status(grpc::StatusCode::UNAVAILABLE, "Owning gateway " + owner + " unavailable: " + status.error_message()));
+        } else {
+            std::cout << "AvatarSyncService: [" << session_label() << "] Forwarded stream to " << owner << " completed." << std::endl;
+            Finish(grpc::Status::OK);
+        }
+        Unref();
+    }
+
+private:
+    void Unref() {
+        if (refs_.fetch_sub(1) == 1) {
+            delete this;
+        }
+    }
+    std::string session_label() const {
+        return state_.frontend_session_id.empty() ? "UNKNOWN_SESSION" : state_.frontend_session_id;
+    }
+
+    AvatarSyncServiceImpl* service_;
+    grpc::CallbackServerContext* context_;
+    const bool already_forwarded_;
+    StreamState state_;
+    avatar_sync::AvatarSyncStreamRequest request_;
+    std::unique_ptr<PeerWriter> peer_;
+    std::atomic<int> refs_{1}; // 서버 리액터 + 피어 리액터
+};
+
+void AvatarSyncServiceImpl::PeerWriter::Start(avatar_sync::AvatarSyncService::Stub* stub,
+                                              avatar_sync::AvatarSyncStreamRequest& config_request) {
+    stub->async()->SyncAvatarStream(&context_, &response_, this);
+    outgoing_.Swap(&config_request);
+    AddHold();
+    StartWrite(&outgoing_);
+    StartCall();
+}
+
+void AvatarSyncServiceImpl::PeerWriter::OnWriteDone(bool ok) {
+    if (!ok) {
+        RemoveHold(); // 피어 스트림이 끊김: 더 쓰지 않고 호출을 끝냄
+    }
+    stream_->OnPeerWriteDone(ok);
+}
+
+void AvatarSyncServiceImpl::PeerWriter::OnDone(const grpc::Status& status) {
+    stream_->OnPeerDone(status); // 마지막 참조라면 이 객체도 함께 삭제됨
+}
+
+grpc::ServerReadReactor<avatar_sync::AvatarSyncStreamRequest>* AvatarSyncServiceImpl::SyncAvatarStream(
+    grpc::CallbackServerContext* context,
     google::protobuf::Empty* /*response*/)
 {
-    avatar_sync::AvatarSyncStreamRequest request;
-    std::string current_frontend_session_id; 
-    // ConsistentWebSocketConnection 타입은 헤더에서 using으로 정의됨
-    ConsistentWebSocketConnection* ws = nullptr; 
-
-    std::cout << "AvatarSyncServiceImpl: incoming gRPC stream from TTS service (peer: " << context->peer() << ")" << std::endl;
-
-    while (reader->Read(&request)) {
-        if (context->IsCancelled()) {
-            std::cout << "AvatarSyncService: [" << (current_frontend_session_id.empty() ? "UNKNOWN_SESSION" : current_frontend_session_id) 
-                      << "] Client (TTS service) cancelled the gRPC stream." << std::endl;
-            return grpc::Status(grpc::StatusCode::CANCELLED, "Client (TTS service) cancelled gRPC stream");
-        }
-
-        switch (request.request_data_case()) {
-            case avatar_sync::AvatarSyncStreamRequest::kConfig: {
-                // proto에서 SyncConfig의 필드명이 frontend_session_id라고 가정
-                current_frontend_session_id = request.config().frontend_session_id(); 
-                if (current_frontend_session_id.empty()) {
-                    std::cerr << "AvatarSyncService: Received SyncConfig with empty frontend_session_id from TTS service." << std::endl;
-                    // 이 경우 오류로 처리하고 스트림을 종료할 수 있습니다.
-                    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "SyncConfig must contain a valid frontend_session_id.");
+    return new StreamReactor(this, context);
+}
+
+// 다중화 채널 하나의 소유 레플리카 중계 (SyncAvatarStream 하나, StreamReactor의 중계와 같은 전달 표시).
+// 다중화 읽기 경로는 블록할 수 없으므로 PeerWriter와 달리 요청을 큐에 쌓고 하나씩 쓴다. 쌓인 바이트는
+// mux_forward_backlog_에 더해져 백로그가 높으면 TTS 쪽 크레딧 반환이 미뤄진다 (소켓 송신 대기와 같은 흐름 제어).
+// 다중화 연결보다 오래 살 수 있으므로 스스로를 붙잡고 있다가 OnDone에서 놓는다.
+class AvatarSyncServiceImpl::MuxForwarder final : public grpc::ClientWriteReactor<avatar_sync::AvatarSyncStreamRequest> {
+public:
+    static std::shared_ptr<MuxForwarder> Start(std::shared_ptr<avatar_sync::AvatarSyncService::Stub> stub, std::string owner_address,
+                                               std::shared_ptr<std::atomic<uint64_t>> backlog,
+                                               avatar_sync::AvatarSyncStreamRequest config_request) {
+        std::shared_ptr<MuxForwarder> forwarder(new MuxForwarder(std::move(stub), std::move(owner_address), std::move(backlog)));
+        forwarder->self_ = forwarder;
+        forwarder->context_.AddMetadata(kForwardedMetadataKey, "1");
+        forwarder->stub_->async()->SyncAvatarStream(&forwarder->context_, &forwarder->response_, forwarder.get());
+        forwarder->AddHold();
+        forwarder->Relay(std::move(config_request));
+        forwarder->StartCall();
+        return forwarder;
+    }
+
+    // 다중화 읽기 경로: 요청을 큐에 넣음 (피어가 끊겼거나 닫은 뒤면 버림)
+    void Relay(avatar_sync::AvatarSyncStreamRequest request) {
+        const uint64_t size = request.ByteSizeLong();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (writes_done_) {
+            return;
+        }
+        backlog_->fetch_add(size);
+        queue_.push_back(std::move(request));
+        if (!writing_) {
+            StartNextWriteLocked();
+        }
+    }
+
+    // close 프레임: 큐를 다 보낸 뒤 WritesDone
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closing_ = true;
+            if (writes_done_ || writing_) {
+                return; // 진행 중인 쓰기가 끝나면 OnWriteDone이 마무리
+            }
+            writes_done_ = true;
+        }
+        StartWritesDone();
+        RemoveHold();
+    }
+
+    // 다중화 연결이 채널을 닫지 않고 끊김: 피어 호출도 취소
+    void Cancel() { context_.TryCancel(); }
+
+    void OnWriteDone(bool ok) override {
+        bool finish_now = false;
+        bool abandon = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            writing_ = false;
+            backlog_->fetch_sub(outgoing_size_);
+            if (!ok) {
+                for (const auto& request : queue_) {
+                    backlog_->fetch_sub(request.ByteSizeLong());
                 }
-                std::cout << "AvatarSyncService: [" << current_frontend_session_id << "] Received SyncConfig. Attempting to find WebSocket connection." << std::endl;
-                ws = find_websocket_by_session_id_(current_frontend_session_id); 
-                if (!ws) {
-                    std::cerr << "AvatarSyncService: [" << current_frontend_session_id << "] ❌ WebSocket connection NOT FOUND for frontend_session_id." << std::endl;
-                    // TTS 서비스에게 웹소켓을 찾을 수 없음을 알리고 스트림을 종료하는 것이 좋습니다.
-                    // return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, "WebSocket session not found for ID: " + current_frontend_session_id);
-                } else {
-                    std::cout << "AvatarSyncService: [" << current_frontend_session_id << "] ✅ WebSocket connection FOUND." << std::endl;
+                queue_.clear();
+                writes_done_ = true;
+                abandon = true;
+            } else if (!queue_.empty()) {
+                StartNextWriteLocked();
+            } else if (closing_) {
+                writes_done_ = true;
+                finish_now = true;
+            }
+        }
+        // hold 해제는 잠금 밖에서 (OnDone이 바로 불려 이 객체를 놓을 수 있음)
+        if (finish_now) {
+            StartWritesDone();
+        }
+        if (finish_now || abandon) {
+            RemoveHold();
+        }
+    }
+
+    void OnDone(const grpc::Status& status) override {
+        if (!status.ok()) {
+            std::cerr << "AvatarSyncService: ❌ Forwarding multiplexed channel to " << owner_address_ << " failed: ("
+                      << status.error_code() << ") " << status.error_message() << std::endl;
+        }
+        std::shared_ptr<MuxForwarder> self = std::move(self_); // 함수가 끝나면 삭제
+    }
+
+private:
+    MuxForwarder(std::shared_ptr<avatar_sync::AvatarSyncService::Stub> stub, std::string owner_address,
+                 std::shared_ptr<std::atomic<uint64_t>> backlog)
+        : stub_(std::move(stub)), owner_address_(std::move(owner_address)), backlog_(std::move(backlog)) {}
+
+    void StartNextWriteLocked() {
+        outgoing_ = std::move(queue_.front());
+        queue_.pop_front();
+        outgoing_size_ = outgoing_.ByteSizeLong();
+        writing_ = true;
+        StartWrite(&outgoing_);
+    }
+
+    std::shared_ptr<avatar_sync::AvatarSyncService::Stub> stub_;
+    const std::string owner_address_;
+    std::shared_ptr<std::atomic<uint64_t>> backlog_;
+    std::shared_ptr<MuxForwarder> self_; // 시작부터 OnDone까지
+    grpc::ClientContext context_;
+    google::protobuf::Empty response_;
+
+    std::mutex mutex_;
+    std::deque<avatar_sync::AvatarSyncStreamRequest> queue_;
+    avatar_sync::AvatarSyncStreamRequest outgoing_;
+    uint64_t outgoing_size_ = 0;
+    bool writing_ = false;
+    bool closing_ = false;
+    bool writes_done_ = false; // WritesDone을 보냈거나 피어가 끊김: 더 쓰지 않음
+};
+
+// 다중화 연결 하나. 읽기는 항상 하나를 걸어 두고, 크레딧/채널 오류 쓰기는 큐에 모아 하나씩 보낸다.
+// 백로그가 높으면 크레딧을 보류하고 서비스의 크레딧 스레드가 나중에 ReleaseCredit을 부른다.
+class AvatarSyncServiceImpl::MuxReactor final
+    : public grpc::ServerBidiReactor<avatar_sync::AvatarSyncMuxFrame, avatar_sync::AvatarSyncMuxControl> {
+public:
+    MuxReactor(AvatarSyncServiceImpl* service, grpc::CallbackServerContext* context) : service_(service), context_(context) {
+        std::cout << "AvatarSyncService: 🔀 multiplexed stream opened (peer: " << context_->peer() << ")" << std::endl;
+        service_->mux_connections_active_++;
+        avatar_sync::AvatarSyncMuxControl control;
+        control.set_channel_id(0);
+        control.set_credit_bytes(kMuxInitialCreditBytes);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            EnqueueLocked(std::move(control));
+        }
+        StartRead(&frame_);
+    }
+
+    void OnReadDone(bool ok) override {
+        if (!ok) {
+            // TTS가 close 없이 떠난 중계 채널은 피어 호출도 취소 (턴이 중간에 끊긴 것)
+            for (auto& [channel_id, forwarder] : forwarded_) {
+                forwarder->Cancel();
+            }
+            forwarded_.clear();
+            std::lock_guard<std::mutex> lock(mutex_);
+            reads_done_ = true;
+            MaybeFinishLocked();
+            return;
+        }
+        // open/데이터/close 모든 프레임을 직렬화 크기로 셈 (TTS 쪽 Connection::Write가 차감하는 기준과 같음)
+        consumed_ += frame_.ByteSizeLong();
+        HandleFrame();
+
+        if (consumed_ >= kMuxCreditBatchBytes) {
+            if (service_->backlog_high()) {
+                // 송신 대기 프레임이 쌓여 있으면 크레딧을 돌려주지 않음 → TTS 쪽 Send가 크레딧을 기다리며 느려짐
+                if (service_->StallCredit(this)) {
+                    service_->mux_credit_stalls_++;
                 }
-                break;
+            } else {
+                ReleaseCredit();
             }
-            case avatar_sync::AvatarSyncStreamRequest::kAudioChunk: {
-                if (ws) { 
-                    const auto& audio_bytes_str = request.audio_chunk(); // bytes 필드는 std::string으로 매핑됨
-                    // 상세 로깅은 필요시에만 활성화 (성능 영향 가능성)
-                    // std::cout << "AvatarSyncService: [" << current_frontend_session_id << "] Received Audio Chunk from TTS. Size: " << audio_bytes_str.size() << ". Sending to WebSocket." << std::endl;
-                    ws->send(std::string_view(audio_bytes_str.data(), audio_bytes_str.size()), uWS::OpCode::BINARY);
-                } else {
-                    std::cerr << "AvatarSyncService: [" << current_frontend_session_id << "] ❌ Received audio chunk, but WebSocket is NULL (either not found or config not received yet)." << std::endl;
+        }
+        StartRead(&frame_);
+    }
+
+    void OnWriteDone(bool ok) override {
+        std::lock_guard<std::mutex> lock(mutex_);
+        writing_ = false;
+        if (!ok) {
+            writes_.clear(); // 피어가 떠남: 남은 제어 메시지는 의미 없음
+            peer_open_ = false;
+        } else if (!writes_.empty()) {
+            StartNextWriteLocked();
+            return;
+        }
+        MaybeFinishLocked();
+    }
+
+    void OnDone() override {
+        service_->ForgetStalled(this);
+        service_->mux_connections_active_--;
+        std::cout << "AvatarSyncService: 🔀 multiplexed stream closed (" << channels_.size() << " channel(s) still open)" << std::endl;
+        delete this;
+    }
+
+    // 읽기 스레드 또는 크레딧 스레드에서 호출. 보류된 만큼을 한 번에 돌려줌
+    void ReleaseCredit() {
+        const uint64_t credit = consumed_.exchange(0);
+        if (credit == 0) {
+            return;
+        }
+        avatar_sync::AvatarSyncMuxControl control;
+        control.set_channel_id(0);
+        control.set_credit_bytes(static_cast<uint32_t>(credit));
+        std::lock_guard<std::mutex> lock(mutex_);
+        EnqueueLocked(std::move(control));
+    }
+
+private:
+    void HandleFrame() {
+        const uint32_t channel_id = frame_.channel_id();
+        switch (frame_.frame_data_case()) {
+            case avatar_sync::AvatarSyncMuxFrame::kOpen: {
+                request_.mutable_config()->Swap(frame_.mutable_open());
+                const std::string owner = service_->RemoteOwner(request_.config().frontend_session_id());
+                if (!owner.empty()) {
+                    // 이 레플리카에 소켓이 없는 세션: SyncAvatarStream과 같이 소유 레플리카로 채널 전체를 중계
+                    std::cout << "AvatarSyncService: [" << request_.config().frontend_session_id() << "] ↪️ Session owned by "
+                              << owner << ", forwarding multiplexed channel " << channel_id << "." << std::endl;
+                    avatar_sync::AvatarSyncStreamRequest config_request;
+                    config_request.Swap(&request_);
+                    forwarded_[channel_id] = MuxForwarder::Start(service_->peer_stub(owner), owner, service_->mux_forward_backlog_,
+                                                                 std::move(config_request));
+                    service_->mux_channels_forwarded_++;
+                    break;
+                }
+                StreamState& state = channels_[channel_id];
+                if (!service_->ProcessRequest(state, request_).ok()) {
+                    channels_.erase(channel_id);
+                    Reject(channel_id, "invalid SyncConfig");
+                } else if (!state.session_found) {
+                    channels_.erase(channel_id);
+                    Reject(channel_id, "session not found on this gateway");
                 }
                 break;
             }
-            case avatar_sync::AvatarSyncStreamRequest::kVisemeData: {
-                if (ws) { 
-                    const auto& vis = request.viseme_data();
-                    nlohmann::json j_payload = {
-                        {"type", "viseme"}, // 클라이언트 JS에서 이 type으로 메시지 구분
-                        {"sessionId", current_frontend_session_id}, 
-                        {"visemeId", vis.viseme_id()},
-                        {"timestampMs", vis.start_time().seconds() * 1000 + vis.start_time().nanos() / 1000000},
-                        {"durationSec", vis.duration_sec()}
-                    };
-                    std::string json_str_payload = j_payload.dump(); 
-                    // 상세 로깅은 필요시에만 활성화
-                    // std::cout << "AvatarSyncService: [" << current_frontend_session_id << "] Received Viseme Data from TTS. ID: " << vis.viseme_id() << ". Sending to WebSocket: " << json_str_payload << std::endl;
-                    ws->send(json_str_payload, uWS::OpCode::TEXT); 
+            case avatar_sync::AvatarSyncMuxFrame::kAudioChunk:
+            case avatar_sync::AvatarSyncMuxFrame::kVisemeData: {
+                if (frame_.frame_data_case() == avatar_sync::AvatarSyncMuxFrame::kAudioChunk) {
+                    request_.mutable_audio_chunk()->swap(*frame_.mutable_audio_chunk());
                 } else {
-                    std::cerr << "AvatarSyncService: [" << current_frontend_session_id << "] ❌ Received viseme data, but WebSocket is NULL (either not found or config not received yet)." << std::endl;
+                    request_.mutable_viseme_data()->Swap(frame_.mutable_viseme_data());
+                }
+                auto forwarded = forwarded_.find(channel_id);
+                if (forwarded != forwarded_.end()) {
+                    avatar_sync::AvatarSyncStreamRequest relayed;
+                    relayed.Swap(&request_);
+                    forwarded->second->Relay(std::move(relayed));
+                    break;
+                }
+                auto it = channels_.find(channel_id);
+                if (it == channels_.end()) {
+                    break; // 거부되었거나 열리지 않은 채널
                 }
+                service_->ProcessRequest(it->second, request_);
                 break;
             }
-            case avatar_sync::AvatarSyncStreamRequest::REQUEST_DATA_NOT_SET:
-                // std::cout << "AvatarSyncService: [" << (current_frontend_session_id.empty() ? "UNKNOWN_SESSION" : current_frontend_session_id) 
-                //           << "] Received request with data not set from TTS service." << std::endl;
+            case avatar_sync::AvatarSyncMuxFrame::kClose: {
+                auto forwarded = forwarded_.find(channel_id);
+                if (forwarded != forwarded_.end()) {
+                    forwarded->second->Close();
+                    forwarded_.erase(forwarded);
+                }
+                channels_.erase(channel_id);
                 break;
+            }
             default:
-                std::cerr << "AvatarSyncService: [" << (current_frontend_session_id.empty() ? "UNKNOWN_SESSION" : current_frontend_session_id) 
-                          << "] Received unknown data type in AvatarSyncStreamRequest from TTS service: " << request.request_data_case() << std::endl;
                 break;
         }
     }
 
-    std::cout << "AvatarSyncService: [" << (current_frontend_session_id.empty() ? "UNKNOWN_SESSION" : current_frontend_session_id) 
-              << "] gRPC stream closed by client (TTS service)." << std::endl;
+    void Reject(uint32_t channel_id, const std::string& reason) {
+        avatar_sync::AvatarSyncMuxControl error;
+        error.set_channel_id(channel_id);
+        error.set_channel_error(reason);
+        std::lock_guard<std::mutex> lock(mutex_);
+        EnqueueLocked(std::move(error));
+    }
+
+    void EnqueueLocked(avatar_sync::AvatarSyncMuxControl control) {
+        if (!peer_open_ || finished_) {
+            return;
+        }
+        writes_.push_back(std::move(control));
+        if (!writing_) {
+            StartNextWriteLocked();
+        }
+    }
+
+    void StartNextWriteLocked() {
+        outgoing_ = std::move(writes_.front());
+        writes_.pop_front();
+        writing_ = true;
+        StartWrite(&outgoing_);
+    }
+
+    // 읽기가 끝나고 진행 중인 쓰기가 없을 때 한 번만 Finish
+    void MaybeFinishLocked() {
+        if (finished_ || !reads_done_ || writing_) {
+            return;
+        }
+        finished_ = true;
+        if (context_->IsCancelled()) {
+            Finish(grpc::Status(grpc::StatusCode::CANCELLED, "Client (TTS service) cancelled multiplexed stream"));
+        } else {
+            Finish(grpc::Status::OK);
+        }
+    }
+
+    AvatarSyncServiceImpl* service_;
+    grpc::CallbackServerContext* context_;
+
+    // 읽기 경로 전용 (읽기는 한 번에 하나)
+    avatar_sync::AvatarSyncMuxFrame frame_;
+    avatar_sync::AvatarSyncStreamRequest request_;
+    std::unordered_map<uint32_t, StreamState> channels_;
+    std::unordered_map<uint32_t, std::shared_ptr<MuxForwarder>> forwarded_; // 소유 레플리카로 중계 중인 채널
+    std::atomic<uint64_t> consumed_{0}; // 아직 돌려주지 않은 크레딧 (크레딧 스레드와 공유)
+
+    // 쓰기 경로 (mutex_)
+    std::mutex mutex_;
+    std::deque<avatar_sync::AvatarSyncMuxControl> writes_;
+    avatar_sync::AvatarSyncMuxControl outgoing_;
+    bool writing_ = false;
+    bool peer_open_ = true;
+    bool reads_done_ = false;
+    bool finished_ = false;
+};
+
+grpc::ServerBidiReactor<avatar_sync::AvatarSyncMuxFrame, avatar_sync::AvatarSyncMuxControl>* AvatarSyncServiceImpl::SyncAvatarMux(
+    grpc::CallbackServerContext* context)
+{
+    return new MuxReactor(this, context);
+}
+
+bool AvatarSyncServiceImpl::backlog_high() const {
+    const uint64_t backlog = (backlog_probe_ ? backlog_probe_() : 0) + mux_forward_backlog_->load();
+    return backlog > kMuxBacklogHighWaterBytes;
+}
+
+std::string AvatarSyncServiceImpl::RemoteOwner(const std::string& session_id) const {
+    if (!session_directory_ || find_websocket_by_session_id_(session_id)) {
+        return std::string();
+    }
+    std::string owner = session_directory_->Lookup(session_id);
+    return owner == session_directory_->self_address() ? std::string() : owner;
+}
+
+bool AvatarSyncServiceImpl::StallCredit(MuxReactor* reactor) {
+    std::lock_guard<std::mutex> lock(stalled_mutex_);
+    if (stopping_ || !stalled_.insert(reactor).second) {
+        return false; // 이미 보류 중: 크레딧 스레드가 누적분을 한 번에 돌려줌
+    }
+    if (!credit_pump_.joinable()) {
+        credit_pump_ = std::thread(&AvatarSyncServiceImpl::CreditPumpLoop, this);
+    }
+    stalled_cv_.notify_one();
+    return true;
+}
+
+void AvatarSyncServiceImpl::ForgetStalled(MuxReactor* reactor) {
+    std::lock_guard<std::mutex> lock(stalled_mutex_);
+    stalled_.erase(reactor);
+}
+
+void AvatarSyncServiceImpl::CreditPumpLoop() {
+    std::unique_lock<std::mutex> lock(stalled_mutex_);
+    while (!stopping_) {
+        if (stalled_.empty()) {
+            stalled_cv_.wait(lock, [this]() { return stopping_ || !stalled_.empty(); });
+            continue;
+        }
+        stalled_cv_.wait_for(lock, std::chrono::milliseconds(5));
+        if (stopping_ || backlog_high()) {
+            continue;
+        }
+        // stalled_mutex_를 쥔 채 호출: 리액터는 OnDone에서 ForgetStalled를 거치므로 그동안 삭제되지 않음
+        for (MuxReactor* reactor : stalled_) {
+            reactor->ReleaseCredit();
+        }
+        stalled_.clear();
+    }
+}
+
+std::shared_ptr<avatar_sync::AvatarSyncService::Stub> AvatarSyncServiceImpl::peer_stub(const std::string& address) {
+    std::lock_guard<std::mutex> lock(peer_stubs_mutex_);
+    auto& stub = peer_stubs_[address];
+    if (!stub) {
+        stub = avatar_sync::AvatarSyncService::NewStub(grpc::CreateChannel(address, grpc::InsecureChannelCredentials()));
+    }
+    return stub;
+}
+
+grpc::Status AvatarSyncServiceImpl::ProcessRequest(StreamState& state, const avatar_sync::AvatarSyncStreamRequest& request) {
+    switch (request.request_data_case()) {
+        case avatar_sync::AvatarSyncStreamRequest::kConfig: {
+            // proto에서 SyncConfig의 필드명이 frontend_session_id라고 가정
+            state.frontend_session_id = request.config().frontend_session_id(); 
+            state.turn_id = request.config().turn_id();
+            if (state.frontend_session_id.empty()) {
+                std::cerr << "AvatarSyncService: Received SyncConfig with empty frontend_session_id from TTS service." << std::endl;
+                // 이 경우 오류로 처리하고 스트림을 종료할 수 있습니다.
+                return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "SyncConfig must contain a valid frontend_session_id.");
+            }
+            std::cout << "AvatarSyncService: [" << state.frontend_session_id << "] Received SyncConfig (turn " << state.turn_id << "). Attempting to find WebSocket connection." << std::endl;
+            state.session_found = find_websocket_by_session_id_(state.frontend_session_id); 
+            state.traced = traffic_tap_ && traffic_tap_->ShouldSample(state.frontend_session_id);
+            if (!state.session_found) {
+                std::cerr << "AvatarSyncService: [" << state.frontend_session_id << "] ❌ WebSocket connection NOT FOUND for frontend_session_id." << std::endl;
+                // TTS 서비스에게 웹소켓을 찾을 수 없음을 알리고 스트림을 종료하는 것이 좋습니다.
+                // return grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, "WebSocket session not found for ID: " + state.frontend_session_id);
+            } else {
+                std::cout << "AvatarSyncService: [" << state.frontend_session_id << "] ✅ WebSocket connection FOUND." << std::endl;
+            }
+            break;
+        }
+        case avatar_sync::AvatarSyncStreamRequest::kAudioChunk: {
+            if (state.session_found) { 
+                const auto& audio_bytes_str = request.audio_chunk(); // bytes 필드는 std::string으로 매핑됨
+                // 상세 로깅은 필요시에만 활성화 (성능 영향 가능성)
+                // std::cout << "AvatarSyncService: [" << state.frontend_session_id << "] Received Audio Chunk from TTS. Size: " << audio_bytes_str.size() << ". Sending to WebSocket." << std::endl;
+                const auto media_offset_ms = static_cast<int64_t>(state.audio_bytes / kPcmBytesPerMs);
+                state.audio_bytes += audio_bytes_str.size();
+                if (state.traced) {
+                    traffic_tap_->Record(TraceEventType::kServerAudio, state.frontend_session_id,
+                                         static_cast<uint32_t>(audio_bytes_str.size()), audio_bytes_str);
+                }
+                deliver_frame_(state.frontend_session_id, state.turn_id, media_offset_ms, audio_bytes_str, uWS::OpCode::BINARY);
+            } else {
+                std::cerr << "AvatarSyncService: [" << state.frontend_session_id << "] ❌ Received audio chunk, but WebSocket is NULL (either not found or config not received yet)." << std::endl;
+            }
+            break;
+        }
+        case avatar_sync::AvatarSyncStreamRequest::kVisemeData: {
+            if (state.session_found) { 
+                const auto& vis = request.viseme_data();
+                const int64_t timestamp_ms = vis.start_time().seconds() * 1000 + vis.start_time().nanos() / 1000000;
+                nlohmann::json j_payload = {
+                    {"type", "viseme"}, // 클라이언트 JS에서 이 type으로 메시지 구분
+                    {"sessionId", state.frontend_session_id}, 
+                    {"turnId", state.turn_id},
+                    {"visemeId", vis.viseme_id()},
+                    {"timestampMs", timestamp_ms},
+                    {"durationSec", vis.duration_sec()}
+                };
+                std::string json_str_payload = j_payload.dump(); 
+                if (state.traced) {
+                    traffic_tap_->Record(TraceEventType::kServerViseme, state.frontend_session_id,
+                                         static_cast<uint32_t>(json_str_payload.size()), json_str_payload);
+                }
+                // 상세 로깅은 필요시에만 활성화
+                // std::cout << "AvatarSyncService: [" << state.frontend_session_id << "] Received Viseme Data from TTS. ID: " << vis.viseme_id() << ". Sending to WebSocket: " << json_str_payload << std::endl;
+                deliver_frame_(state.frontend_session_id, state.turn_id, timestamp_ms, std::move(json_str_payload), uWS::OpCode::TEXT);
+            } else {
+                std::cerr << "AvatarSyncService: [" << state.frontend_session_id << "] ❌ Received viseme data, but WebSocket is NULL (either not found or config not received yet)." << std::endl;
+            }
+            break;
+        }
+        case avatar_sync::AvatarSyncStreamRequest::REQUEST_DATA_NOT_SET:
+            // std::cout << "AvatarSyncService: [" << (state.frontend_session_id.empty() ? "UNKNOWN_SESSION" : state.frontend_session_id) 
+            //           << "] Received request with data not set from TTS service." << std::endl;
+            break;
+        default:
+            std::cerr << "AvatarSyncService: [" << (state.frontend_session_id.empty() ? "UNKNOWN_SESSION" : state.frontend_session_id) 
+                      << "] Received unknown data type in AvatarSyncStreamRequest from TTS service: " << request.request_data_case() << std::endl;
+            break;
+    }
     return grpc::Status::OK;
 }
 
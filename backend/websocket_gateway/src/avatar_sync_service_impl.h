@@ -4,37 +4,127 @@
 
 #include <grpcpp/grpcpp.h>
 #include "avatar_sync.grpc.pb.h"    // 생성된 proto 헤더
+#include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "websocket_server.h" 
+#include "session_directory.h"
 // types.h는 websocket_server.h를 통해 간접적으로 포함될 것으로 예상되지만,
 // 명시적으로 필요한 경우 여기에 추가할 수 있습니다. (현재는 websocket_server.h에 의존)
 
 namespace websocket_gateway { 
 
-// AvatarSyncService의 gRPC 서비스 구현
-class AvatarSyncServiceImpl final : public avatar_sync::AvatarSyncService::Service {
+// AvatarSyncService의 gRPC 서비스 구현 (콜백 API).
+// 스트림마다 리액터 하나가 gRPC 완료 스레드에서 이벤트로 구동되므로, 동시 TTS 스트림 수만큼 스레드가 블록되지 않는다.
+// 리액터 콜백은 빠르게 반환해야 하며, 프레임은 deliver_frame_으로 uWS 루프 전송 큐에 넣기만 한다.
+class AvatarSyncServiceImpl final : public avatar_sync::AvatarSyncService::CallbackService {
 public:
-    // WebSocketServer에 정의된 WebSocketConnection 타입을 사용 (네임스페이스 포함)
-    // 이 using 선언이 성공하려면 websocket_gateway::WebSocketServer가 이 시점에서 완전한 타입이어야 합니다.
-    using ConsistentWebSocketConnection = websocket_gateway::WebSocketServer::WebSocketConnection;
-    
-    // session_id로 WebSocket 연결을 찾아주는 콜백 타입 정의
-    using WebSocketFinder = std::function< ConsistentWebSocketConnection* (const std::string& session_id) >;
-
-    // 생성자: WebSocketFinder 콜백을 주입받음
-    explicit AvatarSyncServiceImpl(WebSocketFinder finder);
-
-    // gRPC 서비스 메소드 오버라이드
-    grpc::Status SyncAvatarStream(
-        grpc::ServerContext* context,
-        grpc::ServerReader<avatar_sync::AvatarSyncStreamRequest>* reader,
+    // session_id에 연결된 WebSocket이 있는지 확인하는 콜백 (WebSocketServer::has_session).
+    // 소켓 포인터는 uWS 루프 스레드에서만 유효하므로 gRPC 스레드에는 존재 여부만 넘긴다.
+    using WebSocketFinder = std::function< bool (const std::string& session_id) >;
+
+    // 오디오/viseme 프레임을 세션으로 전달하는 콜백 (WebSocketServer::deliver_to_session).
+    // gRPC 스레드에서 ws->send를 직접 호출하지 않도록 uWS 루프로 넘기는 역할.
+    // media_offset_ms: 턴 오디오 시작 기준 이 프레임의 재생 위치 (게이트웨이가 세션 타임라인 PTS로 변환)
+    using FrameDeliverer = std::function< void (const std::string& session_id, uint64_t turn_id, int64_t media_offset_ms,
+                                                std::string payload, uWS::OpCode op_code) >;
+
+    // 아직 소켓으로 나가지 않은 프레임 바이트 (WebSocketServer::pending_frame_bytes). 다중화 스트림의 크레딧 조절에 사용
+    using BacklogProbe = std::function< uint64_t () >;
+
+    // TTS 출력 포맷 Raw16Khz16BitMonoPcm 기준 1ms당 바이트 수
+    static constexpr uint64_t kPcmBytesPerMs = 32;
+
+    // 다른 레플리카가 전달한 스트림 표시. 이 메타데이터가 있으면 다시 전달하지 않는다 (전달 루프 방지)
+    static constexpr const char* kForwardedMetadataKey = "x-avatar-sync-forwarded";
+
+    // SyncAvatarMux 흐름 제어: 연결마다 초기 창을 주고, 처리한 바이트를 배치로 돌려준다.
+    // 게이트웨이 송신 대기 바이트가 high water를 넘으면 반환을 미뤄 TTS 송신을 늦춘다.
+    static constexpr uint32_t kMuxInitialCreditBytes = 256 * 1024;       // 16kHz PCM 약 8초
+    static constexpr uint32_t kMuxCreditBatchBytes = 32 * 1024;
+    static constexpr uint64_t kMuxBacklogHighWaterBytes = 4 * 1024 * 1024;
+
+    // 생성자: WebSocketFinder / FrameDeliverer 콜백을 주입받음
+    // traffic_tap이 있으면 샘플링된 세션의 응답 오디오/viseme 프레임도 기록
+    // session_directory가 있으면 이 프로세스에 소켓이 없는 세션의 스트림/다중화 채널을 소유 레플리카로 전달
+    AvatarSyncServiceImpl(WebSocketFinder finder, FrameDeliverer deliverer,
+                          std::shared_ptr<TrafficTap> traffic_tap = nullptr,
+                          std::shared_ptr<SessionDirectory> session_directory = nullptr,
+                          BacklogProbe backlog_probe = nullptr);
+    ~AvatarSyncServiceImpl() override; // 크레딧 대기 스레드 종료 (gRPC 서버를 먼저 Shutdown해야 함)
+
+    // gRPC 서비스 메소드 오버라이드: 스트림마다 리액터를 만들어 반환 (리액터는 OnDone에서 스스로 삭제)
+    grpc::ServerReadReactor<avatar_sync::AvatarSyncStreamRequest>* SyncAvatarStream(
+        grpc::CallbackServerContext* context,
         google::protobuf::Empty* response
     ) override;
 
+    // 다중화 스트림: 채널 하나가 SyncAvatarStream 하나와 같은 경로(ProcessRequest 또는 소유 레플리카 중계)를 탄다
+    grpc::ServerBidiReactor<avatar_sync::AvatarSyncMuxFrame, avatar_sync::AvatarSyncMuxControl>* SyncAvatarMux(
+        grpc::CallbackServerContext* context
+    ) override;
+
+    uint64_t streams_active() const { return streams_active_.load(); }
+    uint64_t mux_connections_active() const { return mux_connections_active_.load(); }
+    uint64_t mux_credit_stalls() const { return mux_credit_stalls_.load(); }
+    uint64_t mux_channels_forwarded() const { return mux_channels_forwarded_.load(); }
+
+    // 스트림 하나(TTS 턴 하나)의 수신 상태
+    struct StreamState {
+        std::string frontend_session_id;
+        uint64_t turn_id = 0; // SyncConfig.turn_id (0 = 턴 정보 없음)
+        bool session_found = false;
+        uint64_t audio_bytes = 0; // 이 턴에서 지금까지 전달한 오디오 (다음 청크의 재생 위치 계산용)
+        bool traced = false;      // TrafficTap 샘플링 대상 세션
+    };
+
+    // 요청 메시지 하나를 처리(세션 조회, viseme JSON 변환, 프레임 전달).
+    // SyncAvatarStream과 루프백 모드(LoopbackSTTClient)가 같은 경로를 쓰도록 분리됨.
+    grpc::Status ProcessRequest(StreamState& state, const avatar_sync::AvatarSyncStreamRequest& request);
+
 private:
+    class StreamReactor;  // SyncAvatarStream 하나 (소유 레플리카로의 중계 포함)
+    class PeerWriter;     // 중계 시 소유 레플리카 쪽 클라이언트 리액터
+    class MuxReactor;     // SyncAvatarMux 연결 하나
+    class MuxForwarder;   // 다른 레플리카 소유 세션의 다중화 채널 하나를 소유 레플리카로 중계
+
     WebSocketFinder find_websocket_by_session_id_; // 웹소켓 연결을 찾는 함수 포인터
+    FrameDeliverer deliver_frame_;
+    std::shared_ptr<TrafficTap> traffic_tap_;
+
+    std::shared_ptr<avatar_sync::AvatarSyncService::Stub> peer_stub(const std::string& address);
+    // 이 레플리카에 소켓이 없고 디렉터리가 다른 소유 레플리카를 알면 그 주소, 아니면 빈 문자열
+    std::string RemoteOwner(const std::string& session_id) const;
+
+    // 백로그(소켓 송신 대기 + 중계 채널 대기)가 high water 아래로 내려갈 때까지 크레딧 반환을 미룬 다중화 연결들.
+    // 리액터 콜백은 블록할 수 없으므로 서비스 전체에서 스레드 하나가 주기적으로 확인해 크레딧을 돌려준다
+    bool backlog_high() const;
+    bool StallCredit(MuxReactor* reactor);
+    void ForgetStalled(MuxReactor* reactor); // 리액터 삭제 전 호출
+    void CreditPumpLoop();
+
+    std::shared_ptr<SessionDirectory> session_directory_;
+    BacklogProbe backlog_probe_;
+    std::atomic<uint64_t> streams_active_{0};
+    std::atomic<uint64_t> mux_connections_active_{0};
+    std::atomic<uint64_t> mux_credit_stalls_{0}; // 백로그 때문에 크레딧 반환을 미룬 횟수
+    std::atomic<uint64_t> mux_channels_forwarded_{0};
+    // 중계 채널이 소유 레플리카로 아직 못 보낸 바이트. MuxForwarder가 서비스보다 오래 살 수 있어 공유
+    std::shared_ptr<std::atomic<uint64_t>> mux_forward_backlog_ = std::make_shared<std::atomic<uint64_t>>(0);
+    std::unordered_set<MuxReactor*> stalled_;    // stalled_mutex_
+    std::mutex stalled_mutex_;
+    std::condition_variable stalled_cv_;
+    bool stopping_ = false;                      // stalled_mutex_
+    std::thread credit_pump_;                    // 첫 stall에서 시작
+    std::unordered_map<std::string, std::shared_ptr<avatar_sync::AvatarSyncService::Stub>> peer_stubs_; // 주소별 채널 재사용
+    std::mutex peer_stubs_mutex_;
 };
 
 } // namespace websocket_gateway
@@ -0,0 +1,89 @@
+#ifndef LOCK_FREE_QUEUE_H
+#define LOCK_FREE_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace websocket_gateway {
+
+// 고정 용량 다중 생산자 큐 (Vyukov bounded MPMC). 슬롯마다 시퀀스 번호를 두어 CAS 한 번으로 자리를 잡는다.
+// 가득 차면 TryPush가 즉시 false를 반환하므로 생산자(uWS 루프, gRPC 스레드)는 절대 블로킹되지 않는다.
+template <typename T>
+class BoundedMpscQueue {
+public:
+    explicit BoundedMpscQueue(size_t capacity)
+        : mask_(RoundUpPow2(capacity) - 1), cells_(new Cell[mask_ + 1]) {
+        if (capacity < 2) {
+            throw std::runtime_error("BoundedMpscQueue capacity must be at least 2.");
+        }
+        for (size_t i = 0; i <= mask_; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedMpscQueue(const BoundedMpscQueue&) = delete;
+    BoundedMpscQueue& operator=(const BoundedMpscQueue&) = delete;
+
+    bool TryPush(T&& value) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[pos & mask_];
+            const size_t seq = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // 가득 참
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 소비자는 하나라고 가정 (CAS 없이 진행)
+    bool TryPop(T& out) {
+        const size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[pos & mask_];
+        const size_t seq = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0) {
+            return false; // 비어 있음
+        }
+        out = std::move(cell.value);
+        cell.value = T{};
+        cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+        dequeue_pos_.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    static size_t RoundUpPow2(size_t n) {
+        size_t p = 2;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+    static constexpr size_t kCacheLine = 64;
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(kCacheLine) std::atomic<size_t> enqueue_pos_{0};
+    alignas(kCacheLine) std::atomic<size_t> dequeue_pos_{0};
+};
+
+} // namespace websocket_gateway
+
+#endif // LOCK_FREE_QUEUE_H
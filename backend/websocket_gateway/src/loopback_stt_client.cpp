@@ -0,0 +1,243 @@
+#include "loopback_stt_client.h"
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+#include <iterator>
+#include "avatar_sync.pb.h"
+
+namespace websocket_gateway {
+
+namespace {
+
+constexpr double kToneHz = 220.0;
+constexpr double kToneAmplitude = 0.2;
+constexpr int kVisemeIdCount = 22; // Azure viseme ID 0~21
+
+size_t CountUtf8Chars(const std::string& text) {
+    size_t count = 0;
+    for (unsigned char c : text) {
+        if ((c & 0xC0) != 0x80) count++;
+    }
+    return count;
+}
+
+} // namespace
+
+LoopbackSTTClient::LoopbackSTTClient(AvatarSyncServiceImpl* avatar_sync, LoopbackScript script)
+    : avatar_sync_(avatar_sync), script_(std::move(script)) {
+    if (!avatar_sync_) {
+        throw std::runtime_error("AvatarSyncServiceImpl cannot be null in LoopbackSTTClient.");
+    }
+    if (script_.transcripts.empty() || script_.sample_rate_hz <= 0 || script_.chunk_ms <= 0 || script_.viseme_interval_ms <= 0) {
+        throw std::runtime_error("Invalid LoopbackScript for LoopbackSTTClient.");
+    }
+}
+
+LoopbackSTTClient::~LoopbackSTTClient() {
+    ResponseWorker current;
+    {
+        std::lock_guard<std::mutex> lock(stream_mutex_);
+        current = TakeResponseLocked();
+    }
+    RetireResponse(std::move(current));
+    // 소멸 시에는 남은 응답 스레드를 모두 기다림 (스레드가 this를 참조하므로)
+    std::vector<ResponseWorker> retired;
+    {
+        std::lock_guard<std::mutex> lock(retired_mutex_);
+        retired.swap(retired_);
+    }
+    for (auto& worker : retired) {
+        worker.thread.join();
+    }
+}
+
+bool LoopbackSTTClient::StartStream(const stt::RecognitionConfig& config, StatusCallback on_finish) {
+    ResponseWorker previous;
+    {
+        std::lock_guard<std::mutex> lock(stream_mutex_);
+        if (stream_active_.load()) {
+            if (on_finish) {
+                on_finish(grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, "Stream already active with FE_SID: " + config_.frontend_session_id()));
+            }
+            return false;
+        }
+        if (config.frontend_session_id().empty()) {
+            if (on_finish) {
+                on_finish(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "frontend_session_id cannot be empty"));
+            }
+            return false;
+        }
+
+        // 새 발화가 시작되면 이전 응답 재생은 중단 (실제 파이프라인의 barge-in과 동일한 효과)
+        previous = TakeResponseLocked();
+
+        config_.CopyFrom(config);
+        status_callback_ = std::move(on_finish);
+        utterance_bytes_ = 0;
+        stream_active_.store(true);
+    }
+    RetireResponse(std::move(previous));
+    return true;
+}
+
+bool LoopbackSTTClient::WriteAudioChunk(const std::string& audio_data_chunk) {
+    if (!stream_active_.load()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(stream_mutex_);
+    utterance_bytes_ += audio_data_chunk.size();
+    audio_bytes_received_ += audio_data_chunk.size();
+    return true;
+}
+
+void LoopbackSTTClient::WritesDoneAndFinish() {
+    StatusCallback callback;
+    ResponseWorker previous;
+    {
+        std::lock_guard<std::mutex> lock(stream_mutex_);
+        if (!stream_active_.exchange(false)) {
+            return;
+        }
+        const std::string& transcript = script_.transcripts[utterance_count_++ % script_.transcripts.size()];
+        std::cout << "LoopbackSTTClient: [" << config_.frontend_session_id() << "] Utterance finished ("
+                  << utterance_bytes_ << " bytes, turn " << config_.turn_id() << "). Scripted transcript: \""
+                  << transcript << "\"" << std::endl;
+
+        previous = TakeResponseLocked();
+        response_.control = std::make_shared<ResponseControl>();
+        response_.thread = std::thread(&LoopbackSTTClient::ResponseTask, this, response_.control,
+                                       config_.frontend_session_id(), config_.turn_id(), transcript);
+        callback = status_callback_;
+    }
+    RetireResponse(std::move(previous));
+    // 실제 STTClient와 마찬가지로 STT 스트림 종료를 OK로 알림 (응답 오디오는 AvatarSync 경로로 따로 도착)
+    if (callback) {
+        callback(grpc::Status::OK);
+    }
+}
+
+void LoopbackSTTClient::StopStreamNow() {
+    StatusCallback callback;
+    ResponseWorker previous;
+    {
+        std::lock_guard<std::mutex> lock(stream_mutex_);
+        previous = TakeResponseLocked();
+        if (stream_active_.exchange(false)) {
+            callback = status_callback_;
+        }
+    }
+    RetireResponse(std::move(previous));
+    if (callback) {
+        callback(grpc::Status(grpc::StatusCode::CANCELLED, "Loopback stream stopped by client."));
+    }
+}
+
+bool LoopbackSTTClient::IsStreamActive() const {
+    return stream_active_.load();
+}
+
+std::string LoopbackSTTClient::GenerateResponsePcm(const LoopbackScript& script, const std::string& transcript) {
+    const size_t duration_ms = std::max<size_t>(1, CountUtf8Chars(transcript)) * static_cast<size_t>(std::max(1, script.ms_per_char));
+    const size_t sample_count = duration_ms * static_cast<size_t>(script.sample_rate_hz) / 1000;
+
+    std::string pcm(sample_count * sizeof(int16_t), '\0');
+    const double phase_step = 2.0 * M_PI * kToneHz / script.sample_rate_hz;
+    for (size_t i = 0; i < sample_count; ++i) {
+        auto sample = static_cast<int16_t>(std::sin(phase_step * static_cast<double>(i)) * kToneAmplitude * 32767.0);
+        // 16-bit little-endian
+        pcm[i * 2] = static_cast<char>(sample & 0xFF);
+        pcm[i * 2 + 1] = static_cast<char>((sample >> 8) & 0xFF);
+    }
+    return pcm;
+}
+
+LoopbackSTTClient::ResponseWorker LoopbackSTTClient::TakeResponseLocked() {
+    ResponseWorker worker = std::move(response_);
+    response_ = ResponseWorker{};
+    if (worker.control) {
+        {
+            std::lock_guard<std::mutex> lock(worker.control->mutex);
+            worker.control->stop_requested = true;
+        }
+        worker.control->cv.notify_all();
+    }
+    return worker;
+}
+
+void LoopbackSTTClient::RetireResponse(ResponseWorker worker) {
+    std::vector<ResponseWorker> finished;
+    {
+        std::lock_guard<std::mutex> lock(retired_mutex_);
+        if (worker.thread.joinable()) {
+            retired_.push_back(std::move(worker));
+        }
+        auto running = std::partition(retired_.begin(), retired_.end(),
+                                      [](const ResponseWorker& w) { return !w.control->done.load(); });
+        std::move(running, retired_.end(), std::back_inserter(finished));
+        retired_.erase(running, retired_.end());
+    }
+    // done이 설정된 스레드는 반환 직전이므로 join이 바로 끝남
+    for (auto& w : finished) {
+        w.thread.join();
+    }
+}
+
+bool LoopbackSTTClient::WaitFor(ResponseControl& control, std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(control.mutex);
+    return !control.cv.wait_until(lock, deadline, [&control]() { return control.stop_requested; });
+}
+
+void LoopbackSTTClient::ResponseTask(std::shared_ptr<ResponseControl> control, std::string frontend_session_id, uint64_t turn_id, std::string transcript) {
+    struct DoneMarker {
+        ResponseControl& control;
+        ~DoneMarker() { control.done.store(true); }
+    } done_marker{*control};
+
+    const std::string pcm = GenerateResponsePcm(script_, transcript);
+
+    if (!WaitFor(*control, std::chrono::steady_clock::now() + std::chrono::milliseconds(script_.response_delay_ms))) {
+        return;
+    }
+
+    AvatarSyncServiceImpl::StreamState state;
+    avatar_sync::AvatarSyncStreamRequest request;
+    request.mutable_config()->set_frontend_session_id(frontend_session_id);
+    request.mutable_config()->set_turn_id(turn_id);
+    if (!avatar_sync_->ProcessRequest(state, request).ok()) {
+        return;
+    }
+
+    const size_t bytes_per_ms = static_cast<size_t>(script_.sample_rate_hz) * sizeof(int16_t) / 1000;
+    const size_t chunk_bytes = std::max<size_t>(sizeof(int16_t), bytes_per_ms * static_cast<size_t>(script_.chunk_ms));
+    const auto start = std::chrono::steady_clock::now();
+    size_t next_viseme_ms = 0;
+    int viseme_id = 0;
+
+    for (size_t offset = 0; offset < pcm.size(); offset += chunk_bytes) {
+        const size_t chunk_start_ms = offset / bytes_per_ms;
+        const size_t length = std::min(chunk_bytes, pcm.size() - offset);
+        const size_t chunk_end_ms = (offset + length) / bytes_per_ms;
+
+        const auto deadline = start + std::chrono::microseconds(static_cast<int64_t>(chunk_start_ms * 1000 * script_.pacing));
+        if (!WaitFor(*control, deadline)) {
+            return;
+        }
+
+        for (; next_viseme_ms < chunk_end_ms; next_viseme_ms += static_cast<size_t>(script_.viseme_interval_ms)) {
+            request.Clear();
+            auto* viseme = request.mutable_viseme_data();
+            viseme->set_viseme_id(std::to_string(viseme_id));
+            viseme->mutable_start_time()->set_seconds(static_cast<int64_t>(next_viseme_ms / 1000));
+            viseme->mutable_start_time()->set_nanos(static_cast<int32_t>((next_viseme_ms % 1000) * 1000000));
+            viseme->set_duration_sec(script_.viseme_interval_ms / 1000.0f);
+            avatar_sync_->ProcessRequest(state, request);
+            viseme_id = (viseme_id + 1) % kVisemeIdCount;
+        }
+
+        request.Clear();
+        request.set_audio_chunk(pcm.data() + offset, length);
+        avatar_sync_->ProcessRequest(state, request);
+    }
+}
+
+} // namespace websocket_gateway
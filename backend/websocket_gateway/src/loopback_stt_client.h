@@ -0,0 +1,92 @@
+#ifndef LOOPBACK_STT_CLIENT_H
+#define LOOPBACK_STT_CLIENT_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+#include "stt_client.h"
+#include "avatar_sync_service_impl.h"
+
+namespace websocket_gateway {
+
+// 루프백 모드 응답 시나리오. 발화마다 transcripts를 순서대로 돌려가며 사용한다.
+struct LoopbackScript {
+    std::vector<std::string> transcripts{"안녕하세요. 게이트웨이 루프백 벤치마크 응답입니다."};
+    int response_delay_ms = 300;   // 발화 종료 ~ 첫 오디오 (STT/LLM/TTS 지연 흉내)
+    int ms_per_char = 60;          // 응답 음성 길이 = 글자 수 * ms_per_char
+    int chunk_ms = 50;             // 오디오 청크 길이
+    int viseme_interval_ms = 80;   // viseme 간격
+    int sample_rate_hz = 16000;    // 16-bit mono PCM
+    double pacing = 1.0;           // 1.0 = 실시간 속도로 전송, 0 = 대기 없이 최대 속도
+};
+
+// stt_service 없이 게이트웨이만 벤치마크하기 위한 프로세스 내 STT 대체 구현.
+// 받은 오디오는 버리고(바이트 수만 집계), 발화가 끝나면 스크립트된 응답 오디오/viseme을
+// AvatarSyncServiceImpl::ProcessRequest 경로로 밀어넣어 실제 TTS 응답과 같은 전송 경로를 탄다.
+class LoopbackSTTClient : public STTStreamClient {
+public:
+    LoopbackSTTClient(AvatarSyncServiceImpl* avatar_sync, LoopbackScript script);
+    ~LoopbackSTTClient() override;
+
+    LoopbackSTTClient(const LoopbackSTTClient&) = delete;
+    LoopbackSTTClient& operator=(const LoopbackSTTClient&) = delete;
+
+    bool StartStream(const stt::RecognitionConfig& config, StatusCallback on_finish) override;
+    bool WriteAudioChunk(const std::string& audio_data_chunk) override;
+    void WritesDoneAndFinish() override;
+    void StopStreamNow() override;
+    bool IsStreamActive() const override;
+
+    uint64_t audio_bytes_received() const { return audio_bytes_received_.load(); }
+
+    // 스크립트 응답 PCM 생성 (테스트에서도 사용)
+    static std::string GenerateResponsePcm(const LoopbackScript& script, const std::string& transcript);
+
+private:
+    // 응답 스레드 하나의 중단 신호. 스레드마다 따로 두어 새 응답이 이전 응답의 중단 플래그를 덮어쓰지 않게 한다
+    struct ResponseControl {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool stop_requested = false;
+        std::atomic<bool> done{false}; // ResponseTask 반환 직전에 설정 (join이 즉시 끝나는지 판단용)
+    };
+    struct ResponseWorker {
+        std::thread thread;
+        std::shared_ptr<ResponseControl> control;
+    };
+
+    void ResponseTask(std::shared_ptr<ResponseControl> control, std::string frontend_session_id, uint64_t turn_id, std::string transcript);
+    // stream_mutex_ 보유 중 호출: 진행 중인 응답에 중단 신호만 보내고 스레드를 꺼내 돌려준다 (join하지 않음)
+    ResponseWorker TakeResponseLocked();
+    // stream_mutex_ 밖에서 호출: 꺼낸 스레드를 retired_에 넣고, 이미 끝난 스레드만 join한다.
+    // uWS 루프 스레드에서 불려도 막히지 않도록 아직 실행 중인 스레드는 다음 호출이나 소멸자에서 join
+    void RetireResponse(ResponseWorker worker);
+    static bool WaitFor(ResponseControl& control, std::chrono::steady_clock::time_point deadline); // 중단 요청 시 false
+
+    AvatarSyncServiceImpl* avatar_sync_;
+    LoopbackScript script_;
+
+    stt::RecognitionConfig config_;
+    StatusCallback status_callback_;
+    std::atomic<bool> stream_active_{false};
+    std::atomic<uint64_t> audio_bytes_received_{0};
+    uint64_t utterance_bytes_ = 0;
+    size_t utterance_count_ = 0;
+
+    ResponseWorker response_; // stream_mutex_로 보호
+
+    std::mutex retired_mutex_;
+    std::vector<ResponseWorker> retired_; // 중단 신호를 보냈지만 아직 join하지 않은 응답 스레드
+
+    mutable std::mutex stream_mutex_;
+};
+
+} // namespace websocket_gateway
+
+#endif // LOOPBACK_STT_CLIENT_H
@@ -1,6 +1,7 @@
 // src/main.cpp
 #include "websocket_server.h" 
 #include "avatar_sync_service_impl.h" 
+#include "loopback_stt_client.h"
 #include <grpcpp/server.h>
 #include <grpcpp/server_builder.h>
 #include <iostream>
@@ -8,18 +9,65 @@
 #include <thread>
 #include <csignal> 
 #include <memory>  
+#include <sstream>
+#include <vector>
 
 // Environment variable names
 const char* ENV_STT_SERVICE_ADDR = "STT_SERVICE_ADDR";
 const char* ENV_GRPC_AVATAR_SYNC_ADDR = "GRPC_AVATAR_SYNC_ADDR";
 const char* ENV_WS_PORT = "WS_PORT";
 const char* ENV_METRICS_PORT = "METRICS_PORT";
+const char* ENV_LLM_SERVICE_ADDR = "LLM_SERVICE_ADDR";
+const char* ENV_TTS_SERVICE_ADDR = "TTS_SERVICE_ADDR";
+const char* ENV_BARGE_IN_ENABLED = "BARGE_IN_ENABLED";
+const char* ENV_WS_PING_INTERVAL_SEC = "WS_PING_INTERVAL_SEC";
+const char* ENV_WS_DEAD_PEER_TIMEOUT_SEC = "WS_DEAD_PEER_TIMEOUT_SEC";
+const char* ENV_SESSION_IDLE_TIMEOUT_SEC = "SESSION_IDLE_TIMEOUT_SEC"; // 0 = 비활성
+const char* ENV_STT_STREAM_INACTIVITY_SEC = "STT_STREAM_INACTIVITY_SEC";
+const char* ENV_STT_CLIENT_RELEASE_SEC = "STT_CLIENT_RELEASE_SEC";
+const char* ENV_TURN_RESPONSE_DEADLINE_SEC = "TURN_RESPONSE_DEADLINE_SEC";
+const char* ENV_PIPELINE_MODE = "PIPELINE_MODE"; // "grpc"(기본) 또는 "loopback"
+const char* ENV_LOOPBACK_TRANSCRIPTS = "LOOPBACK_TRANSCRIPTS"; // '|'로 구분
+const char* ENV_LOOPBACK_RESPONSE_DELAY_MS = "LOOPBACK_RESPONSE_DELAY_MS";
+const char* ENV_LOOPBACK_MS_PER_CHAR = "LOOPBACK_MS_PER_CHAR";
+const char* ENV_LOOPBACK_CHUNK_MS = "LOOPBACK_CHUNK_MS";
+const char* ENV_LOOPBACK_PACING = "LOOPBACK_PACING";
+const char* ENV_TLS_CERT_FILE = "TLS_CERT_FILE"; // 인증서/키가 모두 설정되면 TLS 활성화
+const char* ENV_TLS_KEY_FILE = "TLS_KEY_FILE";
+const char* ENV_TLS_KEY_PASSPHRASE = "TLS_KEY_PASSPHRASE";
+const char* ENV_TLS_CA_FILE = "TLS_CA_FILE";
+const char* ENV_TLS_DH_PARAMS_FILE = "TLS_DH_PARAMS_FILE";
+const char* ENV_TLS_SESSION_TICKETS = "TLS_SESSION_TICKETS"; // "false"로 비활성
+const char* ENV_TLS_SESSION_TIMEOUT_SEC = "TLS_SESSION_TIMEOUT_SEC";
+const char* ENV_RATE_LIMIT_ENABLED = "RATE_LIMIT_ENABLED"; // "false"로 비활성 (부하 테스트용)
+const char* ENV_RATE_LIMIT_AUDIO_RT_RATIO = "RATE_LIMIT_AUDIO_RT_RATIO"; // 세션당 오디오 상한 (실시간 배수, 0 = 무제한)
+const char* ENV_RATE_LIMIT_IP_AUDIO_RT_RATIO = "RATE_LIMIT_IP_AUDIO_RT_RATIO"; // IP당 합산 상한
+const char* ENV_RATE_LIMIT_AUDIO_BURST_MS = "RATE_LIMIT_AUDIO_BURST_MS";
+const char* ENV_RATE_LIMIT_CONTROL_PER_SEC = "RATE_LIMIT_CONTROL_PER_SEC";
+const char* ENV_RATE_LIMIT_IP_CONTROL_PER_SEC = "RATE_LIMIT_IP_CONTROL_PER_SEC";
+const char* ENV_SESSION_AUDIO_QUOTA_SEC = "SESSION_AUDIO_QUOTA_SEC"; // 0 = 무제한
+const char* ENV_WS_MAX_MESSAGE_BYTES = "WS_MAX_MESSAGE_BYTES";
+const char* ENV_TRAFFIC_TAP_SAMPLE_RATE = "TRAFFIC_TAP_SAMPLE_RATE"; // 0(기본) = 비활성, 0.01 = 세션 1%
+const char* ENV_TRAFFIC_TAP_DIR = "TRAFFIC_TAP_DIR";
+const char* ENV_TRAFFIC_TAP_CAPTURE_AUDIO = "TRAFFIC_TAP_CAPTURE_AUDIO"; // "true"면 오디오 내용까지 기록
+const char* ENV_GATEWAY_REPLICA_ID = "GATEWAY_REPLICA_ID"; // 다중 게이트웨이: 이 레플리카의 ID (세션 ID 접두어)
+const char* ENV_GATEWAY_PEERS = "GATEWAY_PEERS";           // "g0=gateway-0:50055,g1=gateway-1:50055" (자기 자신 포함)
+const char* ENV_ADMISSION_MAX_SESSIONS = "ADMISSION_MAX_SESSIONS";         // 0(기본) = 무제한
+const char* ENV_ADMISSION_MAX_ACTIVE_TURNS = "ADMISSION_MAX_ACTIVE_TURNS"; // 0(기본) = 무제한
+const char* ENV_ADMISSION_QUEUE_SIZE = "ADMISSION_QUEUE_SIZE";
+const char* ENV_ADMISSION_QUEUE_TIMEOUT_MS = "ADMISSION_QUEUE_TIMEOUT_MS";
+const char* ENV_ADMISSION_RETRY_AFTER_MS = "ADMISSION_RETRY_AFTER_MS";
+const char* ENV_TIMELINE_RETAINED_SESSIONS = "TIMELINE_RETAINED_SESSIONS"; // 디버그 타임라인 슬롯 = ADMISSION_MAX_SESSIONS + 이 값
 
 // Default values
 std::string STT_SERVICE_ADDR_DEFAULT = "stt-service:50052"; // Docker-compose 서비스 이름 사용
 std::string GRPC_AVATAR_SYNC_ADDR_DEFAULT = "0.0.0.0:50055";
 int WS_PORT_DEFAULT = 8000;
 int METRICS_PORT_DEFAULT = 9090;
+std::string LLM_SERVICE_ADDR_DEFAULT = "llm-service:50053";
+std::string TTS_SERVICE_ADDR_DEFAULT = "tts-service:50054";
+
+std::string PIPELINE_MODE_DEFAULT = "grpc";
 
 // ★ 네임스페이스를 사용하여 전역 변수 선언
 std::unique_ptr<grpc::Server> grpc_server_instance;
@@ -41,6 +89,120 @@ void signal_handler(int signal) {
     }
 }
 
+// 세션 liveness 설정: 환경 변수가 없으면 LivenessConfig 기본값 사용
+websocket_gateway::LivenessConfig LoadLivenessConfig() {
+    websocket_gateway::LivenessConfig config;
+    auto read_seconds = [](const char* env_name, std::chrono::seconds& target) {
+        if (const char* value = std::getenv(env_name)) {
+            target = std::chrono::seconds(std::stoi(value));
+        }
+    };
+    read_seconds(ENV_WS_PING_INTERVAL_SEC, config.ping_interval);
+    read_seconds(ENV_WS_DEAD_PEER_TIMEOUT_SEC, config.dead_peer_timeout);
+    read_seconds(ENV_SESSION_IDLE_TIMEOUT_SEC, config.session_idle_timeout);
+    read_seconds(ENV_STT_STREAM_INACTIVITY_SEC, config.stt_stream_inactivity_timeout);
+    read_seconds(ENV_STT_CLIENT_RELEASE_SEC, config.stt_client_release_after);
+    read_seconds(ENV_TURN_RESPONSE_DEADLINE_SEC, config.turn_response_deadline);
+    return config;
+}
+
+// 게이트웨이 TLS 설정: TLS_CERT_FILE과 TLS_KEY_FILE이 모두 있을 때만 활성화
+websocket_gateway::TlsConfig LoadTlsConfig() {
+    websocket_gateway::TlsConfig config;
+    auto read_string = [](const char* env_name, std::string& target) {
+        if (const char* value = std::getenv(env_name)) target = value;
+    };
+    auto is_false = [](const char* env_name) {
+        return std::getenv(env_name) && std::string(std::getenv(env_name)) == "false";
+    };
+    read_string(ENV_TLS_CERT_FILE, config.cert_file);
+    read_string(ENV_TLS_KEY_FILE, config.key_file);
+    read_string(ENV_TLS_KEY_PASSPHRASE, config.key_passphrase);
+    read_string(ENV_TLS_CA_FILE, config.ca_file);
+    read_string(ENV_TLS_DH_PARAMS_FILE, config.dh_params_file);
+    config.enabled = !config.cert_file.empty() && !config.key_file.empty();
+    config.session_tickets = !is_false(ENV_TLS_SESSION_TICKETS);
+    if (const char* value = std::getenv(ENV_TLS_SESSION_TIMEOUT_SEC)) {
+        config.session_timeout = std::chrono::seconds(std::stoi(value));
+    }
+    return config;
+}
+
+// 업스트림 속도 제한: 환경 변수가 없으면 RateLimitConfig 기본값 사용. 제어 메시지 burst는 속도의 2배로 맞춤
+websocket_gateway::RateLimitConfig LoadRateLimitConfig() {
+    websocket_gateway::RateLimitConfig config;
+    auto read_double = [](const char* env_name, double& target) {
+        if (const char* value = std::getenv(env_name)) target = std::stod(value);
+    };
+    config.enabled = !(std::getenv(ENV_RATE_LIMIT_ENABLED) && std::string(std::getenv(ENV_RATE_LIMIT_ENABLED)) == "false");
+    read_double(ENV_RATE_LIMIT_AUDIO_RT_RATIO, config.session_audio_realtime_ratio);
+    read_double(ENV_RATE_LIMIT_IP_AUDIO_RT_RATIO, config.ip_audio_realtime_ratio);
+    if (std::getenv(ENV_RATE_LIMIT_CONTROL_PER_SEC)) {
+        read_double(ENV_RATE_LIMIT_CONTROL_PER_SEC, config.session_control_per_sec);
+        config.session_control_burst = 2 * config.session_control_per_sec;
+    }
+    if (std::getenv(ENV_RATE_LIMIT_IP_CONTROL_PER_SEC)) {
+        read_double(ENV_RATE_LIMIT_IP_CONTROL_PER_SEC, config.ip_control_per_sec);
+        config.ip_control_burst = 2 * config.ip_control_per_sec;
+    }
+    if (const char* value = std::getenv(ENV_RATE_LIMIT_AUDIO_BURST_MS)) {
+        config.audio_burst = std::chrono::milliseconds(std::stoi(value));
+    }
+    if (const char* value = std::getenv(ENV_SESSION_AUDIO_QUOTA_SEC)) {
+        config.session_audio_quota = std::chrono::seconds(std::stoi(value));
+    }
+    if (const char* value = std::getenv(ENV_WS_MAX_MESSAGE_BYTES)) {
+        config.max_message_bytes = static_cast<uint32_t>(std::stoul(value));
+    }
+    return config;
+}
+
+// 트래픽 탭: TRAFFIC_TAP_SAMPLE_RATE > 0 일 때만 사용
+websocket_gateway::TrafficTapConfig LoadTrafficTapConfig() {
+    websocket_gateway::TrafficTapConfig config;
+    if (const char* value = std::getenv(ENV_TRAFFIC_TAP_SAMPLE_RATE)) config.sample_rate = std::stod(value);
+    if (const char* value = std::getenv(ENV_TRAFFIC_TAP_DIR)) config.output_dir = value;
+    config.capture_audio = std::getenv(ENV_TRAFFIC_TAP_CAPTURE_AUDIO) && std::string(std::getenv(ENV_TRAFFIC_TAP_CAPTURE_AUDIO)) == "true";
+    return config;
+}
+
+// 입장 제어: 환경 변수가 없으면 AdmissionConfig 기본값(무제한) 사용
+websocket_gateway::AdmissionConfig LoadAdmissionConfig() {
+    websocket_gateway::AdmissionConfig config;
+    auto read_u32 = [](const char* env_name, uint32_t& target) {
+        if (const char* value = std::getenv(env_name)) target = static_cast<uint32_t>(std::stoul(value));
+    };
+    auto read_ms = [](const char* env_name, std::chrono::milliseconds& target) {
+        if (const char* value = std::getenv(env_name)) target = std::chrono::milliseconds(std::stoi(value));
+    };
+    read_u32(ENV_ADMISSION_MAX_SESSIONS, config.max_sessions);
+    read_u32(ENV_ADMISSION_MAX_ACTIVE_TURNS, config.max_active_turns);
+    read_u32(ENV_ADMISSION_QUEUE_SIZE, config.queue_capacity);
+    read_ms(ENV_ADMISSION_QUEUE_TIMEOUT_MS, config.queue_timeout);
+    read_ms(ENV_ADMISSION_RETRY_AFTER_MS, config.retry_after);
+    read_u32(ENV_TIMELINE_RETAINED_SESSIONS, config.timeline_retained_sessions);
+    return config;
+}
+
+// 루프백 모드 시나리오: 환경 변수가 없으면 LoopbackScript 기본값 사용
+websocket_gateway::LoopbackScript LoadLoopbackScript() {
+    websocket_gateway::LoopbackScript script;
+    if (const char* transcripts = std::getenv(ENV_LOOPBACK_TRANSCRIPTS)) {
+        std::vector<std::string> lines;
+        std::stringstream ss(transcripts);
+        std::string line;
+        while (std::getline(ss, line, '|')) {
+            if (!line.empty()) lines.push_back(line);
+        }
+        if (!lines.empty()) script.transcripts = std::move(lines);
+    }
+    if (std::getenv(ENV_LOOPBACK_RESPONSE_DELAY_MS)) script.response_delay_ms = std::stoi(std::getenv(ENV_LOOPBACK_RESPONSE_DELAY_MS));
+    if (std::getenv(ENV_LOOPBACK_MS_PER_CHAR)) script.ms_per_char = std::stoi(std::getenv(ENV_LOOPBACK_MS_PER_CHAR));
+    if (std::getenv(ENV_LOOPBACK_CHUNK_MS)) script.chunk_ms = std::stoi(std::getenv(ENV_LOOPBACK_CHUNK_MS));
+    if (std::getenv(ENV_LOOPBACK_PACING)) script.pacing = std::stod(std::getenv(ENV_LOOPBACK_PACING));
+    return script;
+}
+
 // ★ AvatarSyncServiceImpl도 네임스페이스 명시
 void RunGrpcServer(const std::string& grpc_addr, websocket_gateway::AvatarSyncServiceImpl* avatar_service) {
     grpc::ServerBuilder builder;
@@ -66,30 +228,121 @@ int main(int argc, char** argv) {
     std::string grpc_avatar_sync_addr = std::getenv(ENV_GRPC_AVATAR_SYNC_ADDR) ? std::getenv(ENV_GRPC_AVATAR_SYNC_ADDR) : GRPC_AVATAR_SYNC_ADDR_DEFAULT;
     int ws_port = std::getenv(ENV_WS_PORT) ? std::stoi(std::getenv(ENV_WS_PORT)) : WS_PORT_DEFAULT;
     int metrics_port = std::getenv(ENV_METRICS_PORT) ? std::stoi(std::getenv(ENV_METRICS_PORT)) : METRICS_PORT_DEFAULT;
+    std::string llm_service_addr = std::getenv(ENV_LLM_SERVICE_ADDR) ? std::getenv(ENV_LLM_SERVICE_ADDR) : LLM_SERVICE_ADDR_DEFAULT;
+    std::string tts_service_addr = std::getenv(ENV_TTS_SERVICE_ADDR) ? std::getenv(ENV_TTS_SERVICE_ADDR) : TTS_SERVICE_ADDR_DEFAULT;
+    bool barge_in_enabled = !(std::getenv(ENV_BARGE_IN_ENABLED) && std::string(std::getenv(ENV_BARGE_IN_ENABLED)) == "false");
+    std::string pipeline_mode = std::getenv(ENV_PIPELINE_MODE) ? std::getenv(ENV_PIPELINE_MODE) : PIPELINE_MODE_DEFAULT;
+    const bool loopback_mode = (pipeline_mode == "loopback");
 
     std::cout << "Configuration:" << std::endl;
     std::cout << " - WS_PORT: " << ws_port << std::endl;
     std::cout << " - METRICS_PORT: " << metrics_port << std::endl;
     std::cout << " - STT_SERVICE_ADDR: " << stt_service_addr << std::endl;
     std::cout << " - GRPC_AVATAR_SYNC_ADDR: " << grpc_avatar_sync_addr << std::endl;
+    std::cout << " - LLM_SERVICE_ADDR: " << llm_service_addr << std::endl;
+    std::cout << " - TTS_SERVICE_ADDR: " << tts_service_addr << std::endl;
+    std::cout << " - BARGE_IN_ENABLED: " << (barge_in_enabled ? "true" : "false") << std::endl;
+    std::cout << " - PIPELINE_MODE: " << pipeline_mode << std::endl;
+    websocket_gateway::LivenessConfig liveness_config = LoadLivenessConfig();
+    std::cout << " - Liveness: ping " << liveness_config.ping_interval.count() << "s, dead peer "
+              << liveness_config.dead_peer_timeout.count() << "s, idle close " << liveness_config.session_idle_timeout.count()
+              << "s, STT inactivity " << liveness_config.stt_stream_inactivity_timeout.count() << "s, STT client release "
+              << liveness_config.stt_client_release_after.count() << "s, turn deadline "
+              << liveness_config.turn_response_deadline.count() << "s" << std::endl;
+    websocket_gateway::TlsConfig tls_config = LoadTlsConfig();
+    std::cout << " - TLS: " << (tls_config.enabled ? "Enabled (cert " + tls_config.cert_file + ")" : "Disabled") << std::endl;
+    websocket_gateway::RateLimitConfig rate_limit_config = LoadRateLimitConfig();
+    websocket_gateway::AdmissionConfig admission_config = LoadAdmissionConfig();
+    websocket_gateway::TrafficTapConfig traffic_tap_config = LoadTrafficTapConfig();
+    std::shared_ptr<websocket_gateway::TrafficTap> traffic_tap;
+    if (traffic_tap_config.sample_rate > 0) {
+        try {
+            traffic_tap = std::make_shared<websocket_gateway::TrafficTap>(traffic_tap_config);
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to start traffic tap: " << e.what() << ". Tap disabled." << std::endl;
+        }
+    }
+
+    // 다중 게이트웨이: 두 값이 모두 있을 때만 세션 디렉터리 사용 (설정 오류는 잘못된 라우팅을 막기 위해 종료)
+    std::shared_ptr<websocket_gateway::SessionDirectory> session_directory;
+    if (std::getenv(ENV_GATEWAY_REPLICA_ID) && *std::getenv(ENV_GATEWAY_REPLICA_ID) &&
+        std::getenv(ENV_GATEWAY_PEERS) && *std::getenv(ENV_GATEWAY_PEERS)) {
+        try {
+            session_directory = std::make_shared<websocket_gateway::StaticPeerSessionDirectory>(
+                std::getenv(ENV_GATEWAY_REPLICA_ID),
+                websocket_gateway::StaticPeerSessionDirectory::ParsePeers(std::getenv(ENV_GATEWAY_PEERS)));
+        } catch (const std::exception& e) {
+            std::cerr << "Invalid gateway replica configuration: " << e.what() << std::endl;
+            return 1;
+        }
+        std::cout << " - Session directory: replica " << std::getenv(ENV_GATEWAY_REPLICA_ID) << " @ " << session_directory->self_address() << std::endl;
+    }
 
     std::signal(SIGINT, signal_handler);
     std::signal(SIGTERM, signal_handler);
 
-    // ★ WebSocketServer 생성 시 네임스페이스 명시
-    g_websocket_server_instance = std::make_unique<websocket_gateway::WebSocketServer>(ws_port, metrics_port, stt_service_addr);
-
     // ★ AvatarSyncServiceImpl 생성 및 WebSocketFinder 타입 명시
-    // WebSocketFinder의 반환 타입이 websocket_gateway::WebSocketServer::WebSocketConnection* 이어야 함
     websocket_gateway::AvatarSyncServiceImpl::WebSocketFinder finder = 
-        [&](const std::string& session_id) -> websocket_gateway::WebSocketServer::WebSocketConnection* {
+        [&](const std::string& session_id) -> bool {
         if (g_websocket_server_instance) { // ★ 수정된 전역 변수 사용
-            return g_websocket_server_instance->find_websocket_by_session_id(session_id);
+            return g_websocket_server_instance->has_session(session_id);
+        }
+        return false;
+    };
+    // 프레임 전송은 uWS 루프 스레드에서 수행 (gRPC 스레드에서 ws->send 금지)
+    websocket_gateway::AvatarSyncServiceImpl::FrameDeliverer deliverer =
+        [&](const std::string& session_id, uint64_t turn_id, int64_t media_offset_ms, std::string payload, uWS::OpCode op_code) {
+        if (g_websocket_server_instance) {
+            g_websocket_server_instance->deliver_to_session(session_id, turn_id, media_offset_ms, std::move(payload), op_code);
         }
-        return nullptr;
+    };
+    // 다중화 스트림 흐름 제어: 게이트웨이 송신 대기량
+    websocket_gateway::AvatarSyncServiceImpl::BacklogProbe backlog_probe = [&]() -> uint64_t {
+        return g_websocket_server_instance ? g_websocket_server_instance->pending_frame_bytes() : 0;
     };
     // ★ AvatarSyncServiceImpl 생성 시 네임스페이스 명시
-    websocket_gateway::AvatarSyncServiceImpl avatar_service(finder);
+    websocket_gateway::AvatarSyncServiceImpl avatar_service(finder, deliverer, traffic_tap, session_directory, backlog_probe);
+
+    // Barge-in: 새 발화 시작 시 이전 턴의 LLM/TTS 처리를 취소하는 클라이언트
+    // 루프백 모드에서는 LLM/TTS가 없으므로 생성하지 않음 (이전 응답은 LoopbackSTTClient가 직접 중단)
+    std::shared_ptr<websocket_gateway::TurnCancelClient> turn_cancel_client;
+    if (barge_in_enabled && !loopback_mode) {
+        try {
+            turn_cancel_client = std::make_shared<websocket_gateway::TurnCancelClient>(llm_service_addr, tts_service_addr);
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to create TurnCancelClient: " << e.what() << ". Barge-in disabled." << std::endl;
+        }
+    }
+
+    // 루프백 모드: stt/llm/tts 서비스 없이 게이트웨이 자체 오버헤드만 측정
+    websocket_gateway::WebSocketServer::STTClientFactory stt_client_factory;
+    if (loopback_mode) {
+        websocket_gateway::LoopbackScript loopback_script = LoadLoopbackScript();
+        std::cout << "⚠️ Loopback pipeline mode: STT/LLM/TTS replaced by scripted in-process responses ("
+                  << loopback_script.transcripts.size() << " transcript(s), pacing " << loopback_script.pacing << ")." << std::endl;
+        stt_client_factory = [&avatar_service, loopback_script](const std::string& /*session_id*/) {
+            return std::make_unique<websocket_gateway::LoopbackSTTClient>(&avatar_service, loopback_script);
+        };
+    }
+
+    // 하위 서비스 여유 힌트: TTS 출력이 소켓으로 빠지지 못해 쌓이는 중이면(다중화 크레딧을 멈추는 수위) 새 턴을 받지 않음
+    websocket_gateway::AdmissionController::CapacityHint capacity_hint = [&]() -> int64_t {
+        if (g_websocket_server_instance &&
+            g_websocket_server_instance->pending_frame_bytes() > websocket_gateway::AvatarSyncServiceImpl::kMuxBacklogHighWaterBytes) {
+            return 0;
+        }
+        return -1; // 알 수 없음: 로컬 카운터로만 판단
+    };
+
+    // ★ WebSocketServer 생성 시 네임스페이스 명시
+    try {
+        g_websocket_server_instance = websocket_gateway::WebSocketServer::Create(
+            ws_port, metrics_port, stt_service_addr, turn_cancel_client, stt_client_factory, liveness_config, tls_config,
+            rate_limit_config, traffic_tap, session_directory, admission_config, capacity_hint);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to create WebSocket server: " << e.what() << std::endl;
+        return 1;
+    }
 
     std::thread grpc_thread(RunGrpcServer, grpc_avatar_sync_addr, &avatar_service);
 
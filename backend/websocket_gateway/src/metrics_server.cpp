@@ -0,0 +1,142 @@
+#include "metrics_server.h"
+#include <App.h>
+#include <Loop.h>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+namespace websocket_gateway {
+
+LatencyHistogram::LatencyHistogram(std::vector<uint32_t> upper_bounds_ms)
+    : bounds_(std::move(upper_bounds_ms)),
+      counts_(new std::atomic<uint64_t>[bounds_.size() + 1]) {
+    std::sort(bounds_.begin(), bounds_.end());
+    for (size_t i = 0; i <= bounds_.size(); ++i) {
+        counts_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::Observe(uint32_t value_ms) {
+    const size_t index = static_cast<size_t>(std::lower_bound(bounds_.begin(), bounds_.end(), value_ms) - bounds_.begin());
+    counts_[index].fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value_ms, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const {
+    uint64_t total = 0;
+    for (size_t i = 0; i <= bounds_.size(); ++i) {
+        total += counts_[i].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void LatencyHistogram::Render(std::string& out, const std::string& name, const std::string& help) const {
+    out += "# HELP " + name + " " + help + "\n";
+    out += "# TYPE " + name + " histogram\n";
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < bounds_.size(); ++i) {
+        cumulative += counts_[i].load(std::memory_order_relaxed);
+        out += name + "_bucket{le=\"" + std::to_string(bounds_[i]) + "\"} " + std::to_string(cumulative) + "\n";
+    }
+    cumulative += counts_[bounds_.size()].load(std::memory_order_relaxed);
+    out += name + "_bucket{le=\"+Inf\"} " + std::to_string(cumulative) + "\n";
+    out += name + "_sum " + std::to_string(sum()) + "\n";
+    out += name + "_count " + std::to_string(cumulative) + "\n\n";
+}
+
+MetricsHttpServer::MetricsHttpServer(int port, Renderer render_metrics, HealthProbe is_healthy, DebugRenderer render_debug)
+    : port_(port), render_metrics_(std::move(render_metrics)), is_healthy_(std::move(is_healthy)),
+      render_debug_(std::move(render_debug)) {
+    if (!render_metrics_) {
+        throw std::runtime_error("MetricsHttpServer requires a metrics renderer.");
+    }
+}
+
+MetricsHttpServer::~MetricsHttpServer() {
+    Stop();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool MetricsHttpServer::Start() {
+    std::promise<bool> listening;
+    std::future<bool> listen_result = listening.get_future();
+    thread_ = std::thread(&MetricsHttpServer::Run, this, std::move(listening));
+    return listen_result.get();
+}
+
+void MetricsHttpServer::Stop() {
+    if (stopping_.exchange(true)) {
+        return;
+    }
+    if (uWS::Loop* loop = loop_.load()) {
+        loop->defer([this]() {
+            if (listen_socket_) {
+                us_listen_socket_close(0, listen_socket_);
+                listen_socket_ = nullptr;
+            }
+        });
+    }
+}
+
+void MetricsHttpServer::Run(std::promise<bool> listening) {
+    // 이 스레드 전용 uWS 루프. 응답마다 연결을 닫아 keep-alive 소켓이 종료를 막지 않도록 함
+    uWS::App app;
+    app.get("/metrics", [this](uWS::HttpResponse<false>* res, uWS::HttpRequest*) {
+        res->writeHeader("Content-Type", "text/plain; version=0.0.4")->end(render_metrics_(), true);
+    });
+    app.get("/healthz", [this](uWS::HttpResponse<false>* res, uWS::HttpRequest*) {
+        if (!is_healthy_ || is_healthy_()) {
+            res->writeHeader("Content-Type", "text/plain")->end("OK", true);
+        } else {
+            res->writeStatus("503 Service Unavailable")->writeHeader("Content-Type", "text/plain")->end("event loop stalled", true);
+        }
+    });
+    if (render_debug_) {
+        app.get("/debug/sessions", [this](uWS::HttpResponse<false>* res, uWS::HttpRequest* req) {
+            const std::string_view slowest = req->getQuery("slowest");
+            size_t n = kDefaultSlowestSessions;
+            if (!slowest.empty()) {
+                n = std::min<size_t>(std::strtoul(std::string(slowest).c_str(), nullptr, 10), kMaxSlowestSessions);
+            }
+            res->writeHeader("Content-Type", "application/json")->end(render_debug_("", n), true);
+        });
+        app.get("/debug/sessions/*", [this](uWS::HttpResponse<false>* res, uWS::HttpRequest* req) {
+            std::string_view session_id = req->getUrl();
+            session_id.remove_prefix(std::min(session_id.size(), sizeof("/debug/sessions/") - 1));
+            std::string body = session_id.empty() ? std::string() : render_debug_(session_id, 0);
+            if (body.empty()) {
+                res->writeStatus("404 Not Found")->writeHeader("Content-Type", "text/plain")->end("unknown session", true);
+                return;
+            }
+            res->writeHeader("Content-Type", "application/json")->end(body, true);
+        });
+    }
+
+    bool ok = false;
+    app.listen(port_, [this, &ok](us_listen_socket_t* token) {
+        listen_socket_ = token;
+        ok = token != nullptr;
+    });
+    if (!ok) {
+        std::cerr << "Failed to listen on metrics port " << port_ << std::endl;
+        listening.set_value(false);
+        return;
+    }
+    loop_.store(uWS::Loop::get());
+    std::cout << "Metrics HTTP server listening on port " << port_ << " (dedicated thread)" << std::endl;
+    listening.set_value(true);
+
+    if (stopping_.load()) {
+        // Start 직후 Stop이 loop_ 설정 전에 호출된 경우
+        us_listen_socket_close(0, listen_socket_);
+        listen_socket_ = nullptr;
+    }
+    app.run();
+    loop_.store(nullptr);
+    std::cout << "Metrics HTTP server stopped." << std::endl;
+}
+
+} // namespace websocket_gateway
@@ -0,0 +1,80 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+struct us_listen_socket_t;
+namespace uWS { struct Loop; }
+
+namespace websocket_gateway {
+
+// 고정 버킷 히스토그램 (Prometheus histogram). Observe는 어느 스레드에서나 lock-free (relaxed atomics),
+// Render는 /metrics 스레드에서 호출되므로 버킷 사이의 미세한 불일치는 허용한다.
+class LatencyHistogram {
+public:
+    explicit LatencyHistogram(std::vector<uint32_t> upper_bounds_ms);
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void Observe(uint32_t value_ms);
+    // name_bucket{le=..} / name_sum / name_count 를 out에 추가
+    void Render(std::string& out, const std::string& name, const std::string& help) const;
+
+    uint64_t count() const;
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<uint32_t> bounds_;
+    std::unique_ptr<std::atomic<uint64_t>[]> counts_; // bounds_.size() + 1 (+Inf)
+    std::atomic<uint64_t> sum_{0};
+};
+
+// /metrics, /healthz (+ /debug/sessions) 전용 HTTP 서버. 오디오를 처리하는 uWS 루프와 분리된 자체 스레드/루프에서 동작하므로
+// 스크레이프가 실시간 프레임 전송과 경쟁하지 않는다. 렌더러는 이 스레드에서 호출되며 atomics/스냅샷만 읽어야 한다.
+class MetricsHttpServer {
+public:
+    using Renderer = std::function<std::string()>;
+    using HealthProbe = std::function<bool()>;
+    // /debug/sessions/<id> 이면 session_id, /debug/sessions?slowest=N 이면 빈 session_id와 N. 빈 문자열 반환 = 404
+    using DebugRenderer = std::function<std::string(std::string_view session_id, size_t slowest)>;
+
+    MetricsHttpServer(int port, Renderer render_metrics, HealthProbe is_healthy, DebugRenderer render_debug = nullptr);
+    ~MetricsHttpServer(); // Stop() 후 스레드 join
+
+    MetricsHttpServer(const MetricsHttpServer&) = delete;
+    MetricsHttpServer& operator=(const MetricsHttpServer&) = delete;
+
+    // 스레드를 띄우고 리슨 결과를 기다림. 포트 바인드 실패 시 false
+    bool Start();
+    // 리슨 소켓을 닫아 루프가 끝나도록 요청 (블로킹하지 않음, 여러 번 호출 가능)
+    void Stop();
+
+private:
+    static constexpr size_t kDefaultSlowestSessions = 10;
+    static constexpr size_t kMaxSlowestSessions = 200;
+
+    void Run(std::promise<bool> listening);
+
+    int port_;
+    Renderer render_metrics_;
+    HealthProbe is_healthy_;
+    DebugRenderer render_debug_;
+
+    std::thread thread_;
+    std::atomic<uWS::Loop*> loop_{nullptr};
+    us_listen_socket_t* listen_socket_ = nullptr; // 메트릭 스레드 전용
+    std::atomic<bool> stopping_{false};
+};
+
+} // namespace websocket_gateway
+
+#endif // METRICS_SERVER_H
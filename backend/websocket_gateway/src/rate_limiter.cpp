@@ -0,0 +1,181 @@
+#include "rate_limiter.h"
+#include <algorithm>
+#include <cmath>
+
+namespace websocket_gateway {
+
+void TokenBucket::Refill(double rate_per_sec, double burst, uint32_t elapsed_ms) {
+    tokens = static_cast<float>(std::min(burst, tokens + elapsed_ms * rate_per_sec / 1000.0));
+}
+
+bool TokenBucket::TryConsume(double cost, double burst) {
+    // 버킷보다 큰 메시지 하나는 가득 찬 버킷이면 통과시키고 음수로 빚을 짐 (영구 차단 방지)
+    if (tokens >= cost || tokens >= burst) {
+        tokens = static_cast<float>(tokens - cost);
+        return true;
+    }
+    return false;
+}
+
+void TokenBucket::Refund(double cost, double burst) {
+    tokens = static_cast<float>(std::min(burst, tokens + cost));
+}
+
+uint32_t TokenBucket::MsUntilAvailable(double cost, double rate_per_sec, double burst) const {
+    if (rate_per_sec <= 0) return 0;
+    const double missing = std::min(cost, burst) - tokens;
+    if (missing <= 0) return 0;
+    return static_cast<uint32_t>(std::ceil(missing * 1000.0 / rate_per_sec));
+}
+
+UpstreamRateLimiter::UpstreamRateLimiter(const RateLimitConfig& config)
+    : config_(config),
+      session_audio_rate_(config.session_audio_realtime_ratio * kAudioBytesPerSec),
+      session_audio_burst_(session_audio_rate_ * config.audio_burst.count() / 1000.0),
+      ip_audio_rate_(config.ip_audio_realtime_ratio * kAudioBytesPerSec),
+      ip_audio_burst_(ip_audio_rate_ * config.audio_burst.count() / 1000.0),
+      session_audio_quota_ms_(static_cast<uint64_t>(config.session_audio_quota.count()) * 1000) {}
+
+void UpstreamRateLimiter::Refill(SessionRateState& session, IpRateState* ip, uint32_t now_ms) const {
+    auto refill = [now_ms](RateBuckets& buckets, double audio_rate, double audio_burst, double control_rate, double control_burst) {
+        if (now_ms > buckets.last_refill_ms) {
+            const uint32_t elapsed_ms = now_ms - buckets.last_refill_ms;
+            buckets.audio.Refill(audio_rate, audio_burst, elapsed_ms);
+            buckets.control.Refill(control_rate, control_burst, elapsed_ms);
+            buckets.last_refill_ms = now_ms;
+        }
+    };
+    refill(session.buckets, session_audio_rate_, session_audio_burst_, config_.session_control_per_sec, config_.session_control_burst);
+    if (ip) {
+        refill(ip->buckets, ip_audio_rate_, ip_audio_burst_, config_.ip_control_per_sec, config_.ip_control_burst);
+    }
+}
+
+IpRateState* UpstreamRateLimiter::ip_state(const SessionRateState& session) {
+    return session.ip_slot == SessionRateState::kNoIp ? nullptr : &ip_slots_[session.ip_slot];
+}
+
+const IpRateState* UpstreamRateLimiter::ip_state(const SessionRateState& session) const {
+    return session.ip_slot == SessionRateState::kNoIp ? nullptr : &ip_slots_[session.ip_slot];
+}
+
+void UpstreamRateLimiter::Attach(SessionRateState& session, std::string_view remote_ip, uint32_t now_ms) {
+    session.buckets.audio.Reset(session_audio_burst_);
+    session.buckets.control.Reset(config_.session_control_burst);
+    session.buckets.last_refill_ms = now_ms;
+    session.audio_ms_total = 0;
+    session.last_warning_ms = 0;
+
+    auto [it, inserted] = ips_.try_emplace(std::string(remote_ip), 0);
+    if (inserted) {
+        if (free_ip_slots_.empty()) {
+            it->second = static_cast<uint32_t>(ip_slots_.size());
+            ip_slots_.emplace_back();
+        } else {
+            it->second = free_ip_slots_.back();
+            free_ip_slots_.pop_back();
+        }
+        IpRateState& ip = ip_slots_[it->second];
+        ip.remote_ip = it->first;
+        ip.sessions = 0;
+        ip.buckets.audio.Reset(ip_audio_burst_);
+        ip.buckets.control.Reset(config_.ip_control_burst);
+        ip.buckets.last_refill_ms = now_ms;
+    }
+    ip_slots_[it->second].sessions++;
+    session.ip_slot = it->second;
+}
+
+void UpstreamRateLimiter::Detach(SessionRateState& session) {
+    IpRateState* ip = ip_state(session);
+    if (!ip) return;
+    if (--ip->sessions == 0) {
+        ips_.erase(ip->remote_ip);
+        ip->remote_ip.clear();
+        free_ip_slots_.push_back(session.ip_slot);
+    }
+    session.ip_slot = SessionRateState::kNoIp;
+}
+
+UpstreamRateLimiter::Verdict UpstreamRateLimiter::AdmitAudio(SessionRateState& session, size_t bytes, uint32_t now_ms) {
+    // 16kHz 16-bit mono 기준 길이 (ms 미만은 올림 - 쿼터를 넘겨 받지 않도록)
+    const uint32_t frame_ms = static_cast<uint32_t>((bytes * 1000 + static_cast<size_t>(kAudioBytesPerSec) - 1) /
+                                                    static_cast<size_t>(kAudioBytesPerSec));
+    Verdict verdict = Verdict::kAllowed;
+    if (!config_.enabled) {
+        session.audio_ms_total += frame_ms;
+        return verdict;
+    }
+    IpRateState* ip = ip_state(session);
+    Refill(session, ip, now_ms);
+    if (session_audio_quota_ms_ > 0 && uint64_t{session.audio_ms_total} + frame_ms > session_audio_quota_ms_) {
+        verdict = Verdict::kQuotaExceeded;
+    } else if (session_audio_rate_ > 0 &&
+               !session.buckets.audio.TryConsume(static_cast<double>(bytes), session_audio_burst_)) {
+        verdict = Verdict::kSessionLimited;
+    } else if (ip_audio_rate_ > 0 && ip &&
+               !ip->buckets.audio.TryConsume(static_cast<double>(bytes), ip_audio_burst_)) {
+        verdict = Verdict::kIpLimited;
+        session.buckets.audio.Refund(static_cast<double>(bytes), session_audio_burst_); // 보내지 않은 프레임은 세션 몫에서 빼지 않음
+    }
+
+    if (verdict == Verdict::kAllowed) {
+        session.audio_ms_total += frame_ms;
+    } else {
+        stats_.audio_frames_shed[static_cast<int>(verdict)]++;
+        stats_.audio_bytes_shed += bytes;
+    }
+    return verdict;
+}
+
+UpstreamRateLimiter::Verdict UpstreamRateLimiter::AdmitControl(SessionRateState& session, uint32_t now_ms) {
+    Verdict verdict = Verdict::kAllowed;
+    if (!config_.enabled) {
+        return verdict;
+    }
+    IpRateState* ip = ip_state(session);
+    Refill(session, ip, now_ms);
+    if (config_.session_control_per_sec > 0 &&
+        !session.buckets.control.TryConsume(1.0, config_.session_control_burst)) {
+        verdict = Verdict::kSessionLimited;
+    } else if (config_.ip_control_per_sec > 0 && ip &&
+               !ip->buckets.control.TryConsume(1.0, config_.ip_control_burst)) {
+        verdict = Verdict::kIpLimited;
+        session.buckets.control.Refund(1.0, config_.session_control_burst);
+    }
+    if (verdict != Verdict::kAllowed) {
+        stats_.control_messages_shed[static_cast<int>(verdict)]++;
+    }
+    return verdict;
+}
+
+bool UpstreamRateLimiter::ShouldWarn(SessionRateState& session, uint32_t now_ms) {
+    const uint32_t interval_ms = static_cast<uint32_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(config_.warn_interval).count());
+    if (session.last_warning_ms != 0 && now_ms - session.last_warning_ms < interval_ms) {
+        return false;
+    }
+    session.last_warning_ms = std::max<uint32_t>(now_ms, 1); // 0은 "알림 보낸 적 없음"
+    stats_.warnings_sent++;
+    return true;
+}
+
+uint32_t UpstreamRateLimiter::AudioRetryAfterMs(const SessionRateState& session, size_t bytes) const {
+    uint32_t wait_ms = session.buckets.audio.MsUntilAvailable(static_cast<double>(bytes), session_audio_rate_, session_audio_burst_);
+    if (const IpRateState* ip = ip_state(session)) {
+        wait_ms = std::max(wait_ms, ip->buckets.audio.MsUntilAvailable(static_cast<double>(bytes), ip_audio_rate_, ip_audio_burst_));
+    }
+    return wait_ms;
+}
+
+const char* UpstreamRateLimiter::VerdictName(Verdict verdict) {
+    switch (verdict) {
+        case Verdict::kAllowed: return "allowed";
+        case Verdict::kSessionLimited: return "session";
+        case Verdict::kIpLimited: return "ip";
+        case Verdict::kQuotaExceeded: return "quota";
+    }
+    return "unknown";
+}
+
+} // namespace websocket_gateway
@@ -0,0 +1,128 @@
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace websocket_gateway {
+
+// 업스트림(클라이언트 → 게이트웨이 → STT) 속도 제한 설정. 비율/속도 0은 해당 제한 비활성화.
+// 오디오 상한은 실시간 배수로 표현: 16kHz 16-bit mono = 32000 B/s 가 1.0
+struct RateLimitConfig {
+    bool enabled = true;
+    double session_audio_realtime_ratio = 2.0;       // 세션당 오디오 업로드 상한
+    double ip_audio_realtime_ratio = 32.0;           // 원격 IP당 합산 상한 (NAT 뒤 다수 사용자 고려)
+    std::chrono::milliseconds audio_burst{2000};     // 버킷 깊이 (상한 속도로 이 시간만큼 몰아서 허용)
+    double session_control_per_sec = 10.0;           // 세션당 TEXT 제어 메시지
+    double session_control_burst = 20.0;
+    double ip_control_per_sec = 100.0;
+    double ip_control_burst = 200.0;
+    std::chrono::seconds session_audio_quota{0};     // 세션 누적 오디오 상한 (실시간 기준 길이, 0 = 무제한)
+    uint32_t max_message_bytes = 256 * 1024;         // uWS maxPayloadLength. 초과 시 uWS가 연결을 닫음
+    std::chrono::seconds warn_interval{5};           // 세션당 rate_limited 알림 최소 간격
+};
+
+// 토큰 버킷 하나의 잔량. 속도/깊이는 설정에서, 마지막 충전 시각은 RateBuckets에서 받음 (4바이트)
+struct TokenBucket {
+    float tokens = 0.0f;
+
+    void Reset(double burst) { tokens = static_cast<float>(burst); }
+    void Refill(double rate_per_sec, double burst, uint32_t elapsed_ms);
+    // cost만큼 토큰이 있으면 차감하고 true. 없으면 아무것도 차감하지 않고 false
+    bool TryConsume(double cost, double burst);
+    void Refund(double cost, double burst);
+    // cost만큼 쌓이기까지 남은 시간(ms). cost가 burst보다 크면 burst 기준
+    uint32_t MsUntilAvailable(double cost, double rate_per_sec, double burst) const;
+};
+
+// 오디오/제어 버킷 쌍. 충전은 선형이고 상한만 있으므로 두 버킷을 같은 시각에 함께 충전해도 따로 충전한 것과 같음 -
+// 충전 시각 하나를 공유해 PerSocketData에 들어가는 크기를 12바이트로 줄임
+struct RateBuckets {
+    TokenBucket audio;
+    TokenBucket control;
+    uint32_t last_refill_ms = 0;
+};
+
+// 원격 IP 단위 상태. 같은 IP의 세션이 모두 끊기면 슬롯이 반납됨
+struct IpRateState {
+    RateBuckets buckets;
+    uint32_t sessions = 0;
+    std::string remote_ip;
+};
+
+// 세션(소켓) 단위 상태. PerSocketData에 인라인으로 포함되므로 4바이트 필드만 둠 (24바이트)
+struct SessionRateState {
+    static constexpr uint32_t kNoIp = UINT32_MAX;
+
+    RateBuckets buckets;
+    uint32_t audio_ms_total = 0;  // 통과한 오디오 누적 길이 (ms, 프레임마다 올림). 쿼터 판단용 (32비트 = 약 49일)
+    uint32_t last_warning_ms = 0;
+    uint32_t ip_slot = kNoIp;     // UpstreamRateLimiter::Attach가 배정한 IP 상태 슬롯 (Detach 전까지 유효)
+};
+
+// 세션/원격 IP별 토큰 버킷 제한기. uWS 루프 스레드 전용 (스레드 안전하지 않음).
+// 세션 버킷을 먼저 검사하고, IP 버킷은 세션 제한을 통과한 메시지에만 차감한다.
+class UpstreamRateLimiter {
+public:
+    enum class Verdict { kAllowed, kSessionLimited, kIpLimited, kQuotaExceeded };
+
+    struct Stats {
+        uint64_t audio_frames_shed[4] = {};   // Verdict 인덱스 (kAllowed 칸은 사용 안 함)
+        uint64_t audio_bytes_shed = 0;
+        uint64_t control_messages_shed[4] = {};
+        uint64_t warnings_sent = 0;
+    };
+
+    static constexpr double kAudioBytesPerSec = 32000.0; // 16kHz 16-bit mono
+
+    explicit UpstreamRateLimiter(const RateLimitConfig& config = RateLimitConfig{});
+
+    UpstreamRateLimiter(const UpstreamRateLimiter&) = delete;
+    UpstreamRateLimiter& operator=(const UpstreamRateLimiter&) = delete;
+
+    // 연결 시 세션 버킷을 가득 채우고 원격 IP 상태에 연결. 종료 시 Detach 필수
+    void Attach(SessionRateState& session, std::string_view remote_ip, uint32_t now_ms);
+    void Detach(SessionRateState& session);
+
+    Verdict AdmitAudio(SessionRateState& session, size_t bytes, uint32_t now_ms);
+    Verdict AdmitControl(SessionRateState& session, uint32_t now_ms);
+
+    // warn_interval마다 한 번만 true (호출 측이 클라이언트에 알림을 보냄)
+    bool ShouldWarn(SessionRateState& session, uint32_t now_ms);
+    // 다음 오디오 프레임이 통과할 때까지 예상 대기 시간 (클라이언트 알림용)
+    uint32_t AudioRetryAfterMs(const SessionRateState& session, size_t bytes) const;
+
+    const RateLimitConfig& config() const { return config_; }
+    const Stats& stats() const { return stats_; }
+    size_t tracked_ips() const { return ips_.size(); }
+    double session_audio_bytes_per_sec() const { return session_audio_rate_; }
+    double ip_audio_bytes_per_sec() const { return ip_audio_rate_; }
+
+    static const char* VerdictName(Verdict verdict);
+
+private:
+    // 세션(과 IP) 버킷을 now_ms까지 충전
+    void Refill(SessionRateState& session, IpRateState* ip, uint32_t now_ms) const;
+    IpRateState* ip_state(const SessionRateState& session);
+    const IpRateState* ip_state(const SessionRateState& session) const;
+
+    RateLimitConfig config_;
+    double session_audio_rate_;
+    double session_audio_burst_;
+    double ip_audio_rate_;
+    double ip_audio_burst_;
+    uint64_t session_audio_quota_ms_;
+
+    std::unordered_map<std::string, uint32_t> ips_; // 원격 IP -> ip_slots_ 인덱스
+    std::vector<IpRateState> ip_slots_;
+    std::vector<uint32_t> free_ip_slots_;
+    Stats stats_;
+};
+
+} // namespace websocket_gateway
+
+#endif // RATE_LIMITER_H
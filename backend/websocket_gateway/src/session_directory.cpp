@@ -0,0 +1,76 @@
+#include "session_directory.h"
+#include <cctype>
+#include <stdexcept>
+
+namespace websocket_gateway {
+
+StaticPeerSessionDirectory::StaticPeerSessionDirectory(std::string replica_id, std::map<std::string, std::string> peers)
+    : replica_id_(std::move(replica_id)), peers_(std::move(peers)) {
+    if (replica_id_.empty() || replica_id_.size() > kMaxReplicaIdLength) {
+        throw std::runtime_error("Gateway replica ID must be 1-" + std::to_string(kMaxReplicaIdLength) + " characters.");
+    }
+    for (unsigned char c : replica_id_) {
+        if (!std::isalnum(c)) {
+            throw std::runtime_error("Gateway replica ID must be alphanumeric: " + replica_id_);
+        }
+    }
+    auto self = peers_.find(replica_id_);
+    if (self == peers_.end()) {
+        throw std::runtime_error("Gateway replica ID '" + replica_id_ + "' is not listed in the peer list.");
+    }
+    self_address_ = self->second;
+}
+
+std::string StaticPeerSessionDirectory::Lookup(const std::string& session_id) const {
+    const size_t dash = session_id.find('-');
+    if (dash == std::string::npos) {
+        return ""; // 레플리카 ID가 없는 (단일 게이트웨이 시절) 세션
+    }
+    auto it = peers_.find(session_id.substr(0, dash));
+    return it != peers_.end() ? it->second : "";
+}
+
+std::map<std::string, std::string> StaticPeerSessionDirectory::ParsePeers(const std::string& spec) {
+    std::map<std::string, std::string> peers;
+    size_t start = 0;
+    while (start < spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) end = spec.size();
+        const std::string entry = spec.substr(start, end - start);
+        const size_t eq = entry.find('=');
+        if (eq == std::string::npos || eq == 0 || eq + 1 == entry.size()) {
+            throw std::runtime_error("Invalid gateway peer entry '" + entry + "' (expected id=host:port).");
+        }
+        peers[entry.substr(0, eq)] = entry.substr(eq + 1);
+        start = end + 1;
+    }
+    return peers;
+}
+
+InMemorySessionDirectory::InMemorySessionDirectory(std::shared_ptr<Table> table, std::string self_address)
+    : table_(std::move(table)), self_address_(std::move(self_address)) {
+    if (!table_) {
+        throw std::runtime_error("InMemorySessionDirectory requires a shared table.");
+    }
+}
+
+void InMemorySessionDirectory::Register(std::string_view session_id) {
+    std::lock_guard<std::mutex> lock(table_->mutex);
+    table_->owners[std::string(session_id)] = self_address_;
+}
+
+void InMemorySessionDirectory::Unregister(std::string_view session_id) {
+    std::lock_guard<std::mutex> lock(table_->mutex);
+    auto it = table_->owners.find(std::string(session_id));
+    if (it != table_->owners.end() && it->second == self_address_) {
+        table_->owners.erase(it);
+    }
+}
+
+std::string InMemorySessionDirectory::Lookup(const std::string& session_id) const {
+    std::lock_guard<std::mutex> lock(table_->mutex);
+    auto it = table_->owners.find(session_id);
+    return it != table_->owners.end() ? it->second : "";
+}
+
+} // namespace websocket_gateway
@@ -0,0 +1,82 @@
+#ifndef SESSION_DIRECTORY_H
+#define SESSION_DIRECTORY_H
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace websocket_gateway {
+
+// 세션 ID → 소유 게이트웨이 레플리카(AvatarSync gRPC 주소) 디렉터리.
+// 게이트웨이가 여러 개일 때 TTS 스트림이 소켓을 갖지 않은 레플리카에 도착하면 이 정보로 소유자에게 전달한다.
+// Register/Unregister는 uWS 루프 스레드, Lookup은 gRPC 스레드에서 호출된다.
+class SessionDirectory {
+public:
+    virtual ~SessionDirectory() = default;
+
+    // 이 레플리카에서 세션이 열림/닫힘
+    virtual void Register(std::string_view session_id) = 0;
+    virtual void Unregister(std::string_view session_id) = 0;
+
+    // 소유 레플리카의 AvatarSync 주소. 알 수 없으면 빈 문자열
+    virtual std::string Lookup(const std::string& session_id) const = 0;
+
+    // 이 레플리카의 AvatarSync 주소 (Lookup 결과가 자기 자신인지 판단용)
+    virtual const std::string& self_address() const = 0;
+
+    // 새 세션 ID 앞에 붙일 접두어. 라우팅 정보를 ID 자체에 담는 구현만 사용 (기본: 없음)
+    virtual std::string session_id_prefix() const { return ""; }
+};
+
+// 공유 저장소 없이 동작하는 정적 디렉터리: 세션 ID가 "<replica_id>-<random>" 형태이고,
+// 레플리카 ID → 주소는 모든 게이트웨이/TTS가 같은 목록(GATEWAY_PEERS)을 갖는다.
+// 레플리카 추가/제거 시 목록만 갱신하면 되며 세션별 상태가 없다.
+class StaticPeerSessionDirectory final : public SessionDirectory {
+public:
+    static constexpr size_t kMaxReplicaIdLength = 8; // SessionId(32자)에 난수 부분 23자 이상을 남김
+
+    // replica_id가 peers에 없거나 형식이 잘못되면 std::runtime_error
+    StaticPeerSessionDirectory(std::string replica_id, std::map<std::string, std::string> peers);
+
+    void Register(std::string_view) override {}
+    void Unregister(std::string_view) override {}
+    std::string Lookup(const std::string& session_id) const override;
+    const std::string& self_address() const override { return self_address_; }
+    std::string session_id_prefix() const override { return replica_id_ + "-"; }
+
+    // "g0=gateway-0:50055,g1=gateway-1:50055" 형식 파싱. 형식 오류 시 std::runtime_error
+    static std::map<std::string, std::string> ParsePeers(const std::string& spec);
+
+private:
+    std::string replica_id_;
+    std::map<std::string, std::string> peers_;
+    std::string self_address_;
+};
+
+// 한 프로세스 안의 여러 레플리카가 공유하는 메모리 디렉터리 (테스트, 단일 호스트 실험용).
+// 같은 Table을 가리키는 인스턴스들이 각자 자기 주소로 세션을 등록한다.
+class InMemorySessionDirectory final : public SessionDirectory {
+public:
+    struct Table {
+        mutable std::mutex mutex;
+        std::unordered_map<std::string, std::string> owners; // session_id → AvatarSync 주소
+    };
+
+    InMemorySessionDirectory(std::shared_ptr<Table> table, std::string self_address);
+
+    void Register(std::string_view session_id) override;
+    void Unregister(std::string_view session_id) override;
+    std::string Lookup(const std::string& session_id) const override;
+    const std::string& self_address() const override { return self_address_; }
+
+private:
+    std::shared_ptr<Table> table_;
+    std::string self_address_;
+};
+
+} // namespace websocket_gateway
+
+#endif // SESSION_DIRECTORY_H
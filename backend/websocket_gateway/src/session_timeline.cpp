@@ -0,0 +1,228 @@
+#include "session_timeline.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <utility>
+
+namespace websocket_gateway {
+
+SessionTimelineStore::SessionTimelineStore(size_t capacity)
+    : capacity_(std::min<size_t>(capacity, kNoSlot)), slots_(new Slot[capacity_]), free_(capacity_) {
+    for (size_t i = 0; i < capacity_; ++i) {
+        free_[i] = static_cast<uint32_t>(i);
+    }
+    free_count_ = capacity_;
+}
+
+uint32_t SessionTimelineStore::Open(std::string_view session_id, uint32_t now_ms) {
+    if (free_count_ == 0) {
+        sessions_not_recorded_.fetch_add(1, std::memory_order_relaxed);
+        return kNoSlot;
+    }
+    const uint32_t index = free_[free_head_];
+    free_head_ = (free_head_ + 1) % capacity_;
+    free_count_--;
+
+    Slot& slot = slots_[index];
+    std::lock_guard<std::mutex> lock(slot.mutex);
+    const size_t length = std::min(session_id.size(), slot.session_id.size());
+    session_id.copy(slot.session_id.data(), length);
+    slot.session_id_length = static_cast<uint8_t>(length);
+    slot.used = true;
+    slot.live = true;
+    slot.opened_ms = now_ms;
+    slot.closed_ms = 0;
+    slot.recorded = 0;
+    slot.audio_in_turn = 0;
+    slot.audio_out_turn = 0;
+    slot.pending_turn = 0;
+    slot.pending_since_ms = 0;
+    slot.worst_turn_ms = 0;
+    slot.worst_turn_id = 0;
+    slot.turns_measured = 0;
+    Append(slot, Event::kOpen, 0, now_ms, 0);
+    return index;
+}
+
+void SessionTimelineStore::Record(uint32_t index, Event event, uint32_t turn_id, uint32_t now_ms, int32_t detail) {
+    if (index >= capacity_) {
+        return;
+    }
+    Slot& slot = slots_[index];
+    std::lock_guard<std::mutex> lock(slot.mutex);
+    switch (event) {
+        case Event::kFirstAudioIn:
+            if (slot.audio_in_turn == turn_id) {
+                return;
+            }
+            slot.audio_in_turn = turn_id;
+            break;
+        case Event::kUtteranceEnded:
+            slot.pending_turn = turn_id;
+            slot.pending_since_ms = now_ms;
+            break;
+        case Event::kSttFinish:
+            // utterance_ended 없이 STT 쪽에서 발화가 끝난 경우 여기서부터 응답 대기
+            if (slot.pending_turn != turn_id && slot.audio_out_turn != turn_id) {
+                slot.pending_turn = turn_id;
+                slot.pending_since_ms = now_ms;
+            }
+            break;
+        case Event::kStartStream:
+            slot.pending_turn = 0; // 이전 턴을 끊고 새 발화 시작 (barge-in): 응답 대기 종료
+            break;
+        case Event::kFirstAudioOut:
+            if (slot.audio_out_turn == turn_id) {
+                return;
+            }
+            slot.audio_out_turn = turn_id;
+            if (slot.pending_turn == turn_id) {
+                const uint32_t latency_ms = now_ms - std::min(now_ms, slot.pending_since_ms);
+                if (latency_ms >= slot.worst_turn_ms) {
+                    slot.worst_turn_ms = latency_ms;
+                    slot.worst_turn_id = turn_id;
+                }
+                slot.turns_measured++;
+                slot.pending_turn = 0;
+            }
+            break;
+        case Event::kLastViseme:
+            if (slot.recorded > 0) {
+                Entry& last = slot.events[(slot.recorded - 1) % kEventsPerSession];
+                if (last.event == Event::kLastViseme && last.turn_id == turn_id) {
+                    last.at_ms = now_ms;
+                    return;
+                }
+            }
+            break;
+        default:
+            break;
+    }
+    Append(slot, event, turn_id, now_ms, detail);
+}
+
+void SessionTimelineStore::Close(uint32_t index, uint32_t now_ms, int32_t code) {
+    if (index >= capacity_) {
+        return;
+    }
+    {
+        Slot& slot = slots_[index];
+        std::lock_guard<std::mutex> lock(slot.mutex);
+        Append(slot, Event::kClose, 0, now_ms, code);
+        slot.live = false;
+        slot.closed_ms = now_ms;
+    }
+    free_[(free_head_ + free_count_) % capacity_] = index;
+    free_count_++;
+}
+
+void SessionTimelineStore::Append(Slot& slot, Event event, uint32_t turn_id, uint32_t now_ms, int32_t detail) {
+    Entry& entry = slot.events[slot.recorded % kEventsPerSession];
+    entry.at_ms = now_ms;
+    entry.turn_id = turn_id;
+    entry.detail = detail;
+    entry.event = event;
+    slot.recorded++;
+}
+
+uint32_t SessionTimelineStore::Score(const Slot& slot, uint32_t now_ms) {
+    uint32_t score = slot.worst_turn_ms;
+    if (slot.pending_turn != 0) {
+        const uint32_t end_ms = slot.live ? now_ms : slot.closed_ms;
+        score = std::max(score, end_ms - std::min(end_ms, slot.pending_since_ms));
+    }
+    return score;
+}
+
+std::string SessionTimelineStore::RenderLocked(const Slot& slot, uint32_t now_ms) {
+    nlohmann::json events = nlohmann::json::array();
+    const uint64_t first = slot.recorded > kEventsPerSession ? slot.recorded - kEventsPerSession : 0;
+    for (uint64_t i = first; i < slot.recorded; ++i) {
+        const Entry& entry = slot.events[i % kEventsPerSession];
+        nlohmann::json item = {
+            {"event", EventName(entry.event)},
+            {"atMs", entry.at_ms},
+            {"sinceOpenMs", entry.at_ms - std::min(entry.at_ms, slot.opened_ms)}
+        };
+        if (entry.turn_id != 0) {
+            item["turnId"] = entry.turn_id;
+        }
+        if (entry.event == Event::kSttFinish || entry.event == Event::kClose) {
+            item["detail"] = entry.detail;
+        }
+        events.push_back(std::move(item));
+    }
+    nlohmann::json session = {
+        {"sessionId", std::string(slot.session_id.data(), slot.session_id_length)},
+        {"live", slot.live},
+        {"openedAtMs", slot.opened_ms},
+        {"turnsMeasured", slot.turns_measured},
+        {"worstTurnMs", slot.worst_turn_ms},
+        {"worstTurnId", slot.worst_turn_id},
+        {"slowScoreMs", Score(slot, now_ms)},
+        {"eventsDropped", first},
+        {"events", std::move(events)}
+    };
+    if (!slot.live) {
+        session["closedAtMs"] = slot.closed_ms;
+    }
+    if (slot.pending_turn != 0) {
+        session["awaitingResponseTurnId"] = slot.pending_turn;
+    }
+    return session.dump();
+}
+
+std::string SessionTimelineStore::RenderSession(std::string_view session_id, uint32_t now_ms) const {
+    // 같은 ID가 닫힌 뒤 재사용될 일은 없으므로 첫 일치가 유일한 기록
+    for (size_t i = 0; i < capacity_; ++i) {
+        const Slot& slot = slots_[i];
+        std::lock_guard<std::mutex> lock(slot.mutex);
+        if (slot.used && std::string_view(slot.session_id.data(), slot.session_id_length) == session_id) {
+            return RenderLocked(slot, now_ms);
+        }
+    }
+    return "";
+}
+
+std::string SessionTimelineStore::RenderSlowest(size_t n, uint32_t now_ms) const {
+    std::vector<std::pair<uint32_t, size_t>> scored; // (score, slot)
+    for (size_t i = 0; i < capacity_; ++i) {
+        const Slot& slot = slots_[i];
+        std::lock_guard<std::mutex> lock(slot.mutex);
+        if (slot.used) {
+            scored.emplace_back(Score(slot, now_ms), i);
+        }
+    }
+    n = std::min(n, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + static_cast<std::ptrdiff_t>(n), scored.end(),
+                      [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    std::string out = "{\"nowMs\":" + std::to_string(now_ms) + ",\"sessions\":[";
+    for (size_t i = 0; i < n; ++i) {
+        const Slot& slot = slots_[scored[i].second];
+        std::lock_guard<std::mutex> lock(slot.mutex);
+        if (i > 0) {
+            out += ',';
+        }
+        out += RenderLocked(slot, now_ms); // 점수를 매긴 뒤 슬롯이 재사용됐을 수 있지만 디버그 용도로는 무방
+    }
+    out += "]}";
+    return out;
+}
+
+const char* SessionTimelineStore::EventName(Event event) {
+    switch (event) {
+        case Event::kOpen: return "open";
+        case Event::kStartStream: return "start_stream";
+        case Event::kAdmissionQueued: return "admission_queued";
+        case Event::kFirstAudioIn: return "first_audio_in";
+        case Event::kUtteranceEnded: return "utterance_ended";
+        case Event::kSttFinish: return "stt_finish";
+        case Event::kFirstAudioOut: return "first_audio_out";
+        case Event::kLastViseme: return "last_viseme";
+        case Event::kTurnTimeout: return "turn_timeout";
+        case Event::kClose: return "close";
+    }
+    return "unknown";
+}
+
+} // namespace websocket_gateway
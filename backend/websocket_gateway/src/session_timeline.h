@@ -0,0 +1,104 @@
+#ifndef SESSION_TIMELINE_H
+#define SESSION_TIMELINE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace websocket_gateway {
+
+// 세션별 디버그 타임라인. "이 턴이 왜 느렸나"를 로그 없이 재구성하기 위해 세션마다 고정 크기 이벤트 링을 둔다.
+// 슬롯은 생성 시 모두 할당되며, 종료된 세션의 슬롯은 가장 오래전에 닫힌 것부터 재사용되므로
+// 최근에 끝난 세션도 조회할 수 있다.
+// Open/Record/Close는 uWS 루프 스레드 전용이며 할당하지 않는다. Render*는 메트릭 스레드에서 호출되며
+// 슬롯 단위 mutex로 기록과 직렬화한다 (경합은 조회 순간에만 발생).
+class SessionTimelineStore {
+public:
+    static constexpr uint32_t kNoSlot = std::numeric_limits<uint32_t>::max();
+    static constexpr size_t kEventsPerSession = 64; // 넘치면 가장 오래된 이벤트부터 덮어씀
+
+    enum class Event : uint8_t {
+        kOpen,
+        kStartStream,
+        kAdmissionQueued,
+        kFirstAudioIn,      // 턴의 첫 업링크 오디오 (턴당 한 번)
+        kUtteranceEnded,
+        kSttFinish,         // detail = gRPC status code
+        kFirstAudioOut,     // 턴의 첫 TTS 오디오 전송 (턴당 한 번)
+        kLastViseme,        // 같은 턴의 연속 viseme은 마지막 시각으로 갱신
+        kTurnTimeout,
+        kClose,             // detail = WebSocket close code
+    };
+
+    struct Entry {
+        uint32_t at_ms = 0;   // 서버 타임라인 ms
+        uint32_t turn_id = 0;
+        int32_t detail = 0;
+        Event event = Event::kOpen;
+    };
+
+    explicit SessionTimelineStore(size_t capacity);
+
+    SessionTimelineStore(const SessionTimelineStore&) = delete;
+    SessionTimelineStore& operator=(const SessionTimelineStore&) = delete;
+
+    // 세션에 슬롯 배정 후 kOpen 기록. 살아 있는 세션이 capacity만큼 있으면 kNoSlot (기록 생략, sessions_not_recorded 증가)
+    uint32_t Open(std::string_view session_id, uint32_t now_ms);
+    void Record(uint32_t slot, Event event, uint32_t turn_id, uint32_t now_ms, int32_t detail = 0);
+    // kClose 기록 후 슬롯을 재사용 대기열 끝으로 (내용은 재사용될 때까지 조회 가능)
+    void Close(uint32_t slot, uint32_t now_ms, int32_t code);
+
+    // JSON. 모르는 세션이면 빈 문자열
+    std::string RenderSession(std::string_view session_id, uint32_t now_ms) const;
+    // 턴 지연(utterance_ended 또는 STT 종료 → 첫 TTS 오디오)이 가장 큰 세션 n개. 응답을 아직 못 받은 턴은 지금까지의 대기 시간으로 셈
+    std::string RenderSlowest(size_t n, uint32_t now_ms) const;
+
+    static const char* EventName(Event event);
+    size_t capacity() const { return capacity_; }
+    uint64_t sessions_not_recorded() const { return sessions_not_recorded_.load(std::memory_order_relaxed); } // 메트릭 스레드에서 읽음
+
+private:
+    struct Slot {
+        mutable std::mutex mutex;
+        std::array<char, 32> session_id{};
+        uint8_t session_id_length = 0;
+        bool used = false;
+        bool live = false;
+        uint32_t opened_ms = 0;
+        uint32_t closed_ms = 0;
+        uint64_t recorded = 0; // 누적 기록 수 (링 위치 = recorded % kEventsPerSession)
+        std::array<Entry, kEventsPerSession> events;
+
+        // 턴 지연 추적
+        uint32_t audio_in_turn = 0;
+        uint32_t audio_out_turn = 0;
+        uint32_t pending_turn = 0;   // 기준 시각이 잡혔지만 아직 첫 오디오가 나가지 않은 턴 (0 = 없음)
+        uint32_t pending_since_ms = 0;
+        uint32_t worst_turn_ms = 0;
+        uint32_t worst_turn_id = 0;
+        uint32_t turns_measured = 0;
+    };
+
+    static void Append(Slot& slot, Event event, uint32_t turn_id, uint32_t now_ms, int32_t detail);
+    static uint32_t Score(const Slot& slot, uint32_t now_ms); // slot.mutex 보유 상태에서 호출
+    static std::string RenderLocked(const Slot& slot, uint32_t now_ms); // JSON 객체 하나
+
+    size_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+    // 재사용 가능한 슬롯의 FIFO 링 (루프 스레드 전용). 처음엔 전부, 이후엔 닫힌 순서대로
+    std::vector<uint32_t> free_;
+    size_t free_head_ = 0;
+    size_t free_count_ = 0;
+    std::atomic<uint64_t> sessions_not_recorded_{0};
+};
+
+} // namespace websocket_gateway
+
+#endif // SESSION_TIMELINE_H
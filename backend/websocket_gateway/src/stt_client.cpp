@@ -5,6 +5,7 @@
 #include "google/protobuf/empty.pb.h" 
 #include "stt.pb.h" 
 #include <string_view> 
+#include <algorithm>
 
 namespace websocket_gateway { 
 
@@ -40,15 +41,26 @@ STTClient::STTClient(const std::string& target_address) : target_address_(target
 
 STTClient::~STTClient() {
     std::cout << "STTClient destructor called for FE_SID [" << frontend_session_id_ << "]." << std::endl;
-    if (stream_active_.load()) {
-        std::cout << "   STTClient: Stream was active during destruction. Attempting to stop (TryCancel) for FE_SID [" << frontend_session_id_ << "]." << std::endl;
-        StopStreamNow(); 
+    std::vector<std::shared_ptr<TurnStream>> streams;
+    {
+        std::lock_guard<std::mutex> lock(stream_mutex_);
+        if (current_) {
+            std::cout << "   STTClient: Stream was active during destruction. Attempting to stop (TryCancel) for FE_SID [" << frontend_session_id_ << "]." << std::endl;
+            current_->context.TryCancel();
+            current_.reset(); // 완료 스레드 없음: 콜백 없이 버림
+            stream_active_.store(false);
+        }
+        streams.swap(finishing_);
     }
-    if (completion_thread_.joinable()) {
-        std::cout << "   STTClient: Joining completion thread for FE_SID [" << frontend_session_id_ << "] in destructor..." << std::endl;
+    for (auto& stream : streams) {
+        stream->context.TryCancel(); // Finish가 바로 반환되도록
+    }
+    if (!streams.empty()) {
+        std::cout << "   STTClient: Joining " << streams.size() << " completion thread(s) for FE_SID [" << frontend_session_id_ << "] in destructor..." << std::endl;
+    }
+    for (auto& stream : streams) {
         try {
-            completion_thread_.join(); 
-            std::cout << "   STTClient: Completion thread joined successfully for FE_SID [" << frontend_session_id_ << "]." << std::endl;
+            stream->completion_thread.join();
         } catch (const std::system_error& e) {
             std::cerr << "   STTClient: Exception caught while joining completion thread for FE_SID [" << frontend_session_id_ << "]: " << e.what() << std::endl;
         }
@@ -59,68 +71,60 @@ STTClient::~STTClient() {
 bool STTClient::StartStream(const stt::RecognitionConfig& config, StatusCallback on_finish) {
     std::lock_guard<std::mutex> lock(stream_mutex_); 
 
-    bool expected_stream_active = false;
-    if (!stream_active_.compare_exchange_strong(expected_stream_active, true)) {
+    if (current_) {
         std::cerr << "STTClient: Stream already active for FE_SID [" << config.frontend_session_id() 
-                  << "]. Current FE_SID in client: [" << frontend_session_id_ << "]." << std::endl;
+                  << "] (turn " << current_->turn_id << "). Current FE_SID in client: [" << frontend_session_id_ << "]." << std::endl;
         if (on_finish) {
             on_finish(grpc::Status(grpc::StatusCode::FAILED_PRECONDITION, "Stream already active with FE_SID: " + frontend_session_id_));
         }
-        stream_active_.store(true); 
         return false; 
     }
 
-    frontend_session_id_ = config.frontend_session_id(); 
-    if (frontend_session_id_.empty()){
+    if (config.frontend_session_id().empty()){
         std::cerr << "STTClient: CRITICAL - frontend_session_id is empty in RecognitionConfig. Cannot start stream." << std::endl;
-        stream_active_.store(false); 
         if(on_finish) {
             on_finish(grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, "frontend_session_id cannot be empty"));
         }
         return false;
     }
+    frontend_session_id_ = config.frontend_session_id(); 
 
-    if (completion_thread_.joinable()) {
-        std::cout << "STTClient: [" << frontend_session_id_ << "] Previous completion thread is joinable. Joining before starting new stream..." << std::endl;
-        completion_thread_.join();
-        std::cout << "STTClient: [" << frontend_session_id_ << "] Previous completion thread joined." << std::endl;
-    }
+    // 이전 턴은 기다리지 않음: 이미 끝난 마무리 스레드만 정리
+    ReapCompletedLocked();
 
-    context_ = std::make_unique<grpc::ClientContext>();
-    std::cout << "STTClient: [" << frontend_session_id_ << "] Attempting to start gRPC stream to STTService." << std::endl;
-    writer_ = stub_->RecognizeStream(context_.get(), &response_placeholder_);
+    auto stream = std::make_shared<TurnStream>();
+    stream->frontend_session_id = frontend_session_id_;
+    stream->turn_id = config.turn_id();
+    std::cout << "STTClient: [" << frontend_session_id_ << "] Attempting to start gRPC stream to STTService (turn " << stream->turn_id
+              << ", " << finishing_.size() << " previous turn(s) still finishing)." << std::endl;
+    stream->writer = stub_->RecognizeStream(&stream->context, &stream->response_placeholder);
 
-    if (!writer_) {
+    if (!stream->writer) {
         std::cerr << "STTClient: [" << frontend_session_id_ << "] ❌ FAILED to start gRPC stream (stub_->RecognizeStream returned nullptr)." << std::endl;
         if (on_finish) {
             on_finish(grpc::Status(grpc::StatusCode::INTERNAL, "Failed to initialize stream with STTService (writer is null)"));
         }
-        stream_active_.store(false); 
-        frontend_session_id_.clear(); 
-        context_.reset(); 
         return false;
     }
     
-    status_callback_ = std::move(on_finish);
+    stream->status_callback = std::move(on_finish);
 
     stt::STTStreamRequest init_request;
     init_request.mutable_config()->CopyFrom(config); 
 
     std::cout << "STTClient: [" << frontend_session_id_ << "] Sending RecognitionConfig to STTService: " << init_request.ShortDebugString() << std::endl; 
 
-    if (!writer_->Write(init_request)) {
+    if (!stream->writer->Write(init_request)) {
         std::cerr << "STTClient: [" << frontend_session_id_ << "] ❌ FAILED to write initial RecognitionConfig to gRPC stream." << std::endl;
-        grpc::Status status = writer_->Finish(); 
-        if (status_callback_) {
-            status_callback_(status); 
+        grpc::Status status = stream->writer->Finish(); 
+        if (stream->status_callback) {
+            stream->status_callback(status); 
         }
-        stream_active_.store(false);
-        frontend_session_id_.clear();
-        writer_.reset(); 
-        context_.reset(); 
         return false;
     }
 
+    current_ = std::move(stream);
+    stream_active_.store(true);
     std::cout << "STTClient: [" << frontend_session_id_ << "] ✅ Successfully started stream and sent RecognitionConfig." << std::endl;
     return true;
 }
@@ -131,151 +135,129 @@ bool STTClient::WriteAudioChunk(const std::string& audio_data_chunk) {
     }
 
     std::lock_guard<std::mutex> lock(stream_mutex_); 
-    if (!stream_active_.load() || !writer_) { 
+    if (!current_) { 
         return false;
     }
 
     stt::STTStreamRequest request;
     request.set_audio_chunk(audio_data_chunk);
     
-    if (writer_->Write(request)) {
+    if (current_->writer->Write(request)) {
         return true;
     }
     
     // grpc::ClientContext에는 IsCancelled() 멤버가 없습니다.
     // 취소 여부는 스트림 작업의 반환값이나 Finish()의 상태 코드로 확인해야 합니다.
-    // 여기서는 단순히 context_가 null인지 여부만 로깅합니다.
-    std::cerr << "STTClient: [" << frontend_session_id_ << "] ❌ FAILED to write audio chunk. Stream might be broken. Context is "
-              << (context_ ? "not null" : "null") << std::endl;
+    std::cerr << "STTClient: [" << frontend_session_id_ << "] ❌ FAILED to write audio chunk (turn " << current_->turn_id
+              << "). Stream might be broken." << std::endl;
     
     return false;
 }
 
 void STTClient::WritesDoneAndFinish() {
-    std::unique_lock<std::mutex> lock(stream_mutex_); 
-    if (!stream_active_.load()) { 
+    std::lock_guard<std::mutex> lock(stream_mutex_); 
+    if (!current_) { 
         std::cout << "STTClient: [" << frontend_session_id_ << "] WritesDoneAndFinish called but stream is not active. No action." << std::endl;
         return; 
     }
-    
-    if (completion_thread_.joinable()) {
-        lock.unlock(); 
-        std::cout << "STTClient: [" << frontend_session_id_ << "] Previous completion thread is joinable. Joining before starting new one..." << std::endl;
-        completion_thread_.join();
-        std::cout << "STTClient: [" << frontend_session_id_ << "] Previous completion thread joined." << std::endl;
-        lock.lock(); 
-    }
-    
-    if (!writer_) {
-        std::cerr << "STTClient: [" << frontend_session_id_ << "] WritesDoneAndFinish: writer_ is null. Cannot start completion task." << std::endl;
-        stream_active_.store(false); 
-        if(status_callback_) {
-            status_callback_(grpc::Status(grpc::StatusCode::INTERNAL, "Writer became null before WritesDoneAndFinish."));
-        }
-        return;
-    }
-
-    std::cout << "STTClient: [" << frontend_session_id_ << "] Scheduling WritesDone and Finish in a new thread." << std::endl;
-    completion_thread_ = std::thread(&STTClient::StreamCompletionTask, this);
+    std::cout << "STTClient: [" << frontend_session_id_ << "] Scheduling WritesDone and Finish for turn " << current_->turn_id << " in a new thread." << std::endl;
+    BeginFinishLocked();
 }
 
-void STTClient::StreamCompletionTask() {
-    std::string current_fe_sid;
-    StatusCallback local_status_callback;
-    std::unique_ptr<grpc::ClientWriter<stt::STTStreamRequest>> local_writer; 
-    std::unique_ptr<grpc::ClientContext> local_context; 
+void STTClient::BeginFinishLocked() {
+    ReapCompletedLocked();
+    if (finishing_.size() >= kMaxFinishingTurns) {
+        // 가장 오래된 턴은 이미 새 발화에 밀린 응답: 취소해서 RPC/스레드를 돌려받음
+        std::cout << "STTClient: [" << frontend_session_id_ << "] " << finishing_.size() << " turns already finishing. Cancelling turn "
+                  << finishing_.front()->turn_id << "." << std::endl;
+        finishing_.front()->context.TryCancel();
+    }
+    std::shared_ptr<TurnStream> stream = std::move(current_);
+    stream_active_.store(false);
+    // 스레드가 시작되기 전에 목록에 넣어야 소멸자가 항상 join할 수 있음
+    finishing_.push_back(stream);
+    stream->completion_thread = std::thread(&STTClient::StreamCompletionTask, this, stream);
+}
 
-    { 
-        std::lock_guard<std::mutex> lock(stream_mutex_);
-        if (!writer_ || !context_) { 
-             std::cerr << "STTClient: [" << (frontend_session_id_.empty() ? "NO_FE_SID" : frontend_session_id_) 
-                       << "] Writer or Context is null in StreamCompletionTask before moving. Cannot proceed." << std::endl;
-             if (status_callback_) {
-                 status_callback_(grpc::Status(grpc::StatusCode::INTERNAL, "Writer or Context is null in completion task. FE_SID [" + frontend_session_id_ + "]"));
-             }
-             stream_active_.store(false); 
-             writer_.reset(); 
-             context_.reset();
-             return;
-        }
-        current_fe_sid = frontend_session_id_; 
-        local_status_callback = status_callback_;
-        local_writer = std::move(writer_); 
-        local_context = std::move(context_); 
+void STTClient::ReapCompletedLocked() {
+    auto done = std::stable_partition(finishing_.begin(), finishing_.end(),
+                                      [](const std::shared_ptr<TurnStream>& stream) { return !stream->completed.load(); });
+    for (auto it = done; it != finishing_.end(); ++it) {
+        (*it)->completion_thread.join(); // completed 이후에는 스레드가 곧바로 끝남
     }
+    finishing_.erase(done, finishing_.end());
+}
 
-    std::cout << "STTClient: [" << current_fe_sid << "] StreamCompletionTask started." << std::endl;
+void STTClient::StreamCompletionTask(std::shared_ptr<TurnStream> stream) {
+    const std::string& current_fe_sid = stream->frontend_session_id;
+    std::cout << "STTClient: [" << current_fe_sid << "] StreamCompletionTask started (turn " << stream->turn_id << ")." << std::endl;
 
-    bool ws_done_success = false;
     grpc::Status status = grpc::Status::OK;
-    
-    if (local_writer) { 
-        // local_context->IsCancelled() 호출 제거
-        // 취소 여부는 Finish()의 상태 코드로 판단합니다.
-        ws_done_success = local_writer->WritesDone(); 
-        if (!ws_done_success) {
-            std::cerr << "STTClient: [" << current_fe_sid << "] WritesDone failed on client side. Stream might be broken." << std::endl;
-            // WritesDone 실패 시에도 Finish()는 호출하여 서버로부터 상태를 받아야 할 수 있습니다.
-        } else {
-            std::cout << "STTClient: [" << current_fe_sid << "] WritesDone successful." << std::endl;
-        }
+    // 취소 여부는 Finish()의 상태 코드로 판단합니다.
+    if (!stream->writer->WritesDone()) {
+        std::cerr << "STTClient: [" << current_fe_sid << "] WritesDone failed on client side. Stream might be broken." << std::endl;
+        // WritesDone 실패 시에도 Finish()는 호출하여 서버로부터 상태를 받아야 할 수 있습니다.
+    } else {
+        std::cout << "STTClient: [" << current_fe_sid << "] WritesDone successful." << std::endl;
+    }
+
+    try {
+        status = stream->writer->Finish(); 
+    } catch (const std::exception& e) {
+        std::cerr << "STTClient: [" << current_fe_sid << "] Exception during writer->Finish(): " << e.what() << std::endl;
+        status = grpc::Status(grpc::StatusCode::INTERNAL, "Exception during writer->Finish(): " + std::string(e.what()));
+    } catch (...) {
+        std::cerr << "STTClient: [" << current_fe_sid << "] Unknown exception during writer->Finish()." << std::endl;
+        status = grpc::Status(grpc::StatusCode::UNKNOWN, "Unknown exception during writer->Finish()");
+    }
 
+    if (stream->status_callback) { 
         try {
-            status = local_writer->Finish(); 
+            stream->status_callback(status); 
         } catch (const std::exception& e) {
-            std::cerr << "STTClient: [" << current_fe_sid << "] Exception during local_writer->Finish(): " << e.what() << std::endl;
-            status = grpc::Status(grpc::StatusCode::INTERNAL, "Exception during writer->Finish(): " + std::string(e.what()));
+            std::cerr << "STTClient: [" << current_fe_sid << "] Exception in status_callback_: " << e.what() << std::endl;
         } catch (...) {
-            std::cerr << "STTClient: [" << current_fe_sid << "] Unknown exception during local_writer->Finish()." << std::endl;
-            status = grpc::Status(grpc::StatusCode::UNKNOWN, "Unknown exception during writer->Finish()");
-        }
-    } else { 
-         std::cerr << "STTClient: [" << current_fe_sid << "] CRITICAL: local_writer is null in completion task after move." << std::endl;
-         status = grpc::Status(grpc::StatusCode::INTERNAL, "local_writer became null unexpectedly in completion task.");
-    }
-    
-    {
-        std::lock_guard<std::mutex> lock(stream_mutex_);
-        stream_active_.store(false); 
-
-        if (local_status_callback) { 
-            try {
-                local_status_callback(status); 
-            } catch (const std::exception& e) {
-                std::cerr << "STTClient: [" << current_fe_sid << "] Exception in status_callback_: " << e.what() << std::endl;
-            } catch (...) {
-                std::cerr << "STTClient: [" << current_fe_sid << "] Unknown exception in status_callback_." << std::endl;
-            }
+            std::cerr << "STTClient: [" << current_fe_sid << "] Unknown exception in status_callback_." << std::endl;
         }
     }
-    std::cout << "STTClient: [" << current_fe_sid << "] Stream completion task finished with status: (" 
+    std::cout << "STTClient: [" << current_fe_sid << "] Stream completion task finished for turn " << stream->turn_id << " with status: (" 
               << status.error_code() << ") " << svToString(status.error_message()) << std::endl;
+    stream->completed.store(true);
 }
 
 void STTClient::StopStreamNow() {
-    std::unique_lock<std::mutex> lock(stream_mutex_); 
-    std::string current_fe_sid = frontend_session_id_; 
-    
-    if (!stream_active_.load() && !context_ && !writer_) {
+    std::lock_guard<std::mutex> lock(stream_mutex_); 
+    if (!current_) {
         return;
     }
+    std::cout << "STTClient: [" << frontend_session_id_ << "] StopStreamNow requested for turn " << current_->turn_id
+              << ". Attempting to cancel gRPC context (TryCancel)." << std::endl;
+    current_->context.TryCancel(); 
+    // 취소된 스트림도 Finish로 상태(CANCELLED)를 받아 on_finish를 호출 (호출자의 턴 정리가 항상 이루어지도록)
+    BeginFinishLocked();
+    std::cout << "STTClient: [" << frontend_session_id_ << "] StopStreamNow processing finished." << std::endl;
+}
 
-    std::cout << "STTClient: [" << current_fe_sid << "] StopStreamNow requested. Current active state: " << stream_active_.load() << std::endl;
-
-    if (context_) {
-        std::cout << "STTClient: [" << current_fe_sid << "] Attempting to cancel gRPC context (TryCancel)." << std::endl;
-        context_->TryCancel(); 
+bool STTClient::IsStreamActive() const {
+    std::lock_guard<std::mutex> lock(stream_mutex_);
+    if (current_) {
+        return true;
     }
-    
-    if (stream_active_.exchange(false)) { 
-        std::cout << "STTClient: [" << current_fe_sid << "] Stream marked as inactive due to StopStreamNow." << std::endl;
-        writer_.reset(); // Writer도 정리
+    for (const auto& stream : finishing_) {
+        if (!stream->completed.load()) {
+            return true;
+        }
     }
-    std::cout << "STTClient: [" << current_fe_sid << "] StopStreamNow processing finished." << std::endl;
+    return false;
 }
 
-bool STTClient::IsStreamActive() const {
-    return stream_active_.load();
+size_t STTClient::finishing_turns() const {
+    std::lock_guard<std::mutex> lock(stream_mutex_);
+    size_t count = 0;
+    for (const auto& stream : finishing_) {
+        count += stream->completed.load() ? 0 : 1;
+    }
+    return count;
 }
 
 } // namespace websocket_gateway
@@ -9,43 +9,80 @@
 #include <atomic>
 #include <memory>       
 #include <mutex>      
+#include <vector>
 
 namespace websocket_gateway { 
 
-class STTClient {
+// 세션당 STT 스트림 클라이언트 인터페이스.
+// 기본 구현은 stt_service로 gRPC 스트리밍하는 STTClient이며,
+// 벤치마크용 LoopbackSTTClient(loopback_stt_client.h)가 프로세스 내에서 응답을 흉내낸다.
+// 스트림 하나 = 발화(턴) 하나. 오디오를 받는 턴은 하나뿐이지만, WritesDoneAndFinish 이후 이전 턴이 LLM/TTS를
+// 마무리하는 동안 다음 턴의 StartStream을 바로 시작할 수 있다 (on_finish는 턴마다 한 번).
+class STTStreamClient {
 public:
     using StatusCallback = std::function<void(const grpc::Status& status)>;
 
+    virtual ~STTStreamClient() = default;
+
+    // 새 턴 시작. 오디오를 받는 중인 턴이 있으면 실패 (호출자가 먼저 StopStreamNow 또는 WritesDoneAndFinish)
+    virtual bool StartStream(const stt::RecognitionConfig& config, StatusCallback on_finish) = 0;
+    virtual bool WriteAudioChunk(const std::string& audio_data_chunk) = 0;
+    // 현재 턴의 오디오 입력 종료. 턴 마무리는 뒤에서 진행되고 끝나면 on_finish 호출
+    virtual void WritesDoneAndFinish() = 0;
+    // 오디오를 받는 중인 턴 취소 (on_finish는 CANCELLED로 호출됨)
+    virtual void StopStreamNow() = 0;
+    // 오디오를 받는 턴 또는 마무리 중인 이전 턴이 있음
+    virtual bool IsStreamActive() const = 0;
+};
+
+class STTClient : public STTStreamClient {
+public:
+    // 마무리 중인 이전 턴 수 한도. 넘으면 가장 오래된 턴을 취소 (사용자가 연달아 말해도 RPC/스레드가 쌓이지 않도록)
+    static constexpr size_t kMaxFinishingTurns = 4;
+
     explicit STTClient(const std::string& target_address);
-    ~STTClient();
+    ~STTClient() override; // 모든 턴을 취소하고 마무리 스레드를 join
 
     STTClient(const STTClient&) = delete;
     STTClient& operator=(const STTClient&) = delete;
     STTClient(STTClient&&) = delete;
     STTClient& operator=(STTClient&&) = delete;
 
-    bool StartStream(const stt::RecognitionConfig& config, StatusCallback on_finish);
-    bool WriteAudioChunk(const std::string& audio_data_chunk); 
-    void WritesDoneAndFinish(); 
-    void StopStreamNow(); // gRPC 스트림 즉시 중단 시도
-    bool IsStreamActive() const; 
+    bool StartStream(const stt::RecognitionConfig& config, StatusCallback on_finish) override;
+    bool WriteAudioChunk(const std::string& audio_data_chunk) override; 
+    void WritesDoneAndFinish() override; 
+    void StopStreamNow() override; // gRPC 스트림 즉시 중단 시도
+    bool IsStreamActive() const override; 
+
+    size_t finishing_turns() const;
 
 private:
+    // RecognizeStream 하나 (턴 하나)
+    struct TurnStream {
+        std::string frontend_session_id;
+        uint64_t turn_id = 0;
+        grpc::ClientContext context;
+        std::unique_ptr<grpc::ClientWriter<stt::STTStreamRequest>> writer;
+        google::protobuf::Empty response_placeholder;
+        StatusCallback status_callback;
+        std::thread completion_thread;
+        std::atomic<bool> completed{false}; // 완료 작업이 끝나 join이 즉시 반환됨
+    };
+
+    // 현재 턴을 마무리 목록으로 옮기고 WritesDone + Finish를 별도 스레드에서 시작
+    void BeginFinishLocked();
+    void ReapCompletedLocked(); // 끝난 마무리 스레드 join
+    void StreamCompletionTask(std::shared_ptr<TurnStream> stream);
+
     std::string target_address_; 
     std::string frontend_session_id_; 
 
     std::shared_ptr<grpc::Channel> channel_;
     std::unique_ptr<stt::STTService::Stub> stub_;
 
-    std::unique_ptr<grpc::ClientContext> context_;
-    std::unique_ptr<grpc::ClientWriter<stt::STTStreamRequest>> writer_;
-    google::protobuf::Empty response_placeholder_; 
-
-    std::atomic<bool> stream_active_{false};
-    StatusCallback status_callback_;
-    
-    std::thread completion_thread_;
-    void StreamCompletionTask(); 
+    std::shared_ptr<TurnStream> current_;                 // stream_mutex_: 오디오를 받는 턴 (nullptr = 없음)
+    std::vector<std::shared_ptr<TurnStream>> finishing_;  // stream_mutex_: WritesDone 후 응답을 기다리는 이전 턴들
+    std::atomic<bool> stream_active_{false};              // current_ != nullptr (잠금 없이 확인용)
 
     mutable std::mutex stream_mutex_; 
 };
@@ -0,0 +1,96 @@
+#include "timer_wheel.h"
+#include <stdexcept>
+
+namespace websocket_gateway {
+
+TimerWheel::TimerWheel(std::chrono::milliseconds tick, Clock::time_point start)
+    : tick_(tick), start_(start) {
+    if (tick_.count() <= 0) {
+        throw std::runtime_error("TimerWheel tick must be positive.");
+    }
+}
+
+TimerWheel::TimerId TimerWheel::Schedule(std::chrono::milliseconds delay, Callback cb) {
+    uint64_t ticks = delay.count() <= 0 ? 1 : static_cast<uint64_t>((delay.count() + tick_.count() - 1) / tick_.count());
+    if (ticks == 0) ticks = 1;
+    if (ticks > kMaxTicks) ticks = kMaxTicks;
+
+    TimerId id;
+    do {
+        id = next_id_++;
+    } while (id == 0 || index_.count(id) != 0); // 32비트가 한 바퀴 돈 경우 (0과 아직 살아 있는 ID는 재사용하지 않음)
+    insert(Entry{id, current_tick_ + ticks, std::move(cb)});
+    return id;
+}
+
+bool TimerWheel::Cancel(TimerId id) {
+    auto it = index_.find(id);
+    if (it == index_.end()) {
+        return false;
+    }
+    const Location& loc = it->second;
+    wheels_[loc.level][loc.slot].erase(loc.it);
+    index_.erase(it);
+    return true;
+}
+
+size_t TimerWheel::Advance(Clock::time_point now) {
+    if (now <= start_) return 0;
+    const uint64_t target_tick = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - start_).count() / tick_.count());
+
+    size_t fired = 0;
+    while (current_tick_ < target_tick) {
+        current_tick_++;
+        // 하위 레벨이 한 바퀴 돌 때마다 상위 레벨의 해당 슬롯을 한 단계 아래로 재분배
+        for (size_t level = 1; level < kLevels; ++level) {
+            if ((current_tick_ & ((uint64_t{1} << (kSlotBits * level)) - 1)) != 0) break;
+            cascade(level);
+        }
+        fired += fire_current_slot();
+    }
+    return fired;
+}
+
+void TimerWheel::insert(Entry&& entry) {
+    const uint64_t delta = entry.expiry_tick - current_tick_;
+    size_t level = 0;
+    while (level + 1 < kLevels && delta >= (uint64_t{1} << (kSlotBits * (level + 1)))) {
+        level++;
+    }
+    const size_t slot = static_cast<size_t>((entry.expiry_tick >> (kSlotBits * level)) & (kSlots - 1));
+
+    const TimerId id = entry.id;
+    Slot& bucket = wheels_[level][slot];
+    bucket.push_back(std::move(entry));
+    index_[id] = Location{level, slot, std::prev(bucket.end())};
+}
+
+void TimerWheel::cascade(size_t level) {
+    const size_t slot = static_cast<size_t>((current_tick_ >> (kSlotBits * level)) & (kSlots - 1));
+    Slot pending;
+    pending.swap(wheels_[level][slot]);
+    while (!pending.empty()) {
+        Entry entry = std::move(pending.front());
+        pending.pop_front();
+        insert(std::move(entry)); // index_ 항목은 새 위치로 덮어씀
+    }
+}
+
+size_t TimerWheel::fire_current_slot() {
+    Slot& bucket = wheels_[0][current_tick_ & (kSlots - 1)];
+    size_t fired = 0;
+    // 콜백이 같은 슬롯의 다른 타이머를 취소할 수 있으므로 하나씩 꺼내서 실행
+    while (!bucket.empty()) {
+        Entry entry = std::move(bucket.front());
+        bucket.pop_front();
+        index_.erase(entry.id);
+        if (entry.cb) {
+            entry.cb();
+        }
+        fired++;
+    }
+    return fired;
+}
+
+} // namespace websocket_gateway
@@ -0,0 +1,73 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+
+namespace websocket_gateway {
+
+// 계층형 타이머 휠 (64 슬롯 x 4 레벨).
+// 세션 유휴/STT 비활성/턴 데드라인처럼 대부분 취소되거나 한참 뒤에 만료되는 타이머를
+// 세션 수와 무관하게 O(1)로 등록/취소하기 위한 용도. uWS 루프 스레드 전용 (스레드 안전하지 않음).
+class TimerWheel {
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void()>;
+    using TimerId = uint32_t; // 0은 "타이머 없음". PerSocketData에 들어가므로 32비트 (한 바퀴 돌면 사용 중인 ID는 건너뜀)
+
+    explicit TimerWheel(std::chrono::milliseconds tick = std::chrono::milliseconds(100),
+                        Clock::time_point start = Clock::now());
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    // delay 후 cb 실행 (틱 단위로 올림, 최소 1틱). 최대 범위를 넘는 delay는 최대값으로 잘림
+    TimerId Schedule(std::chrono::milliseconds delay, Callback cb);
+    bool Cancel(TimerId id);
+
+    // now까지 경과한 틱을 처리하며 만료된 타이머 실행. 실행된 개수 반환.
+    // 콜백 안에서 Schedule/Cancel 호출 가능.
+    size_t Advance(Clock::time_point now);
+
+    size_t size() const { return index_.size(); }
+    std::chrono::milliseconds tick() const { return tick_; }
+
+private:
+    static constexpr unsigned kSlotBits = 6;
+    static constexpr size_t kSlots = size_t{1} << kSlotBits;
+    static constexpr size_t kLevels = 4;
+    static constexpr uint64_t kMaxTicks = (uint64_t{1} << (kSlotBits * kLevels)) - 1;
+
+    struct Entry {
+        TimerId id;
+        uint64_t expiry_tick;
+        Callback cb;
+    };
+    using Slot = std::list<Entry>;
+
+    struct Location {
+        size_t level;
+        size_t slot;
+        Slot::iterator it;
+    };
+
+    void insert(Entry&& entry);
+    void cascade(size_t level);
+    size_t fire_current_slot();
+
+    std::chrono::milliseconds tick_;
+    Clock::time_point start_;
+    uint64_t current_tick_ = 0;
+    TimerId next_id_ = 1;
+
+    std::array<std::array<Slot, kSlots>, kLevels> wheels_;
+    std::unordered_map<TimerId, Location> index_;
+};
+
+} // namespace websocket_gateway
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,128 @@
+#include "traffic_tap.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+namespace websocket_gateway {
+
+TrafficTap::TrafficTap(const TrafficTapConfig& config)
+    : config_(config),
+      sample_threshold_(static_cast<uint64_t>(std::min(1.0, std::max(0.0, config.sample_rate)) * 65536.0)),
+      start_(std::chrono::steady_clock::now()),
+      queue_(config.queue_capacity) {
+    std::error_code ec;
+    std::filesystem::create_directories(config_.output_dir, ec);
+    if (ec) {
+        throw std::runtime_error("Cannot create traffic tap directory " + config_.output_dir + ": " + ec.message());
+    }
+    OpenNextFile();
+    writer_ = std::thread(&TrafficTap::WriterLoop, this);
+    std::cout << "TrafficTap: sampling " << config_.sample_rate * 100 << "% of sessions to " << current_file_
+              << (config_.capture_audio ? " (with audio)" : " (sizes only)") << std::endl;
+}
+
+TrafficTap::~TrafficTap() {
+    stopping_.store(true);
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    std::cout << "TrafficTap: " << events_recorded() << " events recorded, " << events_dropped() << " dropped, "
+              << bytes_written() << " bytes written." << std::endl;
+}
+
+uint64_t TrafficTap::SessionKey(std::string_view session_id) {
+    uint64_t hash = 1469598103934665603ull; // FNV-1a
+    for (unsigned char c : session_id) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool TrafficTap::ShouldSample(std::string_view session_id) const {
+    return sample_threshold_ > 0 && (SessionKey(session_id) >> 48) < sample_threshold_;
+}
+
+void TrafficTap::Record(TraceEventType type, std::string_view session_id, uint32_t size, std::string_view data) {
+    Event event;
+    event.t_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start_).count());
+    event.session_key = SessionKey(session_id);
+    event.type = type;
+    event.size = size;
+    const bool is_audio = (type == TraceEventType::kClientAudio || type == TraceEventType::kServerAudio);
+    if (!is_audio || config_.capture_audio) {
+        event.data.assign(data.data(), data.size());
+    }
+    if (queue_.TryPush(std::move(event))) {
+        events_recorded_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        events_dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void TrafficTap::WriterLoop() {
+    Event event;
+    for (;;) {
+        bool wrote = false;
+        while (queue_.TryPop(event)) {
+            WriteEvent(event);
+            wrote = true;
+        }
+        if (wrote) {
+            out_.flush();
+        } else if (stopping_.load()) {
+            break; // stopping_ 이후 마지막으로 한 번 더 비운 뒤 종료
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    out_.close();
+}
+
+void TrafficTap::OpenNextFile() {
+    if (out_.is_open()) {
+        out_.close();
+    }
+    const auto wall_sec = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    // 같은 초에 시작한 다른 탭(재시작 등)의 파일을 덮어쓰지 않도록 비어 있는 번호를 찾음
+    std::error_code ec;
+    do {
+        current_file_ = config_.output_dir + "/gateway-" + std::to_string(wall_sec) + "-" + std::to_string(file_index_++) + ".avtrace";
+    } while (std::filesystem::exists(current_file_, ec));
+    out_.open(current_file_, std::ios::binary | std::ios::trunc);
+    if (!out_) {
+        throw std::runtime_error("Cannot open traffic trace file " + current_file_);
+    }
+    out_.write(kFileMagic, sizeof(kFileMagic));
+    current_file_bytes_ = sizeof(kFileMagic);
+}
+
+void TrafficTap::WriteEvent(const Event& event) {
+    if (current_file_bytes_ >= config_.max_file_bytes) {
+        try {
+            OpenNextFile();
+        } catch (const std::exception& e) {
+            std::cerr << "TrafficTap: ❌ " << e.what() << ". Dropping event." << std::endl;
+            events_dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    // 대상 플랫폼(x86-64/arm64 리눅스)은 리틀 엔디언이므로 그대로 복사
+    char header[kRecordHeaderBytes] = {};
+    const uint32_t data_len = static_cast<uint32_t>(event.data.size());
+    std::memcpy(header, &event.t_us, 8);
+    std::memcpy(header + 8, &event.session_key, 8);
+    header[16] = static_cast<char>(event.type);
+    std::memcpy(header + 20, &event.size, 4);
+    std::memcpy(header + 24, &data_len, 4);
+    out_.write(header, sizeof(header));
+    out_.write(event.data.data(), static_cast<std::streamsize>(data_len));
+    current_file_bytes_ += sizeof(header) + data_len;
+    bytes_written_.fetch_add(sizeof(header) + data_len, std::memory_order_relaxed);
+}
+
+} // namespace websocket_gateway
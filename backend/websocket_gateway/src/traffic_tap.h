@@ -0,0 +1,97 @@
+#ifndef TRAFFIC_TAP_H
+#define TRAFFIC_TAP_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "lock_free_queue.h"
+
+namespace websocket_gateway {
+
+// 운영 트래픽 형태(프레임 크기, 도착 간격, 발화 길이, 제어 메시지 순서)를 용량 테스트용으로 기록하는 탭 설정.
+// sample_rate 0이면 비활성. 오디오 내용은 capture_audio일 때만 기록 (기본은 크기만).
+struct TrafficTapConfig {
+    double sample_rate = 0.0;                      // 기록할 세션 비율 (0.0 ~ 1.0)
+    std::string output_dir = "/tmp/gateway_traces";
+    bool capture_audio = false;
+    size_t queue_capacity = 65536;                 // 기록 대기 이벤트 수. 넘치면 버리고 카운트
+    uint64_t max_file_bytes = 256ull * 1024 * 1024; // 파일 회전 크기
+};
+
+// 트레이스 파일 포맷 (리틀 엔디언):
+//   파일 헤더: "AVTRACE1"
+//   레코드:    u64 t_us | u64 session_key | u8 type | u8 reserved[3] | u32 size | u32 data_len | data[data_len]
+// t_us는 탭 시작 기준 steady 시간, session_key는 세션 ID의 FNV-1a 해시.
+// kSessionOpen 레코드의 data는 세션 ID 문자열, kClientText는 메시지 원문, 오디오는 capture_audio일 때만 PCM.
+enum class TraceEventType : uint8_t {
+    kSessionOpen = 1,
+    kSessionClose = 2,
+    kClientText = 3,
+    kClientAudio = 4,
+    kServerAudio = 5,
+    kServerViseme = 6,
+};
+
+// 샘플링된 세션의 이벤트를 lock-free 큐로 받아 백그라운드 스레드가 파일에 기록.
+// Record는 uWS 루프와 gRPC 스레드에서 동시에 호출될 수 있으며 블로킹하지 않는다.
+class TrafficTap {
+public:
+    explicit TrafficTap(const TrafficTapConfig& config);
+    ~TrafficTap(); // 큐에 남은 이벤트를 기록하고 writer 스레드 종료
+
+    TrafficTap(const TrafficTap&) = delete;
+    TrafficTap& operator=(const TrafficTap&) = delete;
+
+    static constexpr char kFileMagic[8] = {'A', 'V', 'T', 'R', 'A', 'C', 'E', '1'};
+    static constexpr size_t kRecordHeaderBytes = 28;
+
+    // 세션 ID 해시 기반 결정적 샘플링: 게이트웨이 소켓 측과 AvatarSync 측이 같은 세션을 고른다
+    bool ShouldSample(std::string_view session_id) const;
+    static uint64_t SessionKey(std::string_view session_id);
+
+    // data는 이벤트 종류에 따라 복사 여부가 결정됨 (오디오는 capture_audio일 때만)
+    void Record(TraceEventType type, std::string_view session_id, uint32_t size, std::string_view data = {});
+
+    bool capture_audio() const { return config_.capture_audio; }
+    uint64_t events_recorded() const { return events_recorded_.load(std::memory_order_relaxed); }
+    uint64_t events_dropped() const { return events_dropped_.load(std::memory_order_relaxed); }
+    uint64_t bytes_written() const { return bytes_written_.load(std::memory_order_relaxed); }
+    const std::string& current_file() const { return current_file_; } // writer 스레드 종료 후에만 안전
+
+private:
+    struct Event {
+        uint64_t t_us = 0;
+        uint64_t session_key = 0;
+        TraceEventType type = TraceEventType::kSessionOpen;
+        uint32_t size = 0;
+        std::string data;
+    };
+
+    void WriterLoop();
+    void OpenNextFile();
+    void WriteEvent(const Event& event);
+
+    TrafficTapConfig config_;
+    uint64_t sample_threshold_;
+    std::chrono::steady_clock::time_point start_;
+    BoundedMpscQueue<Event> queue_;
+
+    std::thread writer_;
+    std::atomic<bool> stopping_{false};
+    std::ofstream out_;                // writer 스레드 전용
+    std::string current_file_;
+    uint64_t current_file_bytes_ = 0;
+    uint32_t file_index_ = 0;
+
+    std::atomic<uint64_t> events_recorded_{0};
+    std::atomic<uint64_t> events_dropped_{0};
+    std::atomic<uint64_t> bytes_written_{0};
+};
+
+} // namespace websocket_gateway
+
+#endif // TRAFFIC_TAP_H
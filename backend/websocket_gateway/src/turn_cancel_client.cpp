@@ -0,0 +1,76 @@
+#include "turn_cancel_client.h"
+#include <iostream>
+#include <chrono>
+#include <stdexcept>
+#include "google/protobuf/empty.pb.h"
+
+namespace websocket_gateway {
+
+namespace {
+
+// 비동기 unary 호출 동안 context/request/response 수명을 유지하기 위한 상태 객체
+template <typename RequestT>
+struct CancelCallState {
+    grpc::ClientContext context;
+    RequestT request;
+    google::protobuf::Empty response;
+};
+
+template <typename StubT, typename RequestT>
+void SendCancel(StubT* stub, const char* target_name, const std::string& frontend_session_id, uint64_t before_turn_id,
+                int deadline_ms, std::atomic<long>& sent_counter, std::atomic<long>& failed_counter) {
+    auto call = std::make_shared<CancelCallState<RequestT>>();
+    call->request.set_frontend_session_id(frontend_session_id);
+    call->request.set_before_turn_id(before_turn_id);
+    call->context.set_deadline(std::chrono::system_clock::now() + std::chrono::milliseconds(deadline_ms));
+
+    sent_counter++;
+    stub->async()->CancelTurn(&call->context, &call->request, &call->response,
+        [call, target_name, &failed_counter](grpc::Status status) {
+            if (!status.ok()) {
+                failed_counter++;
+                std::cerr << "[" << call->request.frontend_session_id() << "] ⚠️ CancelTurn to " << target_name
+                          << " failed: (" << status.error_code() << ") " << status.error_message() << std::endl;
+            }
+        });
+}
+
+} // namespace
+
+TurnCancelClient::TurnCancelClient(const std::string& llm_service_addr, const std::string& tts_service_addr)
+    : llm_service_addr_(llm_service_addr), tts_service_addr_(tts_service_addr) {
+    if (!llm_service_addr_.empty()) {
+        auto channel = grpc::CreateChannel(llm_service_addr_, grpc::InsecureChannelCredentials());
+        if (!channel) {
+            throw std::runtime_error("Failed to create gRPC channel for TurnCancelClient to " + llm_service_addr_);
+        }
+        llm_stub_ = llm::LLMService::NewStub(channel);
+    }
+    if (!tts_service_addr_.empty()) {
+        auto channel = grpc::CreateChannel(tts_service_addr_, grpc::InsecureChannelCredentials());
+        if (!channel) {
+            throw std::runtime_error("Failed to create gRPC channel for TurnCancelClient to " + tts_service_addr_);
+        }
+        tts_stub_ = tts::TTSService::NewStub(channel);
+    }
+    std::cout << "TurnCancelClient created. LLM: " << (llm_service_addr_.empty() ? "(disabled)" : llm_service_addr_)
+              << ", TTS: " << (tts_service_addr_.empty() ? "(disabled)" : tts_service_addr_) << std::endl;
+}
+
+void TurnCancelClient::CancelTurnsBefore(const std::string& frontend_session_id, uint64_t before_turn_id) {
+    if (frontend_session_id.empty()) return;
+
+    // LLM과 TTS에 동시에 보낸다. LLM만 취소하면 이미 TTS에 넘어간 텍스트의 합성은 계속되기 때문.
+    if (llm_stub_) {
+        SendCancel<llm::LLMService::Stub, llm::CancelTurnRequest>(
+            llm_stub_.get(), "llm_engine", frontend_session_id, before_turn_id,
+            kCancelDeadlineMs, cancel_requests_sent_, cancel_requests_failed_);
+    }
+    if (tts_stub_) {
+        SendCancel<tts::TTSService::Stub, tts::CancelTurnRequest>(
+            tts_stub_.get(), "tts_service", frontend_session_id, before_turn_id,
+            kCancelDeadlineMs, cancel_requests_sent_, cancel_requests_failed_);
+    }
+}
+
+} // namespace websocket_gateway
@@ -0,0 +1,48 @@
+#ifndef TURN_CANCEL_CLIENT_H
+#define TURN_CANCEL_CLIENT_H
+
+#include <grpcpp/grpcpp.h>
+#include "llm.grpc.pb.h"
+#include "tts.grpc.pb.h"
+#include <string>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+namespace websocket_gateway {
+
+// Barge-in 처리용 클라이언트.
+// 사용자가 새 발화를 시작하면 이전 턴의 LLM 생성/TTS 합성을 취소하도록
+// llm_engine / tts_service 에 CancelTurn RPC를 보낸다.
+// uWS 루프 스레드에서 호출되므로 비동기(callback) API만 사용하고 절대 블로킹하지 않는다.
+class TurnCancelClient {
+public:
+    // 주소가 비어 있으면 해당 서비스로는 취소 요청을 보내지 않음
+    TurnCancelClient(const std::string& llm_service_addr, const std::string& tts_service_addr);
+    ~TurnCancelClient() = default;
+
+    TurnCancelClient(const TurnCancelClient&) = delete;
+    TurnCancelClient& operator=(const TurnCancelClient&) = delete;
+
+    // frontend_session_id의 turn_id < before_turn_id 인 모든 턴을 취소 (fire-and-forget)
+    void CancelTurnsBefore(const std::string& frontend_session_id, uint64_t before_turn_id);
+
+    long cancel_requests_sent() const { return cancel_requests_sent_.load(); }
+    long cancel_requests_failed() const { return cancel_requests_failed_.load(); }
+
+private:
+    std::string llm_service_addr_;
+    std::string tts_service_addr_;
+
+    std::unique_ptr<llm::LLMService::Stub> llm_stub_;
+    std::unique_ptr<tts::TTSService::Stub> tts_stub_;
+
+    std::atomic<long> cancel_requests_sent_{0};
+    std::atomic<long> cancel_requests_failed_{0};
+
+    static constexpr int kCancelDeadlineMs = 2000;
+};
+
+} // namespace websocket_gateway
+
+#endif // TURN_CANCEL_CLIENT_H
@@ -0,0 +1,90 @@
+#ifndef TURN_OUTPUT_SEQUENCER_H
+#define TURN_OUTPUT_SEQUENCER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace websocket_gateway {
+
+// 세션 하나의 응답 프레임 순서 보장 (겹치는 발화).
+// 이전 턴의 LLM/TTS가 아직 끝나지 않았는데 다음 발화가 시작되면 두 턴의 응답 프레임이 섞여 도착할 수 있다.
+// 더 오래된 턴의 파이프라인(STT 스트림)이 진행 중이면 새 턴의 프레임은 보류했다가 그 턴이 끝나면 내보내고,
+// 이미 새 턴을 내보내기 시작한 뒤 도착한 옛 턴의 프레임은 버린다. 턴 번호 0(턴 정보 없음)은 항상 통과.
+// Frame은 turn_id와 payload(size())를 가져야 한다. uWS 루프 스레드 전용 (스레드 안전하지 않음).
+template <typename Frame>
+class TurnOutputSequencer {
+public:
+    enum class Verdict {
+        kSend,  // 지금 보냄
+        kHold,  // 보류됨 (프레임은 시퀀서가 보관)
+        kStale, // 더 새로운 턴이 이미 나갔으므로 버림
+    };
+
+    // 턴의 STT 스트림 시작 (이 턴이 끝나기 전까지 더 새 턴의 프레임은 보류)
+    void TurnStarted(uint64_t turn_id) {
+        if (turn_id == 0) {
+            return;
+        }
+        auto it = std::lower_bound(in_flight_.begin(), in_flight_.end(), turn_id);
+        if (it == in_flight_.end() || *it != turn_id) {
+            in_flight_.insert(it, turn_id);
+        }
+    }
+
+    // 턴의 STT 스트림 종료 (= LLM/TTS 턴 종료). 보류가 풀린 프레임을 턴 순서대로 released 끝에 추가
+    void TurnFinished(uint64_t turn_id, std::vector<Frame>& released) {
+        auto it = std::lower_bound(in_flight_.begin(), in_flight_.end(), turn_id);
+        if (it != in_flight_.end() && *it == turn_id) {
+            in_flight_.erase(it);
+        }
+        const uint64_t oldest = in_flight_.empty() ? UINT64_MAX : in_flight_.front();
+        // 여러 턴이 한꺼번에 풀려도 턴끼리 섞이지 않도록 턴 번호 기준 안정 분할/정렬 (같은 턴 안에서는 도착 순서 유지)
+        auto ready_end = std::stable_partition(held_.begin(), held_.end(),
+                                               [oldest](const Frame& frame) { return frame.turn_id <= oldest; });
+        std::stable_sort(held_.begin(), ready_end,
+                         [](const Frame& a, const Frame& b) { return a.turn_id < b.turn_id; });
+        for (auto frame = held_.begin(); frame != ready_end; ++frame) {
+            held_bytes_ -= frame->payload.size();
+            last_sent_turn_ = std::max(last_sent_turn_, frame->turn_id);
+        }
+        released.insert(released.end(), std::make_move_iterator(held_.begin()), std::make_move_iterator(ready_end));
+        held_.erase(held_.begin(), ready_end);
+    }
+
+    // 도착한 프레임 판정. kHold면 frame은 시퀀서로 옮겨짐
+    Verdict Admit(Frame& frame) {
+        if (frame.turn_id == 0) {
+            return Verdict::kSend;
+        }
+        if (frame.turn_id < last_sent_turn_) {
+            return Verdict::kStale;
+        }
+        if (!in_flight_.empty() && in_flight_.front() < frame.turn_id) {
+            held_bytes_ += frame.payload.size();
+            held_.push_back(std::move(frame));
+            return Verdict::kHold;
+        }
+        last_sent_turn_ = frame.turn_id;
+        return Verdict::kSend;
+    }
+
+    // 진행 중인 턴도 보류 프레임도 없으면 상태를 지워도 됨
+    bool idle() const { return in_flight_.empty() && held_.empty(); }
+    size_t turns_in_flight() const { return in_flight_.size(); }
+    size_t held_frames() const { return held_.size(); }
+    size_t held_bytes() const { return held_bytes_; }
+
+private:
+    std::vector<uint64_t> in_flight_; // 오름차순
+    std::vector<Frame> held_;         // 도착 순서
+    size_t held_bytes_ = 0;
+    uint64_t last_sent_turn_ = 0;
+};
+
+} // namespace websocket_gateway
+
+#endif // TURN_OUTPUT_SEQUENCER_H
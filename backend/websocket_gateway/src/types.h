@@ -2,20 +2,109 @@
 #define TYPES_H
 
 #include <string>
+#include <string_view>
+#include <array>
+#include <ostream>
+#include <stdexcept>
 #include <memory> // std::unique_ptr
+#include <cstdint>
 
 // STTClient의 전체 정의를 포함하도록 수정합니다.
 // 이렇게 하면 PerSocketData 내의 std::unique_ptr<websocket_gateway::STTClient>가
 // STTClient를 완전한 타입으로 인식할 수 있습니다.
 #include "stt_client.h"
+#include "rate_limiter.h"
+#include "session_timeline.h"
 
-// uWebSockets의 각 연결에 대한 사용자 정의 데이터
+// 세션 ID(32자리 hex)를 힙 할당 없이 PerSocketData 안에 보관.
+// std::string은 SSO 한도(15자)를 넘어 연결마다 별도 할당이 생기므로 고정 크기 버퍼 사용.
+class SessionId {
+public:
+    static constexpr size_t kCapacity = 32;
+
+    SessionId() = default;
+
+    SessionId& operator=(std::string_view id) {
+        if (id.size() > kCapacity) {
+            throw std::runtime_error("Session ID exceeds " + std::to_string(kCapacity) + " characters.");
+        }
+        id.copy(data_.data(), id.size());
+        length_ = static_cast<uint8_t>(id.size());
+        return *this;
+    }
+
+    std::string_view view() const { return std::string_view(data_.data(), length_); }
+    std::string str() const { return std::string(view()); }
+    bool empty() const { return length_ == 0; }
+    operator std::string_view() const { return view(); }
+
+private:
+    std::array<char, kCapacity> data_{};
+    uint8_t length_ = 0;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const SessionId& id) {
+    return os << id.view();
+}
+
+// uWebSockets의 각 연결에 대한 사용자 정의 데이터.
+// 유휴 연결 수만 개를 전제로 고정 크기 필드만 두고, STT 관련 자원은 stt_client 핸들 뒤에서 필요할 때만 생성.
+// 크기 예산 128바이트(캐시 라인 두 개): 포인터 하나를 빼면 모두 4바이트 이하 필드이며, 패딩이 생기지 않도록
+// SessionId(33) 뒤에 bool과 rtt_ms(16비트)를 붙이고 나머지는 4바이트 필드로 채운다. 예산은 아래 static_assert로 강제
 struct PerSocketData {
-    std::string sessionId;
-    // ★ STTClient 타입을 네임스페이스 포함하여 명시 (stt_client.h에서 정의된 네임스페이스 사용)
-    std::unique_ptr<websocket_gateway::STTClient> stt_client; 
+    SessionId sessionId;
     bool stt_stream_active = false;
-    // std::chrono::steady_clock::time_point last_activity; // 유휴 시간 관리를 위해
+    bool framed_audio = false;        // clock_sync에서 요청 시 오디오 프레임 앞에 [ptsMs u32][turnId u32] 헤더를 붙임 (PTS 필드 참고)
+    bool traced = false;              // TrafficTap 샘플링 대상 세션 (연결 시 결정)
+    bool session_admitted = false;    // AdmissionController 세션 입장 여부 (false면 open에서 busy로 종료된 연결)
+    bool holds_turn_slot = false;     // 현재 턴이 입장 슬롯을 보유 (첫 응답 프레임/기한 만료/STT 오류/종료 시 반환)
+    uint16_t rtt_ms = 0;              // 마지막 WebSocket ping/pong 왕복 시간 (65535ms에서 포화)
+
+    // start_stream마다 증가하는 현재 턴 번호. 이전 턴의 응답이 아직 진행 중이어도 새 턴은 겹쳐서 시작됨
+    uint32_t turn_id = 0;
+    // 마지막으로 클라이언트에 오디오/viseme를 보낸 턴 (0 = 재생 중인 응답 없음)
+    uint32_t playing_turn_id = 0;
+    // Barge-in/응답 기한 만료로 취소된 턴의 상한. 이 번호 이하 턴의 TTS 출력은 폐기됨
+    uint32_t cancelled_turn_id = 0;
+
+    // --- liveness (WebSocketServer의 타이머 휠에서 관리, 서버 시작 기준 LivenessConfig::timer_tick 단위) ---
+    uint32_t last_seen_tick = 0;      // 마지막 수신 (pong 포함) - 죽은 연결 감지
+    uint32_t last_activity_tick = 0;  // 마지막 애플리케이션 메시지 (pong 제외) - 유휴 판단
+    uint32_t last_stt_use_tick = 0;   // 마지막 오디오/STT 스트림 시작·종료 - STTClient 해제 판단
+    uint32_t last_ping_sent_tick = 0;
+    uint32_t turn_deadline_tick = 0;  // 발화 종료 후 첫 응답 프레임 기한 (0 = 대기 중인 턴 없음)
+    uint32_t liveness_timer_id = 0;   // TimerWheel::TimerId
+
+    // --- 재생 시각(PTS) 스탬프: 서버 타임라인 ms. 클라이언트는 clock_sync로 오프셋을 추정해 정확한 시각에 재생 ---
+    uint32_t pts_turn_id = 0;         // turn_pts_base_ms가 가리키는 턴
+    uint32_t turn_pts_base_ms = 0;    // 해당 턴 오디오 0ms 지점의 PTS
+    uint32_t audio_end_pts_ms = 0;    // 지금까지 보낸 오디오의 재생 종료 시각 (다음 턴은 이 뒤에 이어 붙음)
+
+    uint32_t admission_ticket = 0;    // 턴 슬롯 대기 중인 AdmissionController::Ticket (0 = 대기 없음)
+    uint32_t timeline_slot = websocket_gateway::SessionTimelineStore::kNoSlot; // 디버그 타임라인 슬롯 (입장한 세션만)
+
+    // 업스트림 속도 제한 (세션 토큰 버킷 + 원격 IP 상태 슬롯). WebSocketServer의 UpstreamRateLimiter가 관리
+    websocket_gateway::SessionRateState rate_limit;
+
+    // ★ STTClient 타입을 네임스페이스 포함하여 명시 (stt_client.h에서 정의된 네임스페이스 사용)
+    // 실제 구현은 STTClient(gRPC) 또는 LoopbackSTTClient(벤치마크 모드).
+    // 첫 start_stream에서 생성되고, 유휴 상태가 지속되면 해제됨 (nullptr = 미생성)
+    std::unique_ptr<websocket_gateway::STTStreamClient> stt_client;
 };
+static_assert(sizeof(PerSocketData) <= 128, "PerSocketData exceeds its 128-byte per-connection budget");
+
+// 오디오를 받는 중인 STT 스트림이 있는지 (BINARY 프레임을 STT로 보낼지 판단)
+inline bool accepts_audio(const PerSocketData& data) {
+    return data.stt_client && data.stt_stream_active;
+}
+
+// 오디오를 받는 중인 STT 스트림 취소. 플래그도 함께 내려야 새 턴이 입장 대기하는 동안 들어온 오디오가
+// 닫힌 스트림에 쓰여 오류가 나지 않음 (liveness 타이머도 스트리밍 중으로 보지 않음)
+inline void cancel_active_stt_stream(PerSocketData& data) {
+    if (accepts_audio(data)) {
+        data.stt_client->StopStreamNow();
+    }
+    data.stt_stream_active = false;
+}
 
 #endif // TYPES_H
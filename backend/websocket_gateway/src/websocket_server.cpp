@@ -7,6 +7,11 @@
 #include <sstream>            
 #include <iomanip>            
 #include <Loop.h>             
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unistd.h>           // sysconf
+#include <openssl/ssl.h>      // TLS 세션 티켓 / 암호 스위트 설정 (uWS SSLApp의 SSL_CTX)
 #include "stt.pb.h"           
 
 // svToString 헬퍼 함수 (이전과 동일)
@@ -25,20 +30,65 @@ inline std::string svToString(const std::string& s) {
 
 namespace websocket_gateway {
 
-WebSocketServer::WebSocketServer(int ws_port, int metrics_port, const std::string& stt_service_addr)
+template <bool SSL>
+WebSocketServerImpl<SSL>::WebSocketServerImpl(int ws_port, int metrics_port, const std::string& stt_service_addr,
+                                              std::shared_ptr<TurnCancelClient> turn_cancel_client,
+                                              STTClientFactory stt_client_factory,
+                                              LivenessConfig liveness_config,
+                                              const TlsConfig& tls_config,
+                                              const RateLimitConfig& rate_limit_config,
+                                              std::shared_ptr<TrafficTap> traffic_tap,
+                                              std::shared_ptr<SessionDirectory> session_directory,
+                                              const AdmissionConfig& admission_config,
+                                              AdmissionController::CapacityHint capacity_hint)
     : ws_port_(ws_port),
       metrics_port_(metrics_port),
       stt_service_address_(stt_service_addr),
-      app_(uWS::SocketContextOptions{}) { 
-    if constexpr (GLOBAL_SSL_ENABLED) {
-         std::cout << "WebSocketServer initialized WITH SSL." << std::endl;
+      tls_(tls_config),
+      app_(make_socket_context_options(tls_)),
+      loop_(uWS::Loop::get()),
+      turn_cancel_client_(std::move(turn_cancel_client)),
+      stt_client_factory_(std::move(stt_client_factory)),
+      liveness_(liveness_config),
+      timer_wheel_(liveness_config.timer_tick),
+      liveness_epoch_(TimerWheel::Clock::now()),
+      traffic_tap_(std::move(traffic_tap)),
+      session_directory_(std::move(session_directory)),
+      rate_limiter_(rate_limit_config),
+      admission_(admission_config, std::move(capacity_hint)),
+      timelines_(admission_config.timeline_sessions()) { 
+    if constexpr (SSL) {
+        if (app_.constructorFailed()) {
+            throw std::runtime_error("Failed to create TLS context (cert: " + tls_.cert_file + ", key: " + tls_.key_file + ").");
+        }
+        configure_tls();
+        std::cout << "WebSocketServer initialized WITH TLS. Session tickets: " << (tls_.session_tickets ? "On" : "Off") << std::endl;
     } else {
         std::cout << "WebSocketServer initialized WITHOUT SSL." << std::endl;
     }
     std::cout << "Compression: " << (GLOBAL_COMPRESSION_ACTUALLY_ENABLED ? "Yes" : "No") << std::endl;
+    std::cout << "STT client: " << (stt_client_factory_ ? "Custom factory" : "gRPC (" + stt_service_address_ + ")") << std::endl;
+    std::cout << "Barge-in (turn cancel): " << (turn_cancel_client_ ? "Enabled" : "Disabled") << std::endl;
+    if (session_directory_) {
+        std::cout << "Session directory: replica " << session_directory_->self_address()
+                  << " (session ID prefix '" << session_directory_->session_id_prefix() << "')" << std::endl;
+    }
+    if (rate_limit_config.enabled) {
+        std::cout << "Upstream rate limit: audio " << rate_limit_config.session_audio_realtime_ratio << "x realtime/session, "
+                  << rate_limit_config.ip_audio_realtime_ratio << "x realtime/IP, control "
+                  << rate_limit_config.session_control_per_sec << "/s/session, quota "
+                  << rate_limit_config.session_audio_quota.count() << "s, max message " << rate_limit_config.max_message_bytes << " B" << std::endl;
+    } else {
+        std::cout << "Upstream rate limit: Disabled (max message " << rate_limit_config.max_message_bytes << " B)" << std::endl;
+    }
+    auto limit_or_unlimited = [](uint32_t limit) { return limit == 0 ? std::string("unlimited") : std::to_string(limit); };
+    std::cout << "Admission control: sessions " << limit_or_unlimited(admission_config.max_sessions) << ", active turns "
+              << limit_or_unlimited(admission_config.max_active_turns) << ", queue " << admission_config.queue_capacity
+              << " x " << admission_config.queue_timeout.count() << " ms, debug timeline slots " << timelines_.capacity() << std::endl;
 }
 
-WebSocketServer::~WebSocketServer() {
+template <bool SSL>
+WebSocketServerImpl<SSL>::~WebSocketServerImpl() {
     std::cout << "WebSocketServer destructor called. Shutting down status: " << is_shutting_down_.load() << std::endl;
     if (!is_shutting_down_.load()) {
         stop(); 
@@ -46,35 +96,67 @@ WebSocketServer::~WebSocketServer() {
     std::cout << "WebSocketServer destroyed." << std::endl;
 }
 
-std::string WebSocketServer::generate_session_id() {
+template <bool SSL>
+std::string WebSocketServerImpl<SSL>::generate_session_id() {
     std::random_device rd;
     std::mt19937_64 gen(rd());
     std::uniform_int_distribution<uint64_t> distrib;
     std::stringstream ss;
+    if (session_directory_) {
+        ss << session_directory_->session_id_prefix(); // 레플리카 접두어만큼 난수 부분을 줄여 SessionId 용량에 맞춤
+    }
     ss << std::hex << std::setw(16) << std::setfill('0') << distrib(gen);
     ss << std::hex << std::setw(16) << std::setfill('0') << distrib(gen);
-    return ss.str();
+    std::string id = ss.str();
+    id.resize(std::min(id.size(), SessionId::kCapacity));
+    return id;
 }
 
-void WebSocketServer::initialize_handlers() {
-    app_.ws<PerSocketData>("/*", { 
+template <bool SSL>
+std::unique_ptr<STTStreamClient> WebSocketServerImpl<SSL>::create_stt_client(const std::string& session_id) {
+    std::unique_ptr<STTStreamClient> client;
+    if (stt_client_factory_) {
+        client = stt_client_factory_(session_id);
+        if (!client) {
+            throw std::runtime_error("STT client factory returned null.");
+        }
+    } else {
+        client = std::make_unique<STTClient>(stt_service_address_);
+    }
+    stt_clients_created_++;
+    stt_clients_live_++;
+    return client;
+}
+
+template <bool SSL>
+void WebSocketServerImpl<SSL>::initialize_handlers() {
+    // uWS 자체 idleTimeout은 최후 방어선. 실제 유휴/죽은 연결 판단은 타이머 휠(on_liveness_timer)에서 수행
+    const auto uws_idle_timeout_sec = static_cast<unsigned short>(
+        std::clamp<long long>(2 * liveness_.dead_peer_timeout.count(), 120, 960));
+
+    app_.template ws<PerSocketData>("/*", { 
         .compression = GLOBAL_COMPRESSION_OPTIONS,
-        .maxPayloadLength = 16 * 1024 * 1024, 
-        .idleTimeout = 600, // 10분
+        .maxPayloadLength = rate_limiter_.config().max_message_bytes,
+        .idleTimeout = uws_idle_timeout_sec,
+        .sendPingsAutomatically = false, // PING은 타이머 휠에서 직접 보내고 pong으로 RTT 측정
 
         .open = [this](WebSocketConnection *ws) { this->on_websocket_open(ws); },
         .message = [this](WebSocketConnection *ws, std::string_view message, uWS::OpCode op_code) { this->on_websocket_message(ws, message, op_code); },
         .drain = [](WebSocketConnection *ws) { /* TODO: Implement if needed for backpressure */ },
         .ping = [](WebSocketConnection *ws, std::string_view) { /* Default uWS ping/pong handling is usually sufficient */ },
-        .pong = [](WebSocketConnection *ws, std::string_view) { /* ... */ },
+        .pong = [this](WebSocketConnection *ws, std::string_view message) { this->on_websocket_pong(ws, message); },
         .close = [this](WebSocketConnection *ws, int code, std::string_view message) { this->on_websocket_close(ws, code, message); }
     });
 
-    app_.get("/healthz", [this](uWS::HttpResponse<GLOBAL_SSL_ENABLED>* res, uWS::HttpRequest* req) { this->handle_health_check(res, req); });
-    app_.get("/metrics", [this](uWS::HttpResponse<GLOBAL_SSL_ENABLED>* res, uWS::HttpRequest* req) { this->handle_metrics(res, req); });
+    // 전용 메트릭 포트가 있으면 /metrics, /healthz는 별도 스레드(MetricsHttpServer)에서 처리
+    if (metrics_port_ <= 0 || metrics_port_ == ws_port_) {
+        app_.get("/healthz", [this](uWS::HttpResponse<SSL>* res, uWS::HttpRequest* req) { this->handle_health_check(res, req); });
+        app_.get("/metrics", [this](uWS::HttpResponse<SSL>* res, uWS::HttpRequest* req) { this->handle_metrics(res, req); });
+    }
 }
 
-bool WebSocketServer::run() {
+template <bool SSL>
+bool WebSocketServerImpl<SSL>::run() {
     initialize_handlers(); 
 
     bool success_ws = false;
@@ -90,26 +172,30 @@ bool WebSocketServer::run() {
     });
     if (!success_ws) return false;
 
+    publish_loop_snapshot(); // 첫 tick 전에 /healthz가 stall로 보지 않도록
     if (metrics_port_ > 0 && metrics_port_ != ws_port_) { 
-        bool success_metrics = false;
-        app_.listen(metrics_port_, [this, &success_metrics](auto* token){ 
-            if (token) {
-                std::cout << "Metrics HTTP server listening on port " << this->metrics_port_ << std::endl;
-                success_metrics = true;
-            } else {
-                 // ★★★ 수정된 부분: this.metrics_port_ -> this->metrics_port_ ★★★
-                 std::cerr << "Failed to listen on metrics port " << this->metrics_port_ << ". Metrics might only be available on WS port if distinct listen fails." << std::endl;
-            }
-        });
+        // 스크레이프가 오디오 루프에 지터를 만들지 않도록 자체 스레드/루프에서 평문 HTTP로 제공
+        metrics_server_ = std::make_unique<MetricsHttpServer>(
+            metrics_port_,
+            [this]() { return this->render_metrics(); },
+            [this]() { return this->event_loop_healthy(); },
+            [this](std::string_view session_id, size_t slowest) { return this->render_session_debug(session_id, slowest); });
+        if (!metrics_server_->Start()) {
+            std::cerr << "Failed to listen on metrics port " << metrics_port_ << ". Metrics are unavailable." << std::endl;
+            metrics_server_.reset();
+        }
     }
 
+    start_tick_timer();
+
     std::cout << "WebSocketServer starting event loop..." << std::endl;
     app_.run(); 
     std::cout << "WebSocketServer event loop has ended." << std::endl;
     return true; 
 }
 
-void WebSocketServer::stop() {
+template <bool SSL>
+void WebSocketServerImpl<SSL>::stop() {
     if (is_shutting_down_.exchange(true)) { 
         return; 
     }
@@ -136,9 +222,17 @@ void WebSocketServer::stop() {
             }
             std::cout << "WebSocketServer: All WebSocket connections signaled to close." << std::endl;
 
+            if (tick_timer_) {
+                us_timer_close(tick_timer_);
+                tick_timer_ = nullptr;
+            }
+            if (metrics_server_) {
+                metrics_server_->Stop(); // 스레드 join은 소멸자에서
+            }
+
             if (listen_socket_ws_) {
                 std::cout << "WebSocketServer: Closing listen socket on port " << ws_port_ << std::endl;
-                us_listen_socket_close(GLOBAL_SSL_ENABLED ? 1 : 0, listen_socket_ws_);
+                us_listen_socket_close(SSL ? 1 : 0, listen_socket_ws_);
                 listen_socket_ws_ = nullptr;
             }
             std::cout << "WebSocketServer: Deferred shutdown tasks complete." << std::endl;
@@ -150,7 +244,8 @@ void WebSocketServer::stop() {
 }
 
 
-WebSocketServer::WebSocketConnection* WebSocketServer::find_websocket_by_session_id(const std::string& session_id) {
+template <bool SSL>
+typename WebSocketServerImpl<SSL>::WebSocketConnection* WebSocketServerImpl<SSL>::find_websocket_by_session_id(const std::string& session_id) {
     std::lock_guard<std::mutex> lock(active_websockets_mutex_);
     auto it = active_websockets_.find(session_id);
     if (it != active_websockets_.end()) {
@@ -159,24 +254,47 @@ WebSocketServer::WebSocketConnection* WebSocketServer::find_websocket_by_session
     return nullptr;
 }
 
-void WebSocketServer::on_websocket_open(WebSocketConnection* ws) {
+template <bool SSL>
+bool WebSocketServerImpl<SSL>::has_session(const std::string& session_id) {
+    return find_websocket_by_session_id(session_id) != nullptr;
+}
+
+template <bool SSL>
+void WebSocketServerImpl<SSL>::on_websocket_open(WebSocketConnection* ws) {
     connected_clients_count_++; 
     PerSocketData *user_data = ws->getUserData(); 
 
-    user_data->sessionId = generate_session_id();
-    try {
-        user_data->stt_client = std::make_unique<websocket_gateway::STTClient>(stt_service_address_);
-    } catch (const std::runtime_error& e) {
-        std::cerr << "[" << (user_data->sessionId.empty() ? "NO_SESSION_ID_YET" : user_data->sessionId)
-                  << "] Failed to create STTClient: " << e.what() << ". Closing WebSocket." << std::endl;
-        ws->end(1011, "Internal server error: STT client initialization failed");
+    // 세션 상한 초과: 세션 ID도 발급하지 않고 busy 후 1013(Try Again Later)으로 닫음. close 핸들러는 카운터만 정리
+    if (!admission_.AdmitSession()) {
+        send_busy(ws, user_data, "session", "max_sessions");
+        ws->end(1013, "Server busy");
         return;
     }
+    user_data->session_admitted = true;
+
+    user_data->sessionId = generate_session_id();
+    user_data->timeline_slot = timelines_.Open(user_data->sessionId.view(), timeline_ms());
+    // STTClient는 첫 start_stream에서 생성 (말하지 않는 연결은 채널/스텁/스레드 슬롯을 갖지 않음)
     user_data->stt_stream_active = false;
 
+    const uint32_t now = now_tick();
+    user_data->last_seen_tick = now;
+    user_data->last_activity_tick = now;
+    user_data->last_stt_use_tick = now;
+    user_data->last_ping_sent_tick = now;
+    arm_liveness_timer(ws, now);
+    rate_limiter_.Attach(user_data->rate_limit, ws->getRemoteAddressAsText(), timeline_ms());
+    user_data->traced = traffic_tap_ && traffic_tap_->ShouldSample(user_data->sessionId.view());
+    if (user_data->traced) {
+        traffic_tap_->Record(TraceEventType::kSessionOpen, user_data->sessionId.view(), 0, user_data->sessionId.view());
+    }
+
     {
         std::lock_guard<std::mutex> lock(active_websockets_mutex_);
-        active_websockets_[user_data->sessionId] = ws;
+        active_websockets_[user_data->sessionId.view()] = ws;
+    }
+    if (session_directory_) {
+        session_directory_->Register(user_data->sessionId.view());
     }
 
     std::cout << "[" << user_data->sessionId << "] WebSocket client connected from "
@@ -185,13 +303,14 @@ void WebSocketServer::on_websocket_open(WebSocketConnection* ws) {
 
     nlohmann::json session_info_payload = {
         {"type", "session_info"},
-        {"sessionId", user_data->sessionId}
+        {"sessionId", user_data->sessionId.view()}
     };
     ws->send(session_info_payload.dump(), uWS::OpCode::TEXT);
     std::cout << "[" << user_data->sessionId << "] Sent 'session_info' to client." << std::endl;
 }
 
-void WebSocketServer::on_websocket_message(WebSocketConnection* ws, std::string_view message, uWS::OpCode op_code) {
+template <bool SSL>
+void WebSocketServerImpl<SSL>::on_websocket_message(WebSocketConnection* ws, std::string_view message, uWS::OpCode op_code) {
     PerSocketData *user_data = ws->getUserData();
     if (!user_data || user_data->sessionId.empty()) { 
         std::cerr << "CRITICAL: PerSocketData is null or sessionId is empty in on_websocket_message. OpCode: "
@@ -199,9 +318,25 @@ void WebSocketServer::on_websocket_message(WebSocketConnection* ws, std::string_
         ws->end(1011, "Internal server error: session data missing or invalid");
         return;
     }
-    const std::string& current_session_id = user_data->sessionId;
+    const std::string_view current_session_id = user_data->sessionId.view();
+    const uint32_t now = now_tick();
+    user_data->last_seen_tick = now;
+    user_data->last_activity_tick = now;
+
+    if (user_data->traced && (op_code == uWS::OpCode::TEXT || op_code == uWS::OpCode::BINARY)) {
+        // 속도 제한 이전의 원래 도착 형태를 기록
+        traffic_tap_->Record(op_code == uWS::OpCode::TEXT ? TraceEventType::kClientText : TraceEventType::kClientAudio,
+                             current_session_id, static_cast<uint32_t>(message.size()), message);
+    }
 
     if (op_code == uWS::OpCode::TEXT) {
+        // 파싱 전에 제한: 초과분은 JSON 파싱 비용도 들이지 않음
+        const uint32_t now_ms = timeline_ms();
+        const auto verdict = rate_limiter_.AdmitControl(user_data->rate_limit, now_ms);
+        if (verdict != UpstreamRateLimiter::Verdict::kAllowed) {
+            warn_rate_limited(ws, user_data, "control", verdict, 0, now_ms);
+            return;
+        }
         std::string message_str = svToString(message);
         try {
             nlohmann::json ctrl_msg = nlohmann::json::parse(message_str);
@@ -210,79 +345,85 @@ void WebSocketServer::on_websocket_message(WebSocketConnection* ws, std::string_
                 std::string type = ctrl_msg["type"];
 
                 if (type == "start_stream") {
-                    if (user_data->stt_stream_active && user_data->stt_client) {
+                    if (accepts_audio(*user_data)) {
                         std::cout << "[" << current_session_id << "] Received 'start_stream' while STT stream is already active. "
                                   << "Stopping previous STT stream and starting new." << std::endl;
-                        user_data->stt_client->StopStreamNow(); 
+                        cancel_active_stt_stream(*user_data);
                     }
                     
-                    stt::RecognitionConfig stt_config;
-                    stt_config.set_frontend_session_id(current_session_id); 
-                    stt_config.set_session_id(current_session_id); 
-                    stt_config.set_language(ctrl_msg.value("language", "ko-KR")); 
-
-                    std::cout << "[" << current_session_id << "] Processing 'start_stream'. Lang: "
-                              << stt_config.language() << ", FE_SID: " << stt_config.frontend_session_id() << std::endl;
-                    
-                    if (!user_data->stt_client) { 
-                        std::cerr << "[" << current_session_id << "] ❌ STTClient is null before StartStream. Recreating." << std::endl;
-                         try {
-                            user_data->stt_client = std::make_unique<websocket_gateway::STTClient>(stt_service_address_);
-                        } catch (const std::runtime_error& e) {
-                             std::cerr << "[" << current_session_id << "] ❌ Failed to recreate STTClient in start_stream: " << e.what() << std::endl;
-                             ws->send("{\"type\":\"error\", \"message\":\"STT client error on start_stream.\"}", uWS::OpCode::TEXT);
-                             return;
-                        }
+                    // 새 발화 = 새 턴. 이전 턴 응답을 재생하는 중에 말을 걸었으면 이전 턴을 끊고 (barge-in),
+                    // 아직 재생 전이면 이전 턴은 그대로 두고 겹쳐 진행 (출력 순서는 turn_sequencers_가 보장)
+                    const uint32_t new_turn_id = ++user_data->turn_id;
+                    timelines_.Record(user_data->timeline_slot, SessionTimelineStore::Event::kStartStream, new_turn_id, timeline_ms());
+                    cancel_previous_turns(ws, user_data, new_turn_id);
+                    user_data->turn_deadline_tick = 0;
+                    user_data->last_stt_use_tick = now;
+                    // 언어 + 선택적 오디오 형식 (생략 시 16kHz 16-bit mono, 그 외 형식은 STT가 변환)
+                    stt::RecognitionConfig requested;
+                    requested.set_language(ctrl_msg.value("language", "ko-KR"));
+                    requested.set_sample_rate_hz(ctrl_msg.value("sampleRateHz", 0u));
+                    requested.set_channels(ctrl_msg.value("channels", 0u));
+                    const std::string sample_format = ctrl_msg.value("sampleFormat", "");
+                    if (sample_format == "float32") {
+                        requested.set_sample_format(stt::SAMPLE_FORMAT_FLOAT32);
+                    } else if (sample_format == "int16") {
+                        requested.set_sample_format(stt::SAMPLE_FORMAT_INT16);
                     }
 
-                    bool started = user_data->stt_client->StartStream(stt_config,
-                        [this, fe_sid = current_session_id, ws_captured = ws](const grpc::Status& status) { 
-                            if (uWS::Loop::get()) { 
-                                uWS::Loop::get()->defer([this, fe_sid, status, ws_captured]() {
-                                    std::cout << "[" << fe_sid << "] STT gRPC stream Finish callback. Status: ("
-                                              << status.error_code() << ") " << svToString(status.error_message()) << std::endl;
-                                    
-                                    WebSocketConnection* current_ws_deferred = find_websocket_by_session_id(fe_sid);
-                                    if (current_ws_deferred && current_ws_deferred == ws_captured) {
-                                        PerSocketData* current_data_deferred = current_ws_deferred->getUserData();
-                                        if (current_data_deferred) {
-                                           current_data_deferred->stt_stream_active = false; 
-                                           std::cout << "[" << fe_sid << "] STT stream marked as inactive by gRPC callback." << std::endl;
-                                        }
-                                        nlohmann::json response_msg;
-                                        if (!status.ok() && status.error_code() != grpc::StatusCode::CANCELLED) { 
-                                            response_msg = {
-                                                {"type", "error"}, {"source", "stt_service_grpc_finish"},
-                                                {"code", status.error_code()}, {"message", svToString(status.error_message())}
-                                            };
-                                        } else if (status.ok()){ 
-                                            response_msg = { {"type", "stt_stream_ended_by_server"}, {"sessionId", fe_sid} };
-                                        }
-                                        if (!response_msg.empty()) {
-                                           current_ws_deferred->send(response_msg.dump(), uWS::OpCode::TEXT);
-                                        }
-                                    }
-                                });
-                            } else {
-                                 std::cerr << "[" << fe_sid << "] uWS::Loop not available in STT Finish callback." << std::endl;
-                            }
-                        });
-
-                    if (started) {
-                        user_data->stt_stream_active = true; 
-                        std::cout << "[" << current_session_id << "] STTClient->StartStream succeeded. STT stream active." << std::endl;
-                        ws->send("{\"type\":\"stt_stream_started\"}", uWS::OpCode::TEXT);
-                        std::cout << "[" << current_session_id << "] Sent 'stt_stream_started' to client." << std::endl;
+                    // 입장 제어: 이전 턴의 슬롯을 아직 들고 있으면 그대로 새 턴에 사용
+                    if (user_data->holds_turn_slot) {
+                        start_stt_stream(ws, user_data, requested, now);
+                    } else if (user_data->admission_ticket != 0) {
+                        // 이미 대기 중: 순서는 유지하고 새 턴 설정만 반영
+                        queued_turns_[user_data->admission_ticket].config = requested;
                     } else {
-                        std::cerr << "[" << current_session_id << "] ❌ FAILED to start STT stream with STTClient->StartStream." << std::endl;
-                        ws->send("{\"type\":\"error\", \"message\":\"Failed to start STT stream with STT service (client init failed)\"}", uWS::OpCode::TEXT);
-                        user_data->stt_stream_active = false; 
+                        AdmissionController::Ticket ticket = 0;
+                        switch (admission_.RequestTurn(timeline_ms(), &ticket)) {
+                            case AdmissionController::Decision::kAdmitted:
+                                user_data->holds_turn_slot = true;
+                                admission_queue_wait_ms_.Observe(0);
+                                start_stt_stream(ws, user_data, requested, now);
+                                break;
+                            case AdmissionController::Decision::kQueued: {
+                                user_data->admission_ticket = ticket;
+                                queued_turns_[ticket] = QueuedTurn{ws, requested};
+                                timelines_.Record(user_data->timeline_slot, SessionTimelineStore::Event::kAdmissionQueued, new_turn_id, timeline_ms());
+                                std::cout << "[" << current_session_id << "] ⏳ Turn " << new_turn_id << " queued for admission ("
+                                          << admission_.queue_depth() << " waiting, " << admission_.active_turns() << " active)." << std::endl;
+                                nlohmann::json queued_msg = {
+                                    {"type", "admission_queued"},
+                                    {"turnId", new_turn_id},
+                                    {"timeoutMs", admission_.config().queue_timeout.count()}
+                                };
+                                ws->send(queued_msg.dump(), uWS::OpCode::TEXT);
+                                break;
+                            }
+                            case AdmissionController::Decision::kRejected:
+                                send_busy(ws, user_data, "turn", "queue_full");
+                                break;
+                        }
                     }
                 } else if (type == "utterance_ended" || type == "stop_stream") {
                      std::cout << "[" << current_session_id << "] Processing '" << type << "' message." << std::endl;
-                        if (user_data->stt_client && user_data->stt_stream_active) { 
+                        if (type == "stop_stream" && user_data->admission_ticket != 0) {
+                            // 아직 입장 대기 중인 턴은 대기열에서만 빼면 됨
+                            admission_.Cancel(user_data->admission_ticket);
+                            queued_turns_.erase(user_data->admission_ticket);
+                            user_data->admission_ticket = 0;
+                            ws->send("{\"type\":\"stream_stopping_acknowledged\"}", uWS::OpCode::TEXT);
+                        } else if (user_data->stt_client && user_data->stt_stream_active) {
                             std::cout << "[" << current_session_id << "] Calling STTClient->WritesDoneAndFinish() for '" << type << "'." << std::endl;
                             user_data->stt_client->WritesDoneAndFinish(); 
+                            // 이 턴은 더 이상 오디오를 받지 않음. LLM/TTS가 마무리되는 동안 다음 start_stream을 바로 시작할 수 있음
+                            user_data->stt_stream_active = false;
+                            user_data->last_stt_use_tick = now;
+                            // stop_stream도 발화를 끝내고 응답을 기다리므로 같은 기준점으로 기록
+                            timelines_.Record(user_data->timeline_slot, SessionTimelineStore::Event::kUtteranceEnded, user_data->turn_id, timeline_ms());
+                            // 이 턴의 첫 응답 프레임이 turn_response_deadline 안에 와야 함
+                            if (liveness_.turn_response_deadline.count() > 0) {
+                                user_data->turn_deadline_tick = now + to_ticks(liveness_.turn_response_deadline);
+                                arm_liveness_timer(ws, now);
+                            }
                             if (type == "stop_stream") { 
                                 ws->send("{\"type\":\"stream_stopping_acknowledged\"}", uWS::OpCode::TEXT);
                             }
@@ -290,6 +431,20 @@ void WebSocketServer::on_websocket_message(WebSocketConnection* ws, std::string_
                             std::cout << "[" << current_session_id << "] STT stream not active or stt_client null. Ignoring '" << type << "'." << std::endl;
                             ws->send("{\"type\":\"info\", \"message\":\"STT stream not active for " + type + "\"}", uWS::OpCode::TEXT);
                         }
+                } else if (type == "clock_sync") {
+                    // NTP 방식 오프셋 추정: 클라이언트 t0(송신), 서버 t1(수신)/t2(응답 송신), 클라이언트 t3(수신)
+                    // offset = ((t1 - t0) + (t2 - t3)) / 2, 최소 RTT 샘플을 사용하는 것은 클라이언트 몫
+                    const uint32_t t1 = timeline_ms();
+                    if (ctrl_msg.contains("framedAudio")) {
+                        user_data->framed_audio = ctrl_msg.value("framedAudio", false);
+                    }
+                    nlohmann::json reply = {
+                        {"type", "clock_sync_reply"},
+                        {"t0", ctrl_msg.value("t0", 0.0)},
+                        {"t1", t1},
+                        {"t2", timeline_ms()}
+                    };
+                    ws->send(reply.dump(), uWS::OpCode::TEXT);
                 } else if (type == "heartbeat") {
                     ws->send("{\"type\":\"heartbeat_ack\"}", uWS::OpCode::TEXT);
                 } else {
@@ -309,12 +464,21 @@ void WebSocketServer::on_websocket_message(WebSocketConnection* ws, std::string_
         }
 
     } else if (op_code == uWS::OpCode::BINARY) {
-        if (user_data->stt_client && user_data->stt_stream_active) { 
+        if (accepts_audio(*user_data)) {
+            user_data->last_stt_use_tick = now;
+            const uint32_t now_ms = timeline_ms();
+            const auto verdict = rate_limiter_.AdmitAudio(user_data->rate_limit, message.length(), now_ms);
+            if (verdict != UpstreamRateLimiter::Verdict::kAllowed) {
+                // STT로 보내지 않고 버림. 클라이언트는 rate_limited 알림을 보고 전송 속도를 낮춰야 함
+                warn_rate_limited(ws, user_data, "audio", verdict,
+                                  rate_limiter_.AudioRetryAfterMs(user_data->rate_limit, message.length()), now_ms);
+                return;
+            }
             total_audio_bytes_processed_stt_ += message.length();
-            if (!user_data->stt_client->WriteAudioChunk(std::string(message))) { 
+            timelines_.Record(user_data->timeline_slot, SessionTimelineStore::Event::kFirstAudioIn, user_data->turn_id, now_ms);
+            if (!user_data->stt_client->WriteAudioChunk(svToString(message))) { 
                  std::cerr << "[" << current_session_id << "] ❌ FAILED to write audio chunk to STTClient. Marking STT stream as inactive and stopping." << std::endl;
-                 user_data->stt_stream_active = false; 
-                 user_data->stt_client->StopStreamNow(); 
+                 cancel_active_stt_stream(*user_data);
                  
                  nlohmann::json err_msg = {{"type", "error"}, {"source", "audio_chunk_send"}, {"message", "Failed to send audio to STT service. Please restart."}};
                  ws->send(err_msg.dump(), uWS::OpCode::TEXT);
@@ -325,7 +489,165 @@ void WebSocketServer::on_websocket_message(WebSocketConnection* ws, std::string_
     }
 }
 
-void WebSocketServer::on_websocket_close(WebSocketConnection* ws, int code, std::string_view message) {
+template <bool SSL>
+void WebSocketServerImpl<SSL>::start_stt_stream(WebSocketConnection* ws, PerSocketData* user_data, const stt::RecognitionConfig& requested, uint32_t now) {
+    const std::string_view current_session_id = user_data->sessionId.view();
+    stt::RecognitionConfig stt_config = requested;
+    stt_config.set_frontend_session_id(std::string(current_session_id));
+    stt_config.set_session_id(std::string(current_session_id));
+    stt_config.set_turn_id(user_data->turn_id);
+
+    std::cout << "[" << current_session_id << "] Processing 'start_stream'. Lang: "
+              << stt_config.language() << ", FE_SID: " << stt_config.frontend_session_id()
+              << ", Turn: " << user_data->turn_id << std::endl;
+
+    if (!user_data->stt_client) {
+        // 연결 후 첫 발화 또는 유휴 해제(stt_client_release_after) 이후 첫 발화
+         try {
+            user_data->stt_client = create_stt_client(stt_config.frontend_session_id());
+        } catch (const std::runtime_error& e) {
+             std::cerr << "[" << current_session_id << "] ❌ Failed to recreate STTClient in start_stream: " << e.what() << std::endl;
+             ws->send("{\"type\":\"error\", \"message\":\"STT client error on start_stream.\"}", uWS::OpCode::TEXT);
+             release_turn_slot(user_data);
+             return;
+        }
+    }
+
+    bool started = user_data->stt_client->StartStream(stt_config,
+        [this, fe_sid = stt_config.frontend_session_id(), ws_captured = ws, turn_id = user_data->turn_id](const grpc::Status& status) {
+            // 이 콜백은 STTClient의 completion 스레드에서 호출되므로 uWS::Loop::get()이 아닌 loop_를 사용해야 함
+            if (loop_) {
+                loop_->defer([this, fe_sid, status, ws_captured, turn_id]() {
+                    std::cout << "[" << fe_sid << "] STT gRPC stream Finish callback. Status: ("
+                              << status.error_code() << ") " << svToString(status.error_message()) << std::endl;
+
+                    WebSocketConnection* current_ws_deferred = find_websocket_by_session_id(fe_sid);
+                    if (current_ws_deferred && current_ws_deferred == ws_captured) {
+                        finish_turn_output(fe_sid, turn_id);
+                        PerSocketData* current_data_deferred = current_ws_deferred->getUserData();
+                        // 이전 턴의 마무리가 새 턴보다 늦게 끝날 수 있음: 세션 상태는 현재 턴의 종료만 반영
+                        if (current_data_deferred && current_data_deferred->turn_id == turn_id) {
+                           current_data_deferred->stt_stream_active = false;
+                           timelines_.Record(current_data_deferred->timeline_slot, SessionTimelineStore::Event::kSttFinish, turn_id,
+                                             timeline_ms(), static_cast<int32_t>(status.error_code()));
+                           std::cout << "[" << fe_sid << "] STT stream marked as inactive by gRPC callback." << std::endl;
+                           if (!status.ok() && status.error_code() != grpc::StatusCode::CANCELLED) {
+                               // 응답이 오지 않을 턴: 슬롯을 바로 돌려줌
+                               release_turn_slot(current_data_deferred);
+                               dispatch_admissions();
+                           } else if (status.ok() && current_data_deferred->holds_turn_slot &&
+                                      current_data_deferred->turn_deadline_tick == 0 && liveness_.turn_response_deadline.count() > 0) {
+                               // utterance_ended 없이 끝난 발화(비활성 종료 등)도 응답 기한이 지나면 슬롯을 놓도록
+                               const uint32_t finish_tick = now_tick();
+                               current_data_deferred->turn_deadline_tick = finish_tick + to_ticks(liveness_.turn_response_deadline);
+                               arm_liveness_timer(current_ws_deferred, finish_tick);
+                           }
+                        }
+                        nlohmann::json response_msg;
+                        if (!status.ok() && status.error_code() != grpc::StatusCode::CANCELLED) {
+                            response_msg = {
+                                {"type", "error"}, {"source", "stt_service_grpc_finish"},
+                                {"code", status.error_code()}, {"message", svToString(status.error_message())},
+                                {"turnId", turn_id}
+                            };
+                        } else if (status.ok()){
+                            response_msg = { {"type", "stt_stream_ended_by_server"}, {"sessionId", fe_sid}, {"turnId", turn_id} };
+                        }
+                        if (!response_msg.empty()) {
+                           current_ws_deferred->send(response_msg.dump(), uWS::OpCode::TEXT);
+                        }
+                    }
+                });
+            } else {
+                 std::cerr << "[" << fe_sid << "] uWS::Loop not available in STT Finish callback." << std::endl;
+            }
+        });
+
+    if (started) {
+        user_data->stt_stream_active = true;
+        auto& sequencer = turn_sequencers_[stt_config.frontend_session_id()];
+        sequencer.TurnStarted(user_data->turn_id);
+        if (sequencer.turns_in_flight() > 1) {
+            overlapping_turns_++;
+            std::cout << "[" << current_session_id << "] 🔀 Turn " << user_data->turn_id << " started while "
+                      << sequencer.turns_in_flight() - 1 << " previous turn(s) are still responding. Its output waits for them." << std::endl;
+        }
+        arm_liveness_timer(ws, now); // STT 비활성 기한 반영
+        std::cout << "[" << current_session_id << "] STTClient->StartStream succeeded. STT stream active." << std::endl;
+        nlohmann::json started_msg = {{"type", "stt_stream_started"}, {"turnId", user_data->turn_id}};
+        ws->send(started_msg.dump(), uWS::OpCode::TEXT);
+        std::cout << "[" << current_session_id << "] Sent 'stt_stream_started' to client." << std::endl;
+    } else {
+        std::cerr << "[" << current_session_id << "] ❌ FAILED to start STT stream with STTClient->StartStream." << std::endl;
+        ws->send("{\"type\":\"error\", \"message\":\"Failed to start STT stream with STT service (client init failed)\"}", uWS::OpCode::TEXT);
+        user_data->stt_stream_active = false;
+        release_turn_slot(user_data);
+    }
+}
+
+template <bool SSL>
+void WebSocketServerImpl<SSL>::release_turn_slot(PerSocketData* user_data) {
+    if (user_data->holds_turn_slot) {
+        user_data->holds_turn_slot = false;
+        admission_.ReleaseTurn();
+    }
+}
+
+template <bool SSL>
+void WebSocketServerImpl<SSL>::dispatch_admissions() {
+    std::vector<AdmissionController::Admission> admitted;
+    std::vector<AdmissionController::Ticket> expired;
+    admission_.Poll(timeline_ms(), admitted, expired);
+
+    for (const auto& admission : admitted) {
+        auto it = queued_turns_.find(admission.ticket);
+        if (it == queued_turns_.end()) {
+            admission_.ReleaseTurn(); // 세션이 이미 닫힘 (close에서 Cancel하므로 정상 경로에서는 없음)
+            continue;
+        }
+        QueuedTurn turn = std::move(it->second);
+        queued_turns_.erase(it);
+        PerSocketData* user_data = turn.ws->getUserData();
+        user_data->admission_ticket = 0;
+        user_data->holds_turn_slot = true;
+        admission_queue_wait_ms_.Observe(admission.waited_ms);
+        std::cout << "[" << user_data->sessionId << "] 🎟️ Turn " << user_data->turn_id << " admitted after "
+                  << admission.waited_ms << " ms in queue." << std::endl;
+        start_stt_stream(turn.ws, user_data, turn.config, now_tick());
+    }
+    for (AdmissionController::Ticket ticket : expired) {
+        auto it = queued_turns_.find(ticket);
+        if (it == queued_turns_.end()) {
+            continue;
+        }
+        WebSocketConnection* ws = it->second.ws;
+        queued_turns_.erase(it);
+        PerSocketData* user_data = ws->getUserData();
+        user_data->admission_ticket = 0;
+        send_busy(ws, user_data, "turn", "queue_timeout");
+    }
+}
+
+template <bool SSL>
+void WebSocketServerImpl<SSL>::send_busy(WebSocketConnection* ws, PerSocketData* user_data, const char* scope, const char* reason) {
+    const uint32_t retry_after_ms = admission_.RetryAfterMs();
+    std::cerr << "[" << user_data->sessionId << "] 🚧 Busy (" << scope << ", " << reason << ") for "
+              << svToString(ws->getRemoteAddressAsText()) << ". Active turns " << admission_.active_turns()
+              << ", sessions " << admission_.active_sessions() << ", queued " << admission_.queue_depth() << "." << std::endl;
+    nlohmann::json busy_msg = {
+        {"type", "busy"},
+        {"scope", scope},
+        {"reason", reason},
+        {"retryAfterMs", retry_after_ms}
+    };
+    if (std::strcmp(scope, "turn") == 0) {
+        busy_msg["turnId"] = user_data->turn_id;
+    }
+    ws->send(busy_msg.dump(), uWS::OpCode::TEXT);
+}
+
+template <bool SSL>
+void WebSocketServerImpl<SSL>::on_websocket_close(WebSocketConnection* ws, int code, std::string_view message) {
     connected_clients_count_--; 
     PerSocketData *user_data = ws->getUserData();
     if (!user_data) { 
@@ -335,7 +657,21 @@ void WebSocketServer::on_websocket_close(WebSocketConnection* ws, int code, std:
                   << std::endl;
         return;
     }
-    std::string session_id_copy = user_data->sessionId; 
+    if (!user_data->session_admitted) {
+        return; // 입장 거절된 연결 (on_websocket_open에서 바로 종료)
+    }
+    std::string session_id_copy = user_data->sessionId.str(); 
+
+    if (user_data->liveness_timer_id != 0) {
+        timer_wheel_.Cancel(user_data->liveness_timer_id);
+        user_data->liveness_timer_id = 0;
+    }
+    rate_limiter_.Detach(user_data->rate_limit);
+    timelines_.Close(user_data->timeline_slot, timeline_ms(), code);
+    user_data->timeline_slot = SessionTimelineStore::kNoSlot;
+    if (user_data->traced) {
+        traffic_tap_->Record(TraceEventType::kSessionClose, user_data->sessionId.view(), static_cast<uint32_t>(code));
+    }
 
     std::cout << "[" << session_id_copy << "] WebSocket client disconnected. Code: " << code 
               << ", Msg: \"" << svToString(message) << "\""
@@ -347,29 +683,759 @@ void WebSocketServer::on_websocket_close(WebSocketConnection* ws, int code, std:
             std::cout << "[" << session_id_copy << "] Forcing STT stream stop (StopStreamNow) due to WebSocket close." << std::endl;
             user_data->stt_client->StopStreamNow(); 
         }
+        user_data->stt_client.reset();
+        stt_clients_live_--;
     }
 
     {
         std::lock_guard<std::mutex> lock(active_websockets_mutex_);
         active_websockets_.erase(session_id_copy); 
     }
+    turn_sequencers_.erase(session_id_copy);
+    if (session_directory_) {
+        session_directory_->Unregister(session_id_copy);
+    }
+
+    if (user_data->admission_ticket != 0) {
+        admission_.Cancel(user_data->admission_ticket);
+        queued_turns_.erase(user_data->admission_ticket);
+        user_data->admission_ticket = 0;
+    }
+    const bool freed_turn_slot = user_data->holds_turn_slot;
+    release_turn_slot(user_data);
+    admission_.ReleaseSession();
+    if (freed_turn_slot) {
+        dispatch_admissions();
+    }
+}
+
+template <bool SSL>
+void WebSocketServerImpl<SSL>::warn_rate_limited(WebSocketConnection* ws, PerSocketData* user_data, const char* kind,
+                                                 UpstreamRateLimiter::Verdict verdict, uint32_t retry_after_ms, uint32_t now_ms) {
+    if (!rate_limiter_.ShouldWarn(user_data->rate_limit, now_ms)) {
+        return;
+    }
+    const char* scope = UpstreamRateLimiter::VerdictName(verdict);
+    std::cerr << "[" << user_data->sessionId << "] 🚦 Rate limited (" << kind << ", " << scope << ") from "
+              << svToString(ws->getRemoteAddressAsText()) << ". Shedding excess messages." << std::endl;
+    nlohmann::json warn_msg = {
+        {"type", "rate_limited"},
+        {"kind", kind},
+        {"scope", scope},
+        {"retryAfterMs", retry_after_ms}
+    };
+    if (verdict == UpstreamRateLimiter::Verdict::kQuotaExceeded) {
+        warn_msg["message"] = "Session audio quota exhausted. Further audio is ignored.";
+    }
+    ws->send(warn_msg.dump(), uWS::OpCode::TEXT);
+}
+
+template <bool SSL>
+void WebSocketServerImpl<SSL>::cancel_previous_turns(WebSocketConnection* ws, PerSocketData* user_data, uint64_t new_turn_id) {
+    if (!turn_cancel_client_ || new_turn_id <= 1) {
+        return;
+    }
+    // 사용자가 재생 중인 응답 위로 말한 경우만 barge-in. 재생이 끝났거나 아직 첫 프레임 전이면 이전 턴은 계속 진행
+    const bool talking_over_playback = user_data->playing_turn_id != 0 && user_data->playing_turn_id < new_turn_id &&
+                                       user_data->audio_end_pts_ms > timeline_ms();
+    if (!talking_over_playback) {
+        return;
+    }
+    const std::string session_id = user_data->sessionId.str();
+    turn_cancel_client_->CancelTurnsBefore(session_id, new_turn_id);
+    user_data->cancelled_turn_id = new_turn_id - 1;
+
+    // 클라이언트가 재생 버퍼를 비우도록 알림
+    turns_cancelled_++;
+    std::cout << "[" << session_id << "] ✋ Barge-in: cancelling turn " << user_data->playing_turn_id
+              << " (new turn " << new_turn_id << ")." << std::endl;
+    nlohmann::json cancel_msg = {
+        {"type", "turn_cancelled"},
+        {"sessionId", session_id},
+        {"turnId", user_data->playing_turn_id}
+    };
+    ws->send(cancel_msg.dump(), uWS::OpCode::TEXT);
+    user_data->playing_turn_id = 0;
+    user_data->audio_end_pts_ms = 0; // 클라이언트가 재생 버퍼를 비우므로 새 턴은 이어 붙이지 않음
+}
+
+template <bool SSL>
+void WebSocketServerImpl<SSL>::finish_turn_output(const std::string& session_id, uint64_t turn_id) {
+    auto it = turn_sequencers_.find(session_id);
+    if (it == turn_sequencers_.end()) {
+        return;
+    }
+    std::vector<PendingFrame> released;
+    it->second.TurnFinished(turn_id, released);
+    if (it->second.idle()) {
+        turn_sequencers_.erase(it);
+    }
+    if (released.empty()) {
+        return;
+    }
+    std::cout << "[" << session_id << "] 🔀 Turn " << turn_id << " finished. Releasing " << released.size()
+              << " held frame(s) of later turn(s)." << std::endl;
+    bool schedule = false;
+    {
+        std::lock_guard<std::mutex> lock(pending_frames_mutex_);
+        auto& queue = pending_frames_[session_id];
+        for (const PendingFrame& frame : released) {
+            pending_frame_bytes_.fetch_add(frame.payload.size(), std::memory_order_relaxed);
+        }
+        // 보류된 프레임은 그 뒤에 도착한 프레임보다 먼저 나가야 함
+        queue.insert(queue.begin(), std::make_move_iterator(released.begin()), std::make_move_iterator(released.end()));
+        if (!flush_scheduled_) {
+            flush_scheduled_ = true;
+            schedule = true;
+        }
+    }
+    if (schedule) {
+        loop_->defer([this]() { this->flush_pending_frames(); });
+    }
+}
+
+template <bool SSL>
+void WebSocketServerImpl<SSL>::deliver_to_session(const std::string& session_id, uint64_t turn_id, int64_t media_offset_ms,
+                                                  std::string payload, uWS::OpCode op_code) {
+    if (!loop_) {
+        std::cerr << "[" << session_id << "] uWS::Loop not available. Dropping avatar frame." << std::endl;
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pending_frames_mutex_);
+        pending_frame_bytes_.fetch_add(payload.size(), std::memory_order_relaxed);
+        pending_frames_[session_id].push_back(PendingFrame{turn_id, media_offset_ms, std::move(payload), op_code, timeline_ms()});
+        if (flush_scheduled_) {
+            return; // 이번 루프 반복의 flush에 같이 실림
+        }
+        flush_scheduled_ = true;
+    }
+    loop_->defer([this]() { this->flush_pending_frames(); });
+}
+
+template <bool SSL>
+void WebSocketServerImpl<SSL>::stamp_presentation_time(PerSocketData* user_data, uint64_t turn_id, int64_t media_offset_ms,
+                                                       std::string& payload, uWS::OpCode op_code, uint32_t now_ms) {
+    // 턴의 첫 프레임: 지금 + 재생 여유. 이전 턴 오디오가 아직 재생 중이면 그 끝에 이어 붙임
+    if (turn_id != user_data->pts_turn_id || user_data->turn_pts_base_ms == 0) {
+        user_data->pts_turn_id = static_cast<uint32_t>(turn_id);
+        user_data->turn_pts_base_ms = std::max(now_ms + kPlayoutLeadMs, user_data->audio_end_pts_ms);
+    }
+    const uint32_t pts_ms = user_data->turn_pts_base_ms + static_cast<uint32_t>(media_offset_ms);
+
+    if (op_code == uWS::OpCode::BINARY) {
+        const uint32_t end_ms = pts_ms + static_cast<uint32_t>(payload.size() / kPcmBytesPerMs);
+        user_data->audio_end_pts_ms = std::max(user_data->audio_end_pts_ms, end_ms);
+        if (user_data->framed_audio) {
+            // [ptsMs u32 LE][turnId u32 LE][PCM...]
+            char header[8];
+            const uint32_t turn_u32 = static_cast<uint32_t>(turn_id);
+            std::memcpy(header, &pts_ms, sizeof(pts_ms));
+            std::memcpy(header + 4, &turn_u32, sizeof(turn_u32));
+            payload.insert(0, header, sizeof(header));
+        }
+    } else if (!payload.empty() && payload.back() == '}') {
+        // AvatarSyncServiceImpl이 만든 viseme JSON 객체 끝에 필드 추가 (다시 파싱하지 않음)
+        payload.pop_back();
+        payload += ",\"ptsMs\":" + std::to_string(pts_ms) + "}";
+    }
+}
+
+template <bool SSL>
+void WebSocketServerImpl<SSL>::flush_pending_frames() {
+    std::unordered_map<std::string, std::vector<PendingFrame>> batch;
+    {
+        std::lock_guard<std::mutex> lock(pending_frames_mutex_);
+        batch.swap(pending_frames_);
+        flush_scheduled_ = false;
+    }
+
+    bool reschedule = false;
+    bool turn_slots_freed = false;
+    const uint32_t now_ms = timeline_ms();
+    for (auto& [session_id, frames] : batch) {
+        WebSocketConnection* ws = find_websocket_by_session_id(session_id);
+        if (!ws) {
+            for (const PendingFrame& frame : frames) {
+                pending_frame_bytes_.fetch_sub(frame.payload.size(), std::memory_order_relaxed);
+            }
+            continue; // 그 사이 연결이 끊김
+        }
+        PerSocketData* user_data = ws->getUserData();
+        auto sequencer_it = turn_sequencers_.find(session_id);
+        TurnOutputSequencer<PendingFrame>* sequencer = sequencer_it != turn_sequencers_.end() ? &sequencer_it->second : nullptr;
+
+        // 소켓당 한 번의 cork 범위에서 모아 보내 write 시스템 콜을 합침. 한 번에 보내는 프레임 수는 상한을 둠
+        size_t next = 0;
+        size_t sent = 0;
+        ws->cork([&]() {
+            for (; next < frames.size() && sent < kMaxFramesPerSocketPerFlush; ++next) {
+                PendingFrame& frame = frames[next];
+                pending_frame_bytes_.fetch_sub(frame.payload.size(), std::memory_order_relaxed); // PTS 헤더를 붙이기 전 크기
+                // turn_id 0은 턴 정보를 모르는 구버전 송신측 - 항상 전달
+                if (frame.turn_id != 0 && frame.turn_id <= user_data->cancelled_turn_id) {
+                    stale_turn_frames_dropped_++;
+                    continue;
+                }
+                if (sequencer) {
+                    const auto verdict = sequencer->Admit(frame);
+                    if (verdict == TurnOutputSequencer<PendingFrame>::Verdict::kHold) {
+                        turn_frames_held_++; // 이전 턴이 끝나면 finish_turn_output이 다시 큐에 넣음
+                        continue;
+                    }
+                    if (verdict == TurnOutputSequencer<PendingFrame>::Verdict::kStale) {
+                        out_of_order_frames_dropped_++;
+                        continue;
+                    }
+                }
+                if (frame.turn_id != 0) {
+                    user_data->playing_turn_id = static_cast<uint32_t>(frame.turn_id);
+                }
+                if (user_data->turn_deadline_tick != 0 && (frame.turn_id == 0 || frame.turn_id >= user_data->turn_id)) {
+                    user_data->turn_deadline_tick = 0; // 응답이 시작됨
+                }
+                if (user_data->holds_turn_slot && (frame.turn_id == 0 || frame.turn_id >= user_data->turn_id)) {
+                    release_turn_slot(user_data); // 첫 응답 프레임까지가 하위 서비스 부하가 큰 구간
+                    turn_slots_freed = true;
+                }
+                if (frame.media_offset_ms >= 0) {
+                    stamp_presentation_time(user_data, frame.turn_id, frame.media_offset_ms, frame.payload, frame.op_code, now_ms);
+                }
+                frame_queue_delay_ms_.Observe(now_ms - std::min(now_ms, frame.enqueued_ms));
+                timelines_.Record(user_data->timeline_slot,
+                                  frame.op_code == uWS::OpCode::BINARY ? SessionTimelineStore::Event::kFirstAudioOut
+                                                                       : SessionTimelineStore::Event::kLastViseme,
+                                  frame.turn_id != 0 ? static_cast<uint32_t>(frame.turn_id) : user_data->turn_id, now_ms);
+                ws->send(frame.payload, frame.op_code);
+                sent++;
+            }
+        });
+        frames_delivered_ += static_cast<long>(sent);
+        frame_flushes_++;
+
+        if (next < frames.size()) {
+            // 상한을 넘은 프레임은 순서를 유지한 채 다음 루프 반복으로 넘김 (그 사이 도착한 프레임보다 앞)
+            frames_carried_over_ += static_cast<long>(frames.size() - next);
+            std::lock_guard<std::mutex> lock(pending_frames_mutex_);
+            auto& queue = pending_frames_[session_id];
+            queue.insert(queue.begin(), std::make_move_iterator(frames.begin() + static_cast<std::ptrdiff_t>(next)),
+                         std::make_move_iterator(frames.end()));
+            if (!flush_scheduled_) {
+                flush_scheduled_ = true;
+                reschedule = true;
+            }
+        }
+    }
+    if (reschedule) {
+        loop_->defer([this]() { this->flush_pending_frames(); });
+    }
+    if (turn_slots_freed) {
+        dispatch_admissions(); // cork 범위 밖에서 대기 턴 시작
+    }
+}
+
+template <bool SSL>
+void WebSocketServerImpl<SSL>::on_websocket_pong(WebSocketConnection* ws, std::string_view message) {
+    PerSocketData* user_data = ws->getUserData();
+    if (!user_data) return;
+    user_data->last_seen_tick = now_tick();
+
+    // PING payload에 실어 보낸 송신 시각으로 RTT 계산
+    const int64_t now = steady_ms();
+    if (message.size() == sizeof(int64_t)) {
+        int64_t sent_ms = 0;
+        std::memcpy(&sent_ms, message.data(), sizeof(sent_ms));
+        if (sent_ms > 0 && sent_ms <= now) {
+            const int64_t rtt_ms = now - sent_ms;
+            user_data->rtt_ms = static_cast<uint16_t>(std::min<int64_t>(rtt_ms, UINT16_MAX));
+            ping_rtt_ms_.Observe(static_cast<uint32_t>(rtt_ms));
+        }
+    }
+}
+
+template <bool SSL>
+int64_t WebSocketServerImpl<SSL>::steady_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+template <bool SSL>
+uint64_t WebSocketServerImpl<SSL>::read_resident_memory_bytes() {
+    // /proc/self/statm: size resident shared ... (페이지 단위)
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size_pages = 0, resident_pages = 0;
+    if (!(statm >> size_pages >> resident_pages)) {
+        return 0;
+    }
+    return resident_pages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
+
+template <bool SSL>
+uint32_t WebSocketServerImpl<SSL>::now_tick() const {
+    // 100ms 틱 기준 uint32로 약 13년. PerSocketData 타임스탬프를 4바이트로 유지하기 위함
+    return static_cast<uint32_t>((TimerWheel::Clock::now() - liveness_epoch_) / liveness_.timer_tick);
+}
+
+template <bool SSL>
+uint32_t WebSocketServerImpl<SSL>::timeline_ms() const {
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        TimerWheel::Clock::now() - liveness_epoch_).count());
+}
+
+template <bool SSL>
+uint32_t WebSocketServerImpl<SSL>::to_ticks(std::chrono::seconds sec) const {
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(sec) / liveness_.timer_tick);
+}
+
+template <bool SSL>
+uWS::SocketContextOptions WebSocketServerImpl<SSL>::make_socket_context_options(const TlsConfig& tls) {
+    uWS::SocketContextOptions options{};
+    if constexpr (SSL) {
+        auto c_str_or_null = [](const std::string& s) { return s.empty() ? nullptr : s.c_str(); };
+        options.cert_file_name = c_str_or_null(tls.cert_file);
+        options.key_file_name = c_str_or_null(tls.key_file);
+        options.passphrase = c_str_or_null(tls.key_passphrase);
+        options.ca_file_name = c_str_or_null(tls.ca_file);
+        options.dh_params_file_name = c_str_or_null(tls.dh_params_file);
+    }
+    return options;
+}
+
+template <bool SSL>
+void WebSocketServerImpl<SSL>::configure_tls() {
+    if constexpr (SSL) {
+        auto* ctx = static_cast<SSL_CTX*>(app_.getNativeHandle());
+        if (!ctx) {
+            throw std::runtime_error("TLS context not available from uWS app.");
+        }
+        SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+
+        // 오디오 프레임당 암호화 비용: AES-NI가 있으면 AES-128-GCM이 가장 저렴.
+        // 서버 우선순위를 쓰되, ChaCha20을 먼저 제시하는 (AES-NI 없는) 클라이언트에는 ChaCha20 선택
+        SSL_CTX_set_ciphersuites(ctx, "TLS_AES_128_GCM_SHA256:TLS_CHACHA20_POLY1305_SHA256:TLS_AES_256_GCM_SHA384");
+        SSL_CTX_set_cipher_list(ctx, "ECDHE-ECDSA-AES128-GCM-SHA256:ECDHE-RSA-AES128-GCM-SHA256:"
+                                     "ECDHE-ECDSA-CHACHA20-POLY1305:ECDHE-RSA-CHACHA20-POLY1305:"
+                                     "ECDHE-ECDSA-AES256-GCM-SHA384:ECDHE-RSA-AES256-GCM-SHA384");
+        SSL_CTX_set_options(ctx, SSL_OP_CIPHER_SERVER_PREFERENCE | SSL_OP_PRIORITIZE_CHACHA |
+                                 SSL_OP_NO_COMPRESSION | SSL_OP_NO_RENEGOTIATION);
+
+        // 세션 재개: TLS 1.3/1.2 무상태 티켓 + TLS 1.2 session id 캐시
+        if (tls_.session_tickets) {
+            SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+            SSL_CTX_set_num_tickets(ctx, 2);
+        } else {
+            SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+            SSL_CTX_set_num_tickets(ctx, 0);
+        }
+        static const unsigned char kSessionIdContext[] = "realtime-avatar-gateway";
+        SSL_CTX_set_session_id_context(ctx, kSessionIdContext, sizeof(kSessionIdContext) - 1);
+        SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+        SSL_CTX_sess_set_cache_size(ctx, tls_.session_cache_size);
+        SSL_CTX_set_timeout(ctx, static_cast<long>(tls_.session_timeout.count()));
+    }
+}
+
+template <bool SSL>
+void WebSocketServerImpl<SSL>::start_tick_timer() {
+    // 루프당 하나의 us_timer가 타이머 휠을 구동. 세션 수와 무관하게 커널 타이머는 하나뿐
+    tick_timer_ = us_create_timer(reinterpret_cast<struct us_loop_t*>(loop_), 0, sizeof(WebSocketServerImpl*));
+    *static_cast<WebSocketServerImpl**>(us_timer_ext(tick_timer_)) = this;
+    const int tick_ms = static_cast<int>(liveness_.timer_tick.count());
+    us_timer_set(tick_timer_, [](struct us_timer_t* timer) {
+        WebSocketServerImpl* self = *static_cast<WebSocketServerImpl**>(us_timer_ext(timer));
+        self->timer_wheel_.Advance(TimerWheel::Clock::now());
+        if (self->admission_.queue_depth() > 0) {
+            self->dispatch_admissions(); // 대기 기한 만료 + 하위 서비스 힌트 회복 반영
+        }
+        self->publish_loop_snapshot();
+    }, tick_ms, tick_ms);
+}
+
+template <bool SSL>
+void WebSocketServerImpl<SSL>::publish_loop_snapshot() {
+    auto& snap = loop_snapshot_;
+    snap.heartbeat_ms.store(timeline_ms(), std::memory_order_relaxed);
+    snap.liveness_timers.store(timer_wheel_.size(), std::memory_order_relaxed);
+    snap.rate_limit_tracked_ips.store(rate_limiter_.tracked_ips(), std::memory_order_relaxed);
+    const auto& rl = rate_limiter_.stats();
+    for (int i = 0; i < 4; ++i) {
+        snap.audio_frames_shed[i].store(rl.audio_frames_shed[i], std::memory_order_relaxed);
+        snap.control_messages_shed[i].store(rl.control_messages_shed[i], std::memory_order_relaxed);
+    }
+    snap.audio_bytes_shed.store(rl.audio_bytes_shed, std::memory_order_relaxed);
+    snap.rate_limit_warnings.store(rl.warnings_sent, std::memory_order_relaxed);
+    snap.admission_sessions.store(admission_.active_sessions(), std::memory_order_relaxed);
+    snap.admission_active_turns.store(admission_.active_turns(), std::memory_order_relaxed);
+    snap.admission_queue_depth.store(admission_.queue_depth(), std::memory_order_relaxed);
+    const auto& adm = admission_.stats();
+    snap.admission_sessions_rejected.store(adm.sessions_rejected, std::memory_order_relaxed);
+    snap.admission_turns_admitted.store(adm.turns_admitted, std::memory_order_relaxed);
+    snap.admission_turns_queued.store(adm.turns_queued, std::memory_order_relaxed);
+    snap.admission_turns_rejected.store(adm.turns_rejected, std::memory_order_relaxed);
+    snap.admission_turns_expired.store(adm.turns_expired, std::memory_order_relaxed);
+    snap.admission_downstream_blocked.store(adm.downstream_blocked, std::memory_order_relaxed);
+    if constexpr (SSL) {
+        if (auto* ctx = static_cast<SSL_CTX*>(app_.getNativeHandle())) {
+            snap.tls_handshakes.store(SSL_CTX_sess_accept_good(ctx), std::memory_order_relaxed);
+            snap.tls_resumptions.store(SSL_CTX_sess_hits(ctx), std::memory_order_relaxed);
+        }
+    }
+}
+
+template <bool SSL>
+std::string WebSocketServerImpl<SSL>::render_session_debug(std::string_view session_id, size_t slowest) const {
+    if (session_id.empty()) {
+        return timelines_.RenderSlowest(slowest, timeline_ms());
+    }
+    std::string body = timelines_.RenderSession(session_id, timeline_ms());
+    if (body.empty()) {
+        // 살아 있지만 슬롯을 못 받은 세션은 404 대신 기록 안 됨을 알림 (timeline_sessions_not_recorded_total)
+        std::lock_guard<std::mutex> lock(active_websockets_mutex_);
+        if (active_websockets_.count(session_id) > 0) {
+            body = nlohmann::json{
+                {"sessionId", session_id},
+                {"live", true},
+                {"timelineRecorded", false},
+                {"reason", "timeline store full (" + std::to_string(timelines_.capacity()) + " slots)"}
+            }.dump();
+        }
+    }
+    return body;
+}
+
+template <bool SSL>
+bool WebSocketServerImpl<SSL>::event_loop_healthy() const {
+    const uint32_t last_tick_ms = loop_snapshot_.heartbeat_ms.load(std::memory_order_relaxed);
+    return !is_shutting_down_.load() && timeline_ms() - last_tick_ms <= kLoopStallThresholdMs;
+}
+
+template <bool SSL>
+void WebSocketServerImpl<SSL>::arm_liveness_timer(WebSocketConnection* ws, uint32_t now) {
+    PerSocketData* user_data = ws->getUserData();
+    if (user_data->liveness_timer_id != 0) {
+        timer_wheel_.Cancel(user_data->liveness_timer_id);
+        user_data->liveness_timer_id = 0;
+    }
+
+    // 틱은 uint32이므로 언더플로 없이 비교하도록 int64로 계산
+    int64_t due = int64_t{user_data->last_seen_tick} + to_ticks(liveness_.dead_peer_timeout);
+    if (liveness_.ping_interval.count() > 0) {
+        due = std::min<int64_t>(due, int64_t{user_data->last_ping_sent_tick} + to_ticks(liveness_.ping_interval));
+    }
+    if (liveness_.session_idle_timeout.count() > 0) {
+        due = std::min<int64_t>(due, int64_t{user_data->last_activity_tick} + to_ticks(liveness_.session_idle_timeout));
+    }
+    if (user_data->stt_stream_active && liveness_.stt_stream_inactivity_timeout.count() > 0) {
+        due = std::min<int64_t>(due, int64_t{user_data->last_stt_use_tick} + to_ticks(liveness_.stt_stream_inactivity_timeout));
+    } else if (user_data->stt_client && liveness_.stt_client_release_after.count() > 0) {
+        due = std::min<int64_t>(due, int64_t{user_data->last_stt_use_tick} + to_ticks(liveness_.stt_client_release_after));
+    }
+    if (user_data->turn_deadline_tick != 0) {
+        due = std::min<int64_t>(due, user_data->turn_deadline_tick);
+    }
+
+    user_data->liveness_timer_id = timer_wheel_.Schedule(
+        liveness_.timer_tick * std::max<int64_t>(0, due - int64_t{now}),
+        [this, ws]() { this->on_liveness_timer(ws); });
 }
 
-void WebSocketServer::handle_health_check(uWS::HttpResponse<GLOBAL_SSL_ENABLED>* res, uWS::HttpRequest* req) {
+template <bool SSL>
+void WebSocketServerImpl<SSL>::on_liveness_timer(WebSocketConnection* ws) {
+    PerSocketData* user_data = ws->getUserData();
+    user_data->liveness_timer_id = 0; // 이미 휠에서 빠짐
+    const uint32_t now = now_tick();
+    const std::string session_id = user_data->sessionId.str();
+    const int64_t tick_ms = liveness_.timer_tick.count();
+    auto elapsed = [now](uint32_t since) { return int64_t{now} - int64_t{since}; };
+
+    if (elapsed(user_data->last_seen_tick) >= to_ticks(liveness_.dead_peer_timeout)) {
+        dead_peer_closes_++;
+        std::cout << "[" << session_id << "] 💤 No data/pong for " << elapsed(user_data->last_seen_tick) * tick_ms << " ms. Closing dead connection." << std::endl;
+        ws->end(1001, "Connection timed out");
+        return;
+    }
+    if (liveness_.session_idle_timeout.count() > 0 && elapsed(user_data->last_activity_tick) >= to_ticks(liveness_.session_idle_timeout)) {
+        idle_session_closes_++;
+        std::cout << "[" << session_id << "] 💤 Session idle for " << elapsed(user_data->last_activity_tick) * tick_ms << " ms. Closing." << std::endl;
+        ws->end(1000, "Idle timeout");
+        return;
+    }
+
+    if (user_data->stt_stream_active) {
+        if (liveness_.stt_stream_inactivity_timeout.count() > 0 && user_data->stt_client &&
+            elapsed(user_data->last_stt_use_tick) >= to_ticks(liveness_.stt_stream_inactivity_timeout)) {
+            stt_inactivity_finishes_++;
+            std::cout << "[" << session_id << "] 💤 No audio for " << elapsed(user_data->last_stt_use_tick) * tick_ms
+                      << " ms on active STT stream. Finishing utterance." << std::endl;
+            user_data->stt_client->WritesDoneAndFinish();
+            user_data->stt_stream_active = false;
+            user_data->last_stt_use_tick = now;
+        }
+    } else if (user_data->stt_client && liveness_.stt_client_release_after.count() > 0 &&
+               !user_data->stt_client->IsStreamActive() &&
+               elapsed(user_data->last_stt_use_tick) >= to_ticks(liveness_.stt_client_release_after)) {
+        // 유휴 세션은 gRPC 채널/스텁/스레드 슬롯을 들고 있지 않도록 해제. 다음 start_stream에서 다시 생성
+        stt_clients_released_++;
+        stt_clients_live_--;
+        user_data->stt_client.reset();
+    }
+
+    if (user_data->turn_deadline_tick != 0 && int64_t{now} >= int64_t{user_data->turn_deadline_tick}) {
+        turn_deadlines_expired_++;
+        user_data->turn_deadline_tick = 0;
+        if (user_data->holds_turn_slot) {
+            release_turn_slot(user_data);
+            dispatch_admissions();
+        }
+        timelines_.Record(user_data->timeline_slot, SessionTimelineStore::Event::kTurnTimeout, user_data->turn_id, timeline_ms());
+        std::cerr << "[" << session_id << "] ⏰ Turn " << user_data->turn_id << " produced no response within "
+                  << liveness_.turn_response_deadline.count() << " s." << std::endl;
+        if (turn_cancel_client_) {
+            turn_cancel_client_->CancelTurnsBefore(session_id, user_data->turn_id + 1);
+            user_data->cancelled_turn_id = user_data->turn_id;
+        }
+        nlohmann::json timeout_msg = {
+            {"type", "turn_timeout"},
+            {"sessionId", session_id},
+            {"turnId", user_data->turn_id}
+        };
+        ws->send(timeout_msg.dump(), uWS::OpCode::TEXT);
+    }
+
+    if (liveness_.ping_interval.count() > 0 && elapsed(user_data->last_ping_sent_tick) >= to_ticks(liveness_.ping_interval)) {
+        user_data->last_ping_sent_tick = now;
+        const int64_t sent_ms = steady_ms();
+        ws->send(std::string_view(reinterpret_cast<const char*>(&sent_ms), sizeof(sent_ms)), uWS::OpCode::PING);
+    }
+
+    arm_liveness_timer(ws, now);
+}
+
+template <bool SSL>
+void WebSocketServerImpl<SSL>::handle_health_check(uWS::HttpResponse<SSL>* res, uWS::HttpRequest* req) {
     res->writeHeader("Content-Type", "text/plain")->end("OK");
 }
 
-void WebSocketServer::handle_metrics(uWS::HttpResponse<GLOBAL_SSL_ENABLED>* res, uWS::HttpRequest* req) {
+template <bool SSL>
+void WebSocketServerImpl<SSL>::handle_metrics(uWS::HttpResponse<SSL>* res, uWS::HttpRequest* req) {
+    res->writeHeader("Content-Type", "text/plain; version=0.0.4")->end(render_metrics());
+}
+
+template <bool SSL>
+std::string WebSocketServerImpl<SSL>::render_metrics() const {
+    const auto& snap = loop_snapshot_;
     std::string metrics_data = "# HELP connected_clients WebSocket connected clients\n";
     metrics_data += "# TYPE connected_clients gauge\n";
     metrics_data += "connected_clients " + std::to_string(connected_clients_count_.load()) + "\n\n";
 
     metrics_data += "# HELP total_audio_bytes_processed_stt Total audio bytes processed by STT client\n";
     metrics_data += "# TYPE total_audio_bytes_processed_stt counter\n";
-    metrics_data += "total_audio_bytes_processed_stt " + std::to_string(total_audio_bytes_processed_stt_.load()) + "\n";
+    metrics_data += "total_audio_bytes_processed_stt " + std::to_string(total_audio_bytes_processed_stt_.load()) + "\n\n";
+
+    metrics_data += "# HELP turns_cancelled_total Turns interrupted by the user starting a new utterance (barge-in)\n";
+    metrics_data += "# TYPE turns_cancelled_total counter\n";
+    metrics_data += "turns_cancelled_total " + std::to_string(turns_cancelled_.load()) + "\n\n";
+
+    metrics_data += "# HELP stale_turn_frames_dropped_total Audio/viseme frames dropped because their turn was cancelled\n";
+    metrics_data += "# TYPE stale_turn_frames_dropped_total counter\n";
+    metrics_data += "stale_turn_frames_dropped_total " + std::to_string(stale_turn_frames_dropped_.load()) + "\n\n";
+
+    metrics_data += "# HELP overlapping_turns_total Turns started while an earlier turn of the session was still responding\n";
+    metrics_data += "# TYPE overlapping_turns_total counter\n";
+    metrics_data += "overlapping_turns_total " + std::to_string(overlapping_turns_.load()) + "\n\n";
+
+    metrics_data += "# HELP turn_frames_held_total Audio/viseme frames held until an earlier turn finished responding\n";
+    metrics_data += "# TYPE turn_frames_held_total counter\n";
+    metrics_data += "turn_frames_held_total " + std::to_string(turn_frames_held_.load()) + "\n\n";
+
+    metrics_data += "# HELP out_of_order_frames_dropped_total Frames of an earlier turn that arrived after a later turn's output started\n";
+    metrics_data += "# TYPE out_of_order_frames_dropped_total counter\n";
+    metrics_data += "out_of_order_frames_dropped_total " + std::to_string(out_of_order_frames_dropped_.load()) + "\n\n";
+
+    metrics_data += "# HELP avatar_frames_delivered_total Audio/viseme frames sent to clients\n";
+    metrics_data += "# TYPE avatar_frames_delivered_total counter\n";
+    metrics_data += "avatar_frames_delivered_total " + std::to_string(frames_delivered_.load()) + "\n\n";
+
+    metrics_data += "# HELP avatar_frame_flushes_total Corked per-socket send batches (frames_delivered / flushes = frames per write)\n";
+    metrics_data += "# TYPE avatar_frame_flushes_total counter\n";
+    metrics_data += "avatar_frame_flushes_total " + std::to_string(frame_flushes_.load()) + "\n\n";
+
+    frame_queue_delay_ms_.Render(metrics_data, "avatar_frame_queue_delay_ms",
+                                 "Time from AvatarSync handing a frame to the gateway until it is written to the socket");
+
+    metrics_data += "# HELP avatar_frames_carried_over_total Frames deferred to the next loop iteration by the per-socket cap\n";
+    metrics_data += "# TYPE avatar_frames_carried_over_total counter\n";
+    metrics_data += "avatar_frames_carried_over_total " + std::to_string(frames_carried_over_.load()) + "\n\n";
+    metrics_data += "# HELP avatar_frame_backlog_bytes Avatar frame bytes queued for the event loop but not yet sent\n";
+    metrics_data += "# TYPE avatar_frame_backlog_bytes gauge\n";
+    metrics_data += "avatar_frame_backlog_bytes " + std::to_string(pending_frame_bytes()) + "\n\n";
+
+    using Verdict = UpstreamRateLimiter::Verdict;
+    metrics_data += "# HELP rate_limit_enabled Whether upstream rate limiting is enforced\n";
+    metrics_data += "# TYPE rate_limit_enabled gauge\n";
+    metrics_data += "rate_limit_enabled " + std::string(rate_limiter_.config().enabled ? "1" : "0") + "\n\n";
+
+    metrics_data += "# HELP rate_limit_audio_bytes_per_second Configured audio upload limit (0 = unlimited)\n";
+    metrics_data += "# TYPE rate_limit_audio_bytes_per_second gauge\n";
+    metrics_data += "rate_limit_audio_bytes_per_second{scope=\"session\"} " + std::to_string(static_cast<long>(rate_limiter_.session_audio_bytes_per_sec())) + "\n";
+    metrics_data += "rate_limit_audio_bytes_per_second{scope=\"ip\"} " + std::to_string(static_cast<long>(rate_limiter_.ip_audio_bytes_per_sec())) + "\n\n";
+
+    metrics_data += "# HELP rate_limit_tracked_ips Remote IPs with at least one open connection\n";
+    metrics_data += "# TYPE rate_limit_tracked_ips gauge\n";
+    metrics_data += "rate_limit_tracked_ips " + std::to_string(snap.rate_limit_tracked_ips.load(std::memory_order_relaxed)) + "\n\n";
 
-    res->writeHeader("Content-Type", "text/plain; version=0.0.4")->end(metrics_data);
+    metrics_data += "# HELP rate_limit_audio_frames_shed_total Audio frames not forwarded to STT, by limit that was hit\n";
+    metrics_data += "# TYPE rate_limit_audio_frames_shed_total counter\n";
+    for (Verdict v : {Verdict::kSessionLimited, Verdict::kIpLimited, Verdict::kQuotaExceeded}) {
+        metrics_data += "rate_limit_audio_frames_shed_total{scope=\"" + std::string(UpstreamRateLimiter::VerdictName(v)) + "\"} "
+                      + std::to_string(snap.audio_frames_shed[static_cast<int>(v)].load(std::memory_order_relaxed)) + "\n";
+    }
+    metrics_data += "\n# HELP rate_limit_audio_bytes_shed_total Audio bytes not forwarded to STT\n";
+    metrics_data += "# TYPE rate_limit_audio_bytes_shed_total counter\n";
+    metrics_data += "rate_limit_audio_bytes_shed_total " + std::to_string(snap.audio_bytes_shed.load(std::memory_order_relaxed)) + "\n\n";
+
+    metrics_data += "# HELP rate_limit_control_messages_shed_total Control (TEXT) messages dropped before parsing\n";
+    metrics_data += "# TYPE rate_limit_control_messages_shed_total counter\n";
+    for (Verdict v : {Verdict::kSessionLimited, Verdict::kIpLimited}) {
+        metrics_data += "rate_limit_control_messages_shed_total{scope=\"" + std::string(UpstreamRateLimiter::VerdictName(v)) + "\"} "
+                      + std::to_string(snap.control_messages_shed[static_cast<int>(v)].load(std::memory_order_relaxed)) + "\n";
+    }
+    metrics_data += "\n# HELP rate_limit_warnings_sent_total rate_limited notices sent to clients\n";
+    metrics_data += "# TYPE rate_limit_warnings_sent_total counter\n";
+    metrics_data += "rate_limit_warnings_sent_total " + std::to_string(snap.rate_limit_warnings.load(std::memory_order_relaxed)) + "\n\n";
+
+    const auto& adm_cfg = admission_.config();
+    metrics_data += "# HELP admission_limit Configured admission limits (0 = unlimited)\n";
+    metrics_data += "# TYPE admission_limit gauge\n";
+    metrics_data += "admission_limit{kind=\"sessions\"} " + std::to_string(adm_cfg.max_sessions) + "\n";
+    metrics_data += "admission_limit{kind=\"active_turns\"} " + std::to_string(adm_cfg.max_active_turns) + "\n";
+    metrics_data += "admission_limit{kind=\"queue\"} " + std::to_string(adm_cfg.queue_capacity) + "\n\n";
+
+    metrics_data += "# HELP admission_active Admitted sessions and turns holding a slot (start_stream until first response frame)\n";
+    metrics_data += "# TYPE admission_active gauge\n";
+    metrics_data += "admission_active{kind=\"sessions\"} " + std::to_string(snap.admission_sessions.load(std::memory_order_relaxed)) + "\n";
+    metrics_data += "admission_active{kind=\"turns\"} " + std::to_string(snap.admission_active_turns.load(std::memory_order_relaxed)) + "\n\n";
+
+    metrics_data += "# HELP admission_queue_depth Turns waiting for a slot\n";
+    metrics_data += "# TYPE admission_queue_depth gauge\n";
+    metrics_data += "admission_queue_depth " + std::to_string(snap.admission_queue_depth.load(std::memory_order_relaxed)) + "\n\n";
+
+    metrics_data += "# HELP admission_turns_total Turn admission outcomes\n";
+    metrics_data += "# TYPE admission_turns_total counter\n";
+    metrics_data += "admission_turns_total{result=\"admitted\"} " + std::to_string(snap.admission_turns_admitted.load(std::memory_order_relaxed)) + "\n";
+    metrics_data += "admission_turns_total{result=\"queued\"} " + std::to_string(snap.admission_turns_queued.load(std::memory_order_relaxed)) + "\n";
+    metrics_data += "admission_turns_total{result=\"rejected_queue_full\"} " + std::to_string(snap.admission_turns_rejected.load(std::memory_order_relaxed)) + "\n";
+    metrics_data += "admission_turns_total{result=\"rejected_queue_timeout\"} " + std::to_string(snap.admission_turns_expired.load(std::memory_order_relaxed)) + "\n\n";
+
+    metrics_data += "# HELP admission_sessions_rejected_total Connections closed with busy because the session limit was reached\n";
+    metrics_data += "# TYPE admission_sessions_rejected_total counter\n";
+    metrics_data += "admission_sessions_rejected_total " + std::to_string(snap.admission_sessions_rejected.load(std::memory_order_relaxed)) + "\n\n";
+
+    metrics_data += "# HELP admission_downstream_blocked_total Admission checks refused by the downstream capacity hint\n";
+    metrics_data += "# TYPE admission_downstream_blocked_total counter\n";
+    metrics_data += "admission_downstream_blocked_total " + std::to_string(snap.admission_downstream_blocked.load(std::memory_order_relaxed)) + "\n\n";
+
+    metrics_data += "# HELP timeline_sessions_not_recorded_total Sessions opened while every debug timeline slot was held by a live session\n";
+    metrics_data += "# TYPE timeline_sessions_not_recorded_total counter\n";
+    metrics_data += "timeline_sessions_not_recorded_total " + std::to_string(timelines_.sessions_not_recorded()) + "\n\n";
+
+    admission_queue_wait_ms_.Render(metrics_data, "admission_queue_wait_ms",
+                                    "Time a turn waited for an admission slot (0 when admitted immediately)");
+
+    if (traffic_tap_) {
+        metrics_data += "# HELP traffic_tap_events_total Sampled session events handed to the trace writer\n";
+        metrics_data += "# TYPE traffic_tap_events_total counter\n";
+        metrics_data += "traffic_tap_events_total{result=\"recorded\"} " + std::to_string(traffic_tap_->events_recorded()) + "\n";
+        metrics_data += "traffic_tap_events_total{result=\"dropped\"} " + std::to_string(traffic_tap_->events_dropped()) + "\n\n";
+        metrics_data += "# HELP traffic_tap_bytes_written_total Trace bytes written to disk\n";
+        metrics_data += "# TYPE traffic_tap_bytes_written_total counter\n";
+        metrics_data += "traffic_tap_bytes_written_total " + std::to_string(traffic_tap_->bytes_written()) + "\n\n";
+    }
+
+    ping_rtt_ms_.Render(metrics_data, "websocket_ping_rtt_ms", "WebSocket ping/pong round-trip time");
+
+    metrics_data += "# HELP liveness_closes_total Connections closed by the liveness timer\n";
+    metrics_data += "# TYPE liveness_closes_total counter\n";
+    metrics_data += "liveness_closes_total{reason=\"dead_peer\"} " + std::to_string(dead_peer_closes_.load()) + "\n";
+    metrics_data += "liveness_closes_total{reason=\"idle\"} " + std::to_string(idle_session_closes_.load()) + "\n\n";
+
+    metrics_data += "# HELP stt_inactivity_finishes_total STT streams finished because no audio arrived\n";
+    metrics_data += "# TYPE stt_inactivity_finishes_total counter\n";
+    metrics_data += "stt_inactivity_finishes_total " + std::to_string(stt_inactivity_finishes_.load()) + "\n\n";
+
+    metrics_data += "# HELP stt_clients_created_total STT clients created (lazily, on first start_stream)\n";
+    metrics_data += "# TYPE stt_clients_created_total counter\n";
+    metrics_data += "stt_clients_created_total " + std::to_string(stt_clients_created_.load()) + "\n\n";
+
+    metrics_data += "# HELP stt_clients_live STT clients currently held by sessions\n";
+    metrics_data += "# TYPE stt_clients_live gauge\n";
+    metrics_data += "stt_clients_live " + std::to_string(stt_clients_live_.load()) + "\n\n";
+
+    metrics_data += "# HELP stt_clients_released_total Idle STT clients released\n";
+    metrics_data += "# TYPE stt_clients_released_total counter\n";
+    metrics_data += "stt_clients_released_total " + std::to_string(stt_clients_released_.load()) + "\n\n";
+
+    metrics_data += "# HELP turn_deadlines_expired_total Turns with no response frame before the deadline\n";
+    metrics_data += "# TYPE turn_deadlines_expired_total counter\n";
+    metrics_data += "turn_deadlines_expired_total " + std::to_string(turn_deadlines_expired_.load()) + "\n\n";
+
+    metrics_data += "# HELP liveness_timers Pending per-session liveness timers\n";
+    metrics_data += "# TYPE liveness_timers gauge\n";
+    metrics_data += "liveness_timers " + std::to_string(snap.liveness_timers.load(std::memory_order_relaxed)) + "\n\n";
+
+    metrics_data += "# HELP per_socket_data_bytes Inline per-connection state size (sizeof(PerSocketData))\n";
+    metrics_data += "# TYPE per_socket_data_bytes gauge\n";
+    metrics_data += "per_socket_data_bytes " + std::to_string(sizeof(PerSocketData)) + "\n\n";
+
+    metrics_data += "# HELP process_resident_memory_bytes Resident memory size in bytes\n";
+    metrics_data += "# TYPE process_resident_memory_bytes gauge\n";
+    metrics_data += "process_resident_memory_bytes " + std::to_string(read_resident_memory_bytes()) + "\n";
+
+    metrics_data += "# HELP event_loop_last_tick_age_ms Time since the audio event loop last ran its tick timer\n";
+    metrics_data += "# TYPE event_loop_last_tick_age_ms gauge\n";
+    metrics_data += "event_loop_last_tick_age_ms " + std::to_string(timeline_ms() - snap.heartbeat_ms.load(std::memory_order_relaxed)) + "\n";
+
+    if constexpr (SSL) {
+        metrics_data += "\n# HELP tls_handshakes_total Completed server-side TLS handshakes\n";
+        metrics_data += "# TYPE tls_handshakes_total counter\n";
+        metrics_data += "tls_handshakes_total " + std::to_string(snap.tls_handshakes.load(std::memory_order_relaxed)) + "\n\n";
+
+        metrics_data += "# HELP tls_session_resumptions_total TLS handshakes resumed from a session ticket or cache\n";
+        metrics_data += "# TYPE tls_session_resumptions_total counter\n";
+        metrics_data += "tls_session_resumptions_total " + std::to_string(snap.tls_resumptions.load(std::memory_order_relaxed)) + "\n";
+    }
+    return metrics_data;
+}
+
+
+std::unique_ptr<WebSocketServer> WebSocketServer::Create(int ws_port, int metrics_port, const std::string& stt_service_addr,
+                                                         std::shared_ptr<TurnCancelClient> turn_cancel_client,
+                                                         STTClientFactory stt_client_factory,
+                                                         LivenessConfig liveness_config,
+                                                         const TlsConfig& tls_config,
+                                                         const RateLimitConfig& rate_limit_config,
+                                                         std::shared_ptr<TrafficTap> traffic_tap,
+                                                         std::shared_ptr<SessionDirectory> session_directory,
+                                                         const AdmissionConfig& admission_config,
+                                                         AdmissionController::CapacityHint capacity_hint) {
+    if (tls_config.enabled) {
+        if (tls_config.cert_file.empty() || tls_config.key_file.empty()) {
+            throw std::runtime_error("TLS enabled but certificate or key file is not set.");
+        }
+        return std::make_unique<WebSocketServerImpl<true>>(ws_port, metrics_port, stt_service_addr, std::move(turn_cancel_client),
+                                                           std::move(stt_client_factory), liveness_config, tls_config,
+                                                           rate_limit_config, std::move(traffic_tap),
+                                                           std::move(session_directory), admission_config,
+                                                           std::move(capacity_hint));
+    }
+    return std::make_unique<WebSocketServerImpl<false>>(ws_port, metrics_port, stt_service_addr, std::move(turn_cancel_client),
+                                                        std::move(stt_client_factory), liveness_config, tls_config,
+                                                        rate_limit_config, std::move(traffic_tap),
+                                                        std::move(session_directory), admission_config,
+                                                        std::move(capacity_hint));
 }
 
+template class WebSocketServerImpl<false>;
+template class WebSocketServerImpl<true>;
 
 } // namespace websocket_gateway
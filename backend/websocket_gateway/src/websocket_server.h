@@ -5,15 +5,25 @@
 #include <string>
 #include <functional>
 #include <map>
+#include <unordered_map>
+#include <vector>
 #include <mutex>
 #include <atomic>
 #include <memory>
+#include <chrono>
+#include "turn_cancel_client.h"
+#include "timer_wheel.h"
+#include "rate_limiter.h"
+#include "metrics_server.h"
+#include "traffic_tap.h"
+#include "session_directory.h"
+#include "admission_control.h"
+#include "turn_output_sequencer.h"
 #include "types.h"      // PerSocketData 정의 (이 안에는 stt_client.h가 포함되어야 함)
                         // types.h 내의 PerSocketData::stt_client는 
                         // std::unique_ptr<websocket_gateway::STTClient> 여야 합니다.
 
-// uWebSockets 관련 전역 상수 정의
-constexpr bool GLOBAL_SSL_ENABLED = false;
+// uWebSockets 관련 전역 상수 정의 (TLS 여부는 런타임 TlsConfig로 결정)
 // uWS::DISABLED, uWS::SHARED_COMPRESSOR, uWS::DEDICATED_COMPRESSOR (뒤에 크기 지정 가능)
 constexpr uWS::CompressOptions GLOBAL_COMPRESSION_OPTIONS = uWS::SHARED_COMPRESSOR; 
 constexpr bool GLOBAL_COMPRESSION_ACTUALLY_ENABLED = (GLOBAL_COMPRESSION_OPTIONS != uWS::DISABLED);
@@ -22,47 +32,255 @@ constexpr bool GLOBAL_COMPRESSION_ACTUALLY_ENABLED = (GLOBAL_COMPRESSION_OPTIONS
 namespace uWS { 
     struct HttpRequest;
     template <bool SSL> struct HttpResponse;
+    struct Loop;
 }
 
 namespace websocket_gateway { // WebSocketServer 클래스를 위한 네임스페이스
 
+// 세션 liveness 관리 설정. 0초는 해당 검사 비활성화.
+struct LivenessConfig {
+    std::chrono::milliseconds timer_tick{100};              // 타이머 휠 해상도
+    std::chrono::seconds ping_interval{20};                 // WebSocket PING 주기 (RTT 측정 겸용)
+    std::chrono::seconds dead_peer_timeout{60};             // 이 시간 동안 아무 수신(pong 포함)이 없으면 연결 종료
+    std::chrono::seconds session_idle_timeout{0};           // 애플리케이션 메시지가 없으면 연결 종료 (기본 비활성)
+    std::chrono::seconds stt_stream_inactivity_timeout{15}; // STT 스트림이 열린 채 오디오가 없으면 발화 종료 처리
+    std::chrono::seconds stt_client_release_after{30};      // STT 미사용 시 STTClient(채널/스텁) 해제
+    std::chrono::seconds turn_response_deadline{30};        // 발화 종료 후 첫 응답 프레임까지의 기한
+};
+
+// 게이트웨이 자체 TLS 종단 설정. enabled=false면 평문 uWS::App 사용.
+struct TlsConfig {
+    bool enabled = false;
+    std::string cert_file;
+    std::string key_file;
+    std::string key_passphrase;
+    std::string ca_file;                          // 클라이언트 인증서 검증용 (선택)
+    std::string dh_params_file;                   // (선택)
+    bool session_tickets = true;                  // 무상태 세션 티켓 재개 (재접속 시 풀 핸드셰이크 생략)
+    std::chrono::seconds session_timeout{3600};   // 티켓/세션 캐시 유효 시간
+    long session_cache_size = 20480;              // 서버 측 세션 캐시 (TLS 1.2 session id 재개용)
+};
+
+// WebSocket 게이트웨이 서버 인터페이스. uWS는 SSL 여부가 타입에 들어가므로
+// 실제 구현(WebSocketServerImpl<SSL>)은 TlsConfig에 따라 Create()에서 선택된다.
 class WebSocketServer {
+public:
+    // 세션별 STT 클라이언트 생성 함수. 인자는 세션 ID.
+    using STTClientFactory = std::function<std::unique_ptr<STTStreamClient>(const std::string& session_id)>;
+
+    // turn_cancel_client가 nullptr이면 barge-in(이전 턴 취소)이 비활성화됨
+    // session_directory가 있으면 세션 열림/닫힘을 등록하고 세션 ID에 레플리카 접두어를 붙임 (다중 게이트웨이)
+    // admission_config/capacity_hint: 세션·턴 입장 제어. 힌트는 uWS 루프 스레드에서 호출되므로 가벼워야 함
+    // stt_client_factory가 nullptr이면 stt_service_addr로 접속하는 STTClient를 사용
+    // TLS 설정 오류(인증서/키 로드 실패 등) 시 std::runtime_error
+    static std::unique_ptr<WebSocketServer> Create(int ws_port, int metrics_port, const std::string& stt_service_addr,
+                                                   std::shared_ptr<TurnCancelClient> turn_cancel_client = nullptr,
+                                                   STTClientFactory stt_client_factory = nullptr,
+                                                   LivenessConfig liveness_config = LivenessConfig{},
+                                                   const TlsConfig& tls_config = TlsConfig{},
+                                                   const RateLimitConfig& rate_limit_config = RateLimitConfig{},
+                                                   std::shared_ptr<TrafficTap> traffic_tap = nullptr,
+                                                   std::shared_ptr<SessionDirectory> session_directory = nullptr,
+                                                   const AdmissionConfig& admission_config = AdmissionConfig{},
+                                                   AdmissionController::CapacityHint capacity_hint = nullptr);
+
+    virtual ~WebSocketServer() = default;
+
+    virtual bool run() = 0;
+    virtual void stop() = 0;
+    virtual bool has_session(const std::string& session_id) = 0;
+
+    // AvatarSync(gRPC 스레드)에서 받은 오디오/viseme 프레임을 세션 소켓으로 전달.
+    // 실제 send는 uWS 루프 스레드에서 수행되며, 그 시점에 이미 취소된 턴의 프레임은 버린다.
+    // media_offset_ms >= 0이면 턴 시작 기준 재생 위치로 보고 세션 타임라인 PTS(ptsMs)를 붙인다.
+    virtual void deliver_to_session(const std::string& session_id, uint64_t turn_id, int64_t media_offset_ms,
+                                    std::string payload, uWS::OpCode op_code) = 0;
+
+    // deliver_to_session으로 받았지만 아직 소켓으로 보내지 않은 프레임 바이트 (AvatarSync 다중화 흐름 제어용)
+    virtual uint64_t pending_frame_bytes() const = 0;
+};
+
+template <bool SSL>
+class WebSocketServerImpl final : public WebSocketServer {
 public:
     // PerSocketData는 types.h에 정의되어 있으며, websocket_gateway::STTClient를 사용해야 함
-    using WebSocketConnection = uWS::WebSocket<GLOBAL_SSL_ENABLED, GLOBAL_COMPRESSION_ACTUALLY_ENABLED, PerSocketData>;
+    using WebSocketConnection = uWS::WebSocket<SSL, GLOBAL_COMPRESSION_ACTUALLY_ENABLED, PerSocketData>;
+
+    WebSocketServerImpl(int ws_port, int metrics_port, const std::string& stt_service_addr,
+                        std::shared_ptr<TurnCancelClient> turn_cancel_client = nullptr,
+                        STTClientFactory stt_client_factory = nullptr,
+                        LivenessConfig liveness_config = LivenessConfig{},
+                        const TlsConfig& tls_config = TlsConfig{},
+                        const RateLimitConfig& rate_limit_config = RateLimitConfig{},
+                        std::shared_ptr<TrafficTap> traffic_tap = nullptr,
+                        std::shared_ptr<SessionDirectory> session_directory = nullptr,
+                        const AdmissionConfig& admission_config = AdmissionConfig{},
+                        AdmissionController::CapacityHint capacity_hint = nullptr);
+    ~WebSocketServerImpl() override;
 
-    WebSocketServer(int ws_port, int metrics_port, const std::string& stt_service_addr);
-    ~WebSocketServer(); // 소멸자 선언
+    bool run() override;
+    void stop() override;
+    bool has_session(const std::string& session_id) override;
+    void deliver_to_session(const std::string& session_id, uint64_t turn_id, int64_t media_offset_ms,
+                            std::string payload, uWS::OpCode op_code) override;
+    uint64_t pending_frame_bytes() const override { return pending_frame_bytes_.load(std::memory_order_relaxed); }
 
-    bool run();
-    void stop();
     WebSocketConnection* find_websocket_by_session_id(const std::string& session_id);
 
 private:
     void initialize_handlers();
     std::string generate_session_id();
+    std::unique_ptr<STTStreamClient> create_stt_client(const std::string& session_id);
 
     // WebSocket 이벤트 핸들러
     void on_websocket_open(WebSocketConnection* ws);
     void on_websocket_message(WebSocketConnection* ws, std::string_view message, uWS::OpCode op_code);
     void on_websocket_close(WebSocketConnection* ws, int code, std::string_view message);
+    void on_websocket_pong(WebSocketConnection* ws, std::string_view message);
+
+    // 타이머 휠 기반 liveness: 세션당 타이머 하나만 두고, 만료 시 모든 조건을 검사한 뒤 다음 기한으로 재등록
+    static int64_t steady_ms();                       // PING payload / RTT 계산용
+    uint32_t now_tick() const;                        // liveness_epoch_ 기준 timer_tick 단위
+    uint32_t to_ticks(std::chrono::seconds sec) const;
+    uint32_t timeline_ms() const;                     // 클럭 동기화/PTS 기준 서버 타임라인 (liveness_epoch_ 기준 ms)
+    static uint64_t read_resident_memory_bytes();    // /metrics 용, 읽기 실패 시 0
+    void start_tick_timer();
+    void publish_loop_snapshot();                     // 루프 스레드 전용 상태를 /metrics 스레드용 atomics로 복사 (tick마다)
+    void arm_liveness_timer(WebSocketConnection* ws, uint32_t now);
+    void on_liveness_timer(WebSocketConnection* ws);
+
+    // 턴 타임라인 오프셋을 세션 타임라인 PTS로 변환해 프레임에 기록 (uWS 루프 스레드)
+    void stamp_presentation_time(PerSocketData* user_data, uint64_t turn_id, int64_t media_offset_ms,
+                                 std::string& payload, uWS::OpCode op_code, uint32_t now_ms);
+
+    // deliver_to_session으로 쌓인 프레임을 소켓별 cork 한 번으로 전송 (uWS 루프 스레드, 루프 반복당 1회)
+    void flush_pending_frames();
+
+    // 속도 제한으로 버린 메시지를 클라이언트에 알림 (세션당 warn_interval마다 최대 1회)
+    void warn_rate_limited(WebSocketConnection* ws, PerSocketData* user_data, const char* kind,
+                           UpstreamRateLimiter::Verdict verdict, uint32_t retry_after_ms, uint32_t now_ms);
+
+    // 입장이 허용된 턴의 STT 스트림 시작 (start_stream 즉시 입장 또는 대기열에서 입장). 실패 시 슬롯 반환
+    void start_stt_stream(WebSocketConnection* ws, PerSocketData* user_data, const stt::RecognitionConfig& requested, uint32_t now);
+    void release_turn_slot(PerSocketData* user_data);
+    // 빈 슬롯을 대기 턴에 배정하고 기한이 지난 대기에는 busy 전송. cork 범위 밖에서 호출
+    void dispatch_admissions();
+    void send_busy(WebSocketConnection* ws, PerSocketData* user_data, const char* scope, const char* reason);
+
+    // 이전 턴 응답이 재생되는 중에 새 턴이 시작되면 (barge-in) 이전 턴(LLM/TTS/클라이언트 재생 버퍼)을 취소.
+    // 재생 전이면 취소하지 않고 턴을 겹쳐 진행
+    void cancel_previous_turns(WebSocketConnection* ws, PerSocketData* user_data, uint64_t new_turn_id);
+    // 턴의 STT 스트림 종료 (= 응답 파이프라인 종료): 이 턴 때문에 보류된 새 턴의 프레임을 전송 큐로 되돌림 (uWS 루프 스레드)
+    void finish_turn_output(const std::string& session_id, uint64_t turn_id);
     
-    // HTTP 라우트 핸들러
-    void handle_health_check(uWS::HttpResponse<GLOBAL_SSL_ENABLED>* res, uWS::HttpRequest* req);
-    void handle_metrics(uWS::HttpResponse<GLOBAL_SSL_ENABLED>* res, uWS::HttpRequest* req);
+    // /metrics 렌더링. 전용 메트릭 스레드에서 호출되므로 atomics와 loop_snapshot_만 읽는다
+    std::string render_metrics() const;
+    // /debug/sessions 렌더링 (메트릭 스레드). session_id가 비어 있으면 느린 세션 slowest개
+    std::string render_session_debug(std::string_view session_id, size_t slowest) const;
+    bool event_loop_healthy() const;                  // 최근 tick 안에 루프가 돌았는지
+    // metrics_port_가 없거나 WS 포트와 같을 때만 사용하는 WS 앱 라우트 (루프 스레드에서 렌더링)
+    void handle_health_check(uWS::HttpResponse<SSL>* res, uWS::HttpRequest* req);
+    void handle_metrics(uWS::HttpResponse<SSL>* res, uWS::HttpRequest* req);
+
+    // TLS: 인증서 옵션 변환 및 SSL_CTX 튜닝(세션 티켓, 암호 스위트 우선순위)
+    static uWS::SocketContextOptions make_socket_context_options(const TlsConfig& tls);
+    void configure_tls();
 
     // 멤버 변수
     int ws_port_;
     int metrics_port_;
     std::string stt_service_address_;
 
-    uWS::TemplatedApp<GLOBAL_SSL_ENABLED> app_; // SSL 비활성화 시 false
+    TlsConfig tls_;
+    uWS::TemplatedApp<SSL> app_;
+    uWS::Loop* loop_ = nullptr; // 생성 스레드(=run() 호출 스레드)의 이벤트 루프. 다른 스레드에서는 이 포인터로만 defer
+
+    std::shared_ptr<TurnCancelClient> turn_cancel_client_;
+    STTClientFactory stt_client_factory_;
+
+    LivenessConfig liveness_;
+    TimerWheel timer_wheel_;             // uWS 루프 스레드에서만 접근
+    TimerWheel::Clock::time_point liveness_epoch_;
+    struct us_timer_t* tick_timer_ = nullptr;
+
+    std::shared_ptr<TrafficTap> traffic_tap_; // nullptr = 트래픽 기록 비활성
+    std::shared_ptr<SessionDirectory> session_directory_; // nullptr = 단일 게이트웨이
+    UpstreamRateLimiter rate_limiter_;   // uWS 루프 스레드에서만 접근 (통계는 loop_snapshot_으로 공개)
+    AdmissionController admission_;      // uWS 루프 스레드에서만 접근 (통계는 loop_snapshot_으로 공개)
+    struct QueuedTurn {
+        WebSocketConnection* ws;         // 소켓 close 시 항목이 먼저 제거됨
+        stt::RecognitionConfig config;   // start_stream의 언어/오디오 형식 (세션/턴 ID는 시작 시 채움)
+    };
+    std::unordered_map<AdmissionController::Ticket, QueuedTurn> queued_turns_;
+    SessionTimelineStore timelines_; // 살아 있는 세션 + 최근 종료 세션. 기록은 루프 스레드, 조회는 메트릭 스레드
+
+    // 루프 스레드 전용 상태의 스냅샷. publish_loop_snapshot()이 tick마다 갱신하고 메트릭 스레드가 읽음
+    struct LoopSnapshot {
+        std::atomic<uint32_t> heartbeat_ms{0};        // timeline_ms 기준 마지막 tick
+        std::atomic<uint64_t> liveness_timers{0};
+        std::atomic<uint64_t> rate_limit_tracked_ips{0};
+        std::atomic<uint64_t> audio_frames_shed[4]{}; // UpstreamRateLimiter::Verdict 인덱스
+        std::atomic<uint64_t> audio_bytes_shed{0};
+        std::atomic<uint64_t> control_messages_shed[4]{};
+        std::atomic<uint64_t> rate_limit_warnings{0};
+        std::atomic<uint64_t> admission_sessions{0};
+        std::atomic<uint64_t> admission_active_turns{0};
+        std::atomic<uint64_t> admission_queue_depth{0};
+        std::atomic<uint64_t> admission_sessions_rejected{0};
+        std::atomic<uint64_t> admission_turns_admitted{0};
+        std::atomic<uint64_t> admission_turns_queued{0};
+        std::atomic<uint64_t> admission_turns_rejected{0};
+        std::atomic<uint64_t> admission_turns_expired{0};
+        std::atomic<uint64_t> admission_downstream_blocked{0};
+        std::atomic<long> tls_handshakes{0};
+        std::atomic<long> tls_resumptions{0};
+    };
+    LoopSnapshot loop_snapshot_;
+    std::unique_ptr<MetricsHttpServer> metrics_server_;
+    static constexpr uint32_t kLoopStallThresholdMs = 2000; // /healthz: 이 시간 동안 tick이 없으면 503
+
+    // AvatarSync 프레임 배치 전송. flush_scheduled_는 pending_frames_mutex_로 보호
+    struct PendingFrame {
+        uint64_t turn_id;
+        int64_t media_offset_ms;
+        std::string payload;
+        uWS::OpCode op_code;
+        uint32_t enqueued_ms; // timeline_ms
+    };
+    static constexpr size_t kMaxFramesPerSocketPerFlush = 32; // 소켓당 루프 반복 1회에 보내는 최대 프레임 수
+    static constexpr uint32_t kPlayoutLeadMs = 100;            // 턴 첫 프레임 PTS = 도착 시각 + 이 여유 (네트워크 지터 흡수)
+    static constexpr uint32_t kPcmBytesPerMs = 32;             // 16kHz 16-bit mono
+    std::unordered_map<std::string, std::vector<PendingFrame>> pending_frames_;
+    std::mutex pending_frames_mutex_;
+    bool flush_scheduled_ = false;
+    std::atomic<uint64_t> pending_frame_bytes_{0};
+    // 겹치는 발화의 응답 순서 보장 (uWS 루프 스레드 전용). 진행 중인 턴이나 보류 프레임이 있는 세션만 항목을 가짐
+    std::unordered_map<std::string, TurnOutputSequencer<PendingFrame>> turn_sequencers_;
 
-    std::map<std::string, WebSocketConnection*> active_websockets_;
-    std::mutex active_websockets_mutex_;
+    // 키는 각 소켓 PerSocketData::sessionId의 인라인 버퍼를 가리킴 (소켓 close 시 함께 제거)
+    std::map<std::string_view, WebSocketConnection*, std::less<>> active_websockets_;
+    mutable std::mutex active_websockets_mutex_;
 
     std::atomic<long> connected_clients_count_{0};
     std::atomic<long> total_audio_bytes_processed_stt_{0};
+    std::atomic<long> turns_cancelled_{0};
+    std::atomic<long> stale_turn_frames_dropped_{0};
+    std::atomic<long> overlapping_turns_{0};          // 이전 턴 응답이 끝나기 전에 시작된 턴
+    std::atomic<long> turn_frames_held_{0};           // 이전 턴이 끝날 때까지 보류된 프레임
+    std::atomic<long> out_of_order_frames_dropped_{0}; // 새 턴이 이미 나간 뒤 도착한 이전 턴 프레임
+    std::atomic<long> dead_peer_closes_{0};
+    std::atomic<long> idle_session_closes_{0};
+    std::atomic<long> stt_inactivity_finishes_{0};
+    std::atomic<long> stt_clients_released_{0};
+    std::atomic<long> turn_deadlines_expired_{0};
+    std::atomic<long> stt_clients_created_{0};
+    std::atomic<long> stt_clients_live_{0};
+    std::atomic<long> frames_delivered_{0};
+    std::atomic<long> frame_flushes_{0};
+    std::atomic<long> frames_carried_over_{0};
+    LatencyHistogram ping_rtt_ms_{{5, 10, 25, 50, 100, 250, 500, 1000, 2500}};
+    LatencyHistogram frame_queue_delay_ms_{{1, 2, 5, 10, 20, 50, 100, 250}}; // deliver_to_session → ws->send
+    LatencyHistogram admission_queue_wait_ms_{{0, 10, 50, 100, 250, 500, 1000, 2000, 5000}}; // start_stream → 턴 슬롯 배정
     
     struct us_listen_socket_t *listen_socket_ws_ = nullptr; // uWebSockets 리슨 소켓
     std::atomic<bool> is_shutting_down_{false};
@@ -0,0 +1,160 @@
+// tests/corked_send_benchmark.cpp
+//
+// 아바타 프레임 전송 경로의 write 시스템 콜 수/처리량 비교: 프레임마다 send vs 소켓당 cork 한 번.
+// uWS 없이 socketpair 위에서 게이트웨이 송신 패턴을 재현한다.
+//   - per-frame: ws->send 한 번 = WebSocket 헤더 + 페이로드 write 한 번 (cork 밖 send)
+//   - corked:    루프 반복마다 소켓당 최대 kMaxFramesPerSocketPerFlush개를 16KB cork 버퍼에 모아 write
+//                (버퍼가 차면 중간에 비우고, 남은 프레임은 다음 반복으로 이월 - flush_pending_frames와 동일)
+// 프레임 구성은 루프백 응답과 같게 50ms 오디오 청크(1600B)마다 viseme JSON 하나 꼴.
+// 시스템 콜 수는 /proc/self/io의 syscw(쓰기 계열 시스템 콜) 증가분이라 strace 없이 커널 값을 그대로 쓴다.
+//
+// 실제 게이트웨이 수치는 loopback_load_generator.py(--gateway-pid)로 측정. 이 도구는 빌드 환경 없이도 돌아가는 근사치용.
+//
+//   cmake -DBUILD_TESTING=ON .. && make corked_send_benchmark
+//   ./corked_send_benchmark [sessions=64] [iterations=2000]
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr size_t kCorkBufferBytes = 16 * 1024;       // uWS LoopData::CORK_BUFFER_SIZE
+constexpr size_t kMaxFramesPerSocketPerFlush = 32;   // WebSocketServerImpl과 동일
+constexpr size_t kAudioChunkBytes = 1600;            // 16kHz 16-bit mono 50ms
+constexpr size_t kVisemeJsonBytes = 120;
+
+uint64_t WriteSyscalls() {
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    uint64_t value = 0;
+    while (io >> key >> value) {
+        if (key == "syscw:") return value;
+    }
+    throw std::runtime_error("/proc/self/io not readable");
+}
+
+void WriteAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        const ssize_t n = ::write(fd, data, size);
+        if (n <= 0) throw std::runtime_error("write failed");
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+// 서버 -> 클라이언트 WebSocket 프레임 (마스크 없음)
+void AppendFrame(std::string& out, size_t payload_size, bool binary) {
+    out.push_back(static_cast<char>(binary ? 0x82 : 0x81));
+    if (payload_size < 126) {
+        out.push_back(static_cast<char>(payload_size));
+    } else {
+        out.push_back(static_cast<char>(126));
+        out.push_back(static_cast<char>((payload_size >> 8) & 0xFF));
+        out.push_back(static_cast<char>(payload_size & 0xFF));
+    }
+    out.append(payload_size, 'x');
+}
+
+struct Result {
+    double mb_per_sec;
+    double writes_per_frame;
+};
+
+Result Run(size_t sessions, size_t iterations, size_t frames_per_iteration, bool corked) {
+    std::vector<int> writers, readers;
+    for (size_t i = 0; i < sessions; ++i) {
+        int fds[2];
+        if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) throw std::runtime_error("socketpair failed");
+        writers.push_back(fds[0]);
+        readers.push_back(fds[1]);
+    }
+
+    // 클라이언트 역할: 모든 소켓을 계속 비움 (송신 버퍼가 차서 write가 막히지 않도록)
+    std::atomic<bool> done{false};
+    std::thread reader([&]() {
+        std::vector<pollfd> pfds;
+        for (int fd : readers) pfds.push_back({fd, POLLIN, 0});
+        std::vector<char> buffer(1 << 16);
+        while (!done.load()) {
+            if (::poll(pfds.data(), pfds.size(), 10) <= 0) continue;
+            for (auto& p : pfds) {
+                if (p.revents & POLLIN) (void)!::read(p.fd, buffer.data(), buffer.size());
+            }
+        }
+    });
+
+    std::vector<size_t> backlog(sessions, 0); // 이월된 프레임 수
+    std::string frame, cork;
+    cork.reserve(kCorkBufferBytes);
+    uint64_t frames = 0, bytes = 0;
+    size_t frame_index = 0;
+
+    const uint64_t syscalls_before = WriteSyscalls();
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t it = 0; it < iterations; ++it) {
+        for (size_t s = 0; s < sessions; ++s) {
+            backlog[s] += frames_per_iteration;
+            const size_t to_send = corked ? std::min(backlog[s], kMaxFramesPerSocketPerFlush) : backlog[s];
+            cork.clear();
+            for (size_t f = 0; f < to_send; ++f, ++frame_index) {
+                const bool viseme = frame_index % 2 == 1;
+                frame.clear();
+                AppendFrame(frame, viseme ? kVisemeJsonBytes : kAudioChunkBytes, !viseme);
+                if (!corked) {
+                    WriteAll(writers[s], frame.data(), frame.size());
+                } else {
+                    if (cork.size() + frame.size() > kCorkBufferBytes) {
+                        WriteAll(writers[s], cork.data(), cork.size());
+                        cork.clear();
+                    }
+                    cork += frame;
+                }
+                bytes += frame.size();
+                frames++;
+            }
+            if (!cork.empty()) {
+                WriteAll(writers[s], cork.data(), cork.size());
+            }
+            backlog[s] -= to_send;
+        }
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const uint64_t syscalls = WriteSyscalls() - syscalls_before;
+
+    done.store(true);
+    reader.join();
+    for (int fd : writers) ::close(fd);
+    for (int fd : readers) ::close(fd);
+    return {bytes / (1024.0 * 1024.0) / elapsed, static_cast<double>(syscalls) / static_cast<double>(frames)};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t sessions = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    const size_t iterations = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+
+    std::printf("sessions=%zu iterations=%zu\n", sessions, iterations);
+    std::printf("%14s %22s %22s %10s\n", "frames/iter", "per-frame MB/s (w/f)", "corked MB/s (w/f)", "speedup");
+    for (size_t frames_per_iteration : {1, 2, 4, 8, 32}) {
+        const Result per_frame = Run(sessions, iterations, frames_per_iteration, false);
+        const Result corked = Run(sessions, iterations, frames_per_iteration, true);
+        std::printf("%14zu %14.1f (%5.2f) %14.1f (%5.2f) %9.2fx\n", frames_per_iteration,
+                    per_frame.mb_per_sec, per_frame.writes_per_frame,
+                    corked.mb_per_sec, corked.writes_per_frame, corked.mb_per_sec / per_frame.mb_per_sec);
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+# tests/idle_memory_benchmark.py
+#
+# 유휴 WebSocket 연결당 게이트웨이 메모리 사용량 측정.
+# N개의 연결을 열고 session_info를 받을 때까지 기다린 뒤, /metrics의
+# process_resident_memory_bytes 증가분을 연결 수로 나눠 출력한다.
+#
+#   python tests/idle_memory_benchmark.py --connections 10000 50000
+#
+# 5만 연결을 위해서는 클라이언트/서버 모두 `ulimit -n`을 충분히 올려야 한다.
+# 단일 출발지 IP의 임시 포트(약 28k) 한계를 피하기 위해 127.0.0.x 여러 주소에서 연결한다.
+
+import argparse
+import asyncio
+import os
+import re
+import time
+import urllib.request
+
+try:
+    import websockets
+except ImportError:
+    print("Error: 'websockets' package not found. Run 'pip install websockets' first.")
+    exit(1)
+
+
+# --- Configuration ---
+GATEWAY_WS_URL = os.getenv("GATEWAY_WS_URL", "ws://127.0.0.1:8000/")
+GATEWAY_METRICS_URL = os.getenv("GATEWAY_METRICS_URL", "http://127.0.0.1:9090/metrics")
+CONNECTIONS_PER_SOURCE_IP = 20000
+SETTLE_SEC = 3.0
+
+
+def read_metrics():
+    with urllib.request.urlopen(GATEWAY_METRICS_URL, timeout=10) as resp:
+        text = resp.read().decode()
+    metrics = {}
+    for line in text.splitlines():
+        match = re.match(r"^([a-zA-Z_:][a-zA-Z0-9_:]*)\s+([0-9.eE+-]+)$", line)
+        if match:
+            metrics[match.group(1)] = float(match.group(2))
+    return metrics
+
+
+async def open_idle_connection(index, ready):
+    host_octet = 1 + index // CONNECTIONS_PER_SOURCE_IP
+    ws = await websockets.connect(
+        GATEWAY_WS_URL,
+        local_addr=(f"127.0.0.{host_octet}", 0),
+        ping_interval=None,  # 서버 PING에는 라이브러리가 자동으로 PONG 응답
+        max_queue=1,
+        open_timeout=60,
+    )
+    await ws.recv()  # session_info
+    ready.append(ws)
+    return ws
+
+
+async def measure(count, concurrency):
+    baseline = read_metrics()
+    ready = []
+    semaphore = asyncio.Semaphore(concurrency)
+
+    async def guarded(i):
+        async with semaphore:
+            try:
+                await open_idle_connection(i, ready)
+            except Exception as e:
+                print(f"  connection {i} failed: {e}")
+
+    start = time.monotonic()
+    await asyncio.gather(*(guarded(i) for i in range(count)))
+    connect_sec = time.monotonic() - start
+    await asyncio.sleep(SETTLE_SEC)
+
+    loaded = read_metrics()
+    opened = len(ready)
+    rss_delta = loaded.get("process_resident_memory_bytes", 0) - baseline.get("process_resident_memory_bytes", 0)
+
+    print(f"--- {count} idle connections ---")
+    print(f"  opened:                 {opened} in {connect_sec:.1f}s")
+    print(f"  connected_clients:      {int(loaded.get('connected_clients', 0))}")
+    print(f"  stt_clients_live:       {int(loaded.get('stt_clients_live', 0))}")
+    print(f"  sizeof(PerSocketData):  {int(loaded.get('per_socket_data_bytes', 0))} bytes")
+    print(f"  RSS delta:              {rss_delta / (1024 * 1024):.1f} MiB")
+    if opened:
+        print(f"  bytes per idle conn:    {rss_delta / opened:.0f}")
+
+    await asyncio.gather(*(ws.close() for ws in ready), return_exceptions=True)
+    await asyncio.sleep(SETTLE_SEC)
+
+
+async def main():
+    parser = argparse.ArgumentParser(description="Gateway idle connection memory benchmark")
+    parser.add_argument("--connections", type=int, nargs="+", default=[10000, 50000])
+    parser.add_argument("--concurrency", type=int, default=500, help="동시에 진행할 핸드셰이크 수")
+    args = parser.parse_args()
+
+    for count in args.connections:
+        await measure(count, args.concurrency)
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -3,13 +3,46 @@
 #include "stt_client.h"
 #include "websocket_server.h"
 #include "avatar_sync_service_impl.h"
+#include "loopback_stt_client.h"
+#include "timer_wheel.h"
+#include "session_timeline.h"
+#include "turn_output_sequencer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using namespace websocket_gateway;
 
 // 기본 PerSocketData 구조체 초기 상태 검증
 TEST(PerSocketDataTest, DefaultValues) {
     PerSocketData data;
-    EXPECT_EQ(data.sessionId, "");
+    EXPECT_TRUE(data.sessionId.empty());
     EXPECT_FALSE(data.stt_stream_active);
     EXPECT_EQ(data.stt_client, nullptr);
+    EXPECT_EQ(data.turn_id, 0u);
+    EXPECT_EQ(data.playing_turn_id, 0u);
+    EXPECT_EQ(data.turn_deadline_tick, 0u);
+    EXPECT_EQ(data.rtt_ms, 0u);
+    EXPECT_EQ(data.liveness_timer_id, 0u);
+}
+
+// SessionId: 32자 hex ID를 인라인 버퍼에 보관, 초과 시 예외
+TEST(SessionIdTest, StoresInlineAndRejectsOversized) {
+    SessionId id;
+    id = std::string(32, 'a');
+    EXPECT_EQ(id.view(), std::string(32, 'a'));
+    id = "abc";
+    EXPECT_EQ(id.str(), "abc");
+    EXPECT_THROW(id = std::string(33, 'b'), std::runtime_error);
+    EXPECT_EQ(id.str(), "abc");
+    // 유휴 연결당 상태가 캐시 라인 두 개 안에 들어가야 함
+    EXPECT_LE(sizeof(PerSocketData), 128u);
 }
 
 // STTClient: 스트림 시작 전 WriteAudioChunk 호출 시 false 반환 확인
@@ -20,18 +53,970 @@ TEST(STTClientTest, WriteAudioChunkWithoutStart) {
 
 // WebSocketServer: 존재하지 않는 세션 ID 조회 시 nullptr 반환 확인
 TEST(WebSocketServerTest, FindWebSocketBySessionIdReturnsNull) {
-    WebSocketServer server(12345, 12345, "localhost:50051");
+    WebSocketServerImpl<false> server(12345, 12345, "localhost:50051");
     EXPECT_EQ(server.find_websocket_by_session_id("nonexistent"), nullptr);
+    EXPECT_FALSE(server.has_session("nonexistent"));
+}
+
+// WebSocketServer: TLS 활성화 시 인증서/키가 없거나 로드할 수 없으면 생성 실패
+TEST(WebSocketServerTest, CreateWithTlsRequiresLoadableCertificate) {
+    TlsConfig tls;
+    tls.enabled = true;
+    EXPECT_THROW(WebSocketServer::Create(12346, 12346, "localhost:50051", nullptr, nullptr, LivenessConfig{}, tls), std::runtime_error);
+
+    tls.cert_file = "/nonexistent/cert.pem";
+    tls.key_file = "/nonexistent/key.pem";
+    EXPECT_THROW(WebSocketServer::Create(12346, 12346, "localhost:50051", nullptr, nullptr, LivenessConfig{}, tls), std::runtime_error);
 }
 
 // AvatarSyncServiceImpl: 기본 생성자와 WebSocketFinder 기본 동작 검증
 TEST(AvatarSyncServiceImplTest, ConstructorWithDefaultFinder) {
     // 기본 WebSocketFinder를 전달하여 객체가 생성되는지 확인
-    AvatarSyncServiceImpl::WebSocketFinder finder;
-    AvatarSyncServiceImpl service(finder);
+    AvatarSyncServiceImpl::WebSocketFinder finder = [](const std::string&) { return false; };
+    AvatarSyncServiceImpl::FrameDeliverer deliverer = [](const std::string&, uint64_t, int64_t, std::string, uWS::OpCode) {};
+    AvatarSyncServiceImpl service(finder, deliverer);
     SUCCEED();
 }
 
+// AvatarSyncServiceImpl: FrameDeliverer가 없으면 생성 실패 (gRPC 스레드에서 직접 send 하는 경로 금지)
+TEST(AvatarSyncServiceImplTest, ConstructorRequiresDeliverer) {
+    AvatarSyncServiceImpl::WebSocketFinder finder = [](const std::string&) { return false; };
+    EXPECT_THROW(AvatarSyncServiceImpl(finder, nullptr), std::runtime_error);
+}
+
+// StaticPeerSessionDirectory: 세션 ID 접두어로 소유 레플리카 주소를 찾음
+TEST(SessionDirectoryTest, StaticPeerRoutesByReplicaPrefix) {
+    auto peers = StaticPeerSessionDirectory::ParsePeers("g0=gateway-0:50055,g1=gateway-1:50055");
+    ASSERT_EQ(peers.size(), 2u);
+    StaticPeerSessionDirectory directory("g1", peers);
+    EXPECT_EQ(directory.self_address(), "gateway-1:50055");
+    EXPECT_EQ(directory.session_id_prefix(), "g1-");
+    EXPECT_EQ(directory.Lookup("g0-0123abcd"), "gateway-0:50055");
+    EXPECT_EQ(directory.Lookup("g1-0123abcd"), "gateway-1:50055");
+    EXPECT_EQ(directory.Lookup("0123abcd"), "");    // 접두어 없는 세션
+    EXPECT_EQ(directory.Lookup("g9-0123abcd"), ""); // 목록에 없는 레플리카
+
+    EXPECT_THROW(StaticPeerSessionDirectory("g2", peers), std::runtime_error);
+    EXPECT_THROW(StaticPeerSessionDirectory("bad-id", peers), std::runtime_error);
+    EXPECT_THROW(StaticPeerSessionDirectory::ParsePeers("g0=gateway-0:50055,g1"), std::runtime_error);
+}
+
+// InMemorySessionDirectory: 같은 테이블을 공유하는 레플리카들, 다른 레플리카의 등록은 지우지 않음
+TEST(SessionDirectoryTest, InMemorySharedTable) {
+    auto table = std::make_shared<InMemorySessionDirectory::Table>();
+    InMemorySessionDirectory a(table, "a:1");
+    InMemorySessionDirectory b(table, "b:1");
+    a.Register("s1");
+    EXPECT_EQ(b.Lookup("s1"), "a:1");
+    b.Unregister("s1");
+    EXPECT_EQ(b.Lookup("s1"), "a:1");
+    a.Unregister("s1");
+    EXPECT_EQ(b.Lookup("s1"), "");
+}
+
+// AvatarSyncServiceImpl: 소켓이 없는 레플리카에 도착한 스트림을 디렉터리의 소유 레플리카로 전달
+TEST(AvatarSyncServiceImplTest, ForwardsStreamToOwningReplica) {
+    auto table = std::make_shared<InMemorySessionDirectory::Table>();
+    std::mutex mutex;
+    std::vector<std::string> owner_frames;
+
+    AvatarSyncServiceImpl owner(
+        [](const std::string& session_id) { return session_id == "s1"; },
+        [&](const std::string&, uint64_t, int64_t, std::string payload, uWS::OpCode) {
+            std::lock_guard<std::mutex> lock(mutex);
+            owner_frames.push_back(std::move(payload));
+        });
+    int owner_port = 0;
+    grpc::ServerBuilder owner_builder;
+    owner_builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &owner_port);
+    owner_builder.RegisterService(&owner);
+    std::unique_ptr<grpc::Server> owner_server = owner_builder.BuildAndStart();
+    ASSERT_TRUE(owner_server);
+    InMemorySessionDirectory owner_directory(table, "127.0.0.1:" + std::to_string(owner_port));
+    owner_directory.Register("s1");
+
+    std::atomic<int> ingress_frames{0};
+    AvatarSyncServiceImpl ingress(
+        [](const std::string&) { return false; },
+        [&](const std::string&, uint64_t, int64_t, std::string, uWS::OpCode) { ingress_frames++; },
+        nullptr, std::make_shared<InMemorySessionDirectory>(table, "ingress"));
+    int ingress_port = 0;
+    grpc::ServerBuilder ingress_builder;
+    ingress_builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &ingress_port);
+    ingress_builder.RegisterService(&ingress);
+    std::unique_ptr<grpc::Server> ingress_server = ingress_builder.BuildAndStart();
+    ASSERT_TRUE(ingress_server);
+
+    auto stub = avatar_sync::AvatarSyncService::NewStub(
+        grpc::CreateChannel("127.0.0.1:" + std::to_string(ingress_port), grpc::InsecureChannelCredentials()));
+    grpc::ClientContext context;
+    google::protobuf::Empty response;
+    auto writer = stub->SyncAvatarStream(&context, &response);
+    avatar_sync::AvatarSyncStreamRequest request;
+    request.mutable_config()->set_frontend_session_id("s1");
+    ASSERT_TRUE(writer->Write(request));
+    request.set_audio_chunk(std::string(640, '\0'));
+    ASSERT_TRUE(writer->Write(request));
+    writer->WritesDone();
+    EXPECT_TRUE(writer->Finish().ok());
+
+    owner_server->Shutdown();
+    ingress_server->Shutdown();
+    EXPECT_EQ(ingress_frames.load(), 0);
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(owner_frames.size(), 1u);
+    EXPECT_EQ(owner_frames[0].size(), 640u);
+}
+
+// AvatarSyncServiceImpl: 다중화 스트림 - 초기 크레딧, 채널별 전달, 없는 세션 채널 거부, 처리량만큼 크레딧 반환
+TEST(AvatarSyncServiceImplTest, MultiplexedChannelsAndCredit) {
+    std::mutex mutex;
+    std::vector<std::string> delivered_sessions;
+    AvatarSyncServiceImpl service(
+        [](const std::string& session_id) { return session_id != "missing"; },
+        [&](const std::string& session_id, uint64_t, int64_t, std::string, uWS::OpCode) {
+            std::lock_guard<std::mutex> lock(mutex);
+            delivered_sessions.push_back(session_id);
+        },
+        nullptr, nullptr, []() -> uint64_t { return 0; });
+    int port = 0;
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+    builder.RegisterService(&service);
+    std::unique_ptr<grpc::Server> server = builder.BuildAndStart();
+    ASSERT_TRUE(server);
+
+    auto stub = avatar_sync::AvatarSyncService::NewStub(
+        grpc::CreateChannel("127.0.0.1:" + std::to_string(port), grpc::InsecureChannelCredentials()));
+    grpc::ClientContext context;
+    auto stream = stub->SyncAvatarMux(&context);
+    avatar_sync::AvatarSyncMuxControl control;
+    ASSERT_TRUE(stream->Read(&control));
+    EXPECT_EQ(control.credit_bytes(), AvatarSyncServiceImpl::kMuxInitialCreditBytes);
+
+    avatar_sync::AvatarSyncMuxFrame frame;
+    const char* sessions[] = {"s1", "s2", "missing"};
+    uint64_t sent_bytes = 0; // open 프레임도 크레딧에 포함
+    for (uint32_t channel = 1; channel <= 3; ++channel) {
+        frame.set_channel_id(channel);
+        frame.mutable_open()->set_frontend_session_id(sessions[channel - 1]);
+        sent_bytes += frame.ByteSizeLong();
+        ASSERT_TRUE(stream->Write(frame));
+    }
+    ASSERT_TRUE(stream->Read(&control));
+    EXPECT_EQ(control.channel_id(), 3u);
+    EXPECT_FALSE(control.channel_error().empty());
+
+    // 크레딧 반환 배치 크기를 넘길 만큼 두 채널에 번갈아 전송 (거부된 채널 3의 프레임은 버려짐)
+    for (int i = 0; i < 12; ++i) {
+        frame.set_channel_id(1 + i % 3);
+        frame.set_audio_chunk(std::string(4096, '\0'));
+        sent_bytes += frame.ByteSizeLong();
+        ASSERT_TRUE(stream->Write(frame));
+    }
+    ASSERT_TRUE(stream->Read(&control));
+    EXPECT_EQ(control.channel_id(), 0u);
+    EXPECT_GE(control.credit_bytes(), AvatarSyncServiceImpl::kMuxCreditBatchBytes);
+    EXPECT_LE(control.credit_bytes(), sent_bytes);
+
+    stream->WritesDone();
+    EXPECT_TRUE(stream->Finish().ok());
+    server->Shutdown();
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(delivered_sessions.size(), 8u);
+    EXPECT_EQ(std::count(delivered_sessions.begin(), delivered_sessions.end(), "s1"), 4);
+    EXPECT_EQ(std::count(delivered_sessions.begin(), delivered_sessions.end(), "missing"), 0);
+}
+
+// 크레딧은 open/데이터/close 모든 프레임을 센다 (TTS 쪽 AvatarSyncMux::Connection::Write의 차감 기준과 같음):
+// 배치 크기에 정확히 맞춘 프레임 열의 마지막 close가 들어와야 크레딧이 반환되고, 반환량은 보낸 프레임 크기 합과 같음
+TEST(AvatarSyncServiceImplTest, MuxCreditCountsOpenDataAndCloseFrames) {
+    AvatarSyncServiceImpl service(
+        [](const std::string&) { return true; },
+        [](const std::string&, uint64_t, int64_t, std::string, uWS::OpCode) {},
+        nullptr, nullptr, []() -> uint64_t { return 0; });
+    int port = 0;
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+    builder.RegisterService(&service);
+    std::unique_ptr<grpc::Server> server = builder.BuildAndStart();
+    ASSERT_TRUE(server);
+
+    auto stub = avatar_sync::AvatarSyncService::NewStub(
+        grpc::CreateChannel("127.0.0.1:" + std::to_string(port), grpc::InsecureChannelCredentials()));
+    grpc::ClientContext context;
+    auto stream = stub->SyncAvatarMux(&context);
+    avatar_sync::AvatarSyncMuxControl control;
+    ASSERT_TRUE(stream->Read(&control)); // 초기 크레딧
+
+    avatar_sync::AvatarSyncMuxFrame open;
+    open.set_channel_id(1);
+    open.mutable_open()->set_frontend_session_id("s1");
+    avatar_sync::AvatarSyncMuxFrame close;
+    close.set_channel_id(1);
+    close.set_close(true);
+    std::vector<avatar_sync::AvatarSyncMuxFrame> frames{open};
+    uint64_t remaining = AvatarSyncServiceImpl::kMuxCreditBatchBytes - open.ByteSizeLong() - close.ByteSizeLong();
+    avatar_sync::AvatarSyncMuxFrame data;
+    data.set_channel_id(1);
+    while (remaining > 0) {
+        // 남은 크기에 딱 맞는 청크 길이 (길이 varint 경계를 넘지 않도록 한 청크는 4096 이하)
+        size_t chunk = std::min<uint64_t>(remaining, 4096);
+        do {
+            data.set_audio_chunk(std::string(chunk, '\0'));
+        } while (data.ByteSizeLong() > remaining && --chunk > 0);
+        ASSERT_GT(chunk, 0u);
+        remaining -= data.ByteSizeLong();
+        frames.push_back(data);
+    }
+    frames.push_back(close);
+
+    uint64_t sent_bytes = 0;
+    for (const auto& frame : frames) {
+        sent_bytes += frame.ByteSizeLong();
+        ASSERT_TRUE(stream->Write(frame));
+    }
+    ASSERT_EQ(sent_bytes, AvatarSyncServiceImpl::kMuxCreditBatchBytes);
+    ASSERT_TRUE(stream->Read(&control));
+    EXPECT_EQ(control.channel_id(), 0u);
+    EXPECT_EQ(control.credit_bytes(), sent_bytes);
+
+    stream->WritesDone();
+    EXPECT_TRUE(stream->Finish().ok());
+    server->Shutdown();
+}
+
+// 다중화 채널도 SyncAvatarStream처럼 다른 레플리카 소유 세션이면 소유 레플리카로 중계됨 (거부되지 않음)
+TEST(AvatarSyncServiceImplTest, ForwardsMultiplexedChannelToOwningReplica) {
+    auto table = std::make_shared<InMemorySessionDirectory::Table>();
+    std::mutex mutex;
+    std::vector<std::pair<uint64_t, std::string>> owner_frames;
+
+    AvatarSyncServiceImpl owner(
+        [](const std::string& session_id) { return session_id == "s1"; },
+        [&](const std::string&, uint64_t turn_id, int64_t, std::string payload, uWS::OpCode) {
+            std::lock_guard<std::mutex> lock(mutex);
+            owner_frames.emplace_back(turn_id, std::move(payload));
+        });
+    int owner_port = 0;
+    grpc::ServerBuilder owner_builder;
+    owner_builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &owner_port);
+    owner_builder.RegisterService(&owner);
+    std::unique_ptr<grpc::Server> owner_server = owner_builder.BuildAndStart();
+    ASSERT_TRUE(owner_server);
+    InMemorySessionDirectory owner_directory(table, "127.0.0.1:" + std::to_string(owner_port));
+    owner_directory.Register("s1");
+
+    std::atomic<int> ingress_frames{0};
+    AvatarSyncServiceImpl ingress(
+        [](const std::string& session_id) { return session_id == "local"; },
+        [&](const std::string&, uint64_t, int64_t, std::string, uWS::OpCode) { ingress_frames++; },
+        nullptr, std::make_shared<InMemorySessionDirectory>(table, "ingress"), []() -> uint64_t { return 0; });
+    int ingress_port = 0;
+    grpc::ServerBuilder ingress_builder;
+    ingress_builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &ingress_port);
+    ingress_builder.RegisterService(&ingress);
+    std::unique_ptr<grpc::Server> ingress_server = ingress_builder.BuildAndStart();
+    ASSERT_TRUE(ingress_server);
+
+    auto stub = avatar_sync::AvatarSyncService::NewStub(
+        grpc::CreateChannel("127.0.0.1:" + std::to_string(ingress_port), grpc::InsecureChannelCredentials()));
+    grpc::ClientContext context;
+    auto stream = stub->SyncAvatarMux(&context);
+    avatar_sync::AvatarSyncMuxControl control;
+    ASSERT_TRUE(stream->Read(&control)); // 초기 크레딧
+
+    // 채널 1: 다른 레플리카 소유 (중계), 채널 2: 이 레플리카 소유 (직접 전달). 두 채널이 섞여 도착
+    avatar_sync::AvatarSyncMuxFrame frame;
+    frame.set_channel_id(1);
+    frame.mutable_open()->set_frontend_session_id("s1");
+    frame.mutable_open()->set_turn_id(7);
+    ASSERT_TRUE(stream->Write(frame));
+    frame.set_channel_id(2);
+    frame.mutable_open()->set_frontend_session_id("local");
+    ASSERT_TRUE(stream->Write(frame));
+    for (int i = 0; i < 3; ++i) {
+        for (uint32_t channel = 1; channel <= 2; ++channel) {
+            frame.set_channel_id(channel);
+            frame.set_audio_chunk(std::string(640, static_cast<char>('a' + i)));
+            ASSERT_TRUE(stream->Write(frame));
+        }
+    }
+    for (uint32_t channel = 1; channel <= 2; ++channel) {
+        frame.set_channel_id(channel);
+        frame.set_close(true);
+        ASSERT_TRUE(stream->Write(frame));
+    }
+    stream->WritesDone();
+    while (stream->Read(&control)) {
+        EXPECT_TRUE(control.channel_error().empty()) << "channel " << control.channel_id() << " rejected: " << control.channel_error();
+    }
+    EXPECT_TRUE(stream->Finish().ok());
+    EXPECT_EQ(ingress.mux_channels_forwarded(), 1u);
+
+    // 중계는 다중화 스트림과 별개 호출이므로 소유 레플리카 도착을 기다림
+    for (int i = 0; i < 200; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (owner_frames.size() >= 3) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ingress_server->Shutdown();
+    owner_server->Shutdown();
+    EXPECT_EQ(ingress_frames.load(), 3); // 채널 2만
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(owner_frames.size(), 3u);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(owner_frames[i].first, 7u);
+        EXPECT_EQ(owner_frames[i].second, std::string(640, static_cast<char>('a' + i)));
+    }
+}
+
+// 백로그가 높은 동안 미룬 크레딧은 리액터를 막지 않고, 백로그가 내려가면 크레딧 스레드가 돌려줌
+TEST(AvatarSyncServiceImplTest, StalledCreditReleasedWhenBacklogDrains) {
+    std::atomic<uint64_t> backlog{AvatarSyncServiceImpl::kMuxBacklogHighWaterBytes + 1};
+    AvatarSyncServiceImpl service(
+        [](const std::string&) { return true; },
+        [](const std::string&, uint64_t, int64_t, std::string, uWS::OpCode) {},
+        nullptr, nullptr, [&backlog]() -> uint64_t { return backlog.load(); });
+    int port = 0;
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+    builder.RegisterService(&service);
+    std::unique_ptr<grpc::Server> server = builder.BuildAndStart();
+    ASSERT_TRUE(server);
+
+    auto stub = avatar_sync::AvatarSyncService::NewStub(
+        grpc::CreateChannel("127.0.0.1:" + std::to_string(port), grpc::InsecureChannelCredentials()));
+    grpc::ClientContext context;
+    auto stream = stub->SyncAvatarMux(&context);
+    avatar_sync::AvatarSyncMuxControl control;
+    ASSERT_TRUE(stream->Read(&control));
+
+    avatar_sync::AvatarSyncMuxFrame frame;
+    frame.set_channel_id(1);
+    frame.mutable_open()->set_frontend_session_id("s1");
+    ASSERT_TRUE(stream->Write(frame));
+    uint64_t sent_bytes = frame.ByteSizeLong();
+    while (sent_bytes < AvatarSyncServiceImpl::kMuxCreditBatchBytes * 2) {
+        frame.set_audio_chunk(std::string(4096, '\0'));
+        sent_bytes += frame.ByteSizeLong();
+        ASSERT_TRUE(stream->Write(frame));
+    }
+    for (int i = 0; i < 200 && service.mux_credit_stalls() == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(service.mux_credit_stalls(), 1u); // 같은 연결의 반복 보류는 한 번으로 셈
+
+    backlog = 0;
+    ASSERT_TRUE(stream->Read(&control));
+    EXPECT_EQ(control.channel_id(), 0u);
+    EXPECT_GE(control.credit_bytes(), AvatarSyncServiceImpl::kMuxCreditBatchBytes);
+    EXPECT_LE(control.credit_bytes(), sent_bytes);
+
+    stream->WritesDone();
+    EXPECT_TRUE(stream->Finish().ok());
+    server->Shutdown();
+}
+
+// TurnCancelClient: 주소가 비어 있으면 아무 RPC도 보내지 않음
+TEST(TurnCancelClientTest, DisabledTargetsSendNothing) {
+    TurnCancelClient client("", "");
+    client.CancelTurnsBefore("session", 2);
+    EXPECT_EQ(client.cancel_requests_sent(), 0);
+}
+
+// LoopbackSTTClient: 발화 종료 후 스크립트 응답(오디오/viseme)이 AvatarSync 전달 경로로 나와야 함
+TEST(LoopbackSTTClientTest, EmitsScriptedResponseThroughAvatarSyncPath) {
+    AvatarSyncServiceImpl::WebSocketFinder finder = [](const std::string&) { return true; };
+    std::mutex frames_mutex;
+    size_t audio_bytes = 0;
+    size_t viseme_frames = 0;
+    uint64_t last_turn_id = 0;
+    int64_t audio_end_ms = 0;
+    int64_t last_viseme_offset_ms = -1;
+    AvatarSyncServiceImpl::FrameDeliverer deliverer = [&](const std::string&, uint64_t turn_id, int64_t media_offset_ms,
+                                                          std::string payload, uWS::OpCode op_code) {
+        std::lock_guard<std::mutex> lock(frames_mutex);
+        last_turn_id = turn_id;
+        if (op_code == uWS::OpCode::BINARY) {
+            EXPECT_EQ(media_offset_ms, audio_end_ms); // 오디오 청크는 턴 타임라인에서 빈틈없이 이어짐
+            audio_bytes += payload.size();
+            audio_end_ms = media_offset_ms + static_cast<int64_t>(payload.size() / AvatarSyncServiceImpl::kPcmBytesPerMs);
+        } else {
+            viseme_frames++;
+            last_viseme_offset_ms = media_offset_ms;
+        }
+    };
+    AvatarSyncServiceImpl avatar_service(finder, deliverer);
+
+    LoopbackScript script;
+    script.transcripts = {"abcd"};
+    script.response_delay_ms = 0;
+    script.ms_per_char = 100; // 400ms 응답
+    script.pacing = 0.0;
+    LoopbackSTTClient client(&avatar_service, script);
+
+    stt::RecognitionConfig config;
+    config.set_frontend_session_id("session");
+    config.set_turn_id(7);
+    std::atomic<bool> finished_ok{false};
+    ASSERT_TRUE(client.StartStream(config, [&](const grpc::Status& status) { finished_ok = status.ok(); }));
+    EXPECT_TRUE(client.WriteAudioChunk(std::string(320, '\0')));
+    client.WritesDoneAndFinish();
+    EXPECT_TRUE(finished_ok.load());
+    EXPECT_FALSE(client.IsStreamActive());
+
+    const size_t expected_bytes = LoopbackSTTClient::GenerateResponsePcm(script, "abcd").size();
+    EXPECT_EQ(expected_bytes, 400u * 16000 / 1000 * 2);
+    for (int i = 0; i < 200; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(frames_mutex);
+            if (audio_bytes >= expected_bytes) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::lock_guard<std::mutex> lock(frames_mutex);
+    EXPECT_EQ(audio_bytes, expected_bytes);
+    EXPECT_EQ(viseme_frames, 5u); // 80ms 간격, 0~320ms
+    EXPECT_EQ(last_viseme_offset_ms, 320);
+    EXPECT_EQ(audio_end_ms, 400);
+    EXPECT_EQ(last_turn_id, 7u);
+    EXPECT_EQ(client.audio_bytes_received(), 320u);
+}
+
+// LoopbackSTTClient: 응답 재생 중 새 발화가 들어오면 이전 응답만 중단되고 새 턴 응답은 끝까지 나와야 함
+TEST(LoopbackSTTClientTest, NewUtteranceStopsOnlyPreviousResponse) {
+    AvatarSyncServiceImpl::WebSocketFinder finder = [](const std::string&) { return true; };
+    std::mutex frames_mutex;
+    std::map<uint64_t, size_t> audio_bytes_by_turn;
+    AvatarSyncServiceImpl::FrameDeliverer deliverer = [&](const std::string&, uint64_t turn_id, int64_t,
+                                                          std::string payload, uWS::OpCode op_code) {
+        if (op_code != uWS::OpCode::BINARY) return;
+        std::lock_guard<std::mutex> lock(frames_mutex);
+        audio_bytes_by_turn[turn_id] += payload.size();
+    };
+    AvatarSyncServiceImpl avatar_service(finder, deliverer);
+
+    LoopbackScript script;
+    script.transcripts = {"abcd"};
+    script.response_delay_ms = 0;
+    script.ms_per_char = 500; // 2초 응답 (실시간 속도) - 두 번째 발화 시점에는 아직 재생 중
+    LoopbackSTTClient client(&avatar_service, script);
+
+    auto utterance = [&](uint64_t turn_id) {
+        stt::RecognitionConfig config;
+        config.set_frontend_session_id("session");
+        config.set_turn_id(turn_id);
+        ASSERT_TRUE(client.StartStream(config, nullptr));
+        client.WritesDoneAndFinish();
+    };
+    utterance(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // 이전 응답 스레드 join을 기다리지 않고 바로 반환해야 함 (uWS 루프 스레드에서 호출됨)
+    const auto start = std::chrono::steady_clock::now();
+    utterance(2);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(100));
+
+    const size_t expected_bytes = LoopbackSTTClient::GenerateResponsePcm(script, "abcd").size();
+    for (int i = 0; i < 600; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(frames_mutex);
+            if (audio_bytes_by_turn[2] >= expected_bytes) break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    std::lock_guard<std::mutex> lock(frames_mutex);
+    EXPECT_LT(audio_bytes_by_turn[1], expected_bytes);
+    EXPECT_EQ(audio_bytes_by_turn[2], expected_bytes);
+}
+
+// TurnOutputSequencer: 이전 턴이 진행 중이면 새 턴 프레임은 보류했다가 턴 순서대로 내보내고, 새 턴이 나간 뒤의 옛 턴 프레임은 버림
+namespace {
+struct SeqFrame {
+    uint64_t turn_id;
+    std::string payload;
+};
+} // namespace
+
+TEST(TurnOutputSequencerTest, HoldsLaterTurnsUntilEarlierTurnFinishes) {
+    TurnOutputSequencer<SeqFrame> sequencer;
+    using Verdict = TurnOutputSequencer<SeqFrame>::Verdict;
+    sequencer.TurnStarted(1);
+    sequencer.TurnStarted(2); // 턴 1의 응답이 끝나기 전에 다음 발화
+    sequencer.TurnStarted(3);
+    EXPECT_EQ(sequencer.turns_in_flight(), 3u);
+
+    SeqFrame frame{1, "a1"};
+    EXPECT_EQ(sequencer.Admit(frame), Verdict::kSend);
+    for (SeqFrame f : {SeqFrame{3, "c1"}, SeqFrame{2, "b1"}, SeqFrame{3, "c2"}, SeqFrame{2, "b2"}}) {
+        EXPECT_EQ(sequencer.Admit(f), Verdict::kHold);
+    }
+    SeqFrame untagged{0, "x"};
+    EXPECT_EQ(sequencer.Admit(untagged), Verdict::kSend); // 턴 정보 없음은 항상 통과
+    EXPECT_EQ(sequencer.held_frames(), 4u);
+    EXPECT_EQ(sequencer.held_bytes(), 8u);
+
+    // 턴 1 종료: 턴 2 프레임만 풀림 (턴 3은 턴 2가 끝날 때까지)
+    std::vector<SeqFrame> released;
+    sequencer.TurnFinished(1, released);
+    ASSERT_EQ(released.size(), 2u);
+    EXPECT_EQ(released[0].payload, "b1");
+    EXPECT_EQ(released[1].payload, "b2");
+    SeqFrame late{1, "a2"};
+    EXPECT_EQ(sequencer.Admit(late), Verdict::kStale); // 턴 2가 이미 나감
+    SeqFrame more{3, "c3"};
+    EXPECT_EQ(sequencer.Admit(more), Verdict::kHold);
+
+    // 턴 3이 먼저 끝나도 턴 2가 진행 중이면 계속 보류
+    released.clear();
+    sequencer.TurnFinished(3, released);
+    EXPECT_TRUE(released.empty());
+    sequencer.TurnFinished(2, released);
+    ASSERT_EQ(released.size(), 3u);
+    EXPECT_EQ(released[0].payload, "c1");
+    EXPECT_EQ(released[1].payload, "c2");
+    EXPECT_EQ(released[2].payload, "c3");
+    EXPECT_TRUE(sequencer.idle());
+    EXPECT_EQ(sequencer.held_bytes(), 0u);
+}
+
+// 겹치는 두 턴: 같은 세션의 턴 1/2 AvatarSync 스트림이 동시에 열려 프레임이 섞여 도착해도,
+// AvatarSync 수신 -> 턴 시퀀서(flush_pending_frames와 같은 판정)를 거치면 턴 1 전체 뒤에 턴 2가 나가고 버려지는 프레임이 없음
+TEST(TurnOutputSequencerTest, OverlappingTurnsThroughAvatarSyncArriveInTurnOrder) {
+    std::mutex mutex;
+    std::vector<SeqFrame> arrived;
+    AvatarSyncServiceImpl service(
+        [](const std::string& session_id) { return session_id == "s1"; },
+        [&](const std::string&, uint64_t turn_id, int64_t, std::string payload, uWS::OpCode) {
+            std::lock_guard<std::mutex> lock(mutex);
+            arrived.push_back(SeqFrame{turn_id, std::move(payload)});
+        });
+    int port = 0;
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+    builder.RegisterService(&service);
+    std::unique_ptr<grpc::Server> server = builder.BuildAndStart();
+    ASSERT_TRUE(server);
+
+    // 턴 1의 TTS가 아직 보내는 중에 턴 2의 TTS 스트림이 열림 (TTS 서비스는 턴마다 별도 RPC)
+    auto stub = avatar_sync::AvatarSyncService::NewStub(
+        grpc::CreateChannel("127.0.0.1:" + std::to_string(port), grpc::InsecureChannelCredentials()));
+    grpc::ClientContext context1, context2;
+    google::protobuf::Empty response1, response2;
+    auto turn1 = stub->SyncAvatarStream(&context1, &response1);
+    auto turn2 = stub->SyncAvatarStream(&context2, &response2);
+    avatar_sync::AvatarSyncStreamRequest request;
+    request.mutable_config()->set_frontend_session_id("s1");
+    request.mutable_config()->set_turn_id(1);
+    ASSERT_TRUE(turn1->Write(request));
+    request.mutable_config()->set_turn_id(2);
+    ASSERT_TRUE(turn2->Write(request));
+    for (int i = 0; i < 3; ++i) {
+        request.set_audio_chunk(std::string(640, static_cast<char>('a' + i)));
+        ASSERT_TRUE(turn2->Write(request));
+        ASSERT_TRUE(turn1->Write(request));
+    }
+    turn2->WritesDone();
+    EXPECT_TRUE(turn2->Finish().ok());
+    turn1->WritesDone();
+    EXPECT_TRUE(turn1->Finish().ok());
+    server->Shutdown();
+
+    // uWS 루프 쪽: 두 턴의 STT 스트림이 진행 중인 상태에서 도착 순서대로 판정
+    TurnOutputSequencer<SeqFrame> sequencer;
+    using Verdict = TurnOutputSequencer<SeqFrame>::Verdict;
+    sequencer.TurnStarted(1);
+    sequencer.TurnStarted(2);
+    std::vector<SeqFrame> sent;
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(arrived.size(), 6u);
+    for (SeqFrame& frame : arrived) {
+        const Verdict verdict = sequencer.Admit(frame);
+        ASSERT_NE(verdict, Verdict::kStale);
+        if (verdict == Verdict::kSend) {
+            sent.push_back(frame);
+        }
+    }
+    sequencer.TurnFinished(1, sent); // 턴 1 응답 끝: 보류된 턴 2 프레임이 뒤에 붙음
+    sequencer.TurnFinished(2, sent);
+    ASSERT_EQ(sent.size(), 6u);
+    for (size_t i = 0; i < sent.size(); ++i) {
+        EXPECT_EQ(sent[i].turn_id, i < 3 ? 1u : 2u) << "frame " << i;
+        EXPECT_EQ(sent[i].payload[0], static_cast<char>('a' + i % 3)) << "frame " << i; // 턴 안 순서 유지
+    }
+    EXPECT_TRUE(sequencer.idle());
+}
+
+// TimerWheel: 상위 레벨로 들어간 긴 타이머도 정확한 틱에 실행되어야 함
+TEST(TimerWheelTest, FiresAtExactTickAcrossLevels) {
+    const auto start = TimerWheel::Clock::now();
+    TimerWheel wheel(std::chrono::milliseconds(10), start);
+    std::vector<int64_t> fired_at;
+    int64_t now_ms = 0;
+    for (int64_t delay_ms : {10, 630, 640, 50000, 3000000}) {
+        wheel.Schedule(std::chrono::milliseconds(delay_ms), [&fired_at, &now_ms]() { fired_at.push_back(now_ms); });
+    }
+    while (wheel.size() > 0 && now_ms <= 3000000) {
+        now_ms += 10;
+        wheel.Advance(start + std::chrono::milliseconds(now_ms));
+    }
+    EXPECT_EQ(fired_at, (std::vector<int64_t>{10, 630, 640, 50000, 3000000}));
+}
+
+// TimerWheel: 취소된 타이머는 실행되지 않고, 콜백 안에서 재등록 가능
+TEST(TimerWheelTest, CancelAndRescheduleFromCallback) {
+    const auto start = TimerWheel::Clock::now();
+    TimerWheel wheel(std::chrono::milliseconds(100), start);
+    int cancelled_calls = 0;
+    int rearmed_calls = 0;
+    auto id = wheel.Schedule(std::chrono::milliseconds(200), [&]() { cancelled_calls++; });
+    EXPECT_TRUE(wheel.Cancel(id));
+    EXPECT_FALSE(wheel.Cancel(id));
+
+    std::function<void()> rearm = [&]() {
+        if (++rearmed_calls < 3) wheel.Schedule(std::chrono::milliseconds(100), rearm);
+    };
+    wheel.Schedule(std::chrono::milliseconds(100), rearm);
+    EXPECT_EQ(wheel.Advance(start + std::chrono::seconds(1)), 3u);
+    EXPECT_EQ(cancelled_calls, 0);
+    EXPECT_EQ(rearmed_calls, 3);
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+// UpstreamRateLimiter: 세션 버킷은 burst 이후 실시간 배수 속도로만 채워지고, 쿼터를 넘으면 계속 거부
+TEST(UpstreamRateLimiterTest, SessionAudioBucketAndQuota) {
+    RateLimitConfig config;
+    config.session_audio_realtime_ratio = 1.0; // 32000 B/s
+    config.ip_audio_realtime_ratio = 0;        // IP 제한 없음
+    config.audio_burst = std::chrono::milliseconds(500);
+    config.session_audio_quota = std::chrono::seconds(2);
+    UpstreamRateLimiter limiter(config);
+
+    SessionRateState session;
+    limiter.Attach(session, "10.0.0.1", 1000);
+    using Verdict = UpstreamRateLimiter::Verdict;
+    // burst 16000B = 3200B 프레임 5개
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(limiter.AdmitAudio(session, 3200, 1000), Verdict::kAllowed);
+    }
+    EXPECT_EQ(limiter.AdmitAudio(session, 3200, 1000), Verdict::kSessionLimited);
+    EXPECT_EQ(limiter.AudioRetryAfterMs(session, 3200), 100u);
+    EXPECT_EQ(limiter.AdmitAudio(session, 3200, 1100), Verdict::kAllowed); // 100ms 뒤 한 프레임만큼 채워짐
+
+    // 실시간 속도로 보내면 쿼터(2초 = 64000B)까지 통과하고 이후 거부
+    uint32_t now_ms = 1100;
+    while (limiter.AdmitAudio(session, 3200, now_ms += 100) == Verdict::kAllowed) {}
+    EXPECT_EQ(session.audio_ms_total, 2000u);
+    EXPECT_EQ(limiter.AdmitAudio(session, 3200, now_ms + 10000), Verdict::kQuotaExceeded);
+    EXPECT_EQ(limiter.stats().audio_frames_shed[static_cast<int>(Verdict::kQuotaExceeded)], 2u);
+    limiter.Detach(session);
+    EXPECT_EQ(limiter.tracked_ips(), 0u);
+}
+
+// UpstreamRateLimiter: 같은 IP의 세션들은 IP 버킷을 공유하고, IP 제한에 걸린 만큼은 세션 버킷에서 빠지지 않음
+TEST(UpstreamRateLimiterTest, IpBucketSharedAcrossSessionsAndWarningsThrottled) {
+    RateLimitConfig config;
+    config.session_audio_realtime_ratio = 1.0;
+    config.ip_audio_realtime_ratio = 1.0;
+    config.audio_burst = std::chrono::milliseconds(100); // 3200B
+    config.warn_interval = std::chrono::seconds(5);
+    UpstreamRateLimiter limiter(config);
+
+    SessionRateState a, b, other;
+    limiter.Attach(a, "10.0.0.1", 0);
+    limiter.Attach(b, "10.0.0.1", 0);
+    limiter.Attach(other, "10.0.0.2", 0);
+    EXPECT_EQ(limiter.tracked_ips(), 2u);
+
+    using Verdict = UpstreamRateLimiter::Verdict;
+    EXPECT_EQ(limiter.AdmitAudio(a, 3200, 0), Verdict::kAllowed);
+    EXPECT_EQ(limiter.AdmitAudio(b, 3200, 0), Verdict::kIpLimited);
+    EXPECT_EQ(limiter.AdmitAudio(other, 3200, 0), Verdict::kAllowed);
+    EXPECT_FLOAT_EQ(b.buckets.audio.tokens, 3200.0f);
+
+    EXPECT_TRUE(limiter.ShouldWarn(b, 0));
+    EXPECT_FALSE(limiter.ShouldWarn(b, 4999));
+    EXPECT_TRUE(limiter.ShouldWarn(b, 5001));
+
+    limiter.Detach(a);
+    EXPECT_EQ(limiter.tracked_ips(), 2u);
+    limiter.Detach(b);
+    limiter.Detach(other);
+    EXPECT_EQ(limiter.tracked_ips(), 0u);
+}
+
+// AdmissionController: 턴 슬롯이 없으면 FIFO로 대기하고, 슬롯 반환 시 앞에서부터 입장, 기한이 지나면 만료
+TEST(AdmissionControllerTest, QueuesTurnsAndExpiresAfterDeadline) {
+    AdmissionConfig config;
+    config.max_sessions = 2;
+    config.max_active_turns = 1;
+    config.queue_capacity = 2;
+    config.queue_timeout = std::chrono::milliseconds(1000);
+    AdmissionController admission(config);
+
+    EXPECT_TRUE(admission.AdmitSession());
+    EXPECT_TRUE(admission.AdmitSession());
+    EXPECT_FALSE(admission.AdmitSession());
+    admission.ReleaseSession();
+    EXPECT_TRUE(admission.AdmitSession());
+    EXPECT_EQ(admission.stats().sessions_rejected, 1u);
+
+    using Decision = AdmissionController::Decision;
+    AdmissionController::Ticket first = 0, second = 0, third = 0;
+    EXPECT_EQ(admission.RequestTurn(0, &first), Decision::kAdmitted);
+    EXPECT_EQ(admission.RequestTurn(100, &first), Decision::kQueued);
+    EXPECT_EQ(admission.RequestTurn(200, &second), Decision::kQueued);
+    EXPECT_EQ(admission.RequestTurn(300, &third), Decision::kRejected);
+    EXPECT_EQ(admission.queue_depth(), 2u);
+
+    std::vector<AdmissionController::Admission> admitted;
+    std::vector<AdmissionController::Ticket> expired;
+    admission.Poll(400, admitted, expired);
+    EXPECT_TRUE(admitted.empty()); // 슬롯이 아직 사용 중
+
+    admission.ReleaseTurn();
+    admission.Poll(600, admitted, expired);
+    ASSERT_EQ(admitted.size(), 1u);
+    EXPECT_EQ(admitted[0].ticket, first);
+    EXPECT_EQ(admitted[0].waited_ms, 500u);
+    EXPECT_EQ(admission.active_turns(), 1u);
+
+    admission.Poll(1200, admitted, expired);
+    ASSERT_EQ(expired.size(), 1u);
+    EXPECT_EQ(expired[0], second);
+    EXPECT_EQ(admission.queue_depth(), 0u);
+    EXPECT_EQ(admission.stats().turns_expired, 1u);
+    EXPECT_EQ(admission.stats().turns_rejected, 1u);
+}
+
+// AdmissionController: 하위 서비스 힌트가 0이면 로컬 여유가 있어도 대기, 취소된 티켓은 입장하지 않음
+TEST(AdmissionControllerTest, DownstreamHintBlocksAndCancelRemovesWaiter) {
+    int64_t downstream_capacity = 0;
+    AdmissionController admission(AdmissionConfig{}, [&downstream_capacity]() { return downstream_capacity; });
+
+    AdmissionController::Ticket a = 0, b = 0;
+    EXPECT_EQ(admission.RequestTurn(0, &a), AdmissionController::Decision::kQueued);
+    EXPECT_EQ(admission.RequestTurn(0, &b), AdmissionController::Decision::kQueued);
+    EXPECT_TRUE(admission.Cancel(a));
+    EXPECT_FALSE(admission.Cancel(a));
+
+    downstream_capacity = -1; // 알 수 없음 = 로컬 카운터만 사용 (기본 무제한)
+    std::vector<AdmissionController::Admission> admitted;
+    std::vector<AdmissionController::Ticket> expired;
+    admission.Poll(10, admitted, expired);
+    ASSERT_EQ(admitted.size(), 1u);
+    EXPECT_EQ(admitted[0].ticket, b);
+    EXPECT_TRUE(expired.empty());
+    EXPECT_GT(admission.stats().downstream_blocked, 0u);
+}
+
+// 진행 중인 스트림에 start_stream이 다시 오고 새 턴이 입장 대기로 빠지면, 대기 중에 온 오디오는
+// 취소된 스트림에 쓰이지 않아야 함 (쓰면 실패해 "Please restart" 오류가 나감)
+namespace {
+class RecordingSTTClient : public STTStreamClient {
+public:
+    bool StartStream(const stt::RecognitionConfig&, StatusCallback) override { active = true; return true; }
+    bool WriteAudioChunk(const std::string&) override { writes++; return active; }
+    void WritesDoneAndFinish() override { active = false; }
+    void StopStreamNow() override { stops++; active = false; }
+    bool IsStreamActive() const override { return active; }
+
+    bool active = false;
+    int writes = 0;
+    int stops = 0;
+};
+} // namespace
+
+TEST(AdmissionControllerTest, RestartWhileStreamingQueuedThenAudioIsNotWritten) {
+    AdmissionConfig config;
+    config.max_active_turns = 1;
+    config.queue_capacity = 1;
+    AdmissionController admission(config);
+    AdmissionController::Ticket ticket = 0;
+    ASSERT_EQ(admission.RequestTurn(0, &ticket), AdmissionController::Decision::kAdmitted); // 다른 세션이 슬롯 사용 중
+
+    PerSocketData data;
+    auto client = std::make_unique<RecordingSTTClient>();
+    RecordingSTTClient* stt = client.get();
+    data.stt_client = std::move(client);
+    ASSERT_TRUE(data.stt_client->StartStream(stt::RecognitionConfig{}, nullptr));
+    data.stt_stream_active = true;
+    ASSERT_TRUE(accepts_audio(data));
+
+    // start_stream 재수신: 이전 스트림 취소 후 슬롯이 없어 대기
+    cancel_active_stt_stream(data);
+    ASSERT_EQ(admission.RequestTurn(100, &ticket), AdmissionController::Decision::kQueued);
+    data.admission_ticket = ticket;
+
+    EXPECT_EQ(stt->stops, 1);
+    EXPECT_FALSE(data.stt_stream_active);
+    // 대기 중 오디오 도착: STT로 보내지 않음
+    EXPECT_FALSE(accepts_audio(data));
+    EXPECT_EQ(stt->writes, 0);
+
+    // 스트림이 없으면 다시 취소해도 StopStreamNow를 또 부르지 않음
+    cancel_active_stt_stream(data);
+    EXPECT_EQ(stt->stops, 1);
+}
+
+// 타임라인 슬롯은 세션 상한 + 보존분. 상한이 있으면 살아 있는 세션이 슬롯을 못 받는 일이 없음
+TEST(SessionTimelineStoreTest, SizedFromAdmissionSessionLimit) {
+    AdmissionConfig config;
+    EXPECT_EQ(config.timeline_sessions(), AdmissionConfig::kDefaultTimelineSessions); // 무제한
+    config.max_sessions = 5000;
+    config.timeline_retained_sessions = 100;
+    EXPECT_EQ(config.timeline_sessions(), 5100u);
+
+    config.max_sessions = 3;
+    config.timeline_retained_sessions = 0;
+    SessionTimelineStore timelines(config.timeline_sessions());
+    for (const char* id : {"a", "b", "c"}) {
+        EXPECT_NE(timelines.Open(id, 0), SessionTimelineStore::kNoSlot);
+    }
+    EXPECT_EQ(timelines.sessions_not_recorded(), 0u);
+}
+
+// SessionTimelineStore: 턴 지연 측정/이벤트 병합, 느린 세션 순 정렬, 닫힌 슬롯은 오래된 것부터 재사용
+TEST(SessionTimelineStoreTest, RecordsTurnLatencyAndReusesClosedSlots) {
+    using Event = SessionTimelineStore::Event;
+    SessionTimelineStore timelines(2);
+    const uint32_t fast = timelines.Open("fast", 0);
+    const uint32_t slow = timelines.Open("slow", 0);
+    EXPECT_EQ(timelines.Open("overflow", 0), SessionTimelineStore::kNoSlot); // 살아 있는 세션은 덮어쓰지 않음
+    EXPECT_EQ(timelines.sessions_not_recorded(), 1u);
+
+    timelines.Record(fast, Event::kStartStream, 1, 10);
+    timelines.Record(fast, Event::kFirstAudioIn, 1, 20);
+    timelines.Record(fast, Event::kFirstAudioIn, 1, 30); // 턴당 한 번
+    timelines.Record(fast, Event::kUtteranceEnded, 1, 100);
+    timelines.Record(fast, Event::kFirstAudioOut, 1, 250);
+    timelines.Record(fast, Event::kLastViseme, 1, 260);
+    timelines.Record(fast, Event::kLastViseme, 1, 900); // 직전 viseme 갱신
+    timelines.Record(slow, Event::kStartStream, 1, 10);
+    timelines.Record(slow, Event::kUtteranceEnded, 1, 100); // 응답 없음: 지금까지 대기 시간으로 평가
+
+    const auto fast_json = nlohmann::json::parse(timelines.RenderSession("fast", 1000));
+    EXPECT_EQ(fast_json["worstTurnMs"], 150);
+    ASSERT_EQ(fast_json["events"].size(), 6u);
+    EXPECT_EQ(fast_json["events"][5]["event"], "last_viseme");
+    EXPECT_EQ(fast_json["events"][5]["atMs"], 900);
+    EXPECT_TRUE(timelines.RenderSession("missing", 1000).empty());
+
+    const auto slowest = nlohmann::json::parse(timelines.RenderSlowest(1, 1000));
+    ASSERT_EQ(slowest["sessions"].size(), 1u);
+    EXPECT_EQ(slowest["sessions"][0]["sessionId"], "slow");
+    EXPECT_EQ(slowest["sessions"][0]["slowScoreMs"], 900);
+
+    timelines.Close(fast, 1100, 1000);
+    timelines.Close(slow, 1200, 1006);
+    EXPECT_EQ(timelines.Open("next", 1300), fast); // 먼저 닫힌 슬롯부터 재사용
+    EXPECT_TRUE(timelines.RenderSession("fast", 1300).empty());
+    const auto closed = nlohmann::json::parse(timelines.RenderSession("slow", 1300));
+    EXPECT_FALSE(closed["live"]);
+    EXPECT_EQ(closed["slowScoreMs"], 1100); // 종료 시각까지의 대기
+    EXPECT_EQ(closed["events"].back()["detail"], 1006);
+}
+
+// LatencyHistogram: 누적 버킷/합계/개수를 Prometheus 형식으로 출력
+TEST(LatencyHistogramTest, RendersCumulativeBuckets) {
+    LatencyHistogram hist({10, 100});
+    for (uint32_t v : {1u, 10u, 11u, 100u, 5000u}) {
+        hist.Observe(v);
+    }
+    EXPECT_EQ(hist.count(), 5u);
+    EXPECT_EQ(hist.sum(), 5122u);
+
+    std::string out;
+    hist.Render(out, "rtt_ms", "test");
+    EXPECT_NE(out.find("# TYPE rtt_ms histogram\n"), std::string::npos);
+    EXPECT_NE(out.find("rtt_ms_bucket{le=\"10\"} 2\n"), std::string::npos);
+    EXPECT_NE(out.find("rtt_ms_bucket{le=\"100\"} 4\n"), std::string::npos);
+    EXPECT_NE(out.find("rtt_ms_bucket{le=\"+Inf\"} 5\n"), std::string::npos);
+    EXPECT_NE(out.find("rtt_ms_count 5\n"), std::string::npos);
+}
+
+// BoundedMpscQueue: 여러 생산자가 동시에 넣어도 유실/중복 없이 한 소비자가 모두 꺼냄
+TEST(BoundedMpscQueueTest, ConcurrentProducersSingleConsumer) {
+    BoundedMpscQueue<int> queue(1024);
+    EXPECT_EQ(queue.capacity(), 1024u);
+    constexpr int kProducers = 4;
+    constexpr int kPerProducer = 10000;
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; ++p) {
+        producers.emplace_back([&queue, p]() {
+            for (int i = 0; i < kPerProducer; ++i) {
+                int value = p * kPerProducer + i;
+                while (!queue.TryPush(std::move(value))) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    std::vector<int> seen(kProducers * kPerProducer, 0);
+    int popped = 0;
+    int value = 0;
+    while (popped < kProducers * kPerProducer) {
+        if (queue.TryPop(value)) {
+            ++seen[value];
+            ++popped;
+        }
+    }
+    for (auto& t : producers) {
+        t.join();
+    }
+    EXPECT_FALSE(queue.TryPop(value));
+    for (int count : seen) {
+        ASSERT_EQ(count, 1);
+    }
+}
+
+// TrafficTap: 결정적 샘플링, 오디오는 크기만 기록, 소멸 시 남은 이벤트를 파일로 flush
+TEST(TrafficTapTest, WritesSampledEventsToTraceFile) {
+    const std::string dir = (std::filesystem::temp_directory_path() / "gateway_tap_test").string();
+    std::filesystem::remove_all(dir);
+
+    TrafficTapConfig config;
+    config.sample_rate = 1.0;
+    config.output_dir = dir;
+    std::string file;
+    {
+        TrafficTap tap(config);
+        EXPECT_TRUE(tap.ShouldSample("any-session"));
+        tap.Record(TraceEventType::kSessionOpen, "s1", 0, "s1");
+        tap.Record(TraceEventType::kClientAudio, "s1", 640, std::string(640, '\x01'));
+        tap.Record(TraceEventType::kSessionClose, "s1", 1000);
+        file = tap.current_file();
+    }
+    TrafficTapConfig off;
+    off.output_dir = dir;
+    EXPECT_FALSE(TrafficTap(off).ShouldSample("any-session"));
+
+    std::ifstream in(file, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    ASSERT_EQ(bytes.compare(0, 8, "AVTRACE1"), 0);
+    ASSERT_EQ(bytes.size(), 8 + 3 * TrafficTap::kRecordHeaderBytes + 2);
+
+    size_t offset = 8;
+    const uint8_t expected_types[] = {1, 4, 2};
+    const uint32_t expected_sizes[] = {0, 640, 1000};
+    for (int i = 0; i < 3; ++i) {
+        uint64_t key = 0;
+        uint32_t size = 0, data_len = 0;
+        std::memcpy(&key, bytes.data() + offset + 8, 8);
+        std::memcpy(&size, bytes.data() + offset + 20, 4);
+        std::memcpy(&data_len, bytes.data() + offset + 24, 4);
+        EXPECT_EQ(key, TrafficTap::SessionKey("s1"));
+        EXPECT_EQ(static_cast<uint8_t>(bytes[offset + 16]), expected_types[i]);
+        EXPECT_EQ(size, expected_sizes[i]);
+        offset += TrafficTap::kRecordHeaderBytes + data_len;
+    }
+    std::filesystem::remove_all(dir);
+}
+
 // Google Test 실행 진입점
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
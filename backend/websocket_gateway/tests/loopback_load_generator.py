@@ -0,0 +1,133 @@
+# tests/loopback_load_generator.py
+#
+# 루프백 모드(PIPELINE_MODE=loopback) 게이트웨이 부하 생성기.
+# 여러 세션이 발화(start_stream → 오디오 → utterance_ended)를 반복하고 스크립트 응답 오디오/viseme을 받는 동안
+# 응답 프레임 처리량과, --gateway-pid를 주면 strace -c로 게이트웨이의 송신 시스템 콜 수를 측정한다.
+# /metrics의 avatar_frames_delivered_total / avatar_frame_flushes_total 증가분으로 write당 프레임 수도 출력.
+#
+#   PIPELINE_MODE=loopback LOOPBACK_PACING=0 ./WebSocketGateway &
+#   python tests/loopback_load_generator.py --sessions 200 --duration 30 --gateway-pid $!
+#
+# 모든 세션이 한 IP에서 접속하므로 IP당 오디오 제한(RATE_LIMIT_IP_AUDIO_RT_RATIO, 기본 32배)보다 세션이 많으면
+# RATE_LIMIT_IP_AUDIO_RT_RATIO=0 으로 게이트웨이를 띄워야 한다. 버려진 프레임 수는 함께 출력된다.
+#
+# strace는 대상 프로세스를 느리게 만들므로 처리량과 시스템 콜 수는 별도 실행으로 비교하는 것이 정확하다
+# (--gateway-pid 없이 한 번, 있이 한 번).
+
+import argparse
+import asyncio
+import os
+import re
+import subprocess
+import time
+import urllib.request
+
+try:
+    import websockets
+except ImportError:
+    print("Error: 'websockets' package not found. Run 'pip install websockets' first.")
+    exit(1)
+
+
+# --- Configuration ---
+GATEWAY_WS_URL = os.getenv("GATEWAY_WS_URL", "ws://127.0.0.1:8000/")
+GATEWAY_METRICS_URL = os.getenv("GATEWAY_METRICS_URL", "http://127.0.0.1:9090/metrics")
+CHUNK_BYTES = 3200          # 16kHz 16-bit mono 100ms
+CHUNK_INTERVAL_SEC = 0.1    # 실시간 속도로 업로드
+UTTERANCE_CHUNKS = 20       # 발화 2초
+SEND_SYSCALLS = "write,writev,sendto,sendmsg"
+
+
+def read_metrics():
+    with urllib.request.urlopen(GATEWAY_METRICS_URL, timeout=5) as resp:
+        text = resp.read().decode()
+    metrics = {}
+    for line in text.splitlines():
+        match = re.match(r"^([a-zA-Z_:][a-zA-Z0-9_:]*(?:\{[^}]*\})?)\s+([0-9.eE+-]+)$", line)
+        if match:
+            metrics[match.group(1)] = float(match.group(2))
+    return metrics
+
+
+def parse_strace_summary(output):
+    # strace -c 요약 표: "% time  seconds  usecs/call  calls  errors syscall"
+    calls = {}
+    for line in output.splitlines():
+        parts = line.split()
+        if len(parts) >= 5 and parts[-1] in SEND_SYSCALLS.split(","):
+            calls[parts[-1]] = int(parts[3])
+    return calls
+
+
+async def run_session(duration, counters):
+    chunk = bytes(CHUNK_BYTES)
+    async with websockets.connect(GATEWAY_WS_URL, max_size=None, ping_interval=None) as ws:
+        await ws.recv()  # session_info
+
+        async def reader():
+            async for message in ws:
+                if isinstance(message, bytes):
+                    counters["audio_frames"] += 1
+                    counters["audio_bytes"] += len(message)
+                elif '"viseme"' in message:
+                    counters["viseme_frames"] += 1
+
+        reader_task = asyncio.create_task(reader())
+        deadline = time.monotonic() + duration
+        while time.monotonic() < deadline:
+            await ws.send('{"type":"start_stream","language":"ko-KR"}')
+            for _ in range(UTTERANCE_CHUNKS):
+                await ws.send(chunk)
+                await asyncio.sleep(CHUNK_INTERVAL_SEC)
+            await ws.send('{"type":"utterance_ended"}')
+            await asyncio.sleep(1.0)  # 응답 수신 시간
+        reader_task.cancel()
+
+
+async def main():
+    parser = argparse.ArgumentParser(description="Gateway loopback load generator")
+    parser.add_argument("--sessions", type=int, default=100)
+    parser.add_argument("--duration", type=float, default=30.0)
+    parser.add_argument("--gateway-pid", type=int, help="지정 시 strace -c로 송신 시스템 콜 수 측정")
+    args = parser.parse_args()
+
+    strace = None
+    if args.gateway_pid:
+        strace = subprocess.Popen(
+            ["strace", "-c", "-f", "-e", f"trace={SEND_SYSCALLS}", "-p", str(args.gateway_pid)],
+            stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True)
+        time.sleep(0.5)
+
+    before = read_metrics()
+    counters = {"audio_frames": 0, "audio_bytes": 0, "viseme_frames": 0}
+    start = time.monotonic()
+    await asyncio.gather(*(run_session(args.duration, counters) for _ in range(args.sessions)),
+                         return_exceptions=True)
+    elapsed = time.monotonic() - start
+    after = read_metrics()
+
+    syscalls = {}
+    if strace:
+        strace.send_signal(2)  # SIGINT → 요약 출력
+        _, err = strace.communicate(timeout=10)
+        syscalls = parse_strace_summary(err)
+
+    frames = counters["audio_frames"] + counters["viseme_frames"]
+    delivered = after.get("avatar_frames_delivered_total", 0) - before.get("avatar_frames_delivered_total", 0)
+    flushes = after.get("avatar_frame_flushes_total", 0) - before.get("avatar_frame_flushes_total", 0)
+
+    print(f"--- {args.sessions} sessions, {elapsed:.1f}s ---")
+    print(f"  frames received:        {frames} ({frames / elapsed:.0f}/s)")
+    print(f"  audio received:         {counters['audio_bytes'] / (1024 * 1024) / elapsed:.2f} MB/s")
+    print(f"  frames per corked write:{delivered / flushes if flushes else 0:>8.2f}")
+    shed = sum(v - before.get(k, 0) for k, v in after.items() if k.startswith("rate_limit_audio_frames_shed_total"))
+    if shed:
+        print(f"  audio frames shed:      {shed:.0f} (rate limited)")
+    if syscalls:
+        total_calls = sum(syscalls.values())
+        print(f"  send syscalls:          {total_calls} {syscalls}")
+        print(f"  syscalls per frame:     {total_calls / delivered if delivered else 0:.3f}")
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
@@ -0,0 +1,59 @@
+// tests/per_socket_data_benchmark.cpp
+//
+// 유휴 연결당 게이트웨이 고정 비용 중 PerSocketData + active_websockets_ 항목 몫을 측정.
+// uWS가 소켓 ext 영역에 두는 PerSocketData와, 세션 ID로 색인하는 active_websockets_ 노드를
+// N개 만들고 malloc 사용량(mallinfo2) 증가분을 연결 수로 나눠 출력한다.
+// 프로세스 전체 RSS(STTClient, uWS 소켓 버퍼 포함)는 idle_memory_benchmark.py로 실행 중인 게이트웨이에서 측정.
+//
+//   cmake -DBUILD_TESTING=ON .. && make per_socket_data_benchmark
+//   ./per_socket_data_benchmark [connections...=10000 50000]
+
+#include <malloc.h>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "types.h"
+
+namespace {
+
+size_t HeapInUse() {
+    const auto info = mallinfo2();
+    return info.uordblks + info.hblkhd; // 큰 배열은 mmap으로 잡히므로 함께 집계
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<size_t> counts;
+    for (int i = 1; i < argc; ++i) {
+        counts.push_back(std::strtoul(argv[i], nullptr, 10));
+    }
+    if (counts.empty()) {
+        counts = {10000, 50000};
+    }
+
+    std::mt19937_64 rng(1);
+    std::printf("%12s %22s %14s %14s\n", "connections", "sizeof(PerSocketData)", "heap bytes", "bytes/conn");
+    for (size_t n : counts) {
+        const size_t before = HeapInUse();
+        {
+            std::vector<PerSocketData> sockets(n);
+            std::map<std::string_view, PerSocketData*, std::less<>> active; // WebSocketServer::active_websockets_와 같은 키
+            char id[SessionId::kCapacity + 1];
+            for (auto& socket : sockets) {
+                std::snprintf(id, sizeof(id), "%016llx%016llx",
+                              static_cast<unsigned long long>(rng()), static_cast<unsigned long long>(rng()));
+                socket.sessionId = std::string_view(id);
+                active[socket.sessionId.view()] = &socket;
+            }
+            const size_t used = HeapInUse() - before;
+            std::printf("%12zu %22zu %14zu %14.1f\n", n, sizeof(PerSocketData), used, static_cast<double>(used) / n);
+        }
+    }
+    return 0;
+}
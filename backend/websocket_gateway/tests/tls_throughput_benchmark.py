@@ -0,0 +1,154 @@
+# tests/tls_throughput_benchmark.py
+#
+# 게이트웨이 TLS 처리량/CPU 비교 벤치마크: 평문 / TLS.
+# 빌드된 게이트웨이 바이너리를 루프백 모드(PIPELINE_MODE=loopback, 최대 속도 응답)로 모드마다 새로 띄우고,
+# 여러 세션이 오디오를 최대 속도로 올리고 스크립트 응답 오디오를 받는 동안
+# 송수신 바이트와 게이트웨이 프로세스 CPU 시간(/proc/<pid>/stat)을 측정한다.
+#
+#   python tests/tls_throughput_benchmark.py --binary build/WebSocketGateway --sessions 32 --duration 15
+
+import argparse
+import asyncio
+import os
+import re
+import ssl
+import subprocess
+import tempfile
+import time
+import urllib.request
+
+try:
+    import websockets
+except ImportError:
+    print("Error: 'websockets' package not found. Run 'pip install websockets' first.")
+    exit(1)
+
+
+# --- Configuration ---
+WS_PORT = int(os.getenv("BENCH_WS_PORT", "18000"))
+METRICS_PORT = int(os.getenv("BENCH_METRICS_PORT", "19090"))
+GRPC_PORT = int(os.getenv("BENCH_GRPC_PORT", "15055"))
+CHUNK_BYTES = 3200  # 16kHz 16-bit mono 100ms
+CLK_TCK = os.sysconf("SC_CLK_TCK")
+
+
+def generate_self_signed_cert(directory):
+    cert = os.path.join(directory, "cert.pem")
+    key = os.path.join(directory, "key.pem")
+    subprocess.run(
+        ["openssl", "req", "-x509", "-newkey", "ec", "-pkeyopt", "ec_paramgen_curve:prime256v1",
+         "-nodes", "-keyout", key, "-out", cert, "-days", "1", "-subj", "/CN=localhost"],
+        check=True, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    return cert, key
+
+
+def process_cpu_seconds(pid):
+    with open(f"/proc/{pid}/stat") as f:
+        fields = f.read().rsplit(")", 1)[1].split()
+    # utime, stime (필드 14, 15 - 괄호 뒤 기준 인덱스 11, 12)
+    return (int(fields[11]) + int(fields[12])) / CLK_TCK
+
+
+def read_metrics():
+    # 메트릭 포트는 TLS 설정과 무관하게 전용 스레드의 평문 HTTP
+    with urllib.request.urlopen(f"http://127.0.0.1:{METRICS_PORT}/metrics", timeout=5) as resp:
+        text = resp.read().decode()
+    metrics = {}
+    for line in text.splitlines():
+        match = re.match(r"^([a-zA-Z_:][a-zA-Z0-9_:]*)\s+([0-9.eE+-]+)$", line)
+        if match:
+            metrics[match.group(1)] = float(match.group(2))
+    return metrics
+
+
+def start_gateway(binary, env_overrides):
+    env = dict(os.environ)
+    env.update({
+        "WS_PORT": str(WS_PORT),
+        "METRICS_PORT": str(METRICS_PORT),
+        "GRPC_AVATAR_SYNC_ADDR": f"127.0.0.1:{GRPC_PORT}",
+        "PIPELINE_MODE": "loopback",
+        "LOOPBACK_PACING": "0",
+        "LOOPBACK_RESPONSE_DELAY_MS": "0",
+        "RATE_LIMIT_ENABLED": "false",  # 최대 속도 업로드가 목적이므로 속도 제한 해제
+    })
+    env.update(env_overrides)
+    proc = subprocess.Popen([binary], env=env, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    time.sleep(1.5)
+    if proc.poll() is not None:
+        raise RuntimeError(f"Gateway exited early with code {proc.returncode}")
+    return proc
+
+
+async def run_session(url, ssl_context, duration, counters):
+    chunk = bytes(CHUNK_BYTES)
+    async with websockets.connect(url, ssl=ssl_context, max_size=None, ping_interval=None) as ws:
+        await ws.recv()  # session_info
+
+        async def reader():
+            async for message in ws:
+                if isinstance(message, bytes):
+                    counters["down"] += len(message)
+
+        reader_task = asyncio.create_task(reader())
+        deadline = time.monotonic() + duration
+        while time.monotonic() < deadline:
+            await ws.send('{"type":"start_stream","language":"ko-KR"}')
+            for _ in range(10):  # 1초 분량 발화
+                await ws.send(chunk)
+                counters["up"] += len(chunk)
+            await ws.send('{"type":"utterance_ended"}')
+        reader_task.cancel()
+
+
+async def measure(mode, binary, cert, key, sessions, duration):
+    tls = mode != "plaintext"
+    env = {}
+    if tls:
+        env = {"TLS_CERT_FILE": cert, "TLS_KEY_FILE": key}
+    proc = start_gateway(binary, env)
+    try:
+        url = f"{'wss' if tls else 'ws'}://127.0.0.1:{WS_PORT}/"
+        ssl_context = ssl._create_unverified_context() if tls else None
+        counters = {"up": 0, "down": 0}
+        cpu_before = process_cpu_seconds(proc.pid)
+        start = time.monotonic()
+        await asyncio.gather(*(run_session(url, ssl_context, duration, counters) for _ in range(sessions)),
+                             return_exceptions=True)
+        elapsed = time.monotonic() - start
+        cpu_used = process_cpu_seconds(proc.pid) - cpu_before
+        metrics = read_metrics()
+    finally:
+        proc.terminate()
+        proc.wait(timeout=10)
+
+    total_mb = (counters["up"] + counters["down"]) / (1024 * 1024)
+    return {
+        "mode": mode,
+        "mb_per_sec": total_mb / elapsed if elapsed > 0 else 0,
+        "cpu_ms_per_mb": cpu_used * 1000 / total_mb if total_mb > 0 else 0,
+        "handshakes": int(metrics.get("tls_handshakes_total", 0)),
+    }
+
+
+async def main():
+    parser = argparse.ArgumentParser(description="Gateway plaintext / TLS throughput benchmark")
+    parser.add_argument("--binary", required=True, help="빌드된 WebSocketGateway 실행 파일 경로")
+    parser.add_argument("--sessions", type=int, default=32)
+    parser.add_argument("--duration", type=float, default=15.0, help="모드별 측정 시간(초)")
+    parser.add_argument("--modes", nargs="+", default=["plaintext", "tls"])
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        cert, key = generate_self_signed_cert(tmp)
+        results = []
+        for mode in args.modes:
+            results.append(await measure(mode, args.binary, cert, key, args.sessions, args.duration))
+
+    print(f"{'mode':<10} {'MB/s':>10} {'CPU ms/MB':>10} {'handshakes':>11}")
+    for r in results:
+        print(f"{r['mode']:<10} {r['mb_per_sec']:>10.1f} {r['cpu_ms_per_mb']:>10.2f} {r['handshakes']:>11}")
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
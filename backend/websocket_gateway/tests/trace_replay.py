@@ -0,0 +1,132 @@
+# tests/trace_replay.py
+#
+# TrafficTap(TRAFFIC_TAP_SAMPLE_RATE)이 기록한 .avtrace 파일로 게이트웨이에 운영 형태의 부하를 재현한다.
+# 기록된 세션마다 WebSocket을 열고 클라이언트 텍스트/오디오를 기록된 시각 그대로(--speed 배속) 보낸다.
+# 오디오 내용이 기록되지 않은 트레이스(TRAFFIC_TAP_CAPTURE_AUDIO 미설정)는 같은 크기의 무음으로 대신한다.
+# 세션 시작 시각도 트레이스 기준이므로 동시 접속 수와 발화 겹침이 운영과 같게 재현된다.
+#
+#   TRAFFIC_TAP_SAMPLE_RATE=0.01 ./WebSocketGateway      # 운영: 세션 1% 기록
+#   PIPELINE_MODE=loopback ./WebSocketGateway &          # 테스트 환경
+#   python tests/trace_replay.py /tmp/gateway_traces/*.avtrace --speed 1.0
+#
+# 게이트웨이가 새 세션 ID를 발급하므로 session_info는 무시하고, 응답 프레임 수는 기록된 수와 비교만 한다.
+
+import argparse
+import asyncio
+import os
+import struct
+import time
+from collections import defaultdict
+
+try:
+    import websockets
+except ImportError:
+    print("Error: 'websockets' package not found. Run 'pip install websockets' first.")
+    exit(1)
+
+
+# --- Configuration ---
+GATEWAY_WS_URL = os.getenv("GATEWAY_WS_URL", "ws://127.0.0.1:8000/")
+FILE_MAGIC = b"AVTRACE1"
+RECORD_HEADER = struct.Struct("<QQB3xII")  # t_us, session_key, type, size, data_len (traffic_tap.h)
+
+SESSION_OPEN, SESSION_CLOSE, CLIENT_TEXT, CLIENT_AUDIO, SERVER_AUDIO, SERVER_VISEME = range(1, 7)
+
+
+def read_trace(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if not data.startswith(FILE_MAGIC):
+        raise ValueError(f"{path}: not an avtrace file")
+    offset = len(FILE_MAGIC)
+    while offset + RECORD_HEADER.size <= len(data):
+        t_us, key, kind, size, data_len = RECORD_HEADER.unpack_from(data, offset)
+        offset += RECORD_HEADER.size
+        payload = data[offset:offset + data_len]
+        offset += data_len
+        if len(payload) < data_len:
+            break  # 쓰는 중에 잘린 마지막 레코드
+        yield t_us, key, kind, size, payload
+
+
+def load_sessions(paths):
+    # 한 프로세스의 트레이스는 같은 시간축을 공유. 열림 레코드가 없는 세션(회전 전에 시작)은 건너뜀
+    sessions = defaultdict(lambda: {"events": [], "server_frames": 0, "opened": False})
+    for path in sorted(paths):
+        for t_us, key, kind, size, payload in read_trace(path):
+            session = sessions[key]
+            if kind == SESSION_OPEN:
+                session["opened"] = True
+                session["start_us"] = t_us
+            elif kind in (CLIENT_TEXT, CLIENT_AUDIO, SESSION_CLOSE):
+                session["events"].append((t_us, kind, size, payload))
+            elif kind in (SERVER_AUDIO, SERVER_VISEME):
+                session["server_frames"] += 1
+    return [s for s in sessions.values() if s["opened"]]
+
+
+async def replay_session(session, origin_us, wall_origin, speed, counters):
+    async def wait_until(t_us):
+        delay = wall_origin + (t_us - origin_us) / 1e6 / speed - time.monotonic()
+        if delay > 0:
+            await asyncio.sleep(delay)
+
+    await wait_until(session["start_us"])
+    async with websockets.connect(GATEWAY_WS_URL, max_size=None, ping_interval=None) as ws:
+        await ws.recv()  # session_info
+
+        async def reader():
+            async for _ in ws:
+                counters["frames_received"] += 1
+
+        reader_task = asyncio.create_task(reader())
+        for t_us, kind, size, payload in session["events"]:
+            await wait_until(t_us)
+            lateness_ms = (time.monotonic() - (wall_origin + (t_us - origin_us) / 1e6 / speed)) * 1000
+            counters["max_lateness_ms"] = max(counters["max_lateness_ms"], lateness_ms)
+            if kind == SESSION_CLOSE:
+                break
+            if kind == CLIENT_TEXT:
+                await ws.send(payload.decode(errors="replace"))
+            else:
+                await ws.send(payload if len(payload) == size else bytes(size))
+                counters["audio_bytes"] += size
+            counters["messages_sent"] += 1
+        await asyncio.sleep(1.0)  # 마지막 응답 수신 시간
+        reader_task.cancel()
+
+
+async def main():
+    parser = argparse.ArgumentParser(description="Replay gateway traffic traces with recorded timing")
+    parser.add_argument("traces", nargs="+", help=".avtrace 파일 (같은 게이트웨이 프로세스에서 기록된 것)")
+    parser.add_argument("--speed", type=float, default=1.0, help="재생 배속 (2.0 = 두 배 빠르게)")
+    parser.add_argument("--sessions", type=int, default=0, help="재생할 최대 세션 수 (0 = 전부)")
+    args = parser.parse_args()
+
+    sessions = sorted(load_sessions(args.traces), key=lambda s: s["start_us"])
+    if args.sessions:
+        sessions = sessions[:args.sessions]
+    if not sessions:
+        print("No complete sessions in trace.")
+        return
+    origin_us = sessions[0]["start_us"]
+    span = (max(e[0] for s in sessions for e in s["events"] or [(s["start_us"],)]) - origin_us) / 1e6
+    print(f"Replaying {len(sessions)} sessions spanning {span:.1f}s at {args.speed}x")
+
+    counters = {"messages_sent": 0, "audio_bytes": 0, "frames_received": 0, "max_lateness_ms": 0.0}
+    wall_origin = time.monotonic() + 0.5
+    results = await asyncio.gather(
+        *(replay_session(s, origin_us, wall_origin, args.speed, counters) for s in sessions),
+        return_exceptions=True)
+    failed = sum(1 for r in results if isinstance(r, Exception))
+
+    recorded_frames = sum(s["server_frames"] for s in sessions)
+    print(f"--- {len(sessions)} sessions ({failed} failed) ---")
+    print(f"  messages sent:          {counters['messages_sent']}")
+    print(f"  audio sent:             {counters['audio_bytes'] / (1024 * 1024):.2f} MB")
+    print(f"  max send lateness:      {counters['max_lateness_ms']:.1f} ms")
+    print(f"  frames received:        {counters['frames_received']} (recorded: {recorded_frames})")
+
+
+if __name__ == "__main__":
+    asyncio.run(main())
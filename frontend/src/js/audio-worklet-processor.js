@@ -40,6 +40,11 @@ class PCMPlayerProcessor extends AudioWorkletProcessor {
 
     this.port.onmessage = (event) => {
       const chunk = event.data;
+      // barge-in: 서버가 이전 턴을 취소하면 남은 재생 버퍼를 비운다
+      if (chunk && chunk.type === 'flush') {
+        this.buffer = new Float32Array(0);
+        return;
+      }
       if (!(chunk instanceof Float32Array)) return;
 
       const combined = new Float32Array(this.buffer.length + chunk.length);
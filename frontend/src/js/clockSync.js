@@ -0,0 +1,65 @@
+// frontend/src/js/clockSync.js
+// 서버 타임라인(ms)과 performance.now() 사이의 오프셋을 NTP 방식으로 추정.
+// t0: 클라이언트 송신, t1/t2: 서버 수신/응답, t3: 클라이언트 수신
+//   offset = ((t1 - t0) + (t2 - t3)) / 2,  rtt = (t3 - t0) - (t2 - t1)
+// 네트워크 지연이 대칭이라는 가정이 가장 잘 맞는 최소 RTT 샘플을 채택한다.
+
+const BURST_COUNT = 5;
+const BURST_INTERVAL_MS = 200;
+const RESYNC_INTERVAL_MS = 30000;
+const SAMPLE_WINDOW = 8;
+
+export class ClockSync {
+    constructor(send) {
+        this.send = send;           // (jsonObject) => void
+        this.samples = [];
+        this.offsetMs = null;       // serverMs - performance.now()
+        this.rttMs = null;
+        this.timers = [];
+        this.framedAudio = false;   // 첫 응답 이후 서버가 보내는 오디오는 PTS 헤더 포함
+    }
+
+    start() {
+        this.stop();
+        this.burst();
+        this.timers.push(setInterval(() => this.burst(), RESYNC_INTERVAL_MS));
+    }
+
+    stop() {
+        this.timers.forEach((t) => { clearTimeout(t); clearInterval(t); });
+        this.timers = [];
+    }
+
+    burst() {
+        for (let i = 0; i < BURST_COUNT; i++) {
+            this.timers.push(setTimeout(() => {
+                // 오디오 프레임에 PTS 헤더를 붙이도록 매번 요청 (재연결 후에도 유지)
+                this.send({ type: "clock_sync", t0: performance.now(), framedAudio: true });
+            }, i * BURST_INTERVAL_MS));
+        }
+    }
+
+    handleReply(msg) {
+        const t3 = performance.now();
+        this.framedAudio = true;
+        const rtt = (t3 - msg.t0) - (msg.t2 - msg.t1);
+        if (rtt < 0) return;
+        const offset = ((msg.t1 - msg.t0) + (msg.t2 - t3)) / 2;
+
+        this.samples.push({ rtt, offset });
+        if (this.samples.length > SAMPLE_WINDOW) this.samples.shift();
+
+        const best = this.samples.reduce((a, b) => (b.rtt < a.rtt ? b : a));
+        this.offsetMs = best.offset;
+        this.rttMs = best.rtt;
+    }
+
+    isSynced() {
+        return this.offsetMs !== null;
+    }
+
+    // 서버 PTS를 performance.now() 기준으로 변환
+    toLocalMs(serverMs) {
+        return serverMs - this.offsetMs;
+    }
+}
@@ -27,18 +27,25 @@ const MIN_SPEECH_FRAMES_FOR_SEGMENT = 3; // 유효한 발화로 간주하기 위
 
 let isUserSessionActive = false;      // 사용자가 시작/종료 버튼으로 제어하는 전체 세션 상태
 let isSttStreamActiveOnServer = false; // 서버의 STT 스트림이 활성 상태인지 여부 (서버 응답으로 업데이트)
+let sttTurnId = 0;                     // 오디오를 보내는 중인 턴 (stt_stream_started의 turnId, -1 = 시작 대기)
 let webSocketReady = false;           // 웹소켓 연결이 성공적으로 열렸는지 여부
 
 // --- WebSocket으로부터 호출될 콜백 함수들 ---
-window.handleSttStreamStarted = () => {
-    console.log("[Main] 서버로부터 STT 스트림 시작 확인 응답 받음.");
+window.handleSttStreamStarted = (turnId = 0) => {
+    console.log(`[Main] 서버로부터 STT 스트림 시작 확인 응답 받음 (턴 ${turnId}).`);
     isSttStreamActiveOnServer = true;
+    sttTurnId = turnId;
     if (isUserSessionActive) { // 사용자 세션이 아직 활성 상태일 때만 UI 업데이트
         statusEl.textContent = '🟢 STT 활성. 말해주세요.';
     }
 };
 
-window.handleSttStreamEnded = (isClosedByClient = false) => {
+window.handleSttStreamEnded = (isClosedByClient = false, turnId = 0) => {
+    // 이전 턴의 응답이 다음 발화가 시작된 뒤에 끝날 수 있음: 현재 턴의 상태는 건드리지 않음
+    if (!isClosedByClient && turnId && turnId !== sttTurnId) {
+        console.log(`[Main] 이전 턴 ${turnId}의 처리 완료 (현재 턴 ${sttTurnId}).`);
+        return;
+    }
     console.log(`[Main] 서버로부터 STT 스트림 종료 알림 받음 (클라이언트 요청 종료: ${isClosedByClient}).`);
     isSttStreamActiveOnServer = false;
     // isClosedByClient가 true이면 closeWebSocket에서 이미 UI를 '종료됨'으로 설정했을 수 있음
@@ -134,6 +141,7 @@ startBtn.addEventListener('click', async () => {
                 if (!isSttStreamActiveOnServer) {
                     console.log(`[Main] 새 발화 시작, "start_stream" 메시지 전송 (언어: ${languageCode}).`);
                     sendJsonMessage({ type: "start_stream", language: languageCode });
+                    sttTurnId = -1; // 새 턴 번호는 stt_stream_started로 받음. 그 전에 끝나는 턴은 모두 이전 턴
                     // isSttStreamActiveOnServer는 서버 응답('stt_stream_started')을 통해 업데이트됨
                     statusEl.textContent = '🔄 STT 스트림 요청 중...';
                 }
@@ -166,8 +174,8 @@ startBtn.addEventListener('click', async () => {
                         
                         console.log('[Main] "utterance_ended" 메시지 전송 (VAD 발화 종료 감지).');
                         sendJsonMessage({ type: "utterance_ended" });
-                        // isSttStreamActiveOnServer는 서버 응답('stt_stream_ended_by_server')을 통해 false로 변경됨
-                        // statusEl.textContent = '➡️ STT 처리 요청됨...'; // 서버 응답 후 변경될 것임
+                        // 서버는 이 턴의 오디오를 더 받지 않음. 응답(LLM/TTS)이 끝나기 전이라도 다음 발화는 새 턴으로 바로 시작
+                        isSttStreamActiveOnServer = false;
                     } else {
                         console.log('[Main] VAD 발화 종료 감지, 그러나 서버 STT 스트림이 활성 상태가 아님. "utterance_ended" 보내지 않음.');
                     }
@@ -1,5 +1,6 @@
 // frontend/src/js/websocket.js
 import { AvatarService } from './avatar.js';
+import { ClockSync } from './clockSync.js';
 
 let socket = null;
 let audioContext = null;
@@ -8,6 +9,11 @@ let playerNode = null;
 let currentSessionId = null;
 let languageCodeForStream = "ko-KR";
 let isAudioContextResumed = false;
+let cancelledBeforeTurnId = 0; // 이 값보다 작은 turnId의 viseme은 무시 (barge-in)
+let clockSync = null;
+let scheduledTimers = new Set(); // PTS 대기 중인 오디오/viseme 타이머 (barge-in 시 취소)
+const AUDIO_SCHEDULE_LEAD_MS = 40; // 워클릿 버퍼링 지연만큼 먼저 넘김
+const FRAMED_AUDIO_HEADER_BYTES = 8; // [ptsMs u32 LE][turnId u32 LE]
 
 export async function initWebSocketConnection(url, language = "ko-KR") {
     if (socket && (socket.readyState === WebSocket.OPEN || socket.readyState === WebSocket.CONNECTING)) {
@@ -40,29 +46,60 @@ export async function initWebSocketConnection(url, language = "ko-KR") {
             if (!socket || socket !== localSocket) return;
 
             if (event.data instanceof ArrayBuffer) {
-                const int16Array = new Int16Array(event.data);
-                const float32Array = new Float32Array(int16Array.length);
-                for (let i = 0; i < int16Array.length; i++) {
-                    float32Array[i] = int16Array[i] / 32768.0;
-                }
-                if (playerNode) {
-                    playerNode.port.postMessage(float32Array);
-                }
+                handleAudioFrame(event.data);
             } else if (typeof event.data === "string") {
                 try {
                     const msg = JSON.parse(event.data);
                     if (msg.type === "viseme") {
-                        AvatarService.applyViseme(msg.visemeId);
+                        if (msg.turnId && msg.turnId < cancelledBeforeTurnId) return;
+                        scheduleAt(msg.ptsMs, 0, () => {
+                            if (msg.turnId && msg.turnId < cancelledBeforeTurnId) return;
+                            AvatarService.applyViseme(msg.visemeId);
+                        });
+                    } else if (msg.type === "turn_cancelled") {
+                        // 사용자가 말을 끊음: 이전 턴의 재생 중인 오디오를 즉시 중단
+                        cancelledBeforeTurnId = Math.max(cancelledBeforeTurnId, (msg.turnId || 0) + 1);
+                        cancelScheduled();
+                        if (playerNode) {
+                            playerNode.port.postMessage({ type: 'flush' });
+                        }
+                    } else if (msg.type === "clock_sync_reply") {
+                        if (clockSync) clockSync.handleReply(msg);
                     } else if (msg.type === "session_info") {
                         currentSessionId = msg.sessionId;
                         console.log("[WebSocket] 세션 ID:", currentSessionId);
+                        clockSync = new ClockSync(sendJsonMessage);
+                        clockSync.start();
                     } else if (msg.type === "stt_stream_started" && typeof window.handleSttStreamStarted === 'function') {
-                        window.handleSttStreamStarted();
+                        window.handleSttStreamStarted(msg.turnId || 0);
                     } else if (msg.type === "stt_stream_ended_by_server" && typeof window.handleSttStreamEnded === 'function') {
-                        window.handleSttStreamEnded();
+                        window.handleSttStreamEnded(false, msg.turnId || 0);
                     } else if (msg.type === "stream_stopping_acknowledged") {
                         const statusEl = document.getElementById('status');
                         if (statusEl) statusEl.textContent = '⏹️ 스트림 중지됨 (서버 확인)';
+                    } else if (msg.type === "turn_timeout") {
+                        console.warn("[WebSocket] 응답 시간 초과. turnId:", msg.turnId);
+                        const statusEl = document.getElementById('status');
+                        if (statusEl) statusEl.textContent = '⏰ 응답이 지연되고 있습니다. 다시 말씀해 주세요.';
+                    } else if (msg.type === "rate_limited") {
+                        // 게이트웨이가 초과분을 버림 (scope: session | ip | quota)
+                        console.warn(`[WebSocket] 전송 속도 제한(${msg.kind}, ${msg.scope}). retryAfterMs=${msg.retryAfterMs}`);
+                        if (msg.scope === "quota") {
+                            const statusEl = document.getElementById('status');
+                            if (statusEl) statusEl.textContent = '⚠️ 세션 오디오 사용량을 모두 사용했습니다.';
+                        }
+                    } else if (msg.type === "admission_queued") {
+                        // 게이트웨이 턴 슬롯 대기 중. stt_stream_started 전까지 오디오는 클라이언트에 쌓임
+                        const statusEl = document.getElementById('status');
+                        if (statusEl) statusEl.textContent = '⏳ 서버가 혼잡합니다. 잠시 대기 중...';
+                    } else if (msg.type === "busy") {
+                        // 게이트웨이 과부하로 거절 (scope: session | turn). 세션 거절이면 곧 1013으로 연결이 닫힘
+                        console.warn(`[WebSocket] 서버 혼잡(${msg.scope}, ${msg.reason}). retryAfterMs=${msg.retryAfterMs}`);
+                        const statusEl = document.getElementById('status');
+                        if (statusEl) {
+                            const seconds = Math.ceil((msg.retryAfterMs || 0) / 1000);
+                            statusEl.textContent = `🚧 서버가 혼잡합니다. ${seconds}초 후 다시 시도해 주세요.`;
+                        }
                     } else if (msg.type === "error") {
                         console.error("[WebSocket] 서버 오류:", msg.message);
                         const statusEl = document.getElementById('status');
@@ -79,6 +116,7 @@ export async function initWebSocketConnection(url, language = "ko-KR") {
             if (socket === localSocket) {
                 socket = null;
                 currentSessionId = null;
+                stopClockSync();
             }
             resolve(false);
         };
@@ -88,12 +126,70 @@ export async function initWebSocketConnection(url, language = "ko-KR") {
             if (socket === localSocket) {
                 socket = null;
                 currentSessionId = null;
+                stopClockSync();
             }
             resolve(false);
         };
     });
 }
 
+function handleAudioFrame(buffer) {
+    // 게이트웨이는 소켓 메시지를 순서대로 처리하므로 첫 clock_sync_reply 이후의 오디오에는 PTS 헤더가 붙어 있음
+    let ptsMs;
+    let turnId = 0;
+    let pcm = buffer;
+    if (clockSync && clockSync.framedAudio && buffer.byteLength >= FRAMED_AUDIO_HEADER_BYTES) {
+        const header = new DataView(buffer, 0, FRAMED_AUDIO_HEADER_BYTES);
+        ptsMs = header.getUint32(0, true);
+        turnId = header.getUint32(4, true);
+        pcm = buffer.slice(FRAMED_AUDIO_HEADER_BYTES);
+    }
+    if (turnId && turnId < cancelledBeforeTurnId) return;
+
+    const int16Array = new Int16Array(pcm);
+    const float32Array = new Float32Array(int16Array.length);
+    for (let i = 0; i < int16Array.length; i++) {
+        float32Array[i] = int16Array[i] / 32768.0;
+    }
+    scheduleAt(ptsMs, AUDIO_SCHEDULE_LEAD_MS, () => {
+        if (turnId && turnId < cancelledBeforeTurnId) return;
+        if (playerNode) {
+            playerNode.port.postMessage(float32Array);
+        }
+    });
+}
+
+// 서버 PTS에 맞춰 실행. 동기화 전이거나 PTS가 없으면(구 게이트웨이) 즉시 실행
+function scheduleAt(ptsMs, leadMs, fn) {
+    if (ptsMs === undefined || !clockSync || !clockSync.isSynced()) {
+        fn();
+        return;
+    }
+    const delay = clockSync.toLocalMs(ptsMs) - leadMs - performance.now();
+    if (delay <= 0) {
+        fn();
+        return;
+    }
+    const timer = setTimeout(() => {
+        scheduledTimers.delete(timer);
+        fn();
+    }, delay);
+    scheduledTimers.add(timer);
+}
+
+function cancelScheduled() {
+    scheduledTimers.forEach((t) => clearTimeout(t));
+    scheduledTimers.clear();
+}
+
+function stopClockSync() {
+    cancelScheduled();
+    if (clockSync) {
+        clockSync.stop();
+        clockSync = null;
+    }
+}
+
 async function initializeAudioContext() {
     if (!audioContext || audioContext.state === 'closed') {
         audioContext = new (window.AudioContext || window.webkitAudioContext)({ sampleRate: 16000 });
@@ -157,6 +253,7 @@ export async function closeWebSocket(updateUI = true) {
         socket = null;
     }
     currentSessionId = null;
+    stopClockSync();
 
     if (updateUI) {
         const statusEl = document.getElementById('status');